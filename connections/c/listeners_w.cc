@@ -213,6 +213,8 @@ PayloadListenerW::PayloadListenerW(PayloadCB payloadCB,
         InputFileW file(std::move(payload.AsFile()));
         payloadW = PayloadW(payload.GetId(), std::move(file));
       } break;
+      // Batches are handed to listeners file by file.
+      case connections::PayloadType::kFileBatch:
       case connections::PayloadType::kUnknown: {
         // Throw exception here?
         break;
@@ -51,6 +51,9 @@ struct ConnectionOptions : public OptionsBase {
   std::string fast_advertisement_service_uuid;
   int keep_alive_interval_millis = 0;
   int keep_alive_timeout_millis = 0;
+  // Whether payload chunks of this connection may be compressed, in either
+  // direction. Only has an effect if payload compression is enabled.
+  bool enable_payload_compression = true;
 
   std::vector<Medium> GetMediums() const;
   ConnectionInfo connection_info;
@@ -27,13 +27,12 @@
 #include "absl/container/btree_map.h"
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
+#include "connections/implementation/analytics/async_event_logger.h"
 #include "internal/analytics/event_logger.h"
-#include "internal/platform/count_down_latch.h"
 #include "internal/platform/error_code_params.h"
 #include "internal/platform/implementation/system_clock.h"
 #include "internal/platform/logging.h"
 #include "internal/platform/mutex_lock.h"
-#include "internal/platform/single_thread_executor.h"
 #include "internal/proto/analytics/connections_log.pb.h"
 #include "proto/connections_enums.pb.h"
 
@@ -100,11 +99,15 @@ AnalyticsRecorder::AnalyticsRecorder(EventLogger *event_logger)
     : event_logger_(event_logger) {
   NEARBY_LOGS(INFO) << "Start AnalyticsRecorder ctor event_logger_="
                     << event_logger_;
+  if (event_logger_ != nullptr) {
+    async_event_logger_ = std::make_unique<AsyncEventLogger>(event_logger_);
+  }
   LogStartSession();
 }
 
 AnalyticsRecorder::~AnalyticsRecorder() {
-  serial_executor_.Shutdown();
+  // Flushes queued events.
+  async_event_logger_.reset();
   MutexLock lock(&mutex_);
   ResetClientSessionLoggingResoucesLocked();
 }
@@ -696,19 +699,15 @@ void AnalyticsRecorder::OnErrorCode(const ErrorCodeParams &params) {
     }
   }
 
-  serial_executor_.Execute(
-      "analytics-recorder", [this, error_code = error_code.release()]() {
-        ConnectionsLog connections_log;
-        connections_log.set_event_type(ERROR_CODE);
-        connections_log.set_version(kVersion);
-        connections_log.set_allocated_error_code(error_code);
+  auto connections_log = std::make_unique<ConnectionsLog>();
+  connections_log->set_event_type(ERROR_CODE);
+  connections_log->set_version(kVersion);
+  connections_log->set_allocated_error_code(error_code.release());
 
-        NEARBY_LOGS(VERBOSE)
-            << "AnalyticsRecorder LogErrorCode connections_log="
-            << connections_log.DebugString();
+  NEARBY_LOGS(VERBOSE) << "AnalyticsRecorder LogErrorCode connections_log="
+                       << connections_log->DebugString();
 
-        event_logger_->Log(connections_log);
-      });
+  async_event_logger_->Log(std::move(connections_log));
 }
 
 void AnalyticsRecorder::LogStartSession() {
@@ -784,34 +783,27 @@ bool AnalyticsRecorder::CanRecordAnalyticsLocked(
 }
 
 void AnalyticsRecorder::LogClientSessionLocked() {
-  serial_executor_.Execute(
-      "analytics-recorder",
-      [this, client_session = std::move(client_session_)]() mutable {
-        ConnectionsLog connections_log;
-        connections_log.set_event_type(CLIENT_SESSION);
-        connections_log.set_allocated_client_session(client_session.release());
-        connections_log.set_version(kVersion);
-
-        NEARBY_LOGS(VERBOSE)
-            << "AnalyticsRecorder LogClientSession connections_log="
-            << connections_log.DebugString();
-
-        event_logger_->Log(connections_log);
-      });
+  auto connections_log = std::make_unique<ConnectionsLog>();
+  connections_log->set_event_type(CLIENT_SESSION);
+  connections_log->set_allocated_client_session(client_session_.release());
+  connections_log->set_version(kVersion);
+
+  NEARBY_LOGS(VERBOSE) << "AnalyticsRecorder LogClientSession connections_log="
+                       << connections_log->DebugString();
+
+  async_event_logger_->Log(std::move(connections_log));
   ResetClientSessionLoggingResoucesLocked();
 }
 
 void AnalyticsRecorder::LogEvent(EventType event_type) {
-  serial_executor_.Execute("analytics-recorder", [this, event_type]() {
-    ConnectionsLog connections_log;
-    connections_log.set_event_type(event_type);
-    connections_log.set_version(kVersion);
+  auto connections_log = std::make_unique<ConnectionsLog>();
+  connections_log->set_event_type(event_type);
+  connections_log->set_version(kVersion);
 
-    NEARBY_LOGS(VERBOSE) << "AnalyticsRecorder LogEvent connections_log="
-                         << connections_log.DebugString();
+  NEARBY_LOGS(VERBOSE) << "AnalyticsRecorder LogEvent connections_log="
+                       << connections_log->DebugString();
 
-    event_logger_->Log(connections_log);
-  });
+  async_event_logger_->Log(std::move(connections_log));
 }
 
 void AnalyticsRecorder::UpdateStrategySessionLocked(
@@ -1080,6 +1072,7 @@ PayloadType AnalyticsRecorder::PayloadTypeToProtoPayloadType(
     case connections::PayloadType::kBytes:
       return BYTES;
     case connections::PayloadType::kFile:
+    case connections::PayloadType::kFileBatch:
       return FILE;
     case connections::PayloadType::kStream:
       return STREAM;
@@ -1323,9 +1316,9 @@ AnalyticsRecorder::LogicalConnection::ResolvePendingPayloads(
 }
 
 void AnalyticsRecorder::Sync() {
-  CountDownLatch latch(1);
-  serial_executor_.Execute([&]() { latch.CountDown(); });
-  latch.Await();
+  if (async_event_logger_ != nullptr) {
+    async_event_logger_->Flush();
+  }
 }
 
 }  // namespace analytics
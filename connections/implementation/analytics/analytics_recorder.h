@@ -25,6 +25,7 @@
 #include "absl/container/btree_map.h"
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
+#include "connections/implementation/analytics/async_event_logger.h"
 #include "connections/implementation/analytics/connection_attempt_metadata_params.h"
 #include "connections/payload_type.h"
 #include "connections/strategy.h"
@@ -32,7 +33,6 @@
 #include "internal/platform/error_code_params.h"
 #include "internal/platform/implementation/system_clock.h"
 #include "internal/platform/mutex.h"
-#include "internal/platform/single_thread_executor.h"
 #include "internal/proto/analytics/connections_log.pb.h"
 #include "proto/connections_enums.pb.h"
 
@@ -182,8 +182,8 @@ class AnalyticsRecorder {
   void LogStartSession() ABSL_LOCKS_EXCLUDED(mutex_);
 
   // Invokes event_logger_.Log() at the end of life of client. Log action is
-  // called in a separate thread to allow synchronous potentially lengthy
-  // execution.
+  // called in a separate thread, through async_event_logger_, to allow
+  // synchronous potentially lengthy execution.
   void LogSession() ABSL_LOCKS_EXCLUDED(mutex_);
 
   bool IsSessionLogged();
@@ -354,7 +354,9 @@ class AnalyticsRecorder {
   // that outlives the one constructed.
   ::nearby::analytics::EventLogger *event_logger_;
 
-  SingleThreadExecutor serial_executor_;
+  // Delivers events to event_logger_ off the calling thread. Null iff
+  // event_logger_ is null.
+  std::unique_ptr<AsyncEventLogger> async_event_logger_;
   // Protects all sub-protos reading and writing in ConnectionLog.
   Mutex mutex_;
 
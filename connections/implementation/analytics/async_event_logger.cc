@@ -0,0 +1,100 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "connections/implementation/analytics/async_event_logger.h"
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <utility>
+
+#include "google/protobuf/message_lite.h"
+#include "internal/platform/count_down_latch.h"
+#include "internal/platform/logging.h"
+#include "internal/platform/mutex_lock.h"
+
+namespace nearby {
+namespace analytics {
+
+using ::google::protobuf::MessageLite;
+
+AsyncEventLogger::AsyncEventLogger(EventLogger* event_logger,
+                                   int max_queued_events)
+    : event_logger_(event_logger),
+      max_queued_events_(max_queued_events > 0 ? max_queued_events : 1) {}
+
+AsyncEventLogger::~AsyncEventLogger() {
+  Flush();
+  executor_.Shutdown();
+}
+
+void AsyncEventLogger::Log(const MessageLite& message) {
+  std::unique_ptr<MessageLite> copy(message.New());
+  copy->CheckTypeAndMergeFrom(message);
+  Log(std::move(copy));
+}
+
+void AsyncEventLogger::Log(std::unique_ptr<MessageLite> message) {
+  if (message == nullptr) return;
+  MutexLock lock(&mutex_);
+  if (queue_.size() >= static_cast<size_t>(max_queued_events_)) {
+    queue_.pop_front();
+    dropped_events_++;
+    unreported_dropped_events_++;
+  }
+  queue_.push_back(std::move(message));
+  if (delivery_scheduled_) return;
+  delivery_scheduled_ = true;
+  executor_.Execute("async-event-logger", [this]() { DeliverQueuedEvents(); });
+}
+
+void AsyncEventLogger::Flush() {
+  CountDownLatch latch(1);
+  // The executor is serial, so this runs after any pending delivery task,
+  // which in turn drains everything queued before it started.
+  executor_.Execute("async-event-logger-flush",
+                    [&latch]() { latch.CountDown(); });
+  latch.Await();
+}
+
+std::int64_t AsyncEventLogger::GetDroppedEventCount() const {
+  MutexLock lock(&mutex_);
+  return dropped_events_;
+}
+
+void AsyncEventLogger::DeliverQueuedEvents() {
+  while (true) {
+    std::deque<std::unique_ptr<MessageLite>> batch;
+    std::int64_t dropped = 0;
+    {
+      MutexLock lock(&mutex_);
+      if (queue_.empty()) {
+        delivery_scheduled_ = false;
+        return;
+      }
+      batch.swap(queue_);
+      std::swap(dropped, unreported_dropped_events_);
+    }
+    if (dropped > 0) {
+      NEARBY_LOGS(WARNING) << "AsyncEventLogger dropped " << dropped
+                           << " events because the queue was full.";
+    }
+    for (const auto& message : batch) {
+      event_logger_->Log(*message);
+    }
+  }
+}
+
+}  // namespace analytics
+}  // namespace nearby
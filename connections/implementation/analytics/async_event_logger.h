@@ -0,0 +1,89 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef NEARBY_CONNECTIONS_IMPLEMENTATION_ANALYTICS_ASYNC_EVENT_LOGGER_H_
+#define NEARBY_CONNECTIONS_IMPLEMENTATION_ANALYTICS_ASYNC_EVENT_LOGGER_H_
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+
+#include "absl/base/thread_annotations.h"
+#include "google/protobuf/message_lite.h"
+#include "internal/analytics/event_logger.h"
+#include "internal/platform/mutex.h"
+#include "internal/platform/single_thread_executor.h"
+
+namespace nearby {
+namespace analytics {
+
+// An EventLogger that hands events to another EventLogger on a background
+// thread, so that callers never block on the wrapped logger's I/O.
+//
+// Events are queued in a bounded queue and delivered in order, in batches:
+// each delivery task drains everything that was queued by the time it runs.
+// If the queue is full, the oldest queued event is dropped to make room; the
+// end-of-session events that are logged last are the most valuable ones.
+//
+// Queued events are flushed to the wrapped logger on destruction.
+class AsyncEventLogger : public EventLogger {
+ public:
+  static constexpr int kDefaultMaxQueuedEvents = 512;
+
+  // `event_logger` must not be null and must outlive this object.
+  explicit AsyncEventLogger(EventLogger* event_logger,
+                            int max_queued_events = kDefaultMaxQueuedEvents);
+  AsyncEventLogger(const AsyncEventLogger&) = delete;
+  AsyncEventLogger& operator=(const AsyncEventLogger&) = delete;
+  ~AsyncEventLogger() override;
+
+  // Queues a copy of `message`.
+  void Log(const ::google::protobuf::MessageLite& message) override
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Queues `message` without copying it.
+  void Log(std::unique_ptr<::google::protobuf::MessageLite> message)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Blocks until every event queued before the call has been delivered.
+  void Flush() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Returns the number of events dropped because the queue was full.
+  std::int64_t GetDroppedEventCount() const ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  // Delivers queued events until the queue is empty.
+  // @AsyncEventLoggerThread
+  void DeliverQueuedEvents() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  EventLogger* const event_logger_;
+  const int max_queued_events_;
+
+  mutable Mutex mutex_;
+  std::deque<std::unique_ptr<::google::protobuf::MessageLite>> queue_
+      ABSL_GUARDED_BY(mutex_);
+  // True if a DeliverQueuedEvents() task is pending or running; it will pick
+  // up any event queued meanwhile.
+  bool delivery_scheduled_ ABSL_GUARDED_BY(mutex_) = false;
+  std::int64_t dropped_events_ ABSL_GUARDED_BY(mutex_) = 0;
+  // Dropped events not yet reported in the log.
+  std::int64_t unreported_dropped_events_ ABSL_GUARDED_BY(mutex_) = 0;
+
+  SingleThreadExecutor executor_;
+};
+
+}  // namespace analytics
+}  // namespace nearby
+
+#endif  // NEARBY_CONNECTIONS_IMPLEMENTATION_ANALYTICS_ASYNC_EVENT_LOGGER_H_
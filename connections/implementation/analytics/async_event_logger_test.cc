@@ -0,0 +1,149 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "connections/implementation/analytics/async_event_logger.h"
+
+#include <memory>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/time/time.h"
+#include "internal/analytics/event_logger.h"
+#include "internal/platform/count_down_latch.h"
+#include "internal/platform/mutex.h"
+#include "internal/platform/mutex_lock.h"
+#include "internal/proto/analytics/connections_log.pb.h"
+#include "proto/connections_enums.pb.h"
+
+namespace nearby {
+namespace analytics {
+namespace {
+
+using ::location::nearby::analytics::proto::ConnectionsLog;
+using ::location::nearby::proto::connections::CLIENT_SESSION;
+using ::location::nearby::proto::connections::ERROR_CODE;
+using ::location::nearby::proto::connections::EventType;
+using ::location::nearby::proto::connections::START_CLIENT_SESSION;
+using ::location::nearby::proto::connections::START_STRATEGY_SESSION;
+using ::location::nearby::proto::connections::STOP_CLIENT_SESSION;
+using ::testing::ElementsAre;
+
+// Records the event types it is given. Optionally blocks in Log() until
+// Unblock() is called, to simulate a logger that does slow I/O.
+class FakeEventLogger : public EventLogger {
+ public:
+  explicit FakeEventLogger(bool block = false) : block_(block) {}
+
+  void Log(const ::google::protobuf::MessageLite& message) override {
+    entered_latch_.CountDown();
+    if (block_) {
+      unblock_latch_.Await();
+    }
+    MutexLock lock(&mutex_);
+    event_types_.push_back(
+        static_cast<const ConnectionsLog&>(message).event_type());
+  }
+
+  // Waits until Log() has been entered at least once.
+  void AwaitEntered() { entered_latch_.Await(); }
+  void Unblock() { unblock_latch_.CountDown(); }
+
+  std::vector<EventType> event_types() const {
+    MutexLock lock(&mutex_);
+    return event_types_;
+  }
+
+ private:
+  const bool block_;
+  CountDownLatch entered_latch_{1};
+  CountDownLatch unblock_latch_{1};
+  mutable Mutex mutex_;
+  std::vector<EventType> event_types_ ABSL_GUARDED_BY(mutex_);
+};
+
+ConnectionsLog MakeEvent(EventType event_type) {
+  ConnectionsLog connections_log;
+  connections_log.set_event_type(event_type);
+  return connections_log;
+}
+
+TEST(AsyncEventLoggerTest, DeliversEventsInOrder) {
+  FakeEventLogger event_logger;
+  AsyncEventLogger async_event_logger(&event_logger);
+
+  async_event_logger.Log(MakeEvent(START_CLIENT_SESSION));
+  async_event_logger.Log(std::make_unique<ConnectionsLog>(
+      MakeEvent(START_STRATEGY_SESSION)));
+  async_event_logger.Log(MakeEvent(STOP_CLIENT_SESSION));
+  async_event_logger.Flush();
+
+  EXPECT_THAT(event_logger.event_types(),
+              ElementsAre(START_CLIENT_SESSION, START_STRATEGY_SESSION,
+                          STOP_CLIENT_SESSION));
+  EXPECT_EQ(async_event_logger.GetDroppedEventCount(), 0);
+}
+
+TEST(AsyncEventLoggerTest, DoesNotBlockOnSlowLogger) {
+  FakeEventLogger event_logger(/*block=*/true);
+  AsyncEventLogger async_event_logger(&event_logger);
+
+  async_event_logger.Log(MakeEvent(START_CLIENT_SESSION));
+  event_logger.AwaitEntered();
+  // The logger is now blocked; logging more must still return immediately.
+  async_event_logger.Log(MakeEvent(ERROR_CODE));
+  async_event_logger.Log(MakeEvent(STOP_CLIENT_SESSION));
+  EXPECT_TRUE(event_logger.event_types().empty());
+
+  event_logger.Unblock();
+  async_event_logger.Flush();
+
+  EXPECT_THAT(event_logger.event_types(),
+              ElementsAre(START_CLIENT_SESSION, ERROR_CODE,
+                          STOP_CLIENT_SESSION));
+}
+
+TEST(AsyncEventLoggerTest, DropsOldestEventsWhenFull) {
+  FakeEventLogger event_logger(/*block=*/true);
+  AsyncEventLogger async_event_logger(&event_logger, /*max_queued_events=*/2);
+
+  async_event_logger.Log(MakeEvent(START_CLIENT_SESSION));
+  event_logger.AwaitEntered();
+  async_event_logger.Log(MakeEvent(START_STRATEGY_SESSION));
+  async_event_logger.Log(MakeEvent(ERROR_CODE));
+  async_event_logger.Log(MakeEvent(CLIENT_SESSION));
+  event_logger.Unblock();
+  async_event_logger.Flush();
+
+  EXPECT_THAT(event_logger.event_types(),
+              ElementsAre(START_CLIENT_SESSION, ERROR_CODE, CLIENT_SESSION));
+  EXPECT_EQ(async_event_logger.GetDroppedEventCount(), 1);
+}
+
+TEST(AsyncEventLoggerTest, FlushesOnDestruction) {
+  FakeEventLogger event_logger;
+  {
+    AsyncEventLogger async_event_logger(&event_logger);
+    async_event_logger.Log(MakeEvent(CLIENT_SESSION));
+    async_event_logger.Log(MakeEvent(STOP_CLIENT_SESSION));
+  }
+
+  EXPECT_THAT(event_logger.event_types(),
+              ElementsAre(CLIENT_SESSION, STOP_CLIENT_SESSION));
+}
+
+}  // namespace
+}  // namespace analytics
+}  // namespace nearby
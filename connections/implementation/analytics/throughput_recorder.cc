@@ -268,6 +268,8 @@ std::string ThroughputRecorder::ToString(PayloadType type) {
       return std::string("Stream");
     case PayloadType::kFile:
       return std::string("File");
+    case PayloadType::kFileBatch:
+      return std::string("FileBatch");
     case PayloadType::kUnknown:
       return std::string("Unknown");
   }
@@ -20,8 +20,13 @@
 #include <utility>
 
 #include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "connections/implementation/buffered_frame_reader.h"
+#include "connections/implementation/flags/nearby_connections_feature_flags.h"
 #include "connections/implementation/offline_frames.h"
+#include "internal/flags/nearby_flags.h"
 #include "internal/platform/byte_array.h"
+#include "internal/platform/byte_buffer_pool.h"
 #include "internal/platform/exception.h"
 #include "internal/platform/logging.h"
 #include "internal/platform/mutex.h"
@@ -99,7 +104,14 @@ BaseEndpointChannel::BaseEndpointChannel(
       technology_(technology),
       band_(band),
       frequency_(frequency),
-      try_count_(try_count) {}
+      try_count_(try_count) {
+  if (NearbyFlags::GetInstance().GetBoolFlag(
+          config_package_nearby::nearby_connections_feature::
+              kEnableBufferedFrameReader)) {
+    frame_reader_ =
+        std::make_unique<BufferedFrameReader>(reader_, kMaxAllowedReadBytes);
+  }
+}
 
 ExceptionOr<ByteArray> BaseEndpointChannel::Read() {
   PacketMetaData packet_meta_data;
@@ -113,24 +125,38 @@ ExceptionOr<ByteArray> BaseEndpointChannel::Read(
     MutexLock lock(&reader_mutex_);
 
     packet_meta_data.StartSocketIo();
-    ExceptionOr<std::int32_t> read_int = ReadInt(reader_);
-    if (!read_int.ok()) {
-      return ExceptionOr<ByteArray>(read_int.exception());
-    }
+    if (frame_reader_ != nullptr) {
+      ExceptionOr<absl::string_view> frame = frame_reader_->ReadFrame();
+      if (!frame.ok()) {
+        return ExceptionOr<ByteArray>(frame.exception());
+      }
+      packet_meta_data.StopSocketIo();
+      packet_meta_data.SetPacketSize(frame.result().size() +
+                                     sizeof(std::int32_t));
+      result =
+          ByteBufferPool::GetInstance().CopyOf(frame.result()).ToByteArray();
+    } else {
+      ExceptionOr<std::int32_t> read_int = ReadInt(reader_);
+      if (!read_int.ok()) {
+        return ExceptionOr<ByteArray>(read_int.exception());
+      }
 
-    if (read_int.result() < 0 || read_int.result() > kMaxAllowedReadBytes) {
-      NEARBY_LOGS(WARNING) << __func__ << ": Read an invalid number of bytes: "
-                           << read_int.result();
-      return ExceptionOr<ByteArray>(Exception::kIo);
-    }
+      if (read_int.result() < 0 || read_int.result() > kMaxAllowedReadBytes) {
+        NEARBY_LOGS(WARNING) << __func__
+                             << ": Read an invalid number of bytes: "
+                             << read_int.result();
+        return ExceptionOr<ByteArray>(Exception::kIo);
+      }
 
-    ExceptionOr<ByteArray> read_bytes = reader_->ReadExactly(read_int.result());
-    if (!read_bytes.ok()) {
-      return read_bytes;
+      ExceptionOr<ByteArray> read_bytes =
+          reader_->ReadExactly(read_int.result());
+      if (!read_bytes.ok()) {
+        return read_bytes;
+      }
+      packet_meta_data.StopSocketIo();
+      packet_meta_data.SetPacketSize(read_int.result() + sizeof(std::int32_t));
+      result = std::move(read_bytes.result());
     }
-    packet_meta_data.StopSocketIo();
-    packet_meta_data.SetPacketSize(read_int.result() + sizeof(std::int32_t));
-    result = std::move(read_bytes.result());
   }
 
   {
@@ -143,6 +169,7 @@ ExceptionOr<ByteArray> BaseEndpointChannel::Read(
           crypto_context_->DecodeMessageFromPeer(input);
       if (decrypted_data) {
         result = ByteArray(std::move(*decrypted_data));
+        ByteBufferPool::GetInstance().Release(std::move(input));
       } else {
         // It could be a protocol race, where remote party sends a KEEP_ALIVE
         // before encryption is setup on their side, and we receive it after
@@ -191,6 +218,12 @@ Exception BaseEndpointChannel::Write(const ByteArray& data) {
 
 Exception BaseEndpointChannel::Write(const ByteArray& data,
                                      PacketMetaData& packet_meta_data) {
+  return Write(data, packet_meta_data, FramePriority::kControl);
+}
+
+Exception BaseEndpointChannel::Write(const ByteArray& data,
+                                     PacketMetaData& packet_meta_data,
+                                     FramePriority priority) {
   {
     MutexLock pause_lock(&is_paused_mutex_);
     if (is_paused_) {
@@ -198,28 +231,32 @@ Exception BaseEndpointChannel::Write(const ByteArray& data,
     }
   }
 
-  ByteArray encrypted_data;
+  PooledByteArray encrypted_data{ByteArray()};
   const ByteArray* data_to_write = &data;
   {
     // Holding both mutexes is necessary to prevent the keep alive and payload
     // threads from writing encrypted messages out of order which causes a
     // failure to decrypt on the reader side. However we need to release the
     // crypto lock after encrypting to ensure read decryption is not blocked.
+    FrameScheduler::Turn turn(write_scheduler_, priority);
     MutexLock lock(&writer_mutex_);
     {
       MutexLock crypto_lock(&crypto_mutex_);
       if (IsEncryptionEnabledLocked()) {
         // If encryption is enabled, encode the message.
         packet_meta_data.StartEncryption();
+        ByteBufferPool& pool = ByteBufferPool::GetInstance();
+        std::string plaintext = pool.CopyOf(data.AsStringView()).ToString();
         std::unique_ptr<std::string> encrypted =
-            crypto_context_->EncodeMessageToPeer(std::string(data));
+            crypto_context_->EncodeMessageToPeer(plaintext);
+        pool.Release(std::move(plaintext));
         packet_meta_data.StopEncryption();
         if (!encrypted) {
           NEARBY_LOGS(WARNING) << __func__ << ": Failed to encrypt data.";
           return {Exception::kIo};
         }
-        encrypted_data = ByteArray(std::move(*encrypted));
-        data_to_write = &encrypted_data;
+        encrypted_data.get() = ByteArray(std::move(*encrypted));
+        data_to_write = &encrypted_data.get();
       }
     }
 
@@ -252,11 +289,14 @@ Exception BaseEndpointChannel::Write(const ByteArray& data,
     }
     packet_meta_data.StopSocketIo();
     packet_meta_data.SetPacketSize(data_size + sizeof(std::uint32_t));
+    turn.SetBytesWritten(packet_meta_data.GetPacketSize());
   }
-
   {
     MutexLock lock(&last_write_mutex_);
     last_write_timestamp_ = SystemClock::ElapsedRealtime();
+    bytes_written_ += packet_meta_data.GetPacketSize();
+    write_duration_ += packet_meta_data.socket_io_end_time -
+                       packet_meta_data.socket_io_start_time;
   }
   return {Exception::kSuccess};
 }
@@ -312,12 +352,28 @@ void BaseEndpointChannel::Close(
   NEARBY_LOGS(INFO) << __func__
                     << ": Closing endpoint channel, reason: " << reason;
   Close();
+  for (int i = 0; i < kFramePriorityCount; ++i) {
+    FrameScheduler::Metrics metrics =
+        write_scheduler_.GetMetrics(static_cast<FramePriority>(i));
+    if (metrics.frames_written == 0) continue;
+    NEARBY_LOGS(INFO) << __func__ << ": Frames of priority " << i << ": "
+                      << metrics.frames_written << " frames, "
+                      << metrics.bytes_written << " bytes, waited "
+                      << metrics.total_wait << " in total, "
+                      << metrics.max_wait << " at most, up to "
+                      << metrics.max_queue_length << " queued";
+  }
 
   if (analytics_recorder_ != nullptr && !endpoint_id_.empty()) {
     analytics_recorder_->OnConnectionClosed(endpoint_id_, GetMedium(), reason);
   }
 }
 
+FrameScheduler::Metrics BaseEndpointChannel::GetWriteMetrics(
+    FramePriority priority) const {
+  return write_scheduler_.GetMetrics(priority);
+}
+
 std::string BaseEndpointChannel::GetType() const {
   MutexLock crypto_lock(&crypto_mutex_);
   std::string subtype = IsEncryptionEnabledLocked() ? "ENCRYPTED_" : "";
@@ -397,6 +453,16 @@ absl::Time BaseEndpointChannel::GetLastWriteTimestamp() const {
   return last_write_timestamp_;
 }
 
+std::int64_t BaseEndpointChannel::GetBytesWritten() const {
+  MutexLock lock(&last_write_mutex_);
+  return bytes_written_;
+}
+
+absl::Duration BaseEndpointChannel::GetWriteDuration() const {
+  MutexLock lock(&last_write_mutex_);
+  return write_duration_;
+}
+
 location::nearby::proto::connections::ConnectionTechnology
 BaseEndpointChannel::GetTechnology() const {
   return technology_;
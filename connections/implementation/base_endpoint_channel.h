@@ -22,7 +22,9 @@
 #include "absl/base/thread_annotations.h"
 #include "connections/implementation/analytics/analytics_recorder.h"
 #include "connections/implementation/analytics/packet_meta_data.h"
+#include "connections/implementation/buffered_frame_reader.h"
 #include "connections/implementation/endpoint_channel.h"
+#include "connections/implementation/frame_scheduler.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/exception.h"
 #include "internal/platform/input_stream.h"
@@ -55,6 +57,9 @@ class BaseEndpointChannel : public EndpointChannel {
   Exception Write(const ByteArray& data) override;
   Exception Write(const ByteArray& data, PacketMetaData& packet_meta_data)
       ABSL_LOCKS_EXCLUDED(writer_mutex_, crypto_mutex_) override;
+  Exception Write(const ByteArray& data, PacketMetaData& packet_meta_data,
+                  FramePriority priority)
+      ABSL_LOCKS_EXCLUDED(writer_mutex_, crypto_mutex_) override;
   void Close() ABSL_LOCKS_EXCLUDED(is_paused_mutex_) override;
   void Close(location::nearby::proto::connections::DisconnectionReason reason)
       override;
@@ -78,9 +83,16 @@ class BaseEndpointChannel : public EndpointChannel {
       ABSL_LOCKS_EXCLUDED(last_read_mutex_) override;
   absl::Time GetLastWriteTimestamp() const
       ABSL_LOCKS_EXCLUDED(last_write_mutex_) override;
+  std::int64_t GetBytesWritten() const
+      ABSL_LOCKS_EXCLUDED(last_write_mutex_) override;
+  absl::Duration GetWriteDuration() const
+      ABSL_LOCKS_EXCLUDED(last_write_mutex_) override;
   void SetAnalyticsRecorder(analytics::AnalyticsRecorder* analytics_recorder,
                             const std::string& endpoint_id) override;
 
+  // Returns the queueing statistics of frames written with `priority`.
+  FrameScheduler::Metrics GetWriteMetrics(FramePriority priority) const;
+
  protected:
   virtual void CloseImpl() = 0;
   // For tests only.
@@ -110,6 +122,9 @@ class BaseEndpointChannel : public EndpointChannel {
   mutable Mutex last_write_mutex_;
   absl::Time last_write_timestamp_ ABSL_GUARDED_BY(last_write_mutex_) =
       absl::InfinitePast();
+  std::int64_t bytes_written_ ABSL_GUARDED_BY(last_write_mutex_) = 0;
+  absl::Duration write_duration_ ABSL_GUARDED_BY(last_write_mutex_) =
+      absl::ZeroDuration();
 
   const std::string service_id_;
   const std::string channel_name_;
@@ -118,7 +133,13 @@ class BaseEndpointChannel : public EndpointChannel {
   // writes waiting on reads that might potentially block forever.
   Mutex reader_mutex_;
   InputStream* reader_ ABSL_PT_GUARDED_BY(reader_mutex_);
+  // Non-null if kEnableBufferedFrameReader is set; wraps reader_.
+  std::unique_ptr<BufferedFrameReader> frame_reader_
+      ABSL_PT_GUARDED_BY(reader_mutex_);
 
+  // Orders concurrent writers by frame priority. A writer holds its turn
+  // before it takes writer_mutex_, so the mutex itself is never contended.
+  FrameScheduler write_scheduler_;
   Mutex writer_mutex_;
   OutputStream* writer_ ABSL_PT_GUARDED_BY(writer_mutex_);
 
@@ -31,7 +31,9 @@
 #include "connections/implementation/client_proxy.h"
 #include "connections/implementation/encryption_runner.h"
 #include "connections/implementation/endpoint_channel.h"
+#include "connections/implementation/flags/nearby_connections_feature_flags.h"
 #include "connections/implementation/offline_frames.h"
+#include "internal/flags/nearby_flags.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/count_down_latch.h"
 #include "internal/platform/exception.h"
@@ -181,6 +183,75 @@ TEST(BaseEndpointChannelTest, ReadWrite) {
   EXPECT_EQ(rx_message, tx_message);
 }
 
+TEST(BaseEndpointChannelTest, ReadWriteWithBufferedFrameReader) {
+  NearbyFlags::GetInstance().OverrideBoolFlagValue(
+      config_package_nearby::nearby_connections_feature::
+          kEnableBufferedFrameReader,
+      true);
+  auto pipe_a = CreatePipe();  // channel_a writes to pipe_a, reads from pipe_b.
+  auto pipe_b = CreatePipe();  // channel_b writes to pipe_b, reads from pipe_a.
+  TestEndpointChannel channel_a(pipe_b.first.get(), pipe_a.second.get());
+  TestEndpointChannel channel_b(pipe_a.first.get(), pipe_b.second.get());
+  ByteArray tx_message_1{"data message 1"};
+  ByteArray tx_message_2{"data message 2"};
+  ByteArray tx_message_3{std::string(kChunkSize, 'x')};
+  channel_a.Write(tx_message_1);
+  channel_a.Write(tx_message_2);
+  channel_a.Write(tx_message_3);
+  EXPECT_EQ(channel_b.Read().result(), tx_message_1);
+  EXPECT_EQ(channel_b.Read().result(), tx_message_2);
+  EXPECT_EQ(channel_b.Read().result(), tx_message_3);
+  NearbyFlags::GetInstance().ResetOverridedValues();
+}
+
+TEST(BaseEndpointChannelTest, CountsBytesWritten) {
+  auto pipe_a = CreatePipe();  // channel_a writes to pipe_a, reads from pipe_b.
+  auto pipe_b = CreatePipe();  // channel_b writes to pipe_b, reads from pipe_a.
+  TestEndpointChannel channel_a(pipe_b.first.get(), pipe_a.second.get());
+  TestEndpointChannel channel_b(pipe_a.first.get(), pipe_b.second.get());
+  ByteArray tx_message_1{"data message 1"};
+  ByteArray tx_message_2{"message 2"};
+
+  EXPECT_EQ(channel_a.GetBytesWritten(), 0);
+  channel_a.Write(tx_message_1);
+  channel_a.Write(tx_message_2);
+  EXPECT_EQ(channel_b.Read().result(), tx_message_1);
+  EXPECT_EQ(channel_b.Read().result(), tx_message_2);
+
+  // Each frame is prefixed with a 4-byte length.
+  EXPECT_EQ(channel_a.GetBytesWritten(),
+            tx_message_1.size() + tx_message_2.size() + 2 * 4);
+  EXPECT_GE(channel_a.GetWriteDuration(), absl::ZeroDuration());
+  EXPECT_EQ(channel_b.GetBytesWritten(), 0);
+}
+
+TEST(BaseEndpointChannelTest, CountsWritesPerPriority) {
+  auto pipe_a = CreatePipe();  // channel_a writes to pipe_a, reads from pipe_b.
+  auto pipe_b = CreatePipe();  // channel_b writes to pipe_b, reads from pipe_a.
+  TestEndpointChannel channel_a(pipe_b.first.get(), pipe_a.second.get());
+  TestEndpointChannel channel_b(pipe_a.first.get(), pipe_b.second.get());
+  ByteArray tx_message_1{"keep alive"};
+  ByteArray tx_message_2{"file chunk"};
+  PacketMetaData packet_meta_data;
+
+  channel_a.Write(tx_message_1, packet_meta_data, FramePriority::kKeepAlive);
+  channel_a.Write(tx_message_2, packet_meta_data, FramePriority::kBulkPayload);
+  channel_a.Write(tx_message_2, packet_meta_data, FramePriority::kBulkPayload);
+  EXPECT_EQ(channel_b.Read().result(), tx_message_1);
+  EXPECT_EQ(channel_b.Read().result(), tx_message_2);
+  EXPECT_EQ(channel_b.Read().result(), tx_message_2);
+
+  EXPECT_EQ(
+      channel_a.GetWriteMetrics(FramePriority::kKeepAlive).frames_written, 1);
+  EXPECT_EQ(channel_a.GetWriteMetrics(FramePriority::kKeepAlive).bytes_written,
+            tx_message_1.size() + 4);
+  EXPECT_EQ(
+      channel_a.GetWriteMetrics(FramePriority::kBulkPayload).frames_written,
+      2);
+  EXPECT_EQ(channel_a.GetWriteMetrics(FramePriority::kControl).frames_written,
+            0);
+}
+
 TEST(BaseEndpointChannelTest, ChannelUnencryptedByDefault) {
   auto pipe = CreatePipe();
   TestEndpointChannel channel(pipe.first.get(), pipe.second.get());
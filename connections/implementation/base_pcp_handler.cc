@@ -55,7 +55,24 @@ namespace nearby {
 namespace connections {
 
 namespace {
-constexpr int kEndpointCancelAlarmTimeout = 10;
+constexpr absl::Duration kEndpointCancelAlarmTimeout = absl::Seconds(10);
+constexpr absl::Duration kEndpointLostByMediumTick = absl::Milliseconds(500);
+// Enough slots for every alarm to expire within one turn of the wheel.
+constexpr size_t kEndpointLostByMediumWheelSlots = 32;
+
+BooleanMediumSelector ToMediumSelector(
+    const absl::flat_hash_set<Medium>& mediums) {
+  // Not using designated initializers here since the VS C++ compiler errors
+  // out indicating that MediumSelector<bool> is not an aggregate
+  BooleanMediumSelector mediumSelector{};
+  mediumSelector.bluetooth = mediums.contains(Medium::BLUETOOTH);
+  mediumSelector.ble = mediums.contains(Medium::BLE);
+  mediumSelector.web_rtc = mediums.contains(Medium::WEB_RTC);
+  mediumSelector.wifi_lan = mediums.contains(Medium::WIFI_LAN);
+  mediumSelector.wifi_hotspot = mediums.contains(Medium::WIFI_HOTSPOT);
+  mediumSelector.wifi_direct = mediums.contains(Medium::WIFI_DIRECT);
+  return mediumSelector;
+}
 }  // namespace
 
 using ::location::nearby::connections::ConnectionRequestFrame;
@@ -77,6 +94,7 @@ BasePcpHandler::BasePcpHandler(Mediums* mediums,
     : mediums_(mediums),
       endpoint_manager_(endpoint_manager),
       channel_manager_(channel_manager),
+      endpoint_lost_by_medium_wheel_(kEndpointLostByMediumWheelSlots),
       pcp_(pcp),
       bwu_manager_(bwu_manager) {}
 
@@ -314,7 +332,8 @@ BooleanMediumSelector BasePcpHandler::ComputeIntersectionOfSupportedMediums(
            "field, so use calculated default medium instead.";
   }
 
-  for (Medium my_medium : GetConnectionMediumsByPriority()) {
+  for (Medium my_medium : GetConnectionMediumsByPriority(
+           connection_info.connection_options.allowed)) {
     NEARBY_LOGS(INFO) << "Our supported medium name: "
                       << location::nearby::proto::connections::Medium_Name(
                              my_medium);
@@ -338,16 +357,7 @@ BooleanMediumSelector BasePcpHandler::ComputeIntersectionOfSupportedMediums(
     }
   }
 
-  // Not using designated initializers here since the VS C++ compiler errors
-  // out indicating that MediumSelector<bool> is not an aggregate
-  BooleanMediumSelector mediumSelector{};
-  mediumSelector.bluetooth = intersection.contains(Medium::BLUETOOTH);
-  mediumSelector.ble = intersection.contains(Medium::BLE);
-  mediumSelector.web_rtc = intersection.contains(Medium::WEB_RTC);
-  mediumSelector.wifi_lan = intersection.contains(Medium::WIFI_LAN);
-  mediumSelector.wifi_hotspot = intersection.contains(Medium::WIFI_HOTSPOT);
-  mediumSelector.wifi_direct = intersection.contains(Medium::WIFI_DIRECT);
-  return mediumSelector;
+  return ToMediumSelector(intersection);
 }
 
 Status BasePcpHandler::StartDiscovery(ClientProxy* client,
@@ -533,6 +543,16 @@ void BasePcpHandler::OnEncryptionSuccessRunnable(
       connection_options, std::move(connection_info.channel),
       connection_info.listener, connection_info.connection_token);
 
+  // Set up the upgrade medium while the user decides whether to accept, so the
+  // upgrade can start right away once the connection is accepted.
+  if (connection_info.is_incoming &&
+      connection_info.client->AutoUpgradeBandwidth() &&
+      NearbyFlags::GetInstance().GetBoolFlag(
+          config_package_nearby::nearby_connections_feature::
+              kEnableBwuPrewarm)) {
+    bwu_manager_->PrewarmBwuForEndpoint(connection_info.client, endpoint_id);
+  }
+
   if (auto future_status = connection_info.result.lock()) {
     NEARBY_LOGS(INFO) << "Connection established; Finalising future OK.";
     future_status->Set({Status::kSuccess});
@@ -776,15 +796,7 @@ bool BasePcpHandler::MediumSupportedByClientOptions(
 std::vector<location::nearby::proto::connections::Medium>
 BasePcpHandler::GetSupportedConnectionMediumsByPriority(
     const ConnectionOptions& local_connection_option) {
-  std::vector<location::nearby::proto::connections::Medium>
-      supported_mediums_by_priority;
-  for (auto medium_by_priority : GetConnectionMediumsByPriority()) {
-    if (MediumSupportedByClientOptions(medium_by_priority,
-                                       local_connection_option)) {
-      supported_mediums_by_priority.push_back(medium_by_priority);
-    }
-  }
-  return supported_mediums_by_priority;
+  return GetConnectionMediumsByPriority(local_connection_option.allowed);
 }
 
 void BasePcpHandler::StripOutUnavailableMediums(
@@ -897,25 +909,20 @@ std::string GetEndpointLostByMediumAlarmKey(absl::string_view endpoint_id,
 
 void BasePcpHandler::StartEndpointLostByMediumAlarms(
     ClientProxy* client, location::nearby::proto::connections::Medium medium) {
+  // A running tick alarm is already part way through the current tick, so
+  // round the timeout up by one tick; alarms may expire late, but never early.
+  bool is_ticking = endpoint_lost_by_medium_tick_alarm_ != nullptr;
+  int64_t ticks = kEndpointCancelAlarmTimeout / kEndpointLostByMediumTick +
+                  (is_ticking ? 1 : 0);
   auto discovered_endpoints_medium = GetDiscoveredEndpoints(medium);
   for (const auto discovered_endpoint : discovered_endpoints_medium) {
     std::string key = GetEndpointLostByMediumAlarmKey(
         discovered_endpoint->endpoint_id, medium);
-    StopEndpointLostByMediumAlarm(discovered_endpoint->endpoint_id, medium);
-    endpoint_lost_by_medium_alarms_.emplace(
-        key, std::make_unique<CancelableAlarm>(
-                 absl::StrCat("EndpointLostByMediumAlarm_", key),
-                 [this, discovered_endpoint, key, client]() {
-                   RunOnPcpHandlerThread(
-                       "endpoint-lost-by-medium-alarm",
-                       [this, client, discovered_endpoint,
-                        key]() RUN_ON_PCP_HANDLER_THREAD() {
-                         if (endpoint_lost_by_medium_alarms_.erase(key) != 0) {
-                           OnEndpointLost(client, *discovered_endpoint);
-                         }
-                       });
-                 },
-                 absl::Seconds(kEndpointCancelAlarmTimeout), &alarm_executor_));
+    endpoint_lost_by_medium_alarms_[key] = {client, discovered_endpoint};
+    endpoint_lost_by_medium_wheel_.Schedule(key, ticks);
+  }
+  if (!is_ticking && !endpoint_lost_by_medium_wheel_.empty()) {
+    ScheduleEndpointLostByMediumTick();
   }
 }
 
@@ -923,9 +930,36 @@ void BasePcpHandler::StopEndpointLostByMediumAlarm(
     absl::string_view endpoint_id,
     location::nearby::proto::connections::Medium medium) {
   std::string key = GetEndpointLostByMediumAlarmKey(endpoint_id, medium);
-  if (endpoint_lost_by_medium_alarms_.contains(key)) {
-    endpoint_lost_by_medium_alarms_[key]->Cancel();
-    endpoint_lost_by_medium_alarms_.erase(key);
+  if (endpoint_lost_by_medium_alarms_.erase(key) != 0) {
+    endpoint_lost_by_medium_wheel_.Cancel(key);
+  }
+}
+
+void BasePcpHandler::ScheduleEndpointLostByMediumTick() {
+  endpoint_lost_by_medium_tick_alarm_ = std::make_unique<CancelableAlarm>(
+      "EndpointLostByMediumAlarm",
+      [this]() {
+        RunOnPcpHandlerThread(
+            "endpoint-lost-by-medium-alarm",
+            [this]() RUN_ON_PCP_HANDLER_THREAD() {
+              OnEndpointLostByMediumTick();
+            });
+      },
+      kEndpointLostByMediumTick, &alarm_executor_);
+}
+
+void BasePcpHandler::OnEndpointLostByMediumTick() {
+  endpoint_lost_by_medium_tick_alarm_.reset();
+  for (const std::string& key : endpoint_lost_by_medium_wheel_.Advance()) {
+    auto it = endpoint_lost_by_medium_alarms_.find(key);
+    if (it == endpoint_lost_by_medium_alarms_.end()) continue;
+    EndpointLostByMediumAlarm alarm = it->second;
+    endpoint_lost_by_medium_alarms_.erase(it);
+    OnEndpointLost(alarm.client, *alarm.endpoint);
+  }
+  // Stop ticking once there's nothing left to expire.
+  if (!endpoint_lost_by_medium_wheel_.empty()) {
+    ScheduleEndpointLostByMediumTick();
   }
 }
 
@@ -1062,7 +1096,8 @@ Status BasePcpHandler::AcceptConnection(ClientProxy* client,
 
         Exception write_exception =
             channel->Write(parser::ForConnectionResponse(
-                Status::kSuccess, client->GetLocalOsInfo()));
+                Status::kSuccess, client->GetLocalOsInfo(),
+                client->SupportsPayloadCompression(endpoint_id)));
         if (!write_exception.Ok()) {
           NEARBY_LOGS(INFO)
               << "AcceptConnection: failed to send response: endpoint_id="
@@ -1205,6 +1240,14 @@ void BasePcpHandler::OnIncomingFrame(
         }
         channel_manager_->UpdateSafeToDisconnectForEndpoint(endpoint_id,
                          client->IsSafeToDisconnectEnabled(endpoint_id));
+        client->SetRemoteSupportsPayloadCompression(
+            endpoint_id,
+            std::find(connection_response.payload_compressions().begin(),
+                      connection_response.payload_compressions().end(),
+                      ConnectionResponseFrame::DEFLATE) !=
+                connection_response.payload_compressions().end());
+        client->SetRemoteSupportsFileBatches(
+            endpoint_id, connection_response.supports_file_batches());
         EvaluateConnectionResult(client, endpoint_id,
                                  /* can_close_immediately= */ true);
 
@@ -1407,8 +1450,10 @@ bool BasePcpHandler::NeedsToTurnOffDiscoveryMedium(
 bool BasePcpHandler::IsPreferred(
     const BasePcpHandler::DiscoveredEndpoint& new_endpoint,
     const BasePcpHandler::DiscoveredEndpoint& old_endpoint) {
+  // Only the two endpoints' mediums need ranking.
   std::vector<location::nearby::proto::connections::Medium> mediums =
-      GetConnectionMediumsByPriority();
+      GetConnectionMediumsByPriority(
+          ToMediumSelector({new_endpoint.medium, old_endpoint.medium}));
   // Make sure the comparator is irreflexive, so we have a strict weak ordering.
   if (new_endpoint.medium != old_endpoint.medium) {
     // As we iterate through the list of mediums, we see if we run into the new
@@ -32,6 +32,7 @@
 #include "connections/implementation/endpoint_channel_manager.h"
 #include "connections/implementation/endpoint_manager.h"
 #include "connections/implementation/mediums/mediums.h"
+#include "connections/implementation/mediums/timing_wheel.h"
 #include "connections/implementation/pcp.h"
 #include "connections/implementation/pcp_handler.h"
 #include "connections/listeners.h"
@@ -338,8 +339,11 @@ class BasePcpHandler : public PcpHandler,
       location::nearby::proto::connections::Medium medium,
       const DiscoveryOptions& old_options, const DiscoveryOptions& new_options);
 
+  // Returns the mediums in `allowed` that are available, in order of decreasing
+  // priority. Mediums that aren't allowed are not looked at, so this doesn't
+  // create mediums the client never asked for.
   virtual std::vector<location::nearby::proto::connections::Medium>
-  GetConnectionMediumsByPriority() = 0;
+  GetConnectionMediumsByPriority(const BooleanMediumSelector& allowed) = 0;
   virtual location::nearby::proto::connections::Medium
   GetDefaultUpgradeMedium() = 0;
 
@@ -369,6 +373,13 @@ class BasePcpHandler : public PcpHandler,
       location::nearby::proto::connections::Medium medium)
       RUN_ON_PCP_HANDLER_THREAD();
 
+  // Arms the alarm that moves endpoint_lost_by_medium_wheel_ forward by one
+  // tick.
+  void ScheduleEndpointLostByMediumTick() RUN_ON_PCP_HANDLER_THREAD();
+
+  // Reports the endpoints whose alarm expired on this tick as lost.
+  void OnEndpointLostByMediumTick() RUN_ON_PCP_HANDLER_THREAD();
+
   // Returns a vector of ConnectionInfos generated from a StartOperationResult.
   std::vector<ConnectionInfoVariant> GetConnectionInfoFromResult(
       absl::string_view service_id, StartOperationResult result);
@@ -605,10 +616,22 @@ class BasePcpHandler : public PcpHandler,
   // advertising.
   ConnectionListener advertising_listener_;
 
-  // Mapping from endpoint_id -> CancelableAlarm for triggering endpoint loss
-  // while discovery options are updated.
-  absl::flat_hash_map<std::string, std::unique_ptr<CancelableAlarm>>
+  struct EndpointLostByMediumAlarm {
+    ClientProxy* client;
+    DiscoveredEndpoint* endpoint;
+  };
+  // Mapping from <medium>_<endpoint_id> -> the endpoint to report as lost when
+  // its alarm expires, for triggering endpoint loss while discovery options
+  // are updated.
+  absl::flat_hash_map<std::string, EndpointLostByMediumAlarm>
       endpoint_lost_by_medium_alarms_ ABSL_GUARDED_BY(GetPcpHandlerThread());
+  // Expiry of the alarms above. A single ticking alarm drives the wheel,
+  // instead of one CancelableAlarm per endpoint, and only while it's not
+  // empty.
+  mediums::TimingWheel<std::string> endpoint_lost_by_medium_wheel_
+      ABSL_GUARDED_BY(GetPcpHandlerThread());
+  std::unique_ptr<CancelableAlarm> endpoint_lost_by_medium_tick_alarm_
+      ABSL_GUARDED_BY(GetPcpHandlerThread());
 
   Pcp pcp_;
   Strategy strategy_{PcpToStrategy(pcp_)};
@@ -223,12 +223,22 @@ class MockPcpHandler : public BasePcpHandler {
               (override));
 
   std::vector<location::nearby::proto::connections::Medium>
-  GetConnectionMediumsByPriority() override {
-    return std::vector<location::nearby::proto::connections::Medium>{
-        location::nearby::proto::connections::WIFI_LAN,
-        location::nearby::proto::connections::WEB_RTC,
-        location::nearby::proto::connections::BLUETOOTH,
-        location::nearby::proto::connections::BLE};
+  GetConnectionMediumsByPriority(
+      const BooleanMediumSelector& allowed) override {
+    std::vector<location::nearby::proto::connections::Medium> mediums;
+    if (allowed.wifi_lan) {
+      mediums.push_back(location::nearby::proto::connections::WIFI_LAN);
+    }
+    if (allowed.web_rtc) {
+      mediums.push_back(location::nearby::proto::connections::WEB_RTC);
+    }
+    if (allowed.bluetooth) {
+      mediums.push_back(location::nearby::proto::connections::BLUETOOTH);
+    }
+    if (allowed.ble) {
+      mediums.push_back(location::nearby::proto::connections::BLE);
+    }
+    return mediums;
   }
 
   // Mock adapters for protected non-virtual methods of a base class.
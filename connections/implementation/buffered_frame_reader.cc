@@ -0,0 +1,132 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "connections/implementation/buffered_frame_reader.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "absl/strings/string_view.h"
+#include "internal/platform/byte_array.h"
+#include "internal/platform/exception.h"
+#include "internal/platform/input_stream.h"
+#include "internal/platform/logging.h"
+
+namespace nearby {
+namespace connections {
+
+namespace {
+
+constexpr std::size_t kFrameLengthSize = sizeof(std::int32_t);
+
+std::int32_t BytesToInt(const char* int_bytes) {
+  std::int32_t result = 0;
+  result |= (static_cast<std::int32_t>(int_bytes[0]) & 0x0FF) << 24;
+  result |= (static_cast<std::int32_t>(int_bytes[1]) & 0x0FF) << 16;
+  result |= (static_cast<std::int32_t>(int_bytes[2]) & 0x0FF) << 8;
+  result |= (static_cast<std::int32_t>(int_bytes[3]) & 0x0FF);
+  return result;
+}
+
+}  // namespace
+
+BufferedFrameReader::BufferedFrameReader(InputStream* reader,
+                                         std::int32_t max_frame_size,
+                                         std::size_t block_size)
+    : reader_(reader),
+      max_frame_size_(max_frame_size),
+      block_size_(block_size > kFrameLengthSize ? block_size
+                                                : kFrameLengthSize) {
+  buffer_.resize(block_size_);
+}
+
+ExceptionOr<absl::string_view> BufferedFrameReader::ReadFrame() {
+  // A previous oversized frame may have grown the buffer; give the memory back
+  // once nothing is pending in it.
+  if (BufferedSize() == 0 && buffer_.size() > block_size_) {
+    buffer_.resize(block_size_);
+    buffer_.shrink_to_fit();
+    begin_ = end_ = 0;
+  }
+
+  Exception exception = Fill(kFrameLengthSize);
+  if (exception.Raised()) {
+    return exception;
+  }
+
+  std::int32_t frame_size = BytesToInt(buffer_.data() + begin_);
+  if (frame_size < 0 || frame_size > max_frame_size_) {
+    NEARBY_LOGS(WARNING) << __func__
+                         << ": Read an invalid number of bytes: " << frame_size;
+    return {Exception::kIo};
+  }
+
+  exception = Fill(kFrameLengthSize + frame_size);
+  if (exception.Raised()) {
+    return exception;
+  }
+
+  absl::string_view frame(buffer_.data() + begin_ + kFrameLengthSize,
+                          frame_size);
+  begin_ += kFrameLengthSize + frame_size;
+  if (begin_ == end_) {
+    begin_ = end_ = 0;
+  }
+  ++frame_count_;
+  return ExceptionOr<absl::string_view>(frame);
+}
+
+Exception BufferedFrameReader::Fill(std::size_t size) {
+  if (BufferedSize() >= size) {
+    return {Exception::kSuccess};
+  }
+
+  // Make room for `size` bytes after begin_: first by moving the pending
+  // bytes to the front of the buffer, then by growing it if still too small.
+  if (begin_ + size > buffer_.size()) {
+    if (begin_ > 0) {
+      std::memmove(buffer_.data(), buffer_.data() + begin_, BufferedSize());
+      end_ -= begin_;
+      begin_ = 0;
+    }
+    if (size > buffer_.size()) {
+      buffer_.resize(size);
+    }
+  }
+
+  while (BufferedSize() < size) {
+    ExceptionOr<ByteArray> read_bytes =
+        reader_->ReadAvailable(buffer_.size() - end_);
+    ++stream_read_count_;
+    if (!read_bytes.ok()) {
+      return read_bytes.GetException();
+    }
+    const ByteArray& block = read_bytes.result();
+    if (block.Empty()) {
+      // End of stream before a complete frame was read.
+      return {Exception::kIo};
+    }
+    if (block.size() > buffer_.size() - end_) {
+      // The stream returned more than requested; keep the extra bytes.
+      buffer_.resize(end_ + block.size());
+    }
+    std::memcpy(buffer_.data() + end_, block.data(), block.size());
+    end_ += block.size();
+  }
+  return {Exception::kSuccess};
+}
+
+}  // namespace connections
+}  // namespace nearby
@@ -0,0 +1,82 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_NEARBY_CONNECTIONS_IMPLEMENTATION_BUFFERED_FRAME_READER_H_
+#define THIRD_PARTY_NEARBY_CONNECTIONS_IMPLEMENTATION_BUFFERED_FRAME_READER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "internal/platform/exception.h"
+#include "internal/platform/input_stream.h"
+
+namespace nearby {
+namespace connections {
+
+// Reads length-prefixed frames (4-byte big-endian length followed by the frame
+// body) from an InputStream.
+//
+// Instead of issuing one read for the length and another for the body, the
+// reader pulls blocks of up to `block_size` bytes from the stream and carves
+// out as many complete frames as the block holds. Blocks are read with
+// InputStream::ReadAvailable(), which returns whatever is available rather
+// than blocking until the whole block has arrived.
+//
+// This class is not thread-safe; callers must serialize calls to ReadFrame().
+class BufferedFrameReader {
+ public:
+  static constexpr std::size_t kDefaultBlockSize = 64 * 1024;  // 64 KB
+
+  BufferedFrameReader(InputStream* reader, std::int32_t max_frame_size,
+                      std::size_t block_size = kDefaultBlockSize);
+  BufferedFrameReader(const BufferedFrameReader&) = delete;
+  BufferedFrameReader& operator=(const BufferedFrameReader&) = delete;
+
+  // Returns the body of the next frame as a view into the internal buffer.
+  // The view is only valid until the next call to ReadFrame().
+  // Returns Exception::kIo on stream error, end of stream, or if the frame
+  // length is negative or larger than `max_frame_size`.
+  ExceptionOr<absl::string_view> ReadFrame();
+
+  // Number of InputStream::ReadAvailable() calls issued so far.
+  std::int64_t GetStreamReadCount() const { return stream_read_count_; }
+
+  // Number of frames returned by ReadFrame() so far.
+  std::int64_t GetFrameCount() const { return frame_count_; }
+
+ private:
+  std::size_t BufferedSize() const { return end_ - begin_; }
+
+  // Reads from the stream until at least `size` bytes are buffered.
+  Exception Fill(std::size_t size);
+
+  InputStream* const reader_;
+  const std::int32_t max_frame_size_;
+  const std::size_t block_size_;
+
+  // Bytes in [begin_, end_) of buffer_ have been read but not yet consumed.
+  std::string buffer_;
+  std::size_t begin_ = 0;
+  std::size_t end_ = 0;
+
+  std::int64_t stream_read_count_ = 0;
+  std::int64_t frame_count_ = 0;
+};
+
+}  // namespace connections
+}  // namespace nearby
+
+#endif  // THIRD_PARTY_NEARBY_CONNECTIONS_IMPLEMENTATION_BUFFERED_FRAME_READER_H_
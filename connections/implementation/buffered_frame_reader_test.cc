@@ -0,0 +1,186 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "connections/implementation/buffered_frame_reader.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "absl/strings/string_view.h"
+#include "internal/platform/byte_array.h"
+#include "internal/platform/exception.h"
+#include "internal/platform/input_stream.h"
+
+namespace nearby {
+namespace connections {
+namespace {
+
+constexpr std::int32_t kMaxFrameSize = 1024 * 1024;
+
+// An InputStream over a fixed string that returns at most `max_read_size`
+// bytes per Read() and counts the calls, so tests can tell how many syscalls a
+// socket-backed stream would have issued.
+class CountingInputStream : public InputStream {
+ public:
+  explicit CountingInputStream(std::string data,
+                               std::size_t max_read_size = SIZE_MAX)
+      : data_(std::move(data)), max_read_size_(max_read_size) {}
+
+  ExceptionOr<ByteArray> Read(std::int64_t size) override {
+    ++read_count_;
+    if (closed_) return {Exception::kIo};
+    std::size_t length = std::min({static_cast<std::size_t>(size),
+                                   data_.size() - position_, max_read_size_});
+    ByteArray result(data_.data() + position_, length);
+    position_ += length;
+    return ExceptionOr<ByteArray>(std::move(result));
+  }
+
+  Exception Close() override {
+    closed_ = true;
+    return {Exception::kSuccess};
+  }
+
+  int read_count() const { return read_count_; }
+
+ private:
+  std::string data_;
+  std::size_t max_read_size_;
+  std::size_t position_ = 0;
+  int read_count_ = 0;
+  bool closed_ = false;
+};
+
+std::string EncodeFrame(absl::string_view body) {
+  std::int32_t size = static_cast<std::int32_t>(body.size());
+  std::string frame;
+  frame.push_back(static_cast<char>((size >> 24) & 0x0FF));
+  frame.push_back(static_cast<char>((size >> 16) & 0x0FF));
+  frame.push_back(static_cast<char>((size >> 8) & 0x0FF));
+  frame.push_back(static_cast<char>(size & 0x0FF));
+  frame.append(body.data(), body.size());
+  return frame;
+}
+
+TEST(BufferedFrameReaderTest, ReadsSingleFrame) {
+  CountingInputStream stream(EncodeFrame("hello"));
+  BufferedFrameReader reader(&stream, kMaxFrameSize);
+
+  ExceptionOr<absl::string_view> frame = reader.ReadFrame();
+
+  ASSERT_TRUE(frame.ok());
+  EXPECT_EQ(frame.result(), "hello");
+  EXPECT_EQ(reader.GetFrameCount(), 1);
+}
+
+TEST(BufferedFrameReaderTest, ReadsEmptyFrame) {
+  CountingInputStream stream(EncodeFrame("") + EncodeFrame("next"));
+  BufferedFrameReader reader(&stream, kMaxFrameSize);
+
+  ExceptionOr<absl::string_view> frame = reader.ReadFrame();
+  ASSERT_TRUE(frame.ok());
+  EXPECT_TRUE(frame.result().empty());
+  frame = reader.ReadFrame();
+  ASSERT_TRUE(frame.ok());
+  EXPECT_EQ(frame.result(), "next");
+}
+
+TEST(BufferedFrameReaderTest, CarvesManySmallFramesFromOneBlock) {
+  constexpr int kFrameCount = 100;
+  std::string data;
+  for (int i = 0; i < kFrameCount; ++i) {
+    data += EncodeFrame(std::string(16, static_cast<char>('a' + i % 26)));
+  }
+  CountingInputStream stream(data);
+  BufferedFrameReader reader(&stream, kMaxFrameSize);
+
+  for (int i = 0; i < kFrameCount; ++i) {
+    ExceptionOr<absl::string_view> frame = reader.ReadFrame();
+    ASSERT_TRUE(frame.ok());
+    EXPECT_EQ(frame.result(),
+              std::string(16, static_cast<char>('a' + i % 26)));
+  }
+
+  // The unbuffered path issues one read for the length and one for the body,
+  // i.e. 2 * kFrameCount reads; all 100 frames fit in a single 64 KB block.
+  EXPECT_EQ(stream.read_count(), 1);
+  EXPECT_EQ(reader.GetStreamReadCount(), 1);
+  EXPECT_EQ(reader.GetFrameCount(), kFrameCount);
+}
+
+TEST(BufferedFrameReaderTest, ReassemblesFramesSplitAcrossReads) {
+  std::string data = EncodeFrame("first frame") + EncodeFrame("second frame");
+  // Deliver one byte at a time to split both the length and the body.
+  CountingInputStream stream(data, /*max_read_size=*/1);
+  BufferedFrameReader reader(&stream, kMaxFrameSize);
+
+  ExceptionOr<absl::string_view> frame = reader.ReadFrame();
+  ASSERT_TRUE(frame.ok());
+  EXPECT_EQ(frame.result(), "first frame");
+  frame = reader.ReadFrame();
+  ASSERT_TRUE(frame.ok());
+  EXPECT_EQ(frame.result(), "second frame");
+}
+
+TEST(BufferedFrameReaderTest, ReadsFrameLargerThanBlock) {
+  std::string large(1000, 'x');
+  CountingInputStream stream(EncodeFrame(large) + EncodeFrame("small"));
+  BufferedFrameReader reader(&stream, kMaxFrameSize, /*block_size=*/64);
+
+  ExceptionOr<absl::string_view> frame = reader.ReadFrame();
+  ASSERT_TRUE(frame.ok());
+  EXPECT_EQ(frame.result(), large);
+  frame = reader.ReadFrame();
+  ASSERT_TRUE(frame.ok());
+  EXPECT_EQ(frame.result(), "small");
+}
+
+TEST(BufferedFrameReaderTest, FailsOnNegativeFrameSize) {
+  CountingInputStream stream(std::string("\xff\xff\xff\xff", 4));
+  BufferedFrameReader reader(&stream, kMaxFrameSize);
+
+  EXPECT_EQ(reader.ReadFrame().exception(), Exception::kIo);
+}
+
+TEST(BufferedFrameReaderTest, FailsOnOversizedFrame) {
+  CountingInputStream stream(EncodeFrame(std::string(100, 'x')));
+  BufferedFrameReader reader(&stream, /*max_frame_size=*/99);
+
+  EXPECT_EQ(reader.ReadFrame().exception(), Exception::kIo);
+}
+
+TEST(BufferedFrameReaderTest, FailsOnTruncatedFrame) {
+  std::string data = EncodeFrame("truncated");
+  data.resize(data.size() - 1);
+  CountingInputStream stream(data);
+  BufferedFrameReader reader(&stream, kMaxFrameSize);
+
+  EXPECT_EQ(reader.ReadFrame().exception(), Exception::kIo);
+}
+
+TEST(BufferedFrameReaderTest, FailsAfterStreamClosed) {
+  CountingInputStream stream(EncodeFrame("data"));
+  BufferedFrameReader reader(&stream, kMaxFrameSize);
+  stream.Close();
+
+  EXPECT_EQ(reader.ReadFrame().exception(), Exception::kIo);
+}
+
+}  // namespace
+}  // namespace connections
+}  // namespace nearby
@@ -26,6 +26,7 @@
 #include "connections/implementation/bwu_handler.h"
 #include "connections/implementation/client_proxy.h"
 #include "connections/implementation/endpoint_channel_manager.h"
+#include "connections/implementation/flags/nearby_connections_feature_flags.h"
 #include "connections/implementation/offline_frames.h"
 #include "connections/implementation/service_id_constants.h"
 #ifdef NO_WEBRTC
@@ -36,9 +37,11 @@
 #include "connections/implementation/wifi_direct_bwu_handler.h"
 #include "connections/implementation/wifi_hotspot_bwu_handler.h"
 #include "connections/implementation/wifi_lan_bwu_handler.h"
+#include "internal/flags/nearby_flags.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/count_down_latch.h"
 #include "internal/platform/feature_flags.h"
+#include "internal/platform/implementation/platform.h"
 #include "internal/platform/logging.h"
 
 namespace nearby {
@@ -52,6 +55,12 @@ using ::location::nearby::proto::connections::DisconnectionReason;
 // Required for C++ 14 support in Chrome
 constexpr absl::Duration BwuManager::kReadClientIntroductionFrameTimeout;
 
+namespace {
+// Directory, relative to the platform's app data path, in which the BWU medium
+// history is persisted.
+constexpr char kBwuPreferencesPath[] = "Google/Nearby/Connections";
+}  // namespace
+
 BwuManager::BwuManager(
     Mediums& mediums, EndpointManager& endpoint_manager,
     EndpointChannelManager& channel_manager,
@@ -87,10 +96,20 @@ BwuManager::BwuManager(
     config_.allow_upgrade_to.wifi_lan = true;
     config_.allow_upgrade_to.wifi_hotspot = true;
   }
-  if (!handlers.empty()) {
-    handlers_ = std::move(handlers);
-  } else {
-    InitBwuHandlers();
+  // Without handlers passed in, each handler is created the first time its
+  // medium is needed, so mediums that are never upgraded to stay untouched.
+  create_handlers_ = handlers.empty();
+  handlers_ = std::move(handlers);
+  if (NearbyFlags::GetInstance().GetBoolFlag(
+          config_package_nearby::nearby_connections_feature::
+              kEnableMeasuredBwuMediumSelection)) {
+#ifndef NEARBY_CHROMIUM
+    preferences_manager_ =
+        api::ImplementationPlatform::CreatePreferencesManager(
+            kBwuPreferencesPath);
+#endif
+    medium_history_ =
+        std::make_unique<BwuMediumHistory>(preferences_manager_.get());
   }
 
   // Register the offline frame processor.
@@ -103,42 +122,46 @@ BwuManager::~BwuManager() {
   Shutdown();
 }
 
-void BwuManager::InitBwuHandlers() {
-  // Register the supported concrete BwuMedium implementations.
-  if (config_.allow_upgrade_to.wifi_hotspot) {
-    handlers_.emplace(
-        Medium::WIFI_HOTSPOT,
-        std::make_unique<WifiHotspotBwuHandler>(
-            *mediums_,
-            absl::bind_front(&BwuManager::OnIncomingConnection, this)));
-  }
-  if (config_.allow_upgrade_to.wifi_direct) {
-    handlers_.emplace(
-        Medium::WIFI_DIRECT,
-        std::make_unique<WifiDirectBwuHandler>(
-            *mediums_,
-            absl::bind_front(&BwuManager::OnIncomingConnection, this)));
-  }
-  if (config_.allow_upgrade_to.wifi_lan) {
-    handlers_.emplace(
-        Medium::WIFI_LAN,
-        std::make_unique<WifiLanBwuHandler>(
-            *mediums_,
-            absl::bind_front(&BwuManager::OnIncomingConnection, this)));
-  }
-  if (config_.allow_upgrade_to.web_rtc) {
-    handlers_.emplace(
-        Medium::WEB_RTC,
-        std::make_unique<WebrtcBwuHandler>(
-            *mediums_,
-            absl::bind_front(&BwuManager::OnIncomingConnection, this)));
+bool BwuManager::IsUpgradeAllowed(Medium medium) const {
+  switch (medium) {
+    case Medium::WIFI_HOTSPOT:
+      return config_.allow_upgrade_to.wifi_hotspot;
+    case Medium::WIFI_DIRECT:
+      return config_.allow_upgrade_to.wifi_direct;
+    case Medium::WIFI_LAN:
+      return config_.allow_upgrade_to.wifi_lan;
+    case Medium::WEB_RTC:
+      return config_.allow_upgrade_to.web_rtc;
+    case Medium::BLUETOOTH:
+      return config_.allow_upgrade_to.bluetooth;
+    default:
+      return false;
   }
-  if (config_.allow_upgrade_to.bluetooth) {
-    handlers_.emplace(
-        Medium::BLUETOOTH,
-        std::make_unique<BluetoothBwuHandler>(
-            *mediums_,
-            absl::bind_front(&BwuManager::OnIncomingConnection, this)));
+}
+
+std::unique_ptr<BwuHandler> BwuManager::CreateBwuHandler(Medium medium) {
+  if (!IsUpgradeAllowed(medium)) return nullptr;
+  // Only the supported concrete BwuMedium implementations are created.
+  auto on_incoming_connection =
+      absl::bind_front(&BwuManager::OnIncomingConnection, this);
+  switch (medium) {
+    case Medium::WIFI_HOTSPOT:
+      return std::make_unique<WifiHotspotBwuHandler>(*mediums_,
+                                                     on_incoming_connection);
+    case Medium::WIFI_DIRECT:
+      return std::make_unique<WifiDirectBwuHandler>(*mediums_,
+                                                    on_incoming_connection);
+    case Medium::WIFI_LAN:
+      return std::make_unique<WifiLanBwuHandler>(*mediums_,
+                                                 on_incoming_connection);
+    case Medium::WEB_RTC:
+      return std::make_unique<WebrtcBwuHandler>(*mediums_,
+                                                on_incoming_connection);
+    case Medium::BLUETOOTH:
+      return std::make_unique<BluetoothBwuHandler>(*mediums_,
+                                                   on_incoming_connection);
+    default:
+      return nullptr;
   }
 }
 
@@ -167,6 +190,7 @@ void BwuManager::Shutdown() {
     medium_handler_pair.second->RevertInitiatorState();
   }
   handlers_.clear();
+  create_handlers_ = false;
 
   NEARBY_LOGS(INFO) << "BwuManager has shut down.";
 }
@@ -189,16 +213,16 @@ void BwuManager::ShutdownExecutors() {
 void BwuManager::InitiateBwuForEndpoint(ClientProxy* client,
                                         const std::string& endpoint_id,
                                         Medium new_medium) {
-  // Select the best medium if one is not provided.
-  Medium proposed_medium =
-      new_medium == Medium::UNKNOWN_MEDIUM
-          ? ChooseBestUpgradeMedium(
-                endpoint_id,
-                client->GetUpgradeMediums(endpoint_id).GetMediums(true))
-          : new_medium;
-
   RunOnBwuManagerThread("bwu-init", [this, client, endpoint_id,
-                                     proposed_medium]() {
+                                     new_medium]() {
+    // Select the best medium if one is not provided. This reads state that is
+    // only touched on this thread, so it can't happen before the hop.
+    Medium proposed_medium =
+        new_medium == Medium::UNKNOWN_MEDIUM
+            ? ChooseBestUpgradeMedium(
+                  endpoint_id,
+                  client->GetUpgradeMediums(endpoint_id).GetMediums(true))
+            : new_medium;
     NEARBY_LOGS(INFO) << "InitiateBwuForEndpoint for endpoint " << endpoint_id
                       << " with medium "
                       << location::nearby::proto::connections::Medium_Name(
@@ -271,8 +295,29 @@ void BwuManager::InitiateBwuForEndpoint(ClientProxy* client,
     }
 
     std::string service_id = channel->GetServiceId();
-    ByteArray bytes = handler->InitializeUpgradedMediumForEndpoint(
-        client, service_id, endpoint_id);
+    ByteArray bytes;
+    auto prewarmed = prewarmed_upgrade_paths_.extract(endpoint_id);
+    if (!prewarmed.empty() && prewarmed.mapped().medium == proposed_medium) {
+      NEARBY_LOGS(INFO) << "BwuManager is using the pre-warmed upgrade path "
+                           "for endpoint "
+                        << endpoint_id << ", saving "
+                        << absl::FormatDuration(
+                               prewarmed.mapped().setup_duration)
+                        << " of set up.";
+      bytes = std::move(prewarmed.mapped().upgrade_path_available);
+    } else {
+      if (!prewarmed.empty()) {
+        // A different medium was pre-warmed; tear it down.
+        BwuHandler* prewarmed_handler =
+            GetHandlerForMedium(prewarmed.mapped().medium);
+        if (prewarmed_handler) {
+          prewarmed_handler->RevertInitiatorState(
+              WrapInitiatorUpgradeServiceId(service_id), endpoint_id);
+        }
+      }
+      bytes = handler->InitializeUpgradedMediumForEndpoint(client, service_id,
+                                                           endpoint_id);
+    }
 
     // Because we grab the endpointChannel first thing, it is possible the
     // endpointChannel is stale by the time we attempt to write over it.
@@ -309,6 +354,62 @@ void BwuManager::InitiateBwuForEndpoint(ClientProxy* client,
         << endpoint_id << " to medium "
         << location::nearby::proto::connections::Medium_Name(proposed_medium);
     in_progress_upgrades_.emplace(endpoint_id, client);
+    upgrade_start_times_[endpoint_id] = SystemClock::ElapsedRealtime();
+  });
+}
+
+void BwuManager::PrewarmBwuForEndpoint(ClientProxy* client,
+                                       const std::string& endpoint_id,
+                                       Medium new_medium) {
+  RunOnBwuManagerThread("bwu-prewarm", [this, client, endpoint_id,
+                                        new_medium]() {
+    Medium proposed_medium =
+        new_medium == Medium::UNKNOWN_MEDIUM
+            ? ChooseBestUpgradeMedium(
+                  endpoint_id,
+                  client->GetUpgradeMediums(endpoint_id).GetMediums(true))
+            : new_medium;
+    if (proposed_medium == Medium::UNKNOWN_MEDIUM ||
+        in_progress_upgrades_.contains(endpoint_id) ||
+        prewarmed_upgrade_paths_.contains(endpoint_id)) {
+      return;
+    }
+    // Same restriction as in InitiateBwuForEndpoint().
+    if (channel_manager_->isWifiLanConnected() &&
+        proposed_medium == Medium::WIFI_HOTSPOT) {
+      return;
+    }
+    auto channel = channel_manager_->GetChannelForEndpoint(endpoint_id);
+    if (channel == nullptr || channel->GetMedium() == proposed_medium) {
+      return;
+    }
+    SetBwuMediumForEndpoint(endpoint_id, proposed_medium);
+    BwuHandler* handler = GetHandlerForMedium(proposed_medium);
+    if (!handler) return;
+
+    absl::Time start_time = SystemClock::ElapsedRealtime();
+    ByteArray bytes = handler->InitializeUpgradedMediumForEndpoint(
+        client, channel->GetServiceId(), endpoint_id);
+    if (bytes.Empty()) {
+      // InitiateBwuForEndpoint() will try again and handle the failure.
+      NEARBY_LOGS(WARNING)
+          << "BwuManager failed to pre-warm the upgrade for endpoint "
+          << endpoint_id << " to medium "
+          << location::nearby::proto::connections::Medium_Name(
+                 proposed_medium);
+      return;
+    }
+    absl::Duration setup_duration = SystemClock::ElapsedRealtime() - start_time;
+    NEARBY_LOGS(INFO) << "BwuManager pre-warmed the upgrade for endpoint "
+                      << endpoint_id << " to medium "
+                      << location::nearby::proto::connections::Medium_Name(
+                             proposed_medium)
+                      << " in " << absl::FormatDuration(setup_duration);
+    prewarmed_upgrade_paths_[endpoint_id] = {
+        .medium = proposed_medium,
+        .upgrade_path_available = std::move(bytes),
+        .setup_duration = setup_duration,
+    };
   });
 }
 
@@ -366,7 +467,10 @@ void BwuManager::OnEndpointDisconnect(ClientProxy* client,
         old_channel->Close(DisconnectionReason::SHUTDOWN);
       }
     }
+    RecordUpgradedChannelThroughput(endpoint_id);
+    prewarmed_upgrade_paths_.erase(endpoint_id);
     in_progress_upgrades_.erase(endpoint_id);
+    upgrade_start_times_.erase(endpoint_id);
     retry_delays_.erase(endpoint_id);
     CancelRetryUpgradeAlarm(endpoint_id);
     successfully_upgraded_endpoints_.erase(endpoint_id);
@@ -455,11 +559,21 @@ void BwuManager::SetBwuMediumForEndpoint(const std::string& endpoint_id,
   endpoint_id_to_bwu_medium_[endpoint_id] = medium;
 }
 
-BwuHandler* BwuManager::GetHandlerForMedium(Medium medium) const {
+bool BwuManager::CanHandleMedium(Medium medium) const {
+  return handlers_.contains(medium) ||
+         (create_handlers_ && IsUpgradeAllowed(medium));
+}
+
+BwuHandler* BwuManager::GetHandlerForMedium(Medium medium) {
   if (medium == Medium::UNKNOWN_MEDIUM) return nullptr;
 
   auto it = handlers_.find(medium);
-  if (it == handlers_.end()) return nullptr;
+  if (it == handlers_.end()) {
+    if (!create_handlers_) return nullptr;
+    std::unique_ptr<BwuHandler> handler = CreateBwuHandler(medium);
+    if (!handler) return nullptr;
+    it = handlers_.emplace(medium, std::move(handler)).first;
+  }
 
   return it->second.get();
 }
@@ -732,6 +846,7 @@ void BwuManager::ProcessBwuPathAvailableEvent(
       client->GetConnectionToken(endpoint_id));
 
   absl::Time connection_attempt_start_time = SystemClock::ElapsedRealtime();
+  upgrade_start_times_[endpoint_id] = connection_attempt_start_time;
   auto channel = ProcessBwuPathAvailableEventInternal(client, endpoint_id,
                                                       upgrade_path_info);
   location::nearby::proto::connections::ConnectionAttemptResult
@@ -892,6 +1007,8 @@ void BwuManager::RunUpgradeFailedProtocol(
                     << location::nearby::proto::connections::Medium_Name(
                            parser::UpgradePathInfoMediumToMedium(
                                upgrade_path_info.medium()));
+  RecordUpgradeFailure(endpoint_id, parser::UpgradePathInfoMediumToMedium(
+                                        upgrade_path_info.medium()));
   // We attempted to connect to the new medium that the remote device has set up
   // for us but we failed. We need to let the remote device know so that they
   // can pick another medium for us to try.
@@ -1155,6 +1272,7 @@ void BwuManager::ProcessSafeToClosePriorChannelEvent(
   }
 
   channel->Resume();
+  RecordUpgradeSuccess(endpoint_id, channel);
 
   // Report the success to the client
   client->OnBandwidthChanged(endpoint_id, channel->GetMedium());
@@ -1209,9 +1327,11 @@ void BwuManager::ProcessUpgradeFailureEvent(
   // Loop through the ordered list of upgrade mediums. One by one, remove the
   // top element until we get to the medium we last attempted to upgrade to. The
   // remainder of the list will contain the mediums we haven't attempted yet.
+  // The list is ranked before the failure is recorded, so that it is in the
+  // same order the failed medium was picked from.
   Medium last = parser::UpgradePathInfoMediumToMedium(upgrade_info.medium());
-  std::vector<Medium> all_possible_mediums =
-      client->GetUpgradeMediums(endpoint_id).GetMediums(true);
+  std::vector<Medium> all_possible_mediums = RankUpgradeMediums(
+      client->GetUpgradeMediums(endpoint_id).GetMediums(true));
   std::vector<Medium> untried_mediums(all_possible_mediums);
   for (Medium medium : all_possible_mediums) {
     untried_mediums.erase(untried_mediums.begin());
@@ -1219,6 +1339,7 @@ void BwuManager::ProcessUpgradeFailureEvent(
       break;
     }
   }
+  RecordUpgradeFailure(endpoint_id, last);
 
   TryNextBestUpgradeMediums(client, endpoint_id, untried_mediums);
 }
@@ -1268,11 +1389,11 @@ void BwuManager::TryNextBestUpgradeMediums(
 }
 
 std::vector<Medium> BwuManager::StripOutUnavailableMediums(
-    const std::vector<Medium>& mediums) const {
+    const std::vector<Medium>& mediums) {
   std::vector<Medium> available_mediums;
   for (Medium m : mediums) {
     bool available = false;
-    if (GetHandlerForMedium(m)) {
+    if (CanHandleMedium(m)) {
       switch (m) {
         case Medium::WIFI_LAN:
           available = mediums_->GetWifiLan().IsAvailable();
@@ -1311,15 +1432,16 @@ std::vector<Medium> BwuManager::StripOutUnavailableMediums(
 // connections (although it's suboptimal for bandwidth throughput). When all
 // endpoints disconnect, we reset the bandwidth upgrade medium.
 Medium BwuManager::ChooseBestUpgradeMedium(
-    const std::string& endpoint_id, const std::vector<Medium>& mediums) const {
+    const std::string& endpoint_id, const std::vector<Medium>& mediums) {
   auto available_mediums = StripOutUnavailableMediums(mediums);
   Medium current_medium = GetBwuMediumForEndpoint(endpoint_id);
   if (current_medium == Medium::UNKNOWN_MEDIUM) {
     if (!available_mediums.empty()) {
       // Case 1: This is our first time upgrading, and we have at least one
       // supported medium to choose from. Return the first medium in the list,
-      // since they are ordered by preference.
-      return available_mediums[0];
+      // since they are ordered by preference (or by measured performance, if
+      // medium history is enabled).
+      return RankUpgradeMediums(available_mediums)[0];
     }
     // Case 2: This is our first time upgrading, but there are no available
     // upgrade mediums. Fall through to returning UNKNOWN_MEDIUM at the
@@ -1356,6 +1478,38 @@ Medium BwuManager::ChooseBestUpgradeMedium(
   return Medium::UNKNOWN_MEDIUM;
 }
 
+std::vector<Medium> BwuManager::RankUpgradeMediums(
+    const std::vector<Medium>& mediums) const {
+  if (medium_history_ == nullptr) return mediums;
+  return medium_history_->RankMediums(mediums);
+}
+
+void BwuManager::RecordUpgradeSuccess(
+    const std::string& endpoint_id, std::shared_ptr<EndpointChannel> channel) {
+  auto item = upgrade_start_times_.extract(endpoint_id);
+  if (medium_history_ == nullptr || item.empty()) return;
+  medium_history_->RecordUpgradeSuccess(
+      channel->GetMedium(), SystemClock::ElapsedRealtime() - item.mapped());
+  upgraded_channels_[endpoint_id] = channel;
+}
+
+void BwuManager::RecordUpgradeFailure(const std::string& endpoint_id,
+                                      Medium medium) {
+  upgrade_start_times_.erase(endpoint_id);
+  if (medium_history_ == nullptr || medium == Medium::UNKNOWN_MEDIUM) return;
+  medium_history_->RecordUpgradeFailure(medium);
+}
+
+void BwuManager::RecordUpgradedChannelThroughput(
+    const std::string& endpoint_id) {
+  auto item = upgraded_channels_.extract(endpoint_id);
+  if (medium_history_ == nullptr || item.empty()) return;
+  std::shared_ptr<EndpointChannel> channel = std::move(item.mapped());
+  medium_history_->RecordThroughput(channel->GetMedium(),
+                                    channel->GetBytesWritten(),
+                                    channel->GetWriteDuration());
+}
+
 void BwuManager::RetryUpgradesAfterDelay(ClientProxy* client,
                                          const std::string& endpoint_id) {
   absl::Duration delay = CalculateNextRetryDelay(endpoint_id);
@@ -25,9 +25,11 @@
 #include "absl/container/flat_hash_set.h"
 #include "absl/time/time.h"
 #include "connections/implementation/bwu_handler.h"
+#include "connections/implementation/bwu_medium_history.h"
 #include "connections/implementation/client_proxy.h"
 #include "connections/implementation/endpoint_manager.h"
 #include "connections/implementation/mediums/mediums.h"
+#include "internal/platform/implementation/preferences_manager.h"
 #include "internal/platform/scheduled_executor.h"
 
 namespace nearby {
@@ -80,6 +82,17 @@ class BwuManager : public EndpointManager::FrameProcessor {
                               const std::string& endpoint_id,
                               Medium new_medium = Medium::UNKNOWN_MEDIUM);
 
+  // Sets up the best upgrade medium for an endpoint whose connection is still
+  // pending acceptance, so that the UPGRADE_PATH_AVAILABLE frame can be sent as
+  // soon as InitiateBwuForEndpoint() is called, without waiting for the medium
+  // to start listening. Nothing is sent to the remote device until then, since
+  // the prior EndpointChannel is not encrypted before acceptance. The set up is
+  // reverted if the endpoint disconnects first. If |new_medium| is not
+  // provided, the best available medium is chosen.
+  void PrewarmBwuForEndpoint(ClientProxy* client_proxy,
+                             const std::string& endpoint_id,
+                             Medium new_medium = Medium::UNKNOWN_MEDIUM);
+
   // == EndpointManager::FrameProcessor interface ==.
   // This is also an entry point for handling messages for both outbound and
   // inbound BWU protocol.
@@ -104,7 +117,7 @@ class BwuManager : public EndpointManager::FrameProcessor {
   void MakeSingleThreadedForTesting();
 
   // OnIncomingConnection is passed to the handlers during handler creation in
-  // InitBwuHandlers. When explicitly passing handlers into the BwuManager
+  // CreateBwuHandler. When explicitly passing handlers into the BwuManager
   // constructor, we need a way to invoke OnIncomingConnection.
   void InvokeOnIncomingConnectionForTesting(
       ClientProxy* client,
@@ -122,12 +135,27 @@ class BwuManager : public EndpointManager::FrameProcessor {
   static constexpr absl::Duration kReadClientIntroductionFrameTimeout =
       absl::Seconds(5);
 
-  void InitBwuHandlers();
+  // An upgrade path set up ahead of InitiateBwuForEndpoint().
+  struct PrewarmedUpgradePath {
+    Medium medium;
+    // Serialized UPGRADE_PATH_AVAILABLE frame.
+    ByteArray upgrade_path_available;
+    // How long the set up took, i.e. what pre-warming saves the upgrade.
+    absl::Duration setup_duration;
+  };
+
+  // Returns a handler for upgrading to `medium`, or nullptr if the medium isn't
+  // supported or allowed.
+  std::unique_ptr<BwuHandler> CreateBwuHandler(Medium medium);
+  // Returns whether the config allows upgrading to `medium`.
+  bool IsUpgradeAllowed(Medium medium) const;
   void RunOnBwuManagerThread(const std::string& name, Runnable runnable);
+  // @BwuHandlerThread
   std::vector<Medium> StripOutUnavailableMediums(
-      const std::vector<Medium>& mediums) const;
+      const std::vector<Medium>& mediums);
+  // @BwuHandlerThread
   Medium ChooseBestUpgradeMedium(const std::string& endpoint_id,
-                                 const std::vector<Medium>& mediums) const;
+                                 const std::vector<Medium>& mediums);
 
   // BaseBwuHandler
   using ClientIntroduction = BwuNegotiationFrame::ClientIntroduction;
@@ -149,7 +177,13 @@ class BwuManager : public EndpointManager::FrameProcessor {
   Medium GetBwuMediumForEndpoint(const std::string& endpoint_id) const;
   void SetBwuMediumForEndpoint(const std::string& endpoint_id, Medium medium);
 
-  BwuHandler* GetHandlerForMedium(Medium medium) const;
+  // Returns the handler for `medium`, creating it on first use.
+  // @BwuHandlerThread
+  BwuHandler* GetHandlerForMedium(Medium medium);
+  // Returns whether GetHandlerForMedium() would return a handler for
+  // `medium`, without creating one.
+  // @BwuHandlerThread
+  bool CanHandleMedium(Medium medium) const;
 
   // Common functionality to take an incoming connection and go through the
   // upgrade process. This is a callback, invoked by concrete handlers, once
@@ -192,6 +226,14 @@ class BwuManager : public EndpointManager::FrameProcessor {
   absl::Duration CalculateNextRetryDelay(const std::string& endpoint_id);
   void RetryUpgradesAfterDelay(ClientProxy* client,
                                const std::string& endpoint_id);
+  // Returns `mediums` ordered by measured performance if medium history is
+  // enabled, otherwise unchanged.
+  std::vector<Medium> RankUpgradeMediums(
+      const std::vector<Medium>& mediums) const;
+  void RecordUpgradeSuccess(const std::string& endpoint_id,
+                            std::shared_ptr<EndpointChannel> channel);
+  void RecordUpgradeFailure(const std::string& endpoint_id, Medium medium);
+  void RecordUpgradedChannelThroughput(const std::string& endpoint_id);
   void AttemptToRecordBandwidthUpgradeErrorForUnknownEndpoint(
       location::nearby::proto::connections::BandwidthUpgradeResult result,
       location::nearby::proto::connections::BandwidthUpgradeErrorStage
@@ -211,6 +253,8 @@ class BwuManager : public EndpointManager::FrameProcessor {
 
   Mediums* mediums_;
   absl::flat_hash_map<Medium, std::unique_ptr<BwuHandler>> handlers_;
+  // Whether handlers missing from `handlers_` are created on demand.
+  bool create_handlers_ = false;
 
   EndpointManager* endpoint_manager_;
   EndpointChannelManager* channel_manager_;
@@ -231,11 +275,27 @@ class BwuManager : public EndpointManager::FrameProcessor {
   absl::flat_hash_map<
       std::string, std::pair<std::unique_ptr<CancelableAlarm>, absl::Duration>>
       retry_upgrade_alarms_;
+  // Maps endpointId -> upgrade path set up by PrewarmBwuForEndpoint() that
+  // hasn't been sent yet.
+  absl::flat_hash_map<std::string, PrewarmedUpgradePath>
+      prewarmed_upgrade_paths_;
   // Maps endpointId -> duration of delay before bwu retry.
   // When bwu failed, retry_upgrade_alarms_ will clear the entry before the
   // retry happen, then we can not find the last delay used in the alarm. Thus
   // using a different map to keep track of the delays per endpoint.
   absl::flat_hash_map<std::string, absl::Duration> retry_delays_;
+
+  // Per-endpoint and per-medium upgrade history. Null unless the
+  // kEnableMeasuredBwuMediumSelection flag is enabled.
+  std::unique_ptr<api::PreferencesManager> preferences_manager_;
+  std::unique_ptr<BwuMediumHistory> medium_history_;
+  // Maps endpointId -> time the in-progress upgrade was started.
+  absl::flat_hash_map<std::string, absl::Time> upgrade_start_times_;
+  // Maps endpointId -> its upgraded EndpointChannel, whose write counters are
+  // recorded into medium_history_ when the endpoint disconnects. Only
+  // populated if medium_history_ is not null.
+  absl::flat_hash_map<std::string, std::shared_ptr<EndpointChannel>>
+      upgraded_channels_;
 };
 
 }  // namespace connections
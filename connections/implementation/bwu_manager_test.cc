@@ -919,6 +919,42 @@ TEST_F(BwuManagerTest, InitiateBwu_Revert_OnDisconnect_Wlan) {
   UnRegisterChannelForEndpoint(kEndpointId1);
 }
 
+TEST_F(BwuManagerTest, PrewarmBwu_InitiateReusesUpgradePath) {
+  CreateInitialEndpoint(kServiceIdA, kEndpointId1, Medium::BLUETOOTH);
+
+  bwu_manager_->PrewarmBwuForEndpoint(&client_, std::string(kEndpointId1),
+                                      Medium::WIFI_LAN);
+
+  // The medium is set up, but the upgrade hasn't started.
+  EXPECT_EQ(1u, fake_wifi_lan_bwu_handler_->handle_initialize_calls().size());
+  EXPECT_FALSE(bwu_manager_->IsUpgradeOngoing(std::string(kEndpointId1)));
+
+  bwu_manager_->InitiateBwuForEndpoint(&client_, std::string(kEndpointId1),
+                                       Medium::WIFI_LAN);
+
+  // The pre-warmed upgrade path is sent without setting up the medium again.
+  EXPECT_EQ(1u, fake_wifi_lan_bwu_handler_->handle_initialize_calls().size());
+  EXPECT_TRUE(bwu_manager_->IsUpgradeOngoing(std::string(kEndpointId1)));
+  UnRegisterChannelForEndpoint(kEndpointId1);
+}
+
+TEST_F(BwuManagerTest, PrewarmBwu_InitiateWithOtherMediumReverts) {
+  FeatureFlags::GetMutableFlagsForTesting().support_multiple_bwu_mediums = true;
+  CreateInitialEndpoint(kServiceIdA, kEndpointId1, Medium::BLUETOOTH);
+
+  bwu_manager_->PrewarmBwuForEndpoint(&client_, std::string(kEndpointId1),
+                                      Medium::WIFI_LAN);
+  bwu_manager_->InitiateBwuForEndpoint(&client_, std::string(kEndpointId1),
+                                       Medium::WEB_RTC);
+
+  ASSERT_EQ(1u, fake_wifi_lan_bwu_handler_->handle_revert_calls().size());
+  EXPECT_EQ(WrapInitiatorUpgradeServiceId(kServiceIdA),
+            fake_wifi_lan_bwu_handler_->handle_revert_calls()[0].service_id);
+  EXPECT_EQ(1u, fake_web_rtc_bwu_handler_->handle_initialize_calls().size());
+  EXPECT_TRUE(bwu_manager_->IsUpgradeOngoing(std::string(kEndpointId1)));
+  UnRegisterChannelForEndpoint(kEndpointId1);
+}
+
 TEST_F(BwuManagerTest, OnReceiveBwuEvent) {
   // TODO(b/235109434): Add more unit tests coverage for BWU module
 }
@@ -0,0 +1,268 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "connections/implementation/bwu_medium_history.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "nlohmann/json.hpp"
+#include "internal/platform/logging.h"
+#include "internal/platform/mutex_lock.h"
+
+namespace nearby {
+namespace connections {
+
+namespace {
+
+using json = ::nlohmann::json;
+using Medium = BwuMediumHistory::Medium;
+using MediumStats = BwuMediumHistory::MediumStats;
+
+// Weight of a new sample in the moving averages.
+constexpr double kMovingAverageWeight = 0.3;
+
+// Throughput samples smaller than this mostly measure latency, not bandwidth.
+constexpr std::int64_t kMinThroughputSampleBytes = 64 * 1024;
+
+// Used for mediums that have been attempted but never completed an upgrade.
+constexpr absl::Duration kDefaultSetupTime = absl::Seconds(5);
+
+// Used for mediums that have no throughput sample yet. These are rough
+// figures; they only matter until a real sample has been recorded.
+std::int64_t GetDefaultThroughputKbps(Medium medium) {
+  switch (medium) {
+    case Medium::BLUETOOTH:
+      return 150;
+    case Medium::WEB_RTC:
+      return 1000;
+    case Medium::WIFI_LAN:
+    case Medium::WIFI_HOTSPOT:
+    case Medium::WIFI_DIRECT:
+      return 10000;
+    default:
+      return 1000;
+  }
+}
+
+template <typename T>
+T MovingAverage(T average, T sample, bool has_average) {
+  if (!has_average) return sample;
+  return static_cast<T>(average + (sample - average) * kMovingAverageWeight);
+}
+
+constexpr char kAttemptsKey[] = "attempts";
+constexpr char kFailuresKey[] = "failures";
+constexpr char kSetupTimeMillisKey[] = "setup_ms";
+constexpr char kThroughputKey[] = "kbps";
+
+}  // namespace
+
+BwuMediumHistory::BwuMediumHistory(api::PreferencesManager* preferences_manager)
+    : preferences_manager_(preferences_manager) {
+  MutexLock lock(&mutex_);
+  LoadLocked();
+  if (preferences_manager_ != nullptr) {
+    save_executor_ = std::make_unique<ScheduledExecutor>();
+  }
+}
+
+BwuMediumHistory::~BwuMediumHistory() {
+  if (save_executor_ == nullptr) return;
+  save_executor_->Shutdown();
+  bool save_pending;
+  {
+    MutexLock lock(&mutex_);
+    save_pending = save_pending_;
+  }
+  if (save_pending) Save();
+}
+
+void BwuMediumHistory::RecordUpgradeSuccess(Medium medium,
+                                            absl::Duration setup_time) {
+  MutexLock lock(&mutex_);
+  UpdateLocked(medium, [setup_time](MediumStats& stats) {
+    bool has_setup_time = stats.setup_time > absl::ZeroDuration();
+    stats.attempts++;
+    stats.setup_time =
+        MovingAverage(stats.setup_time, setup_time, has_setup_time);
+  });
+}
+
+void BwuMediumHistory::RecordUpgradeFailure(Medium medium) {
+  MutexLock lock(&mutex_);
+  UpdateLocked(medium, [](MediumStats& stats) {
+    stats.attempts++;
+    stats.failures++;
+  });
+}
+
+void BwuMediumHistory::RecordThroughput(Medium medium, std::int64_t bytes,
+                                        absl::Duration io_time) {
+  if (bytes < kMinThroughputSampleBytes || io_time <= absl::ZeroDuration()) {
+    return;
+  }
+  std::int64_t throughput_kbps = static_cast<std::int64_t>(
+      bytes / 1024 / absl::ToDoubleSeconds(io_time));
+  MutexLock lock(&mutex_);
+  UpdateLocked(medium, [throughput_kbps](MediumStats& stats) {
+    stats.throughput_kbps = MovingAverage(
+        stats.throughput_kbps, throughput_kbps, stats.throughput_kbps > 0);
+  });
+}
+
+std::optional<MediumStats> BwuMediumHistory::GetStats(Medium medium) const {
+  MutexLock lock(&mutex_);
+  auto it = history_.find(medium);
+  if (it == history_.end()) return std::nullopt;
+  return it->second;
+}
+
+std::vector<Medium> BwuMediumHistory::RankMediums(
+    const std::vector<Medium>& mediums) const {
+  MutexLock lock(&mutex_);
+
+  // Mediums with history, paired with their expected cost and their position
+  // in the static preference order.
+  struct Candidate {
+    Medium medium;
+    double cost;
+    int preference;
+  };
+  std::vector<Candidate> measured;
+  for (int i = 0; i < static_cast<int>(mediums.size()); ++i) {
+    const MediumStats* stats = GetRankingStatsLocked(mediums[i]);
+    if (stats != nullptr) {
+      measured.push_back(
+          {mediums[i], ExpectedCostSeconds(mediums[i], *stats), i});
+    }
+  }
+  if (measured.empty()) return mediums;
+
+  std::stable_sort(measured.begin(), measured.end(),
+                   [](const Candidate& a, const Candidate& b) {
+                     return a.cost < b.cost;
+                   });
+  int best_measured_preference = measured.front().preference;
+
+  std::vector<Medium> ranked;
+  ranked.reserve(mediums.size());
+  // Probe unmeasured mediums that the static order ranks above the best
+  // measured one.
+  for (int i = 0; i < best_measured_preference; ++i) {
+    if (GetRankingStatsLocked(mediums[i]) == nullptr) {
+      ranked.push_back(mediums[i]);
+    }
+  }
+  for (const Candidate& candidate : measured) {
+    ranked.push_back(candidate.medium);
+  }
+  for (int i = best_measured_preference + 1;
+       i < static_cast<int>(mediums.size()); ++i) {
+    if (GetRankingStatsLocked(mediums[i]) == nullptr) {
+      ranked.push_back(mediums[i]);
+    }
+  }
+  return ranked;
+}
+
+const MediumStats* BwuMediumHistory::GetRankingStatsLocked(
+    Medium medium) const {
+  auto it = history_.find(medium);
+  if (it == history_.end() || it->second.attempts == 0) return nullptr;
+  return &it->second;
+}
+
+double BwuMediumHistory::ExpectedCostSeconds(Medium medium,
+                                             const MediumStats& stats) {
+  absl::Duration setup_time = stats.setup_time > absl::ZeroDuration()
+                                  ? stats.setup_time
+                                  : kDefaultSetupTime;
+  std::int64_t throughput_kbps = stats.throughput_kbps > 0
+                                     ? stats.throughput_kbps
+                                     : GetDefaultThroughputKbps(medium);
+  double transfer_seconds = static_cast<double>(kReferenceTransferBytes) /
+                            1024 / static_cast<double>(throughput_kbps);
+  // Laplace-smoothed success rate, so a single failure doesn't rule a medium
+  // out forever and a single success doesn't make it look perfect.
+  double success_rate = (stats.attempts - stats.failures + 1.0) /
+                        (stats.attempts + 2.0);
+  return (absl::ToDoubleSeconds(setup_time) + transfer_seconds) /
+         success_rate;
+}
+
+template <typename Update>
+void BwuMediumHistory::UpdateLocked(Medium medium, Update update) {
+  update(history_[medium]);
+  ScheduleSaveLocked();
+}
+
+void BwuMediumHistory::LoadLocked() {
+  if (preferences_manager_ == nullptr) return;
+  json history = preferences_manager_->Get(kPreferencesKey, json::object());
+  if (!history.is_object()) {
+    NEARBY_LOGS(WARNING) << "Ignoring malformed BWU medium history.";
+    return;
+  }
+  for (const auto& item : history.items()) {
+    const json& value = item.value();
+    int medium_number;
+    if (!absl::SimpleAtoi(item.key(), &medium_number) ||
+        !::location::nearby::proto::connections::Medium_IsValid(
+            medium_number) ||
+        !value.is_object()) {
+      continue;
+    }
+    MediumStats stats;
+    stats.attempts = value.value(kAttemptsKey, 0);
+    stats.failures = value.value(kFailuresKey, 0);
+    stats.setup_time =
+        absl::Milliseconds(value.value(kSetupTimeMillisKey, int64_t{0}));
+    stats.throughput_kbps = value.value(kThroughputKey, int64_t{0});
+    history_[static_cast<Medium>(medium_number)] = stats;
+  }
+}
+
+void BwuMediumHistory::ScheduleSaveLocked() {
+  if (save_executor_ == nullptr || save_pending_) return;
+  save_pending_ = true;
+  save_executor_->Schedule([this]() { Save(); }, kSaveDelay);
+}
+
+void BwuMediumHistory::Save() {
+  json history = json::object();
+  {
+    MutexLock lock(&mutex_);
+    save_pending_ = false;
+    for (const auto& [medium, stats] : history_) {
+      history[absl::StrCat(static_cast<int>(medium))] = {
+          {kAttemptsKey, stats.attempts},
+          {kFailuresKey, stats.failures},
+          {kSetupTimeMillisKey, absl::ToInt64Milliseconds(stats.setup_time)},
+          {kThroughputKey, stats.throughput_kbps},
+      };
+    }
+  }
+  preferences_manager_->Set(kPreferencesKey, history);
+}
+
+}  // namespace connections
+}  // namespace nearby
@@ -0,0 +1,140 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_NEARBY_CONNECTIONS_IMPLEMENTATION_BWU_MEDIUM_HISTORY_H_
+#define THIRD_PARTY_NEARBY_CONNECTIONS_IMPLEMENTATION_BWU_MEDIUM_HISTORY_H_
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "internal/platform/implementation/preferences_manager.h"
+#include "internal/platform/mutex.h"
+#include "internal/platform/scheduled_executor.h"
+#include "proto/connections_enums.pb.h"
+
+namespace nearby {
+namespace connections {
+
+// Records how each bandwidth upgrade medium performed on this device, and ranks
+// candidate upgrade mediums by that history.
+//
+// For every medium we keep the number of upgrade attempts and failures, a
+// moving average of the upgrade setup time and a moving average of the write
+// throughput achieved over the upgraded channel. History is aggregated over all
+// remote endpoints: endpoint IDs are random per session, so per-endpoint
+// history would never be matched again.
+//
+// If a PreferencesManager is provided, history is loaded from it on
+// construction. Updates are written back at most once per kSaveDelay on a
+// background thread, and any pending update is written on destruction, so
+// recording a sample never blocks on storage.
+//
+// This class is thread-safe.
+class BwuMediumHistory {
+ public:
+  using Medium = ::location::nearby::proto::connections::Medium;
+
+  struct MediumStats {
+    int attempts = 0;
+    int failures = 0;
+    // Moving average of the time from initiating the upgrade to the new channel
+    // being ready. Zero if no upgrade has succeeded yet.
+    absl::Duration setup_time = absl::ZeroDuration();
+    // Moving average of write throughput over the upgraded channel, in KB/s.
+    // Zero if no throughput sample has been recorded yet.
+    std::int64_t throughput_kbps = 0;
+  };
+
+  // Preferences key under which the history is persisted.
+  static constexpr absl::string_view kPreferencesKey =
+      "nearby_connections.bwu_medium_history";
+  // How long updates are batched before being written to preferences.
+  static constexpr absl::Duration kSaveDelay = absl::Seconds(10);
+  // Reference transfer size used to weigh setup time against throughput: a
+  // medium is better if it moves this many bytes sooner, setup included.
+  static constexpr std::int64_t kReferenceTransferBytes = 8 * 1024 * 1024;
+
+  // `preferences_manager` may be null, in which case history is kept in memory
+  // only. It must outlive this object.
+  explicit BwuMediumHistory(
+      api::PreferencesManager* preferences_manager = nullptr);
+  BwuMediumHistory(const BwuMediumHistory&) = delete;
+  BwuMediumHistory& operator=(const BwuMediumHistory&) = delete;
+  ~BwuMediumHistory();
+
+  // Records an upgrade to `medium` that completed after `setup_time`.
+  void RecordUpgradeSuccess(Medium medium, absl::Duration setup_time)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Records a failed upgrade attempt to `medium`.
+  void RecordUpgradeFailure(Medium medium) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Records that `bytes` were written over an upgraded `medium` channel while
+  // spending `io_time` in socket writes. Samples that are too small to be
+  // meaningful are ignored.
+  void RecordThroughput(Medium medium, std::int64_t bytes,
+                        absl::Duration io_time) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Returns the stats recorded for `medium`, if any.
+  std::optional<MediumStats> GetStats(Medium medium) const
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Returns `mediums`, which is ordered by static preference, reordered by
+  // measured performance.
+  //
+  // Mediums with history are ordered by the expected time to set up the
+  // upgrade and move kReferenceTransferBytes over it, scaled by their observed
+  // success rate. Mediums without any history are probed: those the static
+  // order prefers over the best measured medium are placed first, so that
+  // they get one chance to prove themselves; the rest are placed last. If no
+  // medium has history the static preference order is returned unchanged.
+  std::vector<Medium> RankMediums(const std::vector<Medium>& mediums) const
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  // Returns the stats used to rank `medium`, or null if it was never tried.
+  const MediumStats* GetRankingStatsLocked(Medium medium) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Returns the expected cost of upgrading to `medium` given `stats`, in
+  // seconds. Lower is better.
+  static double ExpectedCostSeconds(Medium medium, const MediumStats& stats);
+
+  template <typename Update>
+  void UpdateLocked(Medium medium, Update update)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void LoadLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Schedules a save on `save_executor_` unless one is already pending.
+  void ScheduleSaveLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Writes a snapshot of the history to preferences. The snapshot is taken
+  // under `mutex_`; the write happens outside of it.
+  void Save() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  api::PreferencesManager* const preferences_manager_;
+  mutable Mutex mutex_;
+  absl::flat_hash_map<Medium, MediumStats> history_ ABSL_GUARDED_BY(mutex_);
+  bool save_pending_ ABSL_GUARDED_BY(mutex_) = false;
+  // Only created if `preferences_manager_` is not null.
+  std::unique_ptr<ScheduledExecutor> save_executor_;
+};
+
+}  // namespace connections
+}  // namespace nearby
+
+#endif  // THIRD_PARTY_NEARBY_CONNECTIONS_IMPLEMENTATION_BWU_MEDIUM_HISTORY_H_
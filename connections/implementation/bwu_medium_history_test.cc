@@ -0,0 +1,143 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "connections/implementation/bwu_medium_history.h"
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/time/time.h"
+#include "internal/platform/implementation/platform.h"
+#include "internal/platform/implementation/preferences_manager.h"
+#include "proto/connections_enums.pb.h"
+
+namespace nearby {
+namespace connections {
+namespace {
+
+using ::location::nearby::proto::connections::Medium;
+using ::testing::ElementsAre;
+
+constexpr std::int64_t kMegabyte = 1024 * 1024;
+
+// Static preference order used by the BWU manager.
+const std::vector<Medium>& PreferenceOrder() {
+  static const auto* const kOrder = new std::vector<Medium>{
+      Medium::WIFI_HOTSPOT, Medium::WIFI_LAN, Medium::WIFI_DIRECT,
+      Medium::BLUETOOTH};
+  return *kOrder;
+}
+
+TEST(BwuMediumHistoryTest, KeepsPreferenceOrderWithoutHistory) {
+  BwuMediumHistory history;
+
+  EXPECT_EQ(history.RankMediums(PreferenceOrder()), PreferenceOrder());
+}
+
+TEST(BwuMediumHistoryTest, RecordsStats) {
+  BwuMediumHistory history;
+
+  history.RecordUpgradeSuccess(Medium::WIFI_LAN, absl::Seconds(2));
+  history.RecordUpgradeFailure(Medium::WIFI_LAN);
+  history.RecordThroughput(Medium::WIFI_LAN, 10 * kMegabyte, absl::Seconds(1));
+
+  std::optional<BwuMediumHistory::MediumStats> stats =
+      history.GetStats(Medium::WIFI_LAN);
+  ASSERT_TRUE(stats.has_value());
+  EXPECT_EQ(stats->attempts, 2);
+  EXPECT_EQ(stats->failures, 1);
+  EXPECT_EQ(stats->setup_time, absl::Seconds(2));
+  EXPECT_EQ(stats->throughput_kbps, 10 * 1024);
+  EXPECT_FALSE(history.GetStats(Medium::WIFI_HOTSPOT));
+}
+
+TEST(BwuMediumHistoryTest, IgnoresTinyThroughputSamples) {
+  BwuMediumHistory history;
+
+  history.RecordThroughput(Medium::WIFI_LAN, 100, absl::Milliseconds(1));
+
+  EXPECT_FALSE(history.GetStats(Medium::WIFI_LAN));
+}
+
+TEST(BwuMediumHistoryTest, PrefersFasterMediumOverStaticOrder) {
+  BwuMediumHistory history;
+  // Hotspot takes long to set up and is slow on this network; WiFi LAN is
+  // quick and fast.
+  history.RecordUpgradeSuccess(Medium::WIFI_HOTSPOT, absl::Seconds(8));
+  history.RecordThroughput(Medium::WIFI_HOTSPOT, 4 * kMegabyte,
+                           absl::Seconds(2));
+  history.RecordUpgradeSuccess(Medium::WIFI_LAN, absl::Seconds(1));
+  history.RecordThroughput(Medium::WIFI_LAN, 20 * kMegabyte, absl::Seconds(1));
+
+  std::vector<Medium> ranked = history.RankMediums(PreferenceOrder());
+
+  ASSERT_FALSE(ranked.empty());
+  EXPECT_EQ(ranked[0], Medium::WIFI_LAN);
+  EXPECT_EQ(ranked[1], Medium::WIFI_HOTSPOT);
+}
+
+TEST(BwuMediumHistoryTest, DemotesFailingMedium) {
+  BwuMediumHistory history;
+  for (int i = 0; i < 3; ++i) {
+    history.RecordUpgradeFailure(Medium::WIFI_HOTSPOT);
+  }
+  history.RecordUpgradeSuccess(Medium::WIFI_LAN, absl::Seconds(3));
+
+  std::vector<Medium> ranked = history.RankMediums(PreferenceOrder());
+
+  EXPECT_THAT(ranked, ElementsAre(Medium::WIFI_LAN, Medium::WIFI_HOTSPOT,
+                                  Medium::WIFI_DIRECT, Medium::BLUETOOTH));
+}
+
+TEST(BwuMediumHistoryTest, ProbesUnmeasuredMediumsPreferredOverBest) {
+  BwuMediumHistory history;
+  history.RecordUpgradeSuccess(Medium::WIFI_DIRECT, absl::Seconds(3));
+
+  std::vector<Medium> ranked = history.RankMediums(PreferenceOrder());
+
+  // Hotspot and LAN are preferred over Direct statically and have never been
+  // tried, so they are probed first; Bluetooth is not.
+  EXPECT_THAT(ranked, ElementsAre(Medium::WIFI_HOTSPOT, Medium::WIFI_LAN,
+                                  Medium::WIFI_DIRECT, Medium::BLUETOOTH));
+}
+
+TEST(BwuMediumHistoryTest, PersistsHistoryAcrossInstances) {
+  std::unique_ptr<api::PreferencesManager> preferences_manager =
+      api::ImplementationPlatform::CreatePreferencesManager(
+          "bwu_medium_history_test");
+  {
+    BwuMediumHistory history(preferences_manager.get());
+    history.RecordUpgradeSuccess(Medium::WIFI_LAN, absl::Seconds(2));
+    history.RecordUpgradeFailure(Medium::WIFI_HOTSPOT);
+    // The pending save is flushed on destruction.
+  }
+
+  BwuMediumHistory history(preferences_manager.get());
+
+  std::optional<BwuMediumHistory::MediumStats> stats =
+      history.GetStats(Medium::WIFI_LAN);
+  ASSERT_TRUE(stats.has_value());
+  EXPECT_EQ(stats->attempts, 1);
+  EXPECT_EQ(stats->setup_time, absl::Seconds(2));
+  stats = history.GetStats(Medium::WIFI_HOTSPOT);
+  ASSERT_TRUE(stats.has_value());
+  EXPECT_EQ(stats->failures, 1);
+}
+
+}  // namespace
+}  // namespace connections
+}  // namespace nearby
@@ -76,6 +76,12 @@ ClientProxy::ClientProxy(::nearby::analytics::EventLogger* event_logger)
   local_safe_to_disconnect_version_ = NearbyFlags::GetInstance().GetInt64Flag(
       config_package_nearby::nearby_connections_feature::
           kSafeToDisconnectVersion);
+  supports_payload_compression_ = NearbyFlags::GetInstance().GetBoolFlag(
+      config_package_nearby::nearby_connections_feature::
+          kEnablePayloadCompression);
+  supports_file_batches_ = NearbyFlags::GetInstance().GetBoolFlag(
+      config_package_nearby::nearby_connections_feature::
+          kEnableFileBatchPayloads);
 }
 
 ClientProxy::~ClientProxy() { Reset(); }
@@ -853,6 +859,52 @@ bool ClientProxy::IsPayloadReceivedAckEnabled(absl::string_view endpoint_id) {
               .min_nc_version_supports_payload_received_ack);
 }
 
+void ClientProxy::SetRemoteSupportsPayloadCompression(
+    absl::string_view endpoint_id, bool supports_payload_compression) {
+  MutexLock lock(&mutex_);
+
+  ConnectionPair* item = LookupConnection(endpoint_id);
+  if (item != nullptr) {
+    item->first.supports_payload_compression = supports_payload_compression;
+  }
+}
+
+bool ClientProxy::SupportsPayloadCompression(
+    absl::string_view endpoint_id) const {
+  if (!supports_payload_compression_) return false;
+  MutexLock lock(&mutex_);
+
+  const ConnectionPair* item = LookupConnection(endpoint_id);
+  return item != nullptr &&
+         item->first.connection_options.enable_payload_compression;
+}
+
+bool ClientProxy::IsPayloadCompressionEnabled(
+    absl::string_view endpoint_id) const {
+  MutexLock lock(&mutex_);
+
+  const ConnectionPair* item = LookupConnection(endpoint_id);
+  return item != nullptr && item->first.supports_payload_compression &&
+         SupportsPayloadCompression(endpoint_id);
+}
+
+void ClientProxy::SetRemoteSupportsFileBatches(absl::string_view endpoint_id,
+                                               bool supports_file_batches) {
+  MutexLock lock(&mutex_);
+
+  ConnectionPair* item = LookupConnection(endpoint_id);
+  if (item != nullptr) {
+    item->first.supports_file_batches = supports_file_batches;
+  }
+}
+
+bool ClientProxy::IsFileBatchEnabled(absl::string_view endpoint_id) const {
+  if (!supports_file_batches_) return false;
+  MutexLock lock(&mutex_);
+
+  const ConnectionPair* item = LookupConnection(endpoint_id);
+  return item != nullptr && item->first.supports_file_batches;
+}
 
 void ClientProxy::CancelAllEndpoints() {
   for (const auto& item : cancellation_flags_) {
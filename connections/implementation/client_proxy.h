@@ -281,6 +281,21 @@ class ClientProxy final {
   bool IsSafeToDisconnectEnabled(absl::string_view endpoint_id);
   bool IsPayloadReceivedAckEnabled(absl::string_view endpoint_id);
 
+  // Records whether the remote endpoint can decompress payload chunks.
+  void SetRemoteSupportsPayloadCompression(absl::string_view endpoint_id,
+                                           bool supports_payload_compression);
+  // Whether this side accepts compressed payload chunks from the endpoint,
+  // i.e. the feature is on and the connection's options allow it.
+  bool SupportsPayloadCompression(absl::string_view endpoint_id) const;
+  // Whether payload chunks sent to the endpoint may be compressed.
+  bool IsPayloadCompressionEnabled(absl::string_view endpoint_id) const;
+
+  // Records whether the remote endpoint can receive file batch payloads.
+  void SetRemoteSupportsFileBatches(absl::string_view endpoint_id,
+                                    bool supports_file_batches);
+  // Whether file batches may be sent to the endpoint as one transfer.
+  bool IsFileBatchEnabled(absl::string_view endpoint_id) const;
+
  private:
   struct Connection {
     // Status: may be either:
@@ -311,6 +326,8 @@ class ClientProxy final {
     std::string connection_token;
     std::optional<location::nearby::connections::OsInfo> os_info;
     std::int32_t safe_to_disconnect_version;
+    bool supports_payload_compression = false;
+    bool supports_file_batches = false;
   };
   using ConnectionPair = std::pair<Connection, PayloadListener>;
 
@@ -444,6 +461,8 @@ class ClientProxy final {
   std::unique_ptr<v3::ConnectionsDeviceProvider> connections_device_provider_;
   bool supports_safe_to_disconnect_;
   std::int32_t local_safe_to_disconnect_version_;
+  bool supports_payload_compression_;
+  bool supports_file_batches_;
 };
 
 }  // namespace connections
@@ -67,6 +67,8 @@ class MockEndpointChannel : public EndpointChannel {
   MOCK_METHOD(void, Resume, (), (override));
   MOCK_METHOD(absl::Time, GetLastReadTimestamp, (), (const override));
   MOCK_METHOD(absl::Time, GetLastWriteTimestamp, (), (const override));
+  MOCK_METHOD(std::int64_t, GetBytesWritten, (), (const override));
+  MOCK_METHOD(absl::Duration, GetWriteDuration, (), (const override));
   MOCK_METHOD(void, SetAnalyticsRecorder,
               (analytics::AnalyticsRecorder*, const std::string&), (override));
 
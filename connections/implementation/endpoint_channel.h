@@ -21,6 +21,7 @@
 #include "securegcm/d2d_connection_context_v1.h"
 #include "connections/implementation/analytics/analytics_recorder.h"
 #include "connections/implementation/analytics/packet_meta_data.h"
+#include "connections/implementation/frame_scheduler.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/exception.h"
 #include "internal/platform/mutex.h"
@@ -46,6 +47,14 @@ class EndpointChannel {
   virtual Exception Write(
       const ByteArray& data,
       PacketMetaData& packet_meta_data) = 0;  // throws Exception::IO
+
+  // Like Write(), but when several threads write at once, frames of a more
+  // urgent `priority` go first. Writes without a priority are kControl.
+  virtual Exception Write(const ByteArray& data,
+                          PacketMetaData& packet_meta_data,
+                          FramePriority priority) {  // throws Exception::IO
+    return Write(data, packet_meta_data);
+  }
   // Closes this EndpointChannel, without tracking the closure in analytics.
 
   virtual void Close() = 0;
@@ -117,6 +126,13 @@ class EndpointChannel {
   // writes have occurred.
   virtual absl::Time GetLastWriteTimestamp() const = 0;
 
+  // Returns the total number of bytes written to this endpoint, including
+  // framing and encryption overhead.
+  virtual std::int64_t GetBytesWritten() const = 0;
+
+  // Returns the total time spent blocked in socket writes to this endpoint.
+  virtual absl::Duration GetWriteDuration() const = 0;
+
   // Sets the AnalyticsRecorder instance for analytics.
   virtual void SetAnalyticsRecorder(
       analytics::AnalyticsRecorder* analytics_recorder,
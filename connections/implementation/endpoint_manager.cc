@@ -30,6 +30,7 @@
 #include "connections/implementation/payload_manager.h"
 #include "connections/implementation/proto/offline_wire_formats.pb.h"
 #include "connections/implementation/service_id_constants.h"
+#include "internal/platform/byte_buffer_pool.h"
 #include "internal/platform/count_down_latch.h"
 #include "internal/platform/exception.h"
 #include "internal/platform/logging.h"
@@ -220,6 +221,11 @@ ExceptionOr<bool> EndpointManager::HandleData(
   // super class will loop back around and try our luck in case there's been
   // a replacement for this endpoint since we last checked with the
   // EndpointChannelManager.
+  //
+  // Reads don't wait for the memory budget: acks, keep-alives and control
+  // messages must get through, and an incoming BYTES payload only frees its
+  // memory once the rest of it is read. Stream data that gets ahead of the
+  // client waits in its pipe instead.
   while (true) {
     PacketMetaData packet_meta_data;
     ExceptionOr<ByteArray> bytes = endpoint_channel->Read(packet_meta_data);
@@ -246,6 +252,8 @@ ExceptionOr<bool> EndpointManager::HandleData(
         wrapped_frame = std::move(decrypted);
       }
     }
+    // The frame has been parsed, so the read buffer can be reused.
+    ByteBufferPool::GetInstance().Release(std::move(bytes.result()));
     if (!wrapped_frame.ok()) {
       if (wrapped_frame.GetException().Raised(
               Exception::kInvalidProtocolBuffer)) {
@@ -369,7 +377,9 @@ ExceptionOr<bool> EndpointManager::HandleKeepAlive(
           : last_write_time + keep_alive_interval -
                 SystemClock::ElapsedRealtime();
   if (duration_until_write_keep_alive <= absl::ZeroDuration()) {
-    Exception write_exception = endpoint_channel->Write(parser::ForKeepAlive());
+    PacketMetaData packet_meta_data;
+    Exception write_exception = endpoint_channel->Write(
+        parser::ForKeepAlive(), packet_meta_data, FramePriority::kKeepAlive);
     if (!write_exception.Ok()) {
       return ExceptionOr<bool>(write_exception);
     }
@@ -637,15 +647,22 @@ std::vector<std::string> EndpointManager::SendPayloadChunk(
     const PayloadTransferFrame::PayloadChunk& payload_chunk,
     const std::vector<std::string>& endpoint_ids,
     PacketMetaData& packet_meta_data) {
-  ByteArray bytes =
-      parser::ForDataPayloadTransfer(payload_header, payload_chunk);
-
-  return SendTransferFrameBytes(
-      endpoint_ids, bytes, payload_header.id(),
+  PooledByteArray bytes(
+      parser::ForDataPayloadTransfer(payload_header, payload_chunk));
+
+  // Chunks of BYTES payloads are small and often awaited, so they go ahead of
+  // file and stream chunks queued on the same channel.
+  FramePriority priority =
+      payload_header.type() == PayloadTransferFrame::PayloadHeader::BYTES
+          ? FramePriority::kBytesPayload
+          : FramePriority::kBulkPayload;
+  std::vector<std::string> failed_endpoint_ids = SendTransferFrameBytes(
+      endpoint_ids, bytes.get(), payload_header.id(),
       /*offset=*/payload_chunk.offset(),
       /*packet_type=*/
       PayloadTransferFrame::PacketType_Name(PayloadTransferFrame::DATA),
-      packet_meta_data);
+      priority, packet_meta_data);
+  return failed_endpoint_ids;
 }
 
 // Designed to run asynchronously. It is called from IO thread pools, and
@@ -720,7 +737,7 @@ std::vector<std::string> EndpointManager::SendControlMessage(
       /*offset=*/control.offset(),
       /*packet_type=*/
       PayloadTransferFrame::PacketType_Name(PayloadTransferFrame::CONTROL),
-      packet_meta_data);
+      FramePriority::kControl, packet_meta_data);
 }
 
 // @EndpointManagerThread
@@ -887,7 +904,8 @@ CountDownLatch EndpointManager::NotifyFrameProcessorsOnEndpointDisconnect(
 std::vector<std::string> EndpointManager::SendTransferFrameBytes(
     const std::vector<std::string>& endpoint_ids, const ByteArray& bytes,
     std::int64_t payload_id, std::int64_t offset,
-    const std::string& packet_type, PacketMetaData& packet_meta_data) {
+    const std::string& packet_type, FramePriority priority,
+    PacketMetaData& packet_meta_data) {
   std::vector<std::string> failed_endpoint_ids;
   for (const std::string& endpoint_id : endpoint_ids) {
     std::shared_ptr<EndpointChannel> channel =
@@ -907,7 +925,8 @@ std::vector<std::string> EndpointManager::SendTransferFrameBytes(
       continue;
     }
 
-    Exception write_exception = channel->Write(bytes, packet_meta_data);
+    Exception write_exception =
+        channel->Write(bytes, packet_meta_data, priority);
     if (!write_exception.Ok()) {
       failed_endpoint_ids.push_back(endpoint_id);
       NEARBY_LOGS(INFO) << "Failed to send packet; endpoint_id=" << endpoint_id;
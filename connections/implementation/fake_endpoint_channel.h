@@ -86,6 +86,10 @@ class FakeEndpointChannel : public EndpointChannel {
   void Resume() override { is_paused_ = false; }
   absl::Time GetLastReadTimestamp() const override { return read_timestamp_; }
   absl::Time GetLastWriteTimestamp() const override { return write_timestamp_; }
+  std::int64_t GetBytesWritten() const override { return 0; }
+  absl::Duration GetWriteDuration() const override {
+    return absl::ZeroDuration();
+  }
   void SetAnalyticsRecorder(analytics::AnalyticsRecorder* analytics_recorder,
                             const std::string& endpoint_id) override {}
 
@@ -58,6 +58,46 @@ constexpr auto kEnablePayloadReceivedAck =
 constexpr auto kSafeToDisconnectVersion =
     flags::Flag<int64_t>(kConfigPackage, "45425841", 0);
 
+// Enable/Disable reading endpoint channel frames through a block-buffered
+// reader instead of one length read plus one body read per frame.
+constexpr auto kEnableBufferedFrameReader =
+    flags::Flag<bool>(kConfigPackage, "45426431", false);
+
+// Enable/Disable ranking bandwidth upgrade mediums by their measured setup
+// time, throughput and success rate instead of the static preference order.
+constexpr auto kEnableMeasuredBwuMediumSelection =
+    flags::Flag<bool>(kConfigPackage, "45426432", false);
+
+// Enable/Disable setting up the bandwidth upgrade medium while an incoming
+// connection is still pending acceptance.
+constexpr auto kEnableBwuPrewarm =
+    flags::Flag<bool>(kConfigPackage, "45426433", false);
+
+// Enable/Disable starting the mediums of different radios at the same time
+// when advertising or discovery starts.
+constexpr auto kEnableParallelMediumStartup =
+    flags::Flag<bool>(kConfigPackage, "45426434", false);
+
+// Enable/Disable compressing BYTES and FILE payload chunks sent to endpoints
+// that can decompress them.
+constexpr auto kEnablePayloadCompression =
+    flags::Flag<bool>(kConfigPackage, "45426435", false);
+
+// Enable/Disable sending file batch payloads as one transfer to endpoints that
+// can receive them. When disabled, their files are sent one by one.
+constexpr auto kEnableFileBatchPayloads =
+    flags::Flag<bool>(kConfigPackage, "45426436", false);
+
+// The most memory, in bytes, that in-flight payload data may take up before
+// file sends and pipe writes are paused. 0 means no limit.
+constexpr auto kMemoryBudgetBytes =
+    flags::Flag<int64_t>(kConfigPackage, "45426437", 0);
+
+// Enable/Disable creating all mediums on a background thread as soon as Core
+// starts, rather than each on its first use.
+constexpr auto kEnableMediumPrewarm =
+    flags::Flag<bool>(kConfigPackage, "45426438", false);
+
 }  // namespace nearby_connections_feature
 }  // namespace config_package_nearby
 }  // namespace connections
@@ -0,0 +1,85 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "connections/implementation/frame_scheduler.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/time/time.h"
+#include "internal/platform/mutex_lock.h"
+#include "internal/platform/system_clock.h"
+
+namespace nearby {
+namespace connections {
+
+FrameScheduler::Turn::Turn(FrameScheduler& scheduler, FramePriority priority)
+    : scheduler_(scheduler), priority_(priority) {
+  scheduler_.Acquire(priority_);
+}
+
+FrameScheduler::Turn::~Turn() { scheduler_.Release(priority_, bytes_written_); }
+
+FrameScheduler::Metrics FrameScheduler::GetMetrics(
+    FramePriority priority) const {
+  MutexLock lock(&mutex_);
+  return queues_[static_cast<int>(priority)].metrics;
+}
+
+void FrameScheduler::Acquire(FramePriority priority) {
+  absl::Time start_time = SystemClock::ElapsedRealtime();
+  MutexLock lock(&mutex_);
+  Queue& queue = queues_[static_cast<int>(priority)];
+  std::uint64_t ticket = queue.next_ticket++;
+  queue.metrics.queue_length++;
+  queue.metrics.max_queue_length =
+      std::max(queue.metrics.max_queue_length, queue.metrics.queue_length);
+
+  while (is_busy_ || ticket != queue.serving_ticket ||
+         HasMoreUrgentWaiters(priority)) {
+    // Interruptions are ignored; the turn comes once the writer ahead is done.
+    turn_done_.Wait();
+  }
+
+  is_busy_ = true;
+  queue.serving_ticket++;
+  queue.metrics.queue_length--;
+  absl::Duration wait = SystemClock::ElapsedRealtime() - start_time;
+  queue.metrics.total_wait += wait;
+  queue.metrics.max_wait = std::max(queue.metrics.max_wait, wait);
+}
+
+void FrameScheduler::Release(FramePriority priority,
+                             std::size_t bytes_written) {
+  MutexLock lock(&mutex_);
+  // Failed writes wrote nothing and don't count.
+  if (bytes_written > 0) {
+    Metrics& metrics = queues_[static_cast<int>(priority)].metrics;
+    metrics.frames_written++;
+    metrics.bytes_written += bytes_written;
+  }
+  is_busy_ = false;
+  turn_done_.Notify();
+}
+
+bool FrameScheduler::HasMoreUrgentWaiters(FramePriority priority) const {
+  for (int i = 0; i < static_cast<int>(priority); ++i) {
+    if (queues_[i].metrics.queue_length > 0) return true;
+  }
+  return false;
+}
+
+}  // namespace connections
+}  // namespace nearby
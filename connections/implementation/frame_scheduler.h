@@ -0,0 +1,104 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CORE_INTERNAL_FRAME_SCHEDULER_H_
+#define CORE_INTERNAL_FRAME_SCHEDULER_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/time/time.h"
+#include "internal/platform/condition_variable.h"
+#include "internal/platform/mutex.h"
+
+namespace nearby {
+namespace connections {
+
+// Priority classes of outgoing frames, from most to least urgent.
+enum class FramePriority {
+  // Connection setup, bandwidth upgrade, disconnection and payload control
+  // frames.
+  kControl = 0,
+  kKeepAlive = 1,
+  // Chunks of BYTES payloads, which are small and usually awaited.
+  kBytesPayload = 2,
+  // Chunks of FILE and STREAM payloads.
+  kBulkPayload = 3,
+};
+
+inline constexpr int kFramePriorityCount = 4;
+
+// Decides which of the threads writing to a channel at the same time writes
+// next. Frames are written one at a time and never interleaved, but when a
+// frame is done, the oldest waiting frame of the most urgent class goes next.
+// So a keep-alive waits for at most one chunk of a file, rather than for
+// every chunk whose thread happened to grab the lock first.
+class FrameScheduler {
+ public:
+  struct Metrics {
+    std::int64_t frames_written = 0;
+    std::int64_t bytes_written = 0;
+    // Time frames spent waiting for their turn.
+    absl::Duration total_wait = absl::ZeroDuration();
+    absl::Duration max_wait = absl::ZeroDuration();
+    // Frames waiting right now, and the most that ever waited at once.
+    int queue_length = 0;
+    int max_queue_length = 0;
+  };
+
+  // Holds the right to write one frame, from construction until destruction.
+  class Turn {
+   public:
+    Turn(FrameScheduler& scheduler, FramePriority priority);
+    ~Turn();
+    Turn(const Turn&) = delete;
+    Turn& operator=(const Turn&) = delete;
+
+    // Counts `size` bytes as written in this turn.
+    void SetBytesWritten(std::size_t size) { bytes_written_ = size; }
+
+   private:
+    FrameScheduler& scheduler_;
+    const FramePriority priority_;
+    std::size_t bytes_written_ = 0;
+  };
+
+  Metrics GetMetrics(FramePriority priority) const ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  struct Queue {
+    // Tickets hand out turns in arrival order within a class.
+    std::uint64_t next_ticket = 0;
+    std::uint64_t serving_ticket = 0;
+    Metrics metrics;
+  };
+
+  void Acquire(FramePriority priority) ABSL_LOCKS_EXCLUDED(mutex_);
+  void Release(FramePriority priority, std::size_t bytes_written)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+  bool HasMoreUrgentWaiters(FramePriority priority) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  mutable Mutex mutex_;
+  ConditionVariable turn_done_{&mutex_};
+  bool is_busy_ ABSL_GUARDED_BY(mutex_) = false;
+  std::array<Queue, kFramePriorityCount> queues_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace connections
+}  // namespace nearby
+
+#endif  // CORE_INTERNAL_FRAME_SCHEDULER_H_
@@ -0,0 +1,133 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "connections/implementation/frame_scheduler.h"
+
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace nearby {
+namespace connections {
+namespace {
+
+using ::testing::ElementsAre;
+
+// Blocks until `count` frames of `priority` wait for their turn.
+void AwaitQueueLength(const FrameScheduler& scheduler, FramePriority priority,
+                      int count) {
+  while (scheduler.GetMetrics(priority).queue_length < count) {
+    absl::SleepFor(absl::Milliseconds(1));
+  }
+}
+
+// Records the order in which writers got their turn.
+class WriteLog {
+ public:
+  void Add(int writer) {
+    absl::MutexLock lock(&mutex_);
+    writers_.push_back(writer);
+  }
+  std::vector<int> Get() {
+    absl::MutexLock lock(&mutex_);
+    return writers_;
+  }
+
+ private:
+  absl::Mutex mutex_;
+  std::vector<int> writers_;
+};
+
+TEST(FrameSchedulerTest, CountsFrames) {
+  FrameScheduler scheduler;
+
+  {
+    FrameScheduler::Turn turn(scheduler, FramePriority::kBytesPayload);
+    turn.SetBytesWritten(100);
+  }
+  {
+    FrameScheduler::Turn turn(scheduler, FramePriority::kBytesPayload);
+    turn.SetBytesWritten(50);
+  }
+  // Failed writes don't count.
+  { FrameScheduler::Turn turn(scheduler, FramePriority::kBytesPayload); }
+
+  FrameScheduler::Metrics metrics =
+      scheduler.GetMetrics(FramePriority::kBytesPayload);
+  EXPECT_EQ(metrics.frames_written, 2);
+  EXPECT_EQ(metrics.bytes_written, 150);
+  EXPECT_EQ(metrics.queue_length, 0);
+  EXPECT_EQ(metrics.max_queue_length, 1);
+  EXPECT_EQ(scheduler.GetMetrics(FramePriority::kControl).frames_written, 0);
+}
+
+TEST(FrameSchedulerTest, UrgentFramesGoFirst) {
+  FrameScheduler scheduler;
+  WriteLog log;
+  auto turn = std::make_unique<FrameScheduler::Turn>(
+      scheduler, FramePriority::kBulkPayload);
+
+  std::thread bulk([&]() {
+    FrameScheduler::Turn turn(scheduler, FramePriority::kBulkPayload);
+    log.Add(1);
+  });
+  AwaitQueueLength(scheduler, FramePriority::kBulkPayload, 1);
+  std::thread bytes([&]() {
+    FrameScheduler::Turn turn(scheduler, FramePriority::kBytesPayload);
+    log.Add(2);
+  });
+  AwaitQueueLength(scheduler, FramePriority::kBytesPayload, 1);
+  std::thread keep_alive([&]() {
+    FrameScheduler::Turn turn(scheduler, FramePriority::kKeepAlive);
+    log.Add(3);
+  });
+  AwaitQueueLength(scheduler, FramePriority::kKeepAlive, 1);
+  turn.reset();
+  bulk.join();
+  bytes.join();
+  keep_alive.join();
+
+  EXPECT_THAT(log.Get(), ElementsAre(3, 2, 1));
+}
+
+TEST(FrameSchedulerTest, SamePriorityGoesInOrder) {
+  FrameScheduler scheduler;
+  WriteLog log;
+  auto turn = std::make_unique<FrameScheduler::Turn>(scheduler,
+                                                     FramePriority::kControl);
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 3; ++i) {
+    threads.emplace_back([&, i]() {
+      FrameScheduler::Turn turn(scheduler, FramePriority::kControl);
+      log.Add(i);
+    });
+    AwaitQueueLength(scheduler, FramePriority::kControl, i + 1);
+  }
+  turn.reset();
+  for (std::thread& thread : threads) thread.join();
+
+  EXPECT_THAT(log.Get(), ElementsAre(0, 1, 2));
+  EXPECT_EQ(scheduler.GetMetrics(FramePriority::kControl).max_queue_length, 3);
+}
+
+}  // namespace
+}  // namespace connections
+}  // namespace nearby
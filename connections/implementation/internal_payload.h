@@ -16,6 +16,7 @@
 #define CORE_INTERNAL_INTERNAL_PAYLOAD_H_
 
 #include <cstdint>
+#include <vector>
 
 #include "connections/implementation/proto/offline_wire_formats.pb.h"
 #include "connections/payload.h"
@@ -72,6 +73,10 @@ class InternalPayload {
   // @return The next chunk from the Payload, or null if we've reached the end.
   virtual ByteArray DetachNextChunk(int chunk_size) = 0;
 
+  // Whether DetachNextChunk() returned an empty chunk because the Payload
+  // couldn't be read, rather than because it ended.
+  virtual bool IsDetachFailed() const { return false; }
+
   // Adds the next chunk that comprises the Payload to which this object is
   // bound.
   //
@@ -96,6 +101,24 @@ class InternalPayload {
   // early, e.g. after being cancelled or having no more recipients left.
   virtual void Close() {}
 
+  // A file of a FILE_BATCH payload.
+  struct BatchFile {
+    Payload::Id id;
+    std::int64_t size;
+  };
+
+  // Returns the files of a FILE_BATCH payload whose last byte was detached or
+  // attached since the last call. Other payloads have no files.
+  virtual std::vector<BatchFile> TakeFinishedFiles() { return {}; }
+
+  // Returns the files of a FILE_BATCH payload not returned by
+  // TakeFinishedFiles() yet, e.g. to report them failed along with the batch.
+  virtual std::vector<BatchFile> GetUnfinishedFiles() const { return {}; }
+
+  // Returns Payloads for the files of an incoming FILE_BATCH payload that
+  // AttachNextChunk() started since the last call, to hand to the client.
+  virtual std::vector<Payload> TakeStartedFiles() { return {}; }
+
  protected:
   Payload payload_;
   // We're caching the payload ID here because the backing payload will be
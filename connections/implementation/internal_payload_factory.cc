@@ -14,13 +14,18 @@
 
 #include "connections/implementation/internal_payload_factory.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "connections/implementation/internal_payload.h"
 #include "connections/implementation/proto/offline_wire_formats.pb.h"
 #include "connections/payload.h"
@@ -31,6 +36,8 @@
 #include "internal/platform/implementation/platform.h"
 #include "internal/platform/input_stream.h"
 #include "internal/platform/logging.h"
+#include "internal/platform/mutex.h"
+#include "internal/platform/mutex_lock.h"
 #include "internal/platform/os_name.h"
 #include "internal/platform/output_stream.h"
 #include "internal/platform/pipe.h"
@@ -304,6 +311,151 @@ class IncomingFileInternalPayload : public InternalPayload {
   const std::int64_t total_size_;
 };
 
+// Each file of a FILE_BATCH payload is preceded by a PayloadHeader describing
+// it, and by the header's length as 4 big-endian bytes.
+constexpr std::size_t kBatchFileHeaderLengthSize = 4;
+// Bounds the header a misbehaving sender can make us buffer.
+constexpr std::size_t kMaxBatchFileHeaderSize = 64 * 1024;
+
+std::string EncodeBatchFileHeader(Payload& file) {
+  PayloadTransferFrame::PayloadHeader header;
+  header.set_id(file.GetId());
+  header.set_type(PayloadTransferFrame::PayloadHeader::FILE);
+  header.set_total_size(file.AsFile()->GetTotalSize());
+  header.set_file_name(file.GetFileName());
+  header.set_parent_folder(file.GetParentFolder());
+  std::string header_bytes = header.SerializeAsString();
+
+  std::string encoded(kBatchFileHeaderLengthSize, '\0');
+  for (std::size_t i = 0; i < kBatchFileHeaderLengthSize; ++i) {
+    encoded[i] = static_cast<char>(header_bytes.size() >>
+                                   (8 * (kBatchFileHeaderLengthSize - 1 - i)));
+  }
+  return encoded + header_bytes;
+}
+
+std::size_t DecodeBatchFileHeaderLength(absl::string_view encoded) {
+  std::size_t length = 0;
+  for (std::size_t i = 0; i < kBatchFileHeaderLengthSize; ++i) {
+    length = (length << 8) | static_cast<std::uint8_t>(encoded[i]);
+  }
+  return length;
+}
+
+// Sends the files of a FILE_BATCH payload back-to-back, packing as many as fit
+// into each chunk.
+class OutgoingFileBatchInternalPayload : public InternalPayload {
+ public:
+  explicit OutgoingFileBatchInternalPayload(Payload payload)
+      : InternalPayload(std::move(payload)) {
+    for (Payload& file : *payload_.AsFileBatch()) {
+      std::string header = EncodeBatchFileHeader(file);
+      std::int64_t size = file.AsFile()->GetTotalSize();
+      total_size_ += header.size() + size;
+      headers_.push_back(std::move(header));
+      files_.push_back({file.GetId(), size});
+    }
+  }
+
+  PayloadTransferFrame::PayloadHeader::PayloadType GetType() const override {
+    return PayloadTransferFrame::PayloadHeader::FILE_BATCH;
+  }
+
+  std::int64_t GetTotalSize() const override { return total_size_; }
+
+  ByteArray DetachNextChunk(int chunk_size) override {
+    MutexLock lock(&mutex_);
+    std::string chunk;
+    std::vector<Payload>& files = *payload_.AsFileBatch();
+    while (next_file_ < files_.size() && !read_failed_) {
+      const std::string& header = headers_[next_file_];
+      std::size_t space = static_cast<std::size_t>(chunk_size) - chunk.size();
+      if (header_offset_ < header.size()) {
+        if (space == 0) break;
+        std::size_t size = std::min(header.size() - header_offset_, space);
+        chunk.append(header, header_offset_, size);
+        header_offset_ += size;
+        continue;
+      }
+
+      InputFile* file = files[next_file_].AsFile();
+      std::int64_t remaining_size = files_[next_file_].size - file_offset_;
+      if (remaining_size > 0) {
+        if (space == 0) break;
+        ExceptionOr<ByteArray> bytes_read =
+            file->Read(std::min<std::int64_t>(remaining_size, space));
+        if (!bytes_read.ok() || bytes_read.result().Empty()) {
+          // The sender fails the batch once the bytes read so far are out.
+          NEARBY_LOGS(WARNING) << "Failed to read file "
+                               << files_[next_file_].id << " of file batch "
+                               << this;
+          read_failed_ = true;
+          break;
+        }
+        chunk.append(bytes_read.result().data(), bytes_read.result().size());
+        file_offset_ += bytes_read.result().size();
+        continue;
+      }
+
+      file->Close();
+      ++next_file_;
+      header_offset_ = 0;
+      file_offset_ = 0;
+    }
+    return ByteArray(std::move(chunk));
+  }
+
+  bool IsDetachFailed() const override {
+    MutexLock lock(&mutex_);
+    return read_failed_;
+  }
+
+  Exception AttachNextChunk(const ByteArray& chunk) override {
+    return {Exception::kIo};
+  }
+
+  ExceptionOr<size_t> SkipToOffset(size_t offset) override {
+    NEARBY_LOGS(WARNING) << "File batch payload does not support offsets";
+    return {Exception::kIo};
+  }
+
+  void Close() override {
+    MutexLock lock(&mutex_);
+    std::vector<Payload>& files = *payload_.AsFileBatch();
+    for (std::size_t i = next_file_; i < files.size(); ++i) {
+      files[i].AsFile()->Close();
+    }
+  }
+
+  std::vector<BatchFile> TakeFinishedFiles() override {
+    MutexLock lock(&mutex_);
+    std::vector<BatchFile> finished_files(files_.begin() + reported_files_,
+                                          files_.begin() + next_file_);
+    reported_files_ = next_file_;
+    return finished_files;
+  }
+
+  std::vector<BatchFile> GetUnfinishedFiles() const override {
+    MutexLock lock(&mutex_);
+    return std::vector<BatchFile>(files_.begin() + reported_files_,
+                                  files_.end());
+  }
+
+ private:
+  std::int64_t total_size_ = 0;
+  // The encoded headers and sizes of the files, in the order they're sent.
+  std::vector<std::string> headers_;
+  std::vector<BatchFile> files_;
+  mutable Mutex mutex_;
+  // The file being sent, and how much of its header and bytes were sent.
+  std::size_t next_file_ ABSL_GUARDED_BY(mutex_) = 0;
+  std::size_t header_offset_ ABSL_GUARDED_BY(mutex_) = 0;
+  std::int64_t file_offset_ ABSL_GUARDED_BY(mutex_) = 0;
+  // The files before this one were returned by TakeFinishedFiles().
+  std::size_t reported_files_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool read_failed_ ABSL_GUARDED_BY(mutex_) = false;
+};
+
 }  // namespace
 
 using ::nearby::api::ImplementationPlatform;
@@ -323,6 +475,10 @@ std::unique_ptr<InternalPayload> CreateOutgoingInternalPayload(
       return std::make_unique<OutgoingStreamInternalPayload>(
           std::move(payload));
 
+    case PayloadType::kFileBatch:
+      return std::make_unique<OutgoingFileBatchInternalPayload>(
+          std::move(payload));
+
     default:
       DCHECK(false);  // This should never happen.
       return {};
@@ -350,6 +506,205 @@ std::string make_path(const std::string& custom_save_path,
   return api::ImplementationPlatform::GetDownloadPath(parent_folder, file_name);
 }
 
+namespace {
+
+// The file an incoming FILE payload, or a file of a FILE_BATCH payload, is
+// written to, and the Payload handed to the client for it.
+struct IncomingFile {
+  Payload payload;
+  OutputFile output_file;
+};
+
+// Creates the file described by `header`. Returns std::nullopt if `header`
+// has no way to name it.
+std::optional<IncomingFile> CreateIncomingFile(
+    const PayloadTransferFrame::PayloadHeader& header,
+    const std::string& custom_save_path) {
+  const Payload::Id payload_id = header.id();
+  std::string parent_folder;
+  std::string file_name;
+  std::string file_path;
+
+  int64_t total_size = 0;
+
+  if (header.has_parent_folder()) {
+    parent_folder = header.parent_folder();
+  }
+
+  if (header.has_file_name()) {
+    file_name = header.file_name();
+    // if custom_save_path is empty, default download path is used
+    file_path = make_path(custom_save_path, parent_folder, file_name);
+  } else {
+    if (header.has_id()) {
+      file_name = std::to_string(header.id());
+      // if custom_save_path is empty, default download path is used
+      file_path = make_path(custom_save_path, parent_folder, file_name);
+    } else {
+      // This is an error condition, we don't have any way to generate a
+      // file name for the output file.
+      NEARBY_LOGS(ERROR) << "File name not found in incoming file Payload, "
+                            "and the Id wasn't found.";
+      return std::nullopt;
+    }
+  }
+
+  if (header.has_total_size()) {
+    total_size = header.total_size();
+  }
+
+  // These are ordered, the output file must be created first otherwise
+  // there will be no input file to open.
+  // On Chrome the file path should be empty, so use the payload id.
+  if (ImplementationPlatform::GetCurrentOS() == OSName::kChromeOS) {
+    OutputFile output_file(payload_id);
+    return IncomingFile{Payload(payload_id, InputFile(payload_id, total_size)),
+                        std::move(output_file)};
+  }
+  OutputFile output_file(file_path);
+  return IncomingFile{Payload(payload_id, parent_folder, file_name,
+                              InputFile(file_path, total_size)),
+                      std::move(output_file)};
+}
+
+// Reads the files of a FILE_BATCH payload from its chunks, saving each one as
+// if it came in its own FILE payload.
+class IncomingFileBatchInternalPayload : public InternalPayload {
+ public:
+  IncomingFileBatchInternalPayload(Payload payload,
+                                   std::string custom_save_path,
+                                   std::int64_t total_size)
+      : InternalPayload(std::move(payload)),
+        custom_save_path_(std::move(custom_save_path)),
+        total_size_(total_size) {}
+
+  PayloadTransferFrame::PayloadHeader::PayloadType GetType() const override {
+    return PayloadTransferFrame::PayloadHeader::FILE_BATCH;
+  }
+
+  std::int64_t GetTotalSize() const override { return total_size_; }
+
+  ByteArray DetachNextChunk(int chunk_size) override { return {}; }
+
+  Exception AttachNextChunk(const ByteArray& chunk) override {
+    MutexLock lock(&mutex_);
+    if (chunk.Empty()) {
+      // The batch must not end in the middle of a file.
+      if (output_file_.has_value() || !header_.empty()) {
+        NEARBY_LOGS(WARNING) << "File batch " << this
+                             << " ended in the middle of a file.";
+        return {Exception::kIo};
+      }
+      return {Exception::kSuccess};
+    }
+
+    absl::string_view data(chunk.data(), chunk.size());
+    while (!data.empty()) {
+      if (output_file_.has_value()) {
+        std::size_t size = std::min<std::int64_t>(remaining_size_, data.size());
+        Exception write_exception =
+            output_file_->Write(ByteArray(data.data(), size));
+        if (write_exception.Raised()) return write_exception;
+        data.remove_prefix(size);
+        remaining_size_ -= size;
+        if (remaining_size_ == 0) FinishFile();
+        continue;
+      }
+
+      // The header of the next file; it may span chunks.
+      std::size_t header_size = kBatchFileHeaderLengthSize;
+      if (header_.size() >= kBatchFileHeaderLengthSize) {
+        header_size += DecodeBatchFileHeaderLength(header_);
+      }
+      std::size_t size = std::min(header_size - header_.size(), data.size());
+      header_.append(data.data(), size);
+      data.remove_prefix(size);
+      if (header_.size() == kBatchFileHeaderLengthSize) {
+        std::size_t length = DecodeBatchFileHeaderLength(header_);
+        if (length == 0 || length > kMaxBatchFileHeaderSize) {
+          return {Exception::kInvalidProtocolBuffer};
+        }
+        continue;
+      }
+      if (header_.size() < header_size) continue;
+
+      PayloadTransferFrame::PayloadHeader file_header;
+      if (!file_header.ParseFromArray(
+              header_.data() + kBatchFileHeaderLengthSize,
+              header_.size() - kBatchFileHeaderLengthSize) ||
+          !file_header.has_id() || file_header.total_size() < 0) {
+        return {Exception::kInvalidProtocolBuffer};
+      }
+      header_.clear();
+      Exception start_exception = StartFile(file_header);
+      if (start_exception.Raised()) return start_exception;
+    }
+    return {Exception::kSuccess};
+  }
+
+  ExceptionOr<size_t> SkipToOffset(size_t offset) override {
+    NEARBY_LOGS(WARNING) << "Cannot skip offset for an incoming file batch "
+                         << this;
+    return {Exception::kIo};
+  }
+
+  void Close() override {
+    MutexLock lock(&mutex_);
+    if (output_file_.has_value()) output_file_->Close();
+  }
+
+  std::vector<BatchFile> TakeFinishedFiles() override {
+    MutexLock lock(&mutex_);
+    return std::exchange(finished_files_, {});
+  }
+
+  std::vector<BatchFile> GetUnfinishedFiles() const override {
+    MutexLock lock(&mutex_);
+    std::vector<BatchFile> unfinished_files = finished_files_;
+    if (output_file_.has_value()) unfinished_files.push_back(current_file_);
+    return unfinished_files;
+  }
+
+  std::vector<Payload> TakeStartedFiles() override {
+    MutexLock lock(&mutex_);
+    return std::exchange(started_files_, {});
+  }
+
+ private:
+  Exception StartFile(const PayloadTransferFrame::PayloadHeader& file_header)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    std::optional<IncomingFile> file =
+        CreateIncomingFile(file_header, custom_save_path_);
+    if (!file.has_value()) return {Exception::kIo};
+    started_files_.push_back(std::move(file->payload));
+    output_file_.emplace(std::move(file->output_file));
+    current_file_ = {file_header.id(), file_header.total_size()};
+    remaining_size_ = file_header.total_size();
+    if (remaining_size_ == 0) FinishFile();
+    return {Exception::kSuccess};
+  }
+
+  void FinishFile() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    output_file_->Close();
+    output_file_.reset();
+    finished_files_.push_back(current_file_);
+  }
+
+  const std::string custom_save_path_;
+  const std::int64_t total_size_;
+  mutable Mutex mutex_;
+  // The bytes of the next file's header received so far.
+  std::string header_ ABSL_GUARDED_BY(mutex_);
+  // The file being received, if any.
+  std::optional<OutputFile> output_file_ ABSL_GUARDED_BY(mutex_);
+  BatchFile current_file_ ABSL_GUARDED_BY(mutex_) = {};
+  std::int64_t remaining_size_ ABSL_GUARDED_BY(mutex_) = 0;
+  std::vector<Payload> started_files_ ABSL_GUARDED_BY(mutex_);
+  std::vector<BatchFile> finished_files_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace
+
 std::unique_ptr<InternalPayload> CreateIncomingInternalPayload(
     const location::nearby::connections::PayloadTransferFrame& frame,
     const std::string& custom_save_path) {
@@ -373,52 +728,20 @@ std::unique_ptr<InternalPayload> CreateIncomingInternalPayload(
     }
 
     case PayloadTransferFrame::PayloadHeader::FILE: {
-      std::string parent_folder;
-      std::string file_name;
-      std::string file_path;
-
-      int64_t total_size = 0;
-
-      if (frame.payload_header().has_parent_folder()) {
-        parent_folder = frame.payload_header().parent_folder();
-      }
-
-      if (frame.payload_header().has_file_name()) {
-        file_name = frame.payload_header().file_name();
-        // if custom_save_path is empty, default download path is used
-        file_path = make_path(custom_save_path, parent_folder, file_name);
-      } else {
-        if (frame.payload_header().has_id()) {
-          file_name = std::to_string(frame.payload_header().id());
-          // if custom_save_path is empty, default download path is used
-          file_path = make_path(custom_save_path, parent_folder, file_name);
-        } else {
-          // This is an error condition, we don't have any way to generate a
-          // file name for the output file.
-          NEARBY_LOGS(ERROR) << "File name not found in incoming file Payload, "
-                                "and the Id wasn't found.";
-          return {};
-        }
-      }
-
-      if (frame.payload_header().has_total_size()) {
-        total_size = frame.payload_header().total_size();
-      }
+      std::optional<IncomingFile> file =
+          CreateIncomingFile(frame.payload_header(), custom_save_path);
+      if (!file.has_value()) return {};
+      return std::make_unique<IncomingFileInternalPayload>(
+          std::move(file->payload), std::move(file->output_file),
+          frame.payload_header().total_size());
+    }
 
-      // These are ordered, the output file must be created first otherwise
-      // there will be no input file to open.
-      // On Chrome the file path should be empty, so use the payload id.
-      if (ImplementationPlatform::GetCurrentOS() == OSName::kChromeOS) {
-        return std::make_unique<IncomingFileInternalPayload>(
-            Payload(payload_id, InputFile(payload_id, total_size)),
-            OutputFile(payload_id), total_size);
-      } else {
-        return std::make_unique<IncomingFileInternalPayload>(
-            Payload(payload_id, parent_folder, file_name,
-                    InputFile(file_path, total_size)),
-            OutputFile(file_path), total_size);
-      }
+    case PayloadTransferFrame::PayloadHeader::FILE_BATCH: {
+      return std::make_unique<IncomingFileBatchInternalPayload>(
+          Payload(payload_id, std::vector<Payload>()), custom_save_path,
+          frame.payload_header().total_size());
     }
+
     default:
       DCHECK(false);  // This should never happen.
       return {};
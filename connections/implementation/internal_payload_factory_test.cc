@@ -18,8 +18,10 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
 #include "connections/implementation/internal_payload.h"
 #include "connections/implementation/proto/offline_wire_formats.pb.h"
 #include "connections/payload.h"
@@ -34,6 +36,7 @@ namespace connections {
 namespace {
 
 using ::location::nearby::connections::PayloadTransferFrame;
+using BatchFile = InternalPayload::BatchFile;
 constexpr char kText[] = "data chunk";
 
 TEST(InternalPayloadFactoryTest, CanCreateInternalPayloadFromBytePayload) {
@@ -229,6 +232,144 @@ TEST(InternalPayloadFactoryTest,
   EXPECT_EQ(contents_after_skip, ByteArray("6789"));
 }
 
+std::vector<Payload> CreateBatchFiles(
+    const std::vector<std::string>& contents) {
+  std::vector<Payload> files;
+  for (const std::string& file_contents : contents) {
+    Payload::Id file_id = Payload::GenerateId();
+    CreateFileWithContents(file_id, ByteArray(file_contents));
+    files.emplace_back(file_id, "", absl::StrCat("batch-", file_id),
+                       InputFile(file_id, file_contents.size()));
+  }
+  return files;
+}
+
+std::unique_ptr<InternalPayload> CreateIncomingFileBatch(
+    const InternalPayload& outgoing) {
+  PayloadTransferFrame frame;
+  frame.set_packet_type(PayloadTransferFrame::DATA);
+  auto& header = *frame.mutable_payload_header();
+  header.set_type(outgoing.GetType());
+  header.set_id(outgoing.GetId());
+  header.set_total_size(outgoing.GetTotalSize());
+  return CreateIncomingInternalPayload(frame, testing::TempDir());
+}
+
+TEST(InternalPayloadFactoryTest, FileBatchPayloadRoundTripsFiles) {
+  const std::vector<std::string> contents = {"0123456789", "", "abcde"};
+  std::unique_ptr<InternalPayload> outgoing =
+      CreateOutgoingInternalPayload(Payload(CreateBatchFiles(contents)));
+  ASSERT_NE(outgoing, nullptr);
+  EXPECT_EQ(outgoing->GetType(),
+            PayloadTransferFrame::PayloadHeader::FILE_BATCH);
+  std::unique_ptr<InternalPayload> incoming =
+      CreateIncomingFileBatch(*outgoing);
+  ASSERT_NE(incoming, nullptr);
+
+  // Small chunks split the per-file headers as well as the file bytes.
+  std::vector<Payload> received_files;
+  std::vector<BatchFile> sent_files;
+  std::vector<BatchFile> finished_files;
+  std::int64_t sent_size = 0;
+  while (true) {
+    ByteArray chunk = outgoing->DetachNextChunk(7);
+    sent_size += chunk.size();
+    EXPECT_FALSE(incoming->AttachNextChunk(chunk).Raised());
+    for (BatchFile& file : outgoing->TakeFinishedFiles()) {
+      sent_files.push_back(file);
+    }
+    for (Payload& file : incoming->TakeStartedFiles()) {
+      received_files.push_back(std::move(file));
+    }
+    for (BatchFile& file : incoming->TakeFinishedFiles()) {
+      finished_files.push_back(file);
+    }
+    if (chunk.Empty()) break;
+  }
+
+  EXPECT_EQ(sent_size, outgoing->GetTotalSize());
+  EXPECT_TRUE(outgoing->GetUnfinishedFiles().empty());
+  EXPECT_TRUE(incoming->GetUnfinishedFiles().empty());
+  ASSERT_EQ(sent_files.size(), contents.size());
+  ASSERT_EQ(finished_files.size(), contents.size());
+  ASSERT_EQ(received_files.size(), contents.size());
+  for (std::size_t i = 0; i < contents.size(); ++i) {
+    EXPECT_EQ(finished_files[i].id, sent_files[i].id);
+    EXPECT_EQ(finished_files[i].size, contents[i].size());
+    EXPECT_EQ(received_files[i].GetId(), sent_files[i].id);
+    EXPECT_EQ(received_files[i].GetType(), PayloadType::kFile);
+    EXPECT_EQ(received_files[i].GetFileName(),
+              absl::StrCat("batch-", sent_files[i].id));
+    InputFile* file = received_files[i].AsFile();
+    ASSERT_NE(file, nullptr);
+    if (!contents[i].empty()) {
+      EXPECT_EQ(file->Read(contents[i].size()).result(),
+                ByteArray(contents[i]));
+    }
+    file->Close();
+  }
+}
+
+TEST(InternalPayloadFactoryTest, FileBatchPayloadEndingMidFileFails) {
+  std::unique_ptr<InternalPayload> outgoing = CreateOutgoingInternalPayload(
+      Payload(CreateBatchFiles({"0123456789"})));
+  ASSERT_NE(outgoing, nullptr);
+  std::unique_ptr<InternalPayload> incoming =
+      CreateIncomingFileBatch(*outgoing);
+  ASSERT_NE(incoming, nullptr);
+
+  ByteArray chunk = outgoing->DetachNextChunk(outgoing->GetTotalSize() - 1);
+  EXPECT_FALSE(incoming->AttachNextChunk(chunk).Raised());
+
+  EXPECT_TRUE(incoming->AttachNextChunk(ByteArray()).Raised(Exception::kIo));
+  std::vector<BatchFile> unfinished_files = incoming->GetUnfinishedFiles();
+  ASSERT_EQ(unfinished_files.size(), 1);
+  EXPECT_EQ(unfinished_files[0].id, outgoing->GetUnfinishedFiles()[0].id);
+  outgoing->Close();
+  incoming->Close();
+}
+
+TEST(InternalPayloadFactoryTest, FileBatchPayloadFailsDetachOnShortFile) {
+  Payload::Id file_id = Payload::GenerateId();
+  CreateFileWithContents(file_id, ByteArray("0123456789"));
+  std::vector<Payload> files = CreateBatchFiles({"abcde"});
+  files.emplace_back(file_id, "", absl::StrCat("batch-", file_id),
+                     InputFile(file_id, 10));
+  std::unique_ptr<InternalPayload> outgoing =
+      CreateOutgoingInternalPayload(Payload(std::move(files)));
+  ASSERT_NE(outgoing, nullptr);
+  // The second file shrinks after the batch was created.
+  CreateFileWithContents(file_id, ByteArray("012"));
+
+  std::int64_t sent_size = 0;
+  while (true) {
+    ByteArray chunk = outgoing->DetachNextChunk(7);
+    if (chunk.Empty()) break;
+    sent_size += chunk.size();
+  }
+
+  EXPECT_TRUE(outgoing->IsDetachFailed());
+  EXPECT_LT(sent_size, outgoing->GetTotalSize());
+  EXPECT_EQ(outgoing->TakeFinishedFiles().size(), 1);
+  std::vector<BatchFile> unfinished_files = outgoing->GetUnfinishedFiles();
+  ASSERT_EQ(unfinished_files.size(), 1);
+  EXPECT_EQ(unfinished_files[0].id, file_id);
+  outgoing->Close();
+}
+
+TEST(InternalPayloadFactoryTest, FileBatchPayloadRejectsEmptyFileHeader) {
+  std::unique_ptr<InternalPayload> outgoing = CreateOutgoingInternalPayload(
+      Payload(CreateBatchFiles({"0123456789"})));
+  ASSERT_NE(outgoing, nullptr);
+  std::unique_ptr<InternalPayload> incoming =
+      CreateIncomingFileBatch(*outgoing);
+  ASSERT_NE(incoming, nullptr);
+
+  EXPECT_TRUE(incoming->AttachNextChunk(ByteArray(std::string(4, '\0')))
+                  .Raised(Exception::kInvalidProtocolBuffer));
+  outgoing->Close();
+}
+
 }  // namespace
 }  // namespace connections
 }  // namespace nearby
@@ -20,6 +20,7 @@
 #include <utility>
 #include <vector>
 
+#include "absl/status/status.h"
 #include "absl/strings/escaping.h"
 #include "absl/time/time.h"
 #include "absl/types/optional.h"
@@ -32,6 +33,7 @@
 #include "connections/implementation/mediums/utils.h"
 #include "connections/power_level.h"
 #include "internal/flags/nearby_flags.h"
+#include "internal/platform/ble_scan_multiplexer.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/cancelable_alarm.h"
 #include "internal/platform/logging.h"
@@ -260,42 +262,45 @@ bool BleV2::StartScanning(const std::string& service_id, PowerLevel power_level,
   scanned_service_ids_.insert(service_id);
   // TODO(b/213835576): We should re-start scanning once the power level is
   // changed.
-  if (!medium_.StartScanning(
-          mediums::bleutils::kCopresenceServiceUuid,
-          PowerLevelToTxPowerLevel(power_level),
-          {
-              .advertisement_found_cb =
-                  [this](BleV2Peripheral peripheral,
-                         BleAdvertisementData advertisement_data) {
-                    RunOnBleThread([this, peripheral = std::move(peripheral),
-                                    advertisement_data]() {
-                      MutexLock lock(&mutex_);
-                      discovered_peripheral_tracker_
-                          .ProcessFoundBleAdvertisement(
-                              std::move(peripheral), advertisement_data,
-                              {
-                                  .fetch_advertisements =
-                                      [&](BleV2Peripheral peripheral,
-                                          int num_slots, int psm,
-                                          const std::vector<std::string>&
-                                              interesting_service_ids,
-                                          mediums::AdvertisementReadResult&
-                                              advertisement_read_result) {
-                                        // Th`mutex_` is already held here. Use
-                                        // `AssumeHeld` tell the thread
-                                        // annotation static analysis that
-                                        // `mutex_` is already exclusively
-                                        // locked.
-                                        AssumeHeld(mutex_);
-                                        ProcessFetchGattAdvertisementsRequest(
-                                            std::move(peripheral), num_slots,
-                                            psm, interesting_service_ids,
-                                            advertisement_read_result);
-                                      },
-                              });
-                    });
-                  },
-          })) {
+  // The platform scan is shared with other clients in the process that scan
+  // for the same service UUID.
+  scanning_session_ = BleScanMultiplexer::GetInstance().StartScanning(
+      medium_, mediums::bleutils::kCopresenceServiceUuid,
+      PowerLevelToTxPowerLevel(power_level),
+      {
+          .advertisement_found_cb =
+              [this, medium = &medium_](
+                  api::ble_v2::BlePeripheral& platform_peripheral,
+                  BleAdvertisementData advertisement_data) {
+                BleV2Peripheral peripheral(*medium, platform_peripheral);
+                RunOnBleThread([this, peripheral = std::move(peripheral),
+                                advertisement_data]() {
+                  MutexLock lock(&mutex_);
+                  discovered_peripheral_tracker_.ProcessFoundBleAdvertisement(
+                      std::move(peripheral), advertisement_data,
+                      {
+                          .fetch_advertisements =
+                              [&](BleV2Peripheral peripheral, int num_slots,
+                                  int psm,
+                                  const std::vector<std::string>&
+                                      interesting_service_ids,
+                                  mediums::AdvertisementReadResult&
+                                      advertisement_read_result) {
+                                // Th`mutex_` is already held here. Use
+                                // `AssumeHeld` tell the thread annotation
+                                // static analysis that `mutex_` is already
+                                // exclusively locked.
+                                AssumeHeld(mutex_);
+                                ProcessFetchGattAdvertisementsRequest(
+                                    std::move(peripheral), num_slots, psm,
+                                    interesting_service_ids,
+                                    advertisement_read_result);
+                              },
+                      });
+                });
+              },
+      });
+  if (scanning_session_ == nullptr) {
     NEARBY_LOGS(INFO) << "Failed to start scan of BLE services.";
     discovered_peripheral_tracker_.StopTracking(service_id);
     // Erase the service id that is just added.
@@ -343,7 +348,13 @@ bool BleV2::StopScanning(const std::string& service_id) {
   if (lost_alarm_->IsValid()) {
     lost_alarm_->Cancel();
   }
-  return medium_.StopScanning();
+  absl::Status status = scanning_session_->stop_scanning();
+  scanning_session_.reset();
+  if (!status.ok()) {
+    NEARBY_LOGS(WARNING) << "Failed to stop BLE scanning: " << status;
+    return false;
+  }
+  return true;
 }
 
 bool BleV2::IsScanning(const std::string& service_id) const {
@@ -15,7 +15,12 @@
 #ifndef CORE_INTERNAL_MEDIUMS_LOST_ENTITY_TRACKER_H_
 #define CORE_INTERNAL_MEDIUMS_LOST_ENTITY_TRACKER_H_
 
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
 #include "absl/container/flat_hash_set.h"
+#include "connections/implementation/mediums/timing_wheel.h"
 #include "internal/platform/mutex.h"
 #include "internal/platform/mutex_lock.h"
 
@@ -28,6 +33,9 @@ namespace mediums {
 // of whether a specific entity was rediscovered since the last call to
 // ComputeLostEntities.
 //
+// Each call to ComputeLostEntities is a tick of a timing wheel, so it only
+// visits the entities that are actually lost, however many are still around.
+//
 // Note: Entity must overload the < and == operators.
 template <typename Entity>
 class LostEntityTracker {
@@ -46,26 +54,26 @@ class LostEntityTracker {
   EntitySet ComputeLostEntities() ABSL_LOCKS_EXCLUDED(mutex_);
 
  private:
+  // An entity found before one ComputeLostEntities call is reported lost by
+  // the next one, unless it is found again in between.
+  static constexpr int64_t kRoundsUntilLost = 2;
+
   Mutex mutex_;
-  EntitySet current_entities_ ABSL_GUARDED_BY(mutex_);
-  EntitySet previously_found_entities_ ABSL_GUARDED_BY(mutex_);
+  TimingWheel<Entity> last_found_ ABSL_GUARDED_BY(mutex_);
 };
 
 template <typename Entity>
 LostEntityTracker<Entity>::LostEntityTracker()
-    : current_entities_{}, previously_found_entities_{} {}
+    : last_found_(kRoundsUntilLost + 1) {}
 
 template <typename Entity>
-LostEntityTracker<Entity>::~LostEntityTracker() {
-  previously_found_entities_.clear();
-  current_entities_.clear();
-}
+LostEntityTracker<Entity>::~LostEntityTracker() = default;
 
 template <typename Entity>
 void LostEntityTracker<Entity>::RecordFoundEntity(const Entity& entity) {
   MutexLock lock(&mutex_);
 
-  current_entities_.insert(entity);
+  last_found_.Schedule(entity, kRoundsUntilLost);
 }
 
 template <typename Entity>
@@ -73,16 +81,9 @@ typename LostEntityTracker<Entity>::EntitySet
 LostEntityTracker<Entity>::ComputeLostEntities() {
   MutexLock lock(&mutex_);
 
-  // The set of lost entities is the previously found set MINUS the currently
-  // found set.
-  for (const auto& item : current_entities_) {
-    previously_found_entities_.erase(item);
-  }
-  auto lost_entities = std::move(previously_found_entities_);
-  previously_found_entities_ = std::move(current_entities_);
-  current_entities_ = {};
-
-  return lost_entities;
+  std::vector<Entity> lost_entities = last_found_.Advance();
+  return EntitySet(std::make_move_iterator(lost_entities.begin()),
+                   std::make_move_iterator(lost_entities.end()));
 }
 
 }  // namespace mediums
@@ -129,6 +129,33 @@ TEST(LostEntityTrackerTest, SameEntityMultipleCopies) {
   EXPECT_TRUE(lost_entities.find(entity_1_copy) != lost_entities.end());
 }
 
+TEST(LostEntityTrackerTest, ManyEntitiesLowChurn) {
+  constexpr int kNumEntities = 10000;
+  constexpr int kNumRounds = 100;
+  // Every round, 1% of the entities go away and are replaced by new ones.
+  constexpr int kChurnPerRound = kNumEntities / 100;
+  LostEntityTracker<TestEntity> lost_entity_tracker;
+  for (int id = 0; id < kNumEntities; ++id) {
+    lost_entity_tracker.RecordFoundEntity(TestEntity{id});
+  }
+  ASSERT_TRUE(lost_entity_tracker.ComputeLostEntities().empty());
+
+  int first_id = 0;
+  for (int round = 0; round < kNumRounds; ++round) {
+    first_id += kChurnPerRound;
+    for (int id = first_id; id < first_id + kNumEntities; ++id) {
+      lost_entity_tracker.RecordFoundEntity(TestEntity{id});
+    }
+    typename LostEntityTracker<TestEntity>::EntitySet lost_entities =
+        lost_entity_tracker.ComputeLostEntities();
+    ASSERT_EQ(lost_entities.size(), kChurnPerRound);
+    EXPECT_TRUE(lost_entities.find(TestEntity{first_id - 1}) !=
+                lost_entities.end());
+    EXPECT_TRUE(lost_entities.find(TestEntity{first_id}) ==
+                lost_entities.end());
+  }
+}
+
 }  // namespace
 }  // namespace mediums
 }  // namespace connections
@@ -14,26 +14,132 @@
 
 #include "connections/implementation/mediums/mediums.h"
 
+#include <memory>
+#include <vector>
+
+#include "absl/base/call_once.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "connections/implementation/flags/nearby_connections_feature_flags.h"
+#include "internal/flags/nearby_flags.h"
+#include "internal/platform/logging.h"
+#include "internal/platform/mutex_lock.h"
+#include "internal/platform/system_clock.h"
+
 namespace nearby {
 namespace connections {
 
-BluetoothRadio& Mediums::GetBluetoothRadio() { return bluetooth_radio_; }
+template <typename T, typename... Args>
+T& Mediums::GetOrCreate(absl::once_flag& once, std::unique_ptr<T>& medium,
+                        const char* name, Args&... args) {
+  absl::call_once(once, [&]() {
+    absl::Time start_time = SystemClock::ElapsedRealtime();
+    medium = std::make_unique<T>(args...);
+    absl::Duration duration = SystemClock::ElapsedRealtime() - start_time;
+    NEARBY_LOGS(INFO) << "Initialized " << name << " in " << duration;
+    MutexLock lock(&mutex_);
+    init_times_.push_back({name, duration});
+  });
+  return *medium;
+}
+
+bool Mediums::IsCreated(absl::string_view name) const {
+  MutexLock lock(&mutex_);
+  for (const InitTime& init_time : init_times_) {
+    if (init_time.medium == name) return true;
+  }
+  return false;
+}
+
+BluetoothRadio& Mediums::GetBluetoothRadio() {
+  return GetOrCreate(bluetooth_radio_once_, bluetooth_radio_,
+                     "BluetoothRadio");
+}
+
+BluetoothClassic& Mediums::GetBluetoothClassic() {
+  BluetoothRadio& radio = GetBluetoothRadio();
+  return GetOrCreate(bluetooth_classic_once_, bluetooth_classic_,
+                     "BluetoothClassic", radio);
+}
+
+Ble& Mediums::GetBle() {
+  BluetoothRadio& radio = GetBluetoothRadio();
+  return GetOrCreate(ble_once_, ble_, "Ble", radio);
+}
+
+BleV2& Mediums::GetBleV2() {
+  BluetoothRadio& radio = GetBluetoothRadio();
+  return GetOrCreate(ble_v2_once_, ble_v2_, "BleV2", radio);
+}
+
+Wifi& Mediums::GetWifi() { return GetOrCreate(wifi_once_, wifi_, "Wifi"); }
+
+WifiLan& Mediums::GetWifiLan() {
+  return GetOrCreate(wifi_lan_once_, wifi_lan_, "WifiLan");
+}
+
+WifiHotspot& Mediums::GetWifiHotspot() {
+  return GetOrCreate(wifi_hotspot_once_, wifi_hotspot_, "WifiHotspot");
+}
+
+WifiDirect& Mediums::GetWifiDirect() {
+  return GetOrCreate(wifi_direct_once_, wifi_direct_, "WifiDirect");
+}
+
+mediums::WebRtc& Mediums::GetWebRtc() {
+  return GetOrCreate(webrtc_once_, webrtc_, "WebRtc");
+}
+
+bool Mediums::IsBluetoothRadioCreated() const {
+  return IsCreated("BluetoothRadio");
+}
+
+bool Mediums::IsBluetoothClassicCreated() const {
+  return IsCreated("BluetoothClassic");
+}
+
+bool Mediums::IsBleCreated() const { return IsCreated("Ble"); }
 
-BluetoothClassic& Mediums::GetBluetoothClassic() { return bluetooth_classic_; }
+bool Mediums::IsBleV2Created() const { return IsCreated("BleV2"); }
 
-Ble& Mediums::GetBle() { return ble_; }
+bool Mediums::IsWifiCreated() const { return IsCreated("Wifi"); }
 
-BleV2& Mediums::GetBleV2() { return ble_v2_; }
+bool Mediums::IsWifiLanCreated() const { return IsCreated("WifiLan"); }
 
-Wifi& Mediums::GetWifi() { return wifi_; }
+bool Mediums::IsWifiHotspotCreated() const {
+  return IsCreated("WifiHotspot");
+}
 
-WifiLan& Mediums::GetWifiLan() { return wifi_lan_; }
+bool Mediums::IsWifiDirectCreated() const { return IsCreated("WifiDirect"); }
 
-WifiHotspot& Mediums::GetWifiHotspot() { return wifi_hotspot_; }
+bool Mediums::IsWebRtcCreated() const { return IsCreated("WebRtc"); }
 
-WifiDirect& Mediums::GetWifiDirect() { return wifi_direct_; }
+void Mediums::Prewarm(const BooleanMediumSelector& mediums) {
+  if (mediums.bluetooth) GetBluetoothClassic();
+  if (mediums.ble) {
+    if (NearbyFlags::GetInstance().GetBoolFlag(
+            config_package_nearby::nearby_connections_feature::kEnableBleV2)) {
+      GetBleV2();
+    } else {
+      GetBle();
+    }
+  }
+  if (mediums.wifi_lan) GetWifiLan();
+  if (mediums.wifi_hotspot) {
+    GetWifi();
+    GetWifiHotspot();
+  }
+  if (mediums.wifi_direct) {
+    GetWifi();
+    GetWifiDirect();
+  }
+  if (mediums.web_rtc) GetWebRtc();
+}
 
-mediums::WebRtc& Mediums::GetWebRtc() { return webrtc_; }
+std::vector<Mediums::InitTime> Mediums::GetInitTimes() const {
+  MutexLock lock(&mutex_);
+  return init_times_;
+}
 
 }  // namespace connections
 }  // namespace nearby
@@ -15,6 +15,12 @@
 #ifndef CORE_INTERNAL_MEDIUMS_MEDIUMS_H_
 #define CORE_INTERNAL_MEDIUMS_MEDIUMS_H_
 
+#include <memory>
+#include <vector>
+
+#include "absl/base/call_once.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 #include "connections/implementation/mediums/ble.h"
 #include "connections/implementation/mediums/ble_v2.h"
 #include "connections/implementation/mediums/bluetooth_classic.h"
@@ -28,13 +34,25 @@
 #include "connections/implementation/mediums/wifi_hotspot.h"
 #include "connections/implementation/mediums/wifi_direct.h"
 #include "connections/implementation/mediums/wifi_lan.h"
+#include "connections/medium_selector.h"
+#include "internal/platform/mutex.h"
 
 namespace nearby {
 namespace connections {
 
 // Facilitates convenient and reliable usage of various wireless mediums.
+//
+// Each medium is created the first time it is asked for, so that mediums an
+// app never uses don't cost it anything (on some platforms, creating a medium
+// connects to system services). Getters are thread-safe.
 class Mediums {
  public:
+  // How long creating a medium took.
+  struct InitTime {
+    const char* medium;
+    absl::Duration duration;
+  };
+
   Mediums() = default;
   ~Mediums() = default;
 
@@ -65,24 +83,55 @@ class Mediums {
   // Returns a handle to the WebRtc medium.
   mediums::WebRtc& GetWebRtc();
 
+  // Return whether the medium has been created, without creating it. Lets
+  // callers skip tearing down a medium that was never set up.
+  bool IsBluetoothRadioCreated() const;
+  bool IsBluetoothClassicCreated() const;
+  bool IsBleCreated() const;
+  bool IsBleV2Created() const;
+  bool IsWifiCreated() const;
+  bool IsWifiLanCreated() const;
+  bool IsWifiHotspotCreated() const;
+  bool IsWifiDirectCreated() const;
+  bool IsWebRtcCreated() const;
+
+  // Creates the mediums in `mediums` ahead of their first use.
+  void Prewarm(const BooleanMediumSelector& mediums);
+
+  // Returns how long each medium created so far took, in creation order.
+  std::vector<InitTime> GetInitTimes() const;
+
  private:
-  // The order of declaration is critical for both construction and
-  // destruction.
-  //
-  // 1) Construction: The individual mediums have a dependency on the
-  // corresponding radio, so the radio must be initialized first.
-  //
-  // 2) Destruction: The individual mediums should be shut down before the
-  // corresponding radio.
-  BluetoothRadio bluetooth_radio_;
-  BluetoothClassic bluetooth_classic_{bluetooth_radio_};
-  Ble ble_{bluetooth_radio_};
-  BleV2 ble_v2_{bluetooth_radio_};
-  Wifi wifi_;
-  WifiLan wifi_lan_;
-  WifiHotspot wifi_hotspot_;
-  WifiDirect wifi_direct_;
-  mediums::WebRtc webrtc_;
+  template <typename T, typename... Args>
+  T& GetOrCreate(absl::once_flag& once, std::unique_ptr<T>& medium,
+                 const char* name, Args&... args);
+  bool IsCreated(absl::string_view name) const;
+
+  mutable Mutex mutex_;
+  std::vector<InitTime> init_times_ ABSL_GUARDED_BY(mutex_);
+
+  // The order of declaration is critical for destruction: the individual
+  // mediums should be shut down before the corresponding radio. Creation
+  // order is taken care of by the getters, which create the radio before any
+  // medium that depends on it.
+  absl::once_flag bluetooth_radio_once_;
+  absl::once_flag bluetooth_classic_once_;
+  absl::once_flag ble_once_;
+  absl::once_flag ble_v2_once_;
+  absl::once_flag wifi_once_;
+  absl::once_flag wifi_lan_once_;
+  absl::once_flag wifi_hotspot_once_;
+  absl::once_flag wifi_direct_once_;
+  absl::once_flag webrtc_once_;
+  std::unique_ptr<BluetoothRadio> bluetooth_radio_;
+  std::unique_ptr<BluetoothClassic> bluetooth_classic_;
+  std::unique_ptr<Ble> ble_;
+  std::unique_ptr<BleV2> ble_v2_;
+  std::unique_ptr<Wifi> wifi_;
+  std::unique_ptr<WifiLan> wifi_lan_;
+  std::unique_ptr<WifiHotspot> wifi_hotspot_;
+  std::unique_ptr<WifiDirect> wifi_direct_;
+  std::unique_ptr<mediums::WebRtc> webrtc_;
 };
 
 }  // namespace connections
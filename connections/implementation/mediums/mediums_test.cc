@@ -0,0 +1,100 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "connections/implementation/mediums/mediums.h"
+
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "connections/medium_selector.h"
+#include "internal/platform/medium_environment.h"
+
+namespace nearby {
+namespace connections {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::UnorderedElementsAre;
+
+std::vector<std::string> GetInitializedMediums(const Mediums& mediums) {
+  std::vector<std::string> names;
+  for (const Mediums::InitTime& init_time : mediums.GetInitTimes()) {
+    names.push_back(init_time.medium);
+  }
+  return names;
+}
+
+class MediumsTest : public ::testing::Test {
+ protected:
+  void SetUp() override { env_.Start(); }
+  void TearDown() override { env_.Stop(); }
+
+  MediumEnvironment& env_{MediumEnvironment::Instance()};
+};
+
+TEST_F(MediumsTest, NothingIsInitializedUpFront) {
+  Mediums mediums;
+
+  EXPECT_THAT(mediums.GetInitTimes(), IsEmpty());
+}
+
+TEST_F(MediumsTest, MediumIsInitializedOnFirstUse) {
+  Mediums mediums;
+
+  WifiLan& wifi_lan = mediums.GetWifiLan();
+
+  EXPECT_EQ(&mediums.GetWifiLan(), &wifi_lan);
+  EXPECT_THAT(GetInitializedMediums(mediums), ElementsAre("WifiLan"));
+}
+
+TEST_F(MediumsTest, IsCreatedDoesNotCreateMedium) {
+  Mediums mediums;
+
+  EXPECT_FALSE(mediums.IsWifiLanCreated());
+  EXPECT_FALSE(mediums.IsWebRtcCreated());
+  mediums.GetWifiLan();
+
+  EXPECT_TRUE(mediums.IsWifiLanCreated());
+  EXPECT_FALSE(mediums.IsWebRtcCreated());
+  EXPECT_THAT(GetInitializedMediums(mediums), ElementsAre("WifiLan"));
+}
+
+TEST_F(MediumsTest, BluetoothMediumInitializesRadioFirst) {
+  Mediums mediums;
+
+  mediums.GetBluetoothClassic();
+  mediums.GetBle();
+
+  EXPECT_THAT(GetInitializedMediums(mediums),
+              ElementsAre("BluetoothRadio", "BluetoothClassic", "Ble"));
+}
+
+TEST_F(MediumsTest, PrewarmInitializesSelectedMediums) {
+  Mediums mediums;
+  BooleanMediumSelector selector;
+  selector.wifi_lan = true;
+  selector.wifi_hotspot = true;
+
+  mediums.Prewarm(selector);
+
+  EXPECT_THAT(GetInitializedMediums(mediums),
+              UnorderedElementsAre("WifiLan", "Wifi", "WifiHotspot"));
+}
+
+}  // namespace
+}  // namespace connections
+}  // namespace nearby
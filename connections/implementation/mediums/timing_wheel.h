@@ -0,0 +1,139 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CORE_INTERNAL_MEDIUMS_TIMING_WHEEL_H_
+#define CORE_INTERNAL_MEDIUMS_TIMING_WHEEL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+
+namespace nearby {
+namespace connections {
+namespace mediums {
+
+// Tracks when each of a set of keys expires, measured in ticks. Every key sits
+// in the slot of the tick it expires on, so advancing the wheel only visits the
+// keys in one slot instead of every key, and rescheduling a key moves it
+// between slots in constant time.
+//
+// The caller decides what a tick is: a scan round, a second, etc.
+//
+// Note: Key must be hashable and overload the == operator. Not thread safe.
+template <typename Key>
+class TimingWheel {
+ public:
+  // Keys scheduled `num_slots` or more ticks ahead share a slot with keys that
+  // expire sooner, and are skipped over until their tick comes.
+  explicit TimingWheel(size_t num_slots);
+  ~TimingWheel() = default;
+
+  // Schedules `key` to expire `ticks` ticks after the current one, replacing
+  // any earlier schedule. `ticks` must be positive.
+  void Schedule(const Key& key, int64_t ticks);
+
+  // Stops tracking `key`. Returns false if it wasn't scheduled.
+  bool Cancel(const Key& key);
+
+  bool Contains(const Key& key) const { return locations_.contains(key); }
+
+  // Moves to the next tick and returns the keys that expire on it. They are no
+  // longer tracked afterwards.
+  std::vector<Key> Advance();
+
+  int64_t GetCurrentTick() const { return current_tick_; }
+  size_t size() const { return locations_.size(); }
+  bool empty() const { return locations_.empty(); }
+
+ private:
+  struct Entry {
+    Key key;
+    int64_t expiry_tick;
+  };
+  using Slot = std::list<Entry>;
+  struct Location {
+    size_t slot;
+    typename Slot::iterator entry;
+  };
+
+  size_t GetSlot(int64_t tick) const { return tick % slots_.size(); }
+
+  int64_t current_tick_ = 0;
+  std::vector<Slot> slots_;
+  absl::flat_hash_map<Key, Location> locations_;
+};
+
+template <typename Key>
+TimingWheel<Key>::TimingWheel(size_t num_slots) : slots_(num_slots) {}
+
+template <typename Key>
+void TimingWheel<Key>::Schedule(const Key& key, int64_t ticks) {
+  int64_t expiry_tick = current_tick_ + ticks;
+  size_t slot = GetSlot(expiry_tick);
+
+  auto it = locations_.find(key);
+  if (it == locations_.end()) {
+    slots_[slot].push_back({key, expiry_tick});
+    locations_.emplace(key, Location{slot, std::prev(slots_[slot].end())});
+    return;
+  }
+
+  Location& location = it->second;
+  // Rescheduling to the same tick, e.g. when an entity is seen several times
+  // in one round, doesn't touch the slots at all.
+  if (location.entry->expiry_tick == expiry_tick) return;
+  location.entry->expiry_tick = expiry_tick;
+  if (location.slot != slot) {
+    slots_[slot].splice(slots_[slot].end(), slots_[location.slot],
+                        location.entry);
+    location.slot = slot;
+  }
+}
+
+template <typename Key>
+bool TimingWheel<Key>::Cancel(const Key& key) {
+  auto it = locations_.find(key);
+  if (it == locations_.end()) return false;
+  slots_[it->second.slot].erase(it->second.entry);
+  locations_.erase(it);
+  return true;
+}
+
+template <typename Key>
+std::vector<Key> TimingWheel<Key>::Advance() {
+  current_tick_++;
+  std::vector<Key> expired;
+  Slot& slot = slots_[GetSlot(current_tick_)];
+  for (auto it = slot.begin(); it != slot.end();) {
+    if (it->expiry_tick > current_tick_) {
+      ++it;
+      continue;
+    }
+    locations_.erase(it->key);
+    expired.push_back(std::move(it->key));
+    it = slot.erase(it);
+  }
+  return expired;
+}
+
+}  // namespace mediums
+}  // namespace connections
+}  // namespace nearby
+
+#endif  // CORE_INTERNAL_MEDIUMS_TIMING_WHEEL_H_
@@ -0,0 +1,82 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "connections/implementation/mediums/timing_wheel.h"
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace nearby {
+namespace connections {
+namespace mediums {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::UnorderedElementsAre;
+
+TEST(TimingWheelTest, ExpiresOnScheduledTick) {
+  TimingWheel<std::string> wheel(4);
+
+  wheel.Schedule("a", 1);
+  wheel.Schedule("b", 2);
+  wheel.Schedule("c", 2);
+
+  EXPECT_EQ(wheel.size(), 3);
+  EXPECT_THAT(wheel.Advance(), ElementsAre("a"));
+  EXPECT_THAT(wheel.Advance(), UnorderedElementsAre("b", "c"));
+  EXPECT_TRUE(wheel.empty());
+  EXPECT_EQ(wheel.GetCurrentTick(), 2);
+}
+
+TEST(TimingWheelTest, RescheduleReplacesExpiry) {
+  TimingWheel<std::string> wheel(4);
+  wheel.Schedule("a", 1);
+
+  wheel.Schedule("a", 3);
+
+  EXPECT_EQ(wheel.size(), 1);
+  EXPECT_THAT(wheel.Advance(), IsEmpty());
+  EXPECT_THAT(wheel.Advance(), IsEmpty());
+  EXPECT_THAT(wheel.Advance(), ElementsAre("a"));
+}
+
+TEST(TimingWheelTest, Cancel) {
+  TimingWheel<std::string> wheel(4);
+  wheel.Schedule("a", 1);
+
+  EXPECT_TRUE(wheel.Cancel("a"));
+  EXPECT_FALSE(wheel.Cancel("a"));
+
+  EXPECT_FALSE(wheel.Contains("a"));
+  EXPECT_THAT(wheel.Advance(), IsEmpty());
+}
+
+TEST(TimingWheelTest, ScheduleBeyondOneRevolution) {
+  TimingWheel<std::string> wheel(2);
+
+  wheel.Schedule("a", 5);
+
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_THAT(wheel.Advance(), IsEmpty());
+  }
+  EXPECT_THAT(wheel.Advance(), ElementsAre("a"));
+}
+
+}  // namespace
+}  // namespace mediums
+}  // namespace connections
+}  // namespace nearby
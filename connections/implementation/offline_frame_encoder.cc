@@ -0,0 +1,253 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "connections/implementation/offline_frame_encoder.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "connections/implementation/proto/offline_wire_formats.pb.h"
+
+namespace nearby {
+namespace connections {
+namespace parser {
+namespace {
+
+using ::location::nearby::connections::OfflineFrame;
+using ::location::nearby::connections::PayloadTransferFrame;
+using ::location::nearby::connections::V1Frame;
+using PayloadHeader = PayloadTransferFrame::PayloadHeader;
+using PayloadChunk = PayloadTransferFrame::PayloadChunk;
+
+enum WireType : char {
+  kVarint = 0,
+  kLengthDelimited = 2,
+};
+
+// Every field written here has a number below 16, so its tag is one byte.
+constexpr char Tag(int field_number, WireType wire_type) {
+  return static_cast<char>(field_number << 3 | wire_type);
+}
+constexpr size_t kTagSize = 1;
+
+// The fixed fields of the frames, in the order protobuf serializes them.
+constexpr std::array<char, kKeepAliveFrameSize> kKeepAliveFrame = {
+    Tag(OfflineFrame::kVersionFieldNumber, kVarint),
+    OfflineFrame::V1,
+    Tag(OfflineFrame::kV1FieldNumber, kLengthDelimited),
+    4,
+    Tag(V1Frame::kTypeFieldNumber, kVarint),
+    V1Frame::KEEP_ALIVE,
+    Tag(V1Frame::kKeepAliveFieldNumber, kLengthDelimited),
+    0,
+};
+constexpr std::array<char, 2> kVersionV1 = {
+    Tag(OfflineFrame::kVersionFieldNumber, kVarint), OfflineFrame::V1};
+constexpr char kV1Tag = Tag(OfflineFrame::kV1FieldNumber, kLengthDelimited);
+constexpr std::array<char, 2> kPayloadTransferType = {
+    Tag(V1Frame::kTypeFieldNumber, kVarint), V1Frame::PAYLOAD_TRANSFER};
+constexpr char kPayloadTransferTag =
+    Tag(V1Frame::kPayloadTransferFieldNumber, kLengthDelimited);
+constexpr std::array<char, 2> kDataPacketType = {
+    Tag(PayloadTransferFrame::kPacketTypeFieldNumber, kVarint),
+    PayloadTransferFrame::DATA};
+constexpr char kPayloadHeaderTag =
+    Tag(PayloadTransferFrame::kPayloadHeaderFieldNumber, kLengthDelimited);
+constexpr char kPayloadChunkTag =
+    Tag(PayloadTransferFrame::kPayloadChunkFieldNumber, kLengthDelimited);
+
+// Signed integers and enums are sign extended to 64 bits on the wire, so a
+// negative value always takes ten bytes.
+size_t VarintSize(uint64_t value) {
+  size_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    size++;
+  }
+  return size;
+}
+
+size_t LengthDelimitedSize(size_t length) {
+  return kTagSize + VarintSize(length) + length;
+}
+
+char* WriteVarint(uint64_t value, char* out) {
+  while (value >= 0x80) {
+    *out++ = static_cast<char>(value | 0x80);
+    value >>= 7;
+  }
+  *out++ = static_cast<char>(value);
+  return out;
+}
+
+char* WriteBytes(absl::string_view bytes, char* out) {
+  if (!bytes.empty()) std::memcpy(out, bytes.data(), bytes.size());
+  return out + bytes.size();
+}
+
+template <size_t N>
+char* WriteBytes(const std::array<char, N>& bytes, char* out) {
+  return WriteBytes(absl::string_view(bytes.data(), N), out);
+}
+
+char* WriteVarintField(int field_number, uint64_t value, char* out) {
+  *out++ = Tag(field_number, kVarint);
+  return WriteVarint(value, out);
+}
+
+char* WriteLengthDelimitedField(int field_number, absl::string_view value,
+                                char* out) {
+  *out++ = Tag(field_number, kLengthDelimited);
+  out = WriteVarint(value.size(), out);
+  return WriteBytes(value, out);
+}
+
+// Unknown fields, if any, are kept and written after the known ones, like
+// protobuf does. A field added to the proto must be added here too, which the
+// round trip tests catch.
+size_t GetPayloadHeaderSize(const PayloadHeader& header) {
+  size_t size = 0;
+  if (header.has_id()) size += kTagSize + VarintSize(header.id());
+  if (header.has_type()) size += kTagSize + VarintSize(header.type());
+  if (header.has_total_size()) {
+    size += kTagSize + VarintSize(header.total_size());
+  }
+  if (header.has_is_sensitive()) size += kTagSize + 1;
+  if (header.has_file_name()) {
+    size += LengthDelimitedSize(header.file_name().size());
+  }
+  if (header.has_parent_folder()) {
+    size += LengthDelimitedSize(header.parent_folder().size());
+  }
+  return size + header.unknown_fields().size();
+}
+
+char* WritePayloadHeader(const PayloadHeader& header, char* out) {
+  if (header.has_id()) {
+    out = WriteVarintField(PayloadHeader::kIdFieldNumber, header.id(), out);
+  }
+  if (header.has_type()) {
+    out = WriteVarintField(PayloadHeader::kTypeFieldNumber, header.type(), out);
+  }
+  if (header.has_total_size()) {
+    out = WriteVarintField(PayloadHeader::kTotalSizeFieldNumber,
+                           header.total_size(), out);
+  }
+  if (header.has_is_sensitive()) {
+    out = WriteVarintField(PayloadHeader::kIsSensitiveFieldNumber,
+                           header.is_sensitive(), out);
+  }
+  if (header.has_file_name()) {
+    out = WriteLengthDelimitedField(PayloadHeader::kFileNameFieldNumber,
+                                    header.file_name(), out);
+  }
+  if (header.has_parent_folder()) {
+    out = WriteLengthDelimitedField(PayloadHeader::kParentFolderFieldNumber,
+                                    header.parent_folder(), out);
+  }
+  return WriteBytes(header.unknown_fields(), out);
+}
+
+size_t GetPayloadChunkSize(const PayloadChunk& chunk) {
+  size_t size = 0;
+  if (chunk.has_flags()) size += kTagSize + VarintSize(chunk.flags());
+  if (chunk.has_offset()) size += kTagSize + VarintSize(chunk.offset());
+  if (chunk.has_body()) size += LengthDelimitedSize(chunk.body().size());
+  if (chunk.has_index()) size += kTagSize + VarintSize(chunk.index());
+  return size + chunk.unknown_fields().size();
+}
+
+char* WritePayloadChunk(const PayloadChunk& chunk, char* out) {
+  if (chunk.has_flags()) {
+    out = WriteVarintField(PayloadChunk::kFlagsFieldNumber, chunk.flags(), out);
+  }
+  if (chunk.has_offset()) {
+    out =
+        WriteVarintField(PayloadChunk::kOffsetFieldNumber, chunk.offset(), out);
+  }
+  if (chunk.has_body()) {
+    out = WriteLengthDelimitedField(PayloadChunk::kBodyFieldNumber,
+                                    chunk.body(), out);
+  }
+  if (chunk.has_index()) {
+    out = WriteVarintField(PayloadChunk::kIndexFieldNumber, chunk.index(), out);
+  }
+  return WriteBytes(chunk.unknown_fields(), out);
+}
+
+// Lengths of the nested messages of a DATA frame.
+struct DataFrameSizes {
+  size_t header;
+  size_t chunk;
+  size_t payload_transfer;
+  size_t v1;
+  size_t frame;
+};
+
+DataFrameSizes GetDataFrameSizes(const PayloadHeader& header,
+                                 const PayloadChunk& chunk) {
+  DataFrameSizes sizes;
+  sizes.header = GetPayloadHeaderSize(header);
+  sizes.chunk = GetPayloadChunkSize(chunk);
+  sizes.payload_transfer = kDataPacketType.size() +
+                           LengthDelimitedSize(sizes.header) +
+                           LengthDelimitedSize(sizes.chunk);
+  sizes.v1 =
+      kPayloadTransferType.size() + LengthDelimitedSize(sizes.payload_transfer);
+  sizes.frame = kVersionV1.size() + LengthDelimitedSize(sizes.v1);
+  return sizes;
+}
+
+}  // namespace
+
+size_t EncodeKeepAlive(absl::Span<char> buffer) {
+  if (buffer.size() < kKeepAliveFrame.size()) return 0;
+  WriteBytes(kKeepAliveFrame, buffer.data());
+  return kKeepAliveFrame.size();
+}
+
+size_t GetDataPayloadTransferSize(const PayloadHeader& header,
+                                  const PayloadChunk& chunk) {
+  return GetDataFrameSizes(header, chunk).frame;
+}
+
+size_t EncodeDataPayloadTransfer(const PayloadHeader& header,
+                                 const PayloadChunk& chunk,
+                                 absl::Span<char> buffer) {
+  DataFrameSizes sizes = GetDataFrameSizes(header, chunk);
+  if (buffer.size() < sizes.frame) return 0;
+
+  char* out = WriteBytes(kVersionV1, buffer.data());
+  *out++ = kV1Tag;
+  out = WriteVarint(sizes.v1, out);
+  out = WriteBytes(kPayloadTransferType, out);
+  *out++ = kPayloadTransferTag;
+  out = WriteVarint(sizes.payload_transfer, out);
+  out = WriteBytes(kDataPacketType, out);
+  *out++ = kPayloadHeaderTag;
+  out = WriteVarint(sizes.header, out);
+  out = WritePayloadHeader(header, out);
+  *out++ = kPayloadChunkTag;
+  out = WriteVarint(sizes.chunk, out);
+  out = WritePayloadChunk(chunk, out);
+  return out - buffer.data();
+}
+
+}  // namespace parser
+}  // namespace connections
+}  // namespace nearby
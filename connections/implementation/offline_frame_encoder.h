@@ -0,0 +1,60 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CORE_INTERNAL_OFFLINE_FRAME_ENCODER_H_
+#define CORE_INTERNAL_OFFLINE_FRAME_ENCODER_H_
+
+#include <cstddef>
+
+#include "absl/types/span.h"
+#include "connections/implementation/proto/offline_wire_formats.pb.h"
+
+namespace nearby {
+namespace connections {
+namespace parser {
+
+// Encoders for the frames sent most often. Their layout is fixed apart from a
+// few varints and the payload, so they are written field by field straight
+// into the caller's buffer, instead of building an OfflineFrame and
+// serializing it. The bytes are the same as the protobuf encoding.
+
+// Size of the KEEP_ALIVE frame written by EncodeKeepAlive().
+inline constexpr size_t kKeepAliveFrameSize = 8;
+
+// Writes a KEEP_ALIVE frame to `buffer`. Returns the number of bytes written,
+// or 0 if `buffer` is smaller than kKeepAliveFrameSize.
+size_t EncodeKeepAlive(absl::Span<char> buffer);
+
+// Returns the size of the DATA frame written by EncodeDataPayloadTransfer().
+size_t GetDataPayloadTransferSize(
+    const location::nearby::connections::PayloadTransferFrame::PayloadHeader&
+        header,
+    const location::nearby::connections::PayloadTransferFrame::PayloadChunk&
+        chunk);
+
+// Writes a PAYLOAD_TRANSFER frame of type DATA carrying `header` and `chunk`
+// to `buffer`. Returns the number of bytes written, or 0 if `buffer` is
+// smaller than GetDataPayloadTransferSize().
+size_t EncodeDataPayloadTransfer(
+    const location::nearby::connections::PayloadTransferFrame::PayloadHeader&
+        header,
+    const location::nearby::connections::PayloadTransferFrame::PayloadChunk&
+        chunk,
+    absl::Span<char> buffer);
+
+}  // namespace parser
+}  // namespace connections
+}  // namespace nearby
+
+#endif  // CORE_INTERNAL_OFFLINE_FRAME_ENCODER_H_
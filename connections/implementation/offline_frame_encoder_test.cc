@@ -0,0 +1,143 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "connections/implementation/offline_frame_encoder.h"
+
+#include <cstddef>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "absl/types/span.h"
+#include "connections/implementation/proto/offline_wire_formats.pb.h"
+
+namespace nearby {
+namespace connections {
+namespace parser {
+namespace {
+
+using ::location::nearby::connections::OfflineFrame;
+using ::location::nearby::connections::PayloadTransferFrame;
+using ::location::nearby::connections::V1Frame;
+using PayloadHeader = PayloadTransferFrame::PayloadHeader;
+using PayloadChunk = PayloadTransferFrame::PayloadChunk;
+
+std::string SerializeDataFrame(const PayloadHeader& header,
+                               const PayloadChunk& chunk) {
+  OfflineFrame frame;
+  frame.set_version(OfflineFrame::V1);
+  auto* v1_frame = frame.mutable_v1();
+  v1_frame->set_type(V1Frame::PAYLOAD_TRANSFER);
+  auto* sub_frame = v1_frame->mutable_payload_transfer();
+  sub_frame->set_packet_type(PayloadTransferFrame::DATA);
+  *sub_frame->mutable_payload_header() = header;
+  *sub_frame->mutable_payload_chunk() = chunk;
+  return frame.SerializeAsString();
+}
+
+std::string EncodeDataFrame(const PayloadHeader& header,
+                            const PayloadChunk& chunk) {
+  std::string bytes(GetDataPayloadTransferSize(header, chunk), '\0');
+  size_t size = EncodeDataPayloadTransfer(header, chunk, absl::MakeSpan(bytes));
+  EXPECT_EQ(size, bytes.size());
+  return bytes;
+}
+
+TEST(OfflineFrameEncoderTest, KeepAliveMatchesProtobuf) {
+  OfflineFrame frame;
+  frame.set_version(OfflineFrame::V1);
+  frame.mutable_v1()->set_type(V1Frame::KEEP_ALIVE);
+  frame.mutable_v1()->mutable_keep_alive();
+  std::string bytes(kKeepAliveFrameSize, '\0');
+
+  EXPECT_EQ(EncodeKeepAlive(absl::MakeSpan(bytes)), kKeepAliveFrameSize);
+
+  EXPECT_EQ(bytes, frame.SerializeAsString());
+}
+
+TEST(OfflineFrameEncoderTest, DataMatchesProtobuf) {
+  PayloadHeader header;
+  header.set_id(12345);
+  header.set_type(PayloadHeader::FILE);
+  header.set_total_size(1024 * 1024 * 1024);
+  header.set_is_sensitive(true);
+  header.set_file_name("file.txt");
+  header.set_parent_folder("folder");
+  PayloadChunk chunk;
+  chunk.set_flags(PayloadChunk::LAST_CHUNK);
+  chunk.set_offset(1024 * 1024);
+  chunk.set_body(std::string(300, 'x'));
+  chunk.set_index(7);
+
+  EXPECT_EQ(EncodeDataFrame(header, chunk), SerializeDataFrame(header, chunk));
+}
+
+TEST(OfflineFrameEncoderTest, EmptyDataMatchesProtobuf) {
+  PayloadHeader header;
+  PayloadChunk chunk;
+
+  EXPECT_EQ(EncodeDataFrame(header, chunk), SerializeDataFrame(header, chunk));
+
+  chunk.set_body("");
+  EXPECT_EQ(EncodeDataFrame(header, chunk), SerializeDataFrame(header, chunk));
+}
+
+TEST(OfflineFrameEncoderTest, NegativeValuesMatchProtobuf) {
+  PayloadHeader header;
+  header.set_id(-1);
+  header.set_total_size(-1);
+  PayloadChunk chunk;
+  chunk.set_flags(-1);
+  chunk.set_offset(-1);
+  chunk.set_index(-1);
+
+  EXPECT_EQ(EncodeDataFrame(header, chunk), SerializeDataFrame(header, chunk));
+}
+
+TEST(OfflineFrameEncoderTest, LargeBodyMatchesProtobuf) {
+  PayloadHeader header;
+  header.set_id(1);
+  PayloadChunk chunk;
+  chunk.set_body(std::string(1024 * 1024, 'x'));
+
+  EXPECT_EQ(EncodeDataFrame(header, chunk), SerializeDataFrame(header, chunk));
+}
+
+TEST(OfflineFrameEncoderTest, KeepsUnknownFields) {
+  PayloadHeader header;
+  header.set_id(1);
+  // Field 15, varint 1.
+  ASSERT_TRUE(header.MergeFromString(std::string("\x78\x01", 2)));
+  PayloadChunk chunk;
+  chunk.set_body("body");
+  // Field 15, varint 2.
+  ASSERT_TRUE(chunk.MergeFromString(std::string("\x78\x02", 2)));
+
+  EXPECT_EQ(EncodeDataFrame(header, chunk), SerializeDataFrame(header, chunk));
+}
+
+TEST(OfflineFrameEncoderTest, BufferTooSmall) {
+  PayloadHeader header;
+  header.set_id(1);
+  PayloadChunk chunk;
+  chunk.set_body("body");
+  std::string bytes(GetDataPayloadTransferSize(header, chunk) - 1, '\0');
+
+  EXPECT_EQ(EncodeDataPayloadTransfer(header, chunk, absl::MakeSpan(bytes)), 0);
+  EXPECT_EQ(EncodeKeepAlive(absl::MakeSpan(bytes).subspan(0, 1)), 0);
+}
+
+}  // namespace
+}  // namespace parser
+}  // namespace connections
+}  // namespace nearby
@@ -20,12 +20,15 @@
 #include <utility>
 #include <vector>
 
+#include "absl/types/span.h"
 #include "connections/implementation/flags/nearby_connections_feature_flags.h"
+#include "connections/implementation/offline_frame_encoder.h"
 #include "connections/implementation/offline_frames_validator.h"
 #include "connections/implementation/proto/offline_wire_formats.pb.h"
 #include "connections/status.h"
 #include "internal/flags/nearby_flags.h"
 #include "internal/platform/byte_array.h"
+#include "internal/platform/byte_buffer_pool.h"
 
 namespace nearby {
 namespace connections {
@@ -44,11 +47,14 @@ using ::location::nearby::connections::OsInfo;
 using ::location::nearby::connections::PayloadTransferFrame;
 using ::location::nearby::connections::V1Frame;
 
+// Serializes into pooled storage. Callers on the frame path hand the bytes
+// back to the pool, e.g. through `PooledByteArray`, once they are written.
 ByteArray ToBytes(OfflineFrame&& frame) {
-  ByteArray bytes(frame.ByteSizeLong());
   frame.set_version(OfflineFrame::V1);
+  PooledByteBuffer bytes =
+      ByteBufferPool::GetInstance().Acquire(frame.ByteSizeLong());
   frame.SerializeToArray(bytes.data(), bytes.size());
-  return bytes;
+  return std::move(bytes).ToByteArray();
 }
 
 }  // namespace
@@ -56,7 +62,7 @@ ByteArray ToBytes(OfflineFrame&& frame) {
 ExceptionOrOfflineFrame FromBytes(const ByteArray& bytes) {
   OfflineFrame frame;
 
-  if (frame.ParseFromString(std::string(bytes))) {
+  if (frame.ParseFromArray(bytes.data(), bytes.size())) {
     Exception validation_exception = EnsureValidOfflineFrame(frame);
     if (validation_exception.Raised()) {
       return ExceptionOrOfflineFrame(validation_exception);
@@ -168,8 +174,8 @@ ByteArray ForConnectionRequestPresence(
   return ToBytes(std::move(frame));
 }
 
-ByteArray ForConnectionResponse(
-    std::int32_t status, const OsInfo& os_info) {
+ByteArray ForConnectionResponse(std::int32_t status, const OsInfo& os_info,
+                                bool supports_payload_compression) {
   OfflineFrame frame;
 
   frame.set_version(OfflineFrame::V1);
@@ -189,6 +195,14 @@ ByteArray ForConnectionResponse(
       NearbyFlags::GetInstance().GetInt64Flag(
           config_package_nearby::nearby_connections_feature::
               kSafeToDisconnectVersion));
+  if (supports_payload_compression) {
+    sub_frame->add_payload_compressions(ConnectionResponseFrame::DEFLATE);
+  }
+  if (NearbyFlags::GetInstance().GetBoolFlag(
+          config_package_nearby::nearby_connections_feature::
+              kEnableFileBatchPayloads)) {
+    sub_frame->set_supports_file_batches(true);
+  }
 
   return ToBytes(std::move(frame));
 }
@@ -196,17 +210,12 @@ ByteArray ForConnectionResponse(
 ByteArray ForDataPayloadTransfer(
     const PayloadTransferFrame::PayloadHeader& header,
     const PayloadTransferFrame::PayloadChunk& chunk) {
-  OfflineFrame frame;
-
-  frame.set_version(OfflineFrame::V1);
-  auto* v1_frame = frame.mutable_v1();
-  v1_frame->set_type(V1Frame::PAYLOAD_TRANSFER);
-  auto* sub_frame = v1_frame->mutable_payload_transfer();
-  sub_frame->set_packet_type(PayloadTransferFrame::DATA);
-  *sub_frame->mutable_payload_header() = header;
-  *sub_frame->mutable_payload_chunk() = chunk;
-
-  return ToBytes(std::move(frame));
+  // Encoded without an OfflineFrame, which would copy the chunk body.
+  PooledByteBuffer bytes = ByteBufferPool::GetInstance().Acquire(
+      GetDataPayloadTransferSize(header, chunk));
+  EncodeDataPayloadTransfer(header, chunk,
+                            absl::MakeSpan(bytes.data(), bytes.size()));
+  return std::move(bytes).ToByteArray();
 }
 
 ByteArray ForControlPayloadTransfer(
@@ -443,14 +452,9 @@ ByteArray ForBwuFailure(const UpgradePathInfo& info) {
 }
 
 ByteArray ForKeepAlive() {
-  OfflineFrame frame;
-
-  frame.set_version(OfflineFrame::V1);
-  auto* v1_frame = frame.mutable_v1();
-  v1_frame->set_type(V1Frame::KEEP_ALIVE);
-  v1_frame->mutable_keep_alive();
-
-  return ToBytes(std::move(frame));
+  ByteArray bytes(kKeepAliveFrameSize);
+  EncodeKeepAlive(absl::MakeSpan(bytes.data(), bytes.size()));
+  return bytes;
 }
 
 ByteArray ForDisconnection(bool request_safe_to_disconnect,
@@ -53,7 +53,8 @@ ByteArray ForConnectionRequestPresence(
     const location::nearby::connections::PresenceDevice& proto_presence_device,
     const ConnectionInfo& connection_info);
 ByteArray ForConnectionResponse(
-    std::int32_t status, const location::nearby::connections::OsInfo& os_info);
+    std::int32_t status, const location::nearby::connections::OsInfo& os_info,
+    bool supports_payload_compression = false);
 
 // Builds Payload transfer messages.
 ByteArray ForDataPayloadTransfer(
@@ -0,0 +1,389 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Replays a corpus of OfflineFrames through parsing, validation and dispatch
+// the way EndpointManager handles incoming frames. Every frame, pathological
+// ones included, must be handled within a budget proportional to its size, so
+// that a peer can't stall the reader thread.
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "connections/implementation/offline_frames.h"
+#include "connections/implementation/offline_frames_validator.h"
+#include "connections/implementation/proto/offline_wire_formats.pb.h"
+#include "internal/platform/byte_array.h"
+#include "internal/platform/exception.h"
+
+namespace nearby {
+namespace connections {
+namespace parser {
+namespace {
+
+using ::location::nearby::connections::OfflineFrame;
+using ::location::nearby::connections::OsInfo;
+using ::location::nearby::connections::PayloadTransferFrame;
+using ::location::nearby::connections::V1Frame;
+using ::testing::IsEmpty;
+
+constexpr absl::string_view kEndpointId{"ABC"};
+constexpr absl::string_view kEndpointName{"XYZ"};
+constexpr absl::string_view kServiceId{"service"};
+constexpr absl::string_view kSsid{"ssid"};
+constexpr absl::string_view kPassword{"password"};
+constexpr absl::string_view kGateway{"192.168.1.1"};
+constexpr absl::string_view kIp4Bytes{"8xqT"};
+constexpr absl::string_view kWifiDirectSsid{"DIRECT-A0-0123456789AB"};
+constexpr absl::string_view kWifiDirectPassword{"WIFIDIRECT123456"};
+constexpr absl::string_view kMacAddress{"FF:FF:FF:FF:FF:FF"};
+constexpr int kNonce = 1234;
+constexpr int kPort = 1000;
+constexpr int kFrequency = 2412;
+constexpr std::int64_t kPayloadId = 12345;
+constexpr int kChunkSize = 32 * 1024;
+constexpr int kChunkCount = 16;
+constexpr int kReplayRounds = 50;
+// Parse and validation time allowed per KiB of frame, and at least. Linear
+// parsing is about a thousand times faster on a desktop, so only a super-linear
+// validator or parser exceeds it, even on slow or loaded machines.
+constexpr absl::Duration kFrameBudgetPerKib = absl::Milliseconds(1);
+constexpr absl::Duration kMinFrameBudget = absl::Milliseconds(100);
+
+struct CorpusEntry {
+  std::string name;
+  ByteArray bytes;
+  // The frame type it should be dispatched as, or UNKNOWN_FRAME_TYPE if it
+  // should be rejected.
+  V1Frame::FrameType expected_type;
+};
+
+struct ReplayResult {
+  int frames = 0;
+  int rejected = 0;
+  absl::Duration worst;
+  // Entries that took longer than FrameBudget() allows for their size.
+  std::vector<std::string> over_budget;
+};
+
+absl::Duration FrameBudget(const ByteArray& bytes) {
+  return std::max(kMinFrameBudget,
+                  kFrameBudgetPerKib * (bytes.size() / 1024.0));
+}
+
+PayloadTransferFrame::PayloadHeader FileHeader(std::string file_name,
+                                               std::string parent_folder) {
+  PayloadTransferFrame::PayloadHeader header;
+  header.set_id(kPayloadId);
+  header.set_type(PayloadTransferFrame::PayloadHeader::FILE);
+  header.set_total_size(kChunkSize * kChunkCount);
+  header.set_file_name(std::move(file_name));
+  header.set_parent_folder(std::move(parent_folder));
+  return header;
+}
+
+PayloadTransferFrame::PayloadChunk Chunk(std::int64_t offset, int flags,
+                                         std::string body) {
+  PayloadTransferFrame::PayloadChunk chunk;
+  chunk.set_offset(offset);
+  chunk.set_flags(flags);
+  chunk.set_body(std::move(body));
+  return chunk;
+}
+
+ConnectionInfo MakeConnectionInfo(std::string endpoint_id) {
+  return ConnectionInfo{std::move(endpoint_id),
+                        ByteArray{std::string(kEndpointName)},
+                        kNonce,
+                        /*supports_5_ghz=*/true,
+                        std::string(kMacAddress),
+                        kFrequency,
+                        std::string(kIp4Bytes),
+                        {Medium::BLUETOOTH, Medium::WIFI_LAN},
+                        /*keep_alive_interval_millis=*/1000,
+                        /*keep_alive_timeout_millis=*/5000};
+}
+
+// A full session: connection handshake, a file transfer with a bandwidth
+// upgrade part way through, keep-alives and a disconnection.
+std::vector<CorpusEntry> ValidSession() {
+  std::vector<CorpusEntry> corpus;
+  corpus.push_back(
+      {"connection_request",
+       ForConnectionRequestConnections({}, MakeConnectionInfo("ABCD")),
+       V1Frame::CONNECTION_REQUEST});
+  corpus.push_back({"connection_response", ForConnectionResponse(0, OsInfo()),
+                    V1Frame::CONNECTION_RESPONSE});
+  PayloadTransferFrame::PayloadHeader header =
+      FileHeader("photo (1).jpg", "Pictures");
+  std::string body(kChunkSize, 'x');
+  for (int i = 0; i < kChunkCount; ++i) {
+    corpus.push_back(
+        {"data_chunk", ForDataPayloadTransfer(header, Chunk(i * kChunkSize, 0,
+                                                            body)),
+         V1Frame::PAYLOAD_TRANSFER});
+    if (i % 4 == 0) {
+      corpus.push_back(
+          {"keep_alive", ForKeepAlive(), V1Frame::KEEP_ALIVE});
+    }
+    if (i == kChunkCount / 2) {
+      corpus.push_back({"bwu_wifi_hotspot",
+                        ForBwuWifiHotspotPathAvailable(
+                            std::string(kSsid), std::string(kPassword), kPort,
+                            std::string(kGateway), false),
+                        V1Frame::BANDWIDTH_UPGRADE_NEGOTIATION});
+      corpus.push_back({"bwu_wifi_lan",
+                        ForBwuWifiLanPathAvailable(std::string(kIp4Bytes),
+                                                   kPort),
+                        V1Frame::BANDWIDTH_UPGRADE_NEGOTIATION});
+      corpus.push_back({"bwu_wifi_direct",
+                        ForBwuWifiDirectPathAvailable(
+                            std::string(kWifiDirectSsid),
+                            std::string(kWifiDirectPassword), kPort,
+                            kFrequency, false, std::string(kGateway)),
+                        V1Frame::BANDWIDTH_UPGRADE_NEGOTIATION});
+      corpus.push_back({"bwu_bluetooth",
+                        ForBwuBluetoothPathAvailable(std::string(kServiceId),
+                                                     std::string(kMacAddress)),
+                        V1Frame::BANDWIDTH_UPGRADE_NEGOTIATION});
+      corpus.push_back({"bwu_introduction",
+                        ForBwuIntroduction(std::string(kEndpointId), false),
+                        V1Frame::BANDWIDTH_UPGRADE_NEGOTIATION});
+      corpus.push_back({"bwu_introduction_ack", ForBwuIntroductionAck(),
+                        V1Frame::BANDWIDTH_UPGRADE_NEGOTIATION});
+      corpus.push_back({"bwu_last_write", ForBwuLastWrite(),
+                        V1Frame::BANDWIDTH_UPGRADE_NEGOTIATION});
+      corpus.push_back({"bwu_safe_to_close", ForBwuSafeToClose(),
+                        V1Frame::BANDWIDTH_UPGRADE_NEGOTIATION});
+    }
+  }
+  corpus.push_back(
+      {"last_chunk",
+       ForDataPayloadTransfer(
+           header, Chunk(kChunkSize * kChunkCount,
+                         PayloadTransferFrame::PayloadChunk::LAST_CHUNK, "")),
+       V1Frame::PAYLOAD_TRANSFER});
+  PayloadTransferFrame::ControlMessage control;
+  control.set_event(PayloadTransferFrame::ControlMessage::PAYLOAD_CANCELED);
+  control.set_offset(0);
+  corpus.push_back({"control_cancel", ForControlPayloadTransfer(header, control),
+                    V1Frame::PAYLOAD_TRANSFER});
+  corpus.push_back({"disconnection", ForDisconnection(false, false),
+                    V1Frame::DISCONNECTION});
+  return corpus;
+}
+
+std::vector<CorpusEntry> MalformedFrames() {
+  std::vector<CorpusEntry> corpus;
+  std::string request(
+      ForConnectionRequestConnections({}, MakeConnectionInfo("ABCD")));
+  corpus.push_back({"truncated", ByteArray(request.substr(0, request.size() / 2)),
+                    V1Frame::UNKNOWN_FRAME_TYPE});
+  corpus.push_back(
+      {"empty_endpoint_id",
+       ForConnectionRequestConnections({}, MakeConnectionInfo("")),
+       V1Frame::UNKNOWN_FRAME_TYPE});
+  corpus.push_back(
+      {"short_hotspot_password",
+       ForBwuWifiHotspotPathAvailable(std::string(kSsid), "pass", kPort,
+                                      std::string(kGateway), false),
+       V1Frame::UNKNOWN_FRAME_TYPE});
+
+  OfflineFrame data_without_chunk;
+  data_without_chunk.ParseFromString(std::string(ForDataPayloadTransfer(
+      FileHeader("a.txt", ""), Chunk(0, 0, "body"))));
+  data_without_chunk.mutable_v1()
+      ->mutable_payload_transfer()
+      ->clear_payload_chunk();
+  corpus.push_back({"data_without_chunk",
+                    ByteArray(data_without_chunk.SerializeAsString()),
+                    V1Frame::UNKNOWN_FRAME_TYPE});
+
+  std::mt19937 random(/*seed=*/42);
+  for (int i = 0; i < 8; ++i) {
+    std::string noise(64 + i * 32, '\0');
+    for (char& c : noise) c = static_cast<char>(random());
+    // Starts with a frame of an unknown version, so that the noise can't
+    // accidentally be a valid frame.
+    noise[0] = 0x08;
+    noise[1] = 0x7f;
+    corpus.push_back(
+        {"random_noise", ByteArray(std::move(noise)),
+         V1Frame::UNKNOWN_FRAME_TYPE});
+  }
+  return corpus;
+}
+
+std::vector<CorpusEntry> PathologicalFrames() {
+  std::vector<CorpusEntry> corpus;
+  std::string huge(1024 * 1024, 'a');
+  corpus.push_back({"huge_file_name",
+                    ForDataPayloadTransfer(FileHeader(huge, ""),
+                                           Chunk(0, 0, "body")),
+                    V1Frame::PAYLOAD_TRANSFER});
+  corpus.push_back({"huge_parent_folder",
+                    ForDataPayloadTransfer(FileHeader("a.txt", huge),
+                                           Chunk(0, 0, "body")),
+                    V1Frame::PAYLOAD_TRANSFER});
+  corpus.push_back({"huge_file_name_with_illegal_suffix",
+                    ForDataPayloadTransfer(FileHeader(huge + "/", ""),
+                                           Chunk(0, 0, "body")),
+                    V1Frame::UNKNOWN_FRAME_TYPE});
+
+  // A gateway that almost matches the address patterns all the way through.
+  std::string huge_gateway;
+  while (huge_gateway.size() < 64 * 1024) huge_gateway += "192.168.";
+  huge_gateway += "1.1";
+  corpus.push_back({"huge_gateway",
+                    ForBwuWifiHotspotPathAvailable(
+                        std::string(kSsid), std::string(kPassword), kPort,
+                        huge_gateway, false),
+                    V1Frame::UNKNOWN_FRAME_TYPE});
+  corpus.push_back({"huge_wifi_direct_ssid",
+                    ForBwuWifiDirectPathAvailable(
+                        "DIRECT-A0-" + std::string(64 * 1024, 'a'),
+                        std::string(kWifiDirectPassword), kPort, kFrequency,
+                        false, std::string(kGateway)),
+                    V1Frame::UNKNOWN_FRAME_TYPE});
+
+  // Deeply nested groups in an unknown field, past the parser's recursion
+  // limit.
+  std::string deep = std::string(ForKeepAlive());
+  deep.append(100 * 1000, '\x7b');
+  corpus.push_back(
+      {"deep_nesting", ByteArray(std::move(deep)), V1Frame::UNKNOWN_FRAME_TYPE});
+  return corpus;
+}
+
+class OfflineFramesCorpusTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    // Mirrors the frame processors that EndpointManager registers.
+    for (V1Frame::FrameType type :
+         {V1Frame::CONNECTION_REQUEST, V1Frame::CONNECTION_RESPONSE,
+          V1Frame::PAYLOAD_TRANSFER, V1Frame::BANDWIDTH_UPGRADE_NEGOTIATION,
+          V1Frame::KEEP_ALIVE, V1Frame::DISCONNECTION}) {
+      processors_.emplace(type, [this, type](const OfflineFrame& frame) {
+        dispatched_[type]++;
+      });
+    }
+  }
+
+  // Parses, validates and dispatches each frame, like EndpointManager's reader
+  // loop. Returns the frame type each entry was dispatched as.
+  std::vector<V1Frame::FrameType> Replay(const std::vector<CorpusEntry>& corpus,
+                                         ReplayResult& result) {
+    std::vector<V1Frame::FrameType> dispatched;
+    dispatched.reserve(corpus.size());
+    for (const CorpusEntry& entry : corpus) {
+      absl::Time start = absl::Now();
+      V1Frame::FrameType type = V1Frame::UNKNOWN_FRAME_TYPE;
+      ExceptionOr<OfflineFrame> frame = FromBytes(entry.bytes);
+      if (frame.ok()) {
+        type = GetFrameType(frame.result());
+        auto it = processors_.find(type);
+        if (it != processors_.end()) {
+          it->second(frame.result());
+        } else {
+          type = V1Frame::UNKNOWN_FRAME_TYPE;
+        }
+      }
+      absl::Duration elapsed = absl::Now() - start;
+
+      if (type == V1Frame::UNKNOWN_FRAME_TYPE) result.rejected++;
+      result.frames++;
+      result.worst = std::max(result.worst, elapsed);
+      if (elapsed > FrameBudget(entry.bytes)) {
+        result.over_budget.push_back(entry.name);
+      }
+      dispatched.push_back(type);
+    }
+    return dispatched;
+  }
+
+  absl::flat_hash_map<V1Frame::FrameType,
+                      std::function<void(const OfflineFrame&)>>
+      processors_;
+  absl::flat_hash_map<V1Frame::FrameType, int> dispatched_;
+};
+
+TEST_F(OfflineFramesCorpusTest, DispatchesValidSession) {
+  std::vector<CorpusEntry> corpus = ValidSession();
+  ReplayResult result;
+
+  std::vector<V1Frame::FrameType> dispatched = Replay(corpus, result);
+
+  for (int i = 0; i < corpus.size(); ++i) {
+    EXPECT_EQ(dispatched[i], corpus[i].expected_type) << corpus[i].name;
+  }
+  EXPECT_EQ(result.rejected, 0);
+  EXPECT_EQ(dispatched_[V1Frame::PAYLOAD_TRANSFER], kChunkCount + 2);
+  EXPECT_EQ(dispatched_[V1Frame::DISCONNECTION], 1);
+}
+
+TEST_F(OfflineFramesCorpusTest, RejectsMalformedFrames) {
+  std::vector<CorpusEntry> corpus = MalformedFrames();
+  ReplayResult result;
+
+  std::vector<V1Frame::FrameType> dispatched = Replay(corpus, result);
+
+  for (int i = 0; i < corpus.size(); ++i) {
+    EXPECT_EQ(dispatched[i], V1Frame::UNKNOWN_FRAME_TYPE) << corpus[i].name;
+  }
+  EXPECT_TRUE(dispatched_.empty());
+}
+
+TEST_F(OfflineFramesCorpusTest, HandlesPathologicalFrames) {
+  std::vector<CorpusEntry> corpus = PathologicalFrames();
+
+  for (const CorpusEntry& entry : corpus) {
+    ReplayResult result;
+    std::vector<V1Frame::FrameType> dispatched = Replay({entry}, result);
+
+    EXPECT_EQ(dispatched[0], entry.expected_type) << entry.name;
+    EXPECT_THAT(result.over_budget, IsEmpty())
+        << entry.name << " took " << result.worst << " for "
+        << entry.bytes.size() << " bytes";
+  }
+}
+
+TEST_F(OfflineFramesCorpusTest, ReplaysCorpusAtMaxRate) {
+  std::vector<CorpusEntry> corpus = ValidSession();
+  for (CorpusEntry& entry : MalformedFrames()) {
+    corpus.push_back(std::move(entry));
+  }
+  ReplayResult result;
+
+  for (int round = 0; round < kReplayRounds; ++round) {
+    Replay(corpus, result);
+  }
+
+  EXPECT_EQ(result.frames, corpus.size() * kReplayRounds);
+  EXPECT_THAT(result.over_budget, IsEmpty());
+}
+
+}  // namespace
+}  // namespace parser
+}  // namespace connections
+}  // namespace nearby
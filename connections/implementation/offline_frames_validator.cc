@@ -18,6 +18,7 @@
 #include <regex>  //NOLINT
 #include <string>
 
+#include "absl/strings/string_view.h"
 #include "connections/implementation/internal_payload.h"
 #include "connections/implementation/offline_frames.h"
 #include "connections/implementation/proto/offline_wire_formats.pb.h"
@@ -65,11 +66,34 @@ constexpr absl::string_view kWifiDirectSsidPatternString{
 constexpr int kWifiDirectSsidMaxLength = 32;
 constexpr int kWifiPasswordSsidMinLength = 8;
 constexpr int kWifiPasswordSsidMaxLength = 64;
+// Longer than any address the gateway patterns accept. Checked before matching,
+// so that an oversized gateway is rejected without running the regex over it.
+constexpr int kGatewayMaxLength = 45;
 
 inline bool WithinRange(int value, int min, int max) {
   return value >= min && value < max;
 }
 
+// The patterns are compiled once; building a std::regex costs far more than
+// matching one, and every BWU frame is validated.
+const std::regex& Ipv4Pattern() {
+  static const std::regex* pattern =
+      new std::regex(std::string(kIpv4PatternString));
+  return *pattern;
+}
+
+const std::regex& Ipv6Pattern() {
+  static const std::regex* pattern =
+      new std::regex(std::string(kIpv6PatternString));
+  return *pattern;
+}
+
+const std::regex& WifiDirectSsidPattern() {
+  static const std::regex* pattern =
+      new std::regex(std::string(kWifiDirectSsidPatternString));
+  return *pattern;
+}
+
 Exception EnsureValidConnectionRequestFrame(
     const ConnectionRequestFrame& frame) {
   if (!frame.has_endpoint_id()) return {Exception::kInvalidProtocolBuffer};
@@ -165,12 +189,11 @@ Exception EnsureValidBandwidthUpgradeWifiHotspotPathAvailableFrame(
       !WithinRange(wifi_hotspot_credentials.password().length(),
                    kWifiPasswordSsidMinLength, kWifiPasswordSsidMaxLength))
     return {Exception::kInvalidProtocolBuffer};
-  if (!wifi_hotspot_credentials.has_gateway())
+  if (!wifi_hotspot_credentials.has_gateway() ||
+      wifi_hotspot_credentials.gateway().length() > kGatewayMaxLength)
     return {Exception::kInvalidProtocolBuffer};
-  const std::regex ip4_pattern(std::string(kIpv4PatternString).c_str());
-  const std::regex ip6_pattern(std::string(kIpv6PatternString).c_str());
-  if (!(std::regex_match(wifi_hotspot_credentials.gateway(), ip4_pattern) ||
-        std::regex_match(wifi_hotspot_credentials.gateway(), ip6_pattern)))
+  if (!(std::regex_match(wifi_hotspot_credentials.gateway(), Ipv4Pattern()) ||
+        std::regex_match(wifi_hotspot_credentials.gateway(), Ipv6Pattern())))
     return {Exception::kInvalidProtocolBuffer};
 
   // For backwards compatibility reasons, no other fields should be null-checked
@@ -204,11 +227,10 @@ Exception EnsureValidBandwidthUpgradeWifiAwarePathAvailableFrame(
 
 Exception EnsureValidBandwidthUpgradeWifiDirectPathAvailableFrame(
     const WifiDirectCredentials& wifi_direct_credentials) {
-  const std::regex ssid_pattern(
-      std::string(kWifiDirectSsidPatternString).c_str());
   if (!wifi_direct_credentials.has_ssid() ||
       !(wifi_direct_credentials.ssid().length() < kWifiDirectSsidMaxLength &&
-        std::regex_match(wifi_direct_credentials.ssid(), ssid_pattern)))
+        std::regex_match(wifi_direct_credentials.ssid(),
+                         WifiDirectSsidPattern())))
     return {Exception::kInvalidProtocolBuffer};
 
   if (!wifi_direct_credentials.has_password() ||
@@ -341,7 +363,7 @@ Exception EnsureValidBandwidthUpgradeNegotiationFrame(
   return {Exception::kSuccess};
 }
 
-bool CheckForIllegalCharacters(std::string toBeValidated,
+bool CheckForIllegalCharacters(absl::string_view toBeValidated,
                                const absl::string_view illegalPatterns[],
                                size_t illegalPatternsSize) {
   if (toBeValidated.empty()) {
@@ -352,9 +374,9 @@ bool CheckForIllegalCharacters(std::string toBeValidated,
 
   size_t found = 0;
   for (int index = 0; index < illegalPatternsSize; index++) {
-    found = toBeValidated.find(std::string(illegalPatterns[index]));
+    found = toBeValidated.find(illegalPatterns[index]);
 
-    if (found != std::string::npos) {
+    if (found != absl::string_view::npos) {
       // TODO(jfcarroll): Find a way to issue a log statement here.
       // Currently, this breaks the fuzzer, as a logging dep is not
       // included for it in the BUILD file.
@@ -14,15 +14,34 @@
 
 #include "connections/implementation/offline_service_controller.h"
 
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
+#include "absl/time/time.h"
+#include "connections/implementation/flags/nearby_connections_feature_flags.h"
+#include "connections/medium_selector.h"
+#include "internal/flags/nearby_flags.h"
+#include "internal/platform/system_clock.h"
 
 namespace nearby {
 namespace connections {
 
+OfflineServiceController::OfflineServiceController() {
+  if (NearbyFlags::GetInstance().GetBoolFlag(
+          config_package_nearby::nearby_connections_feature::
+              kEnableMediumPrewarm)) {
+    prewarm_executor_ = std::make_unique<SingleThreadExecutor>();
+    prewarm_executor_->Execute("prewarm-mediums", [this]() {
+      mediums_.Prewarm(BooleanMediumSelector().SetAll(true));
+    });
+  }
+  construction_duration_ = SystemClock::ElapsedRealtime() - created_at_;
+}
+
 OfflineServiceController::~OfflineServiceController() { Stop(); }
 
 void OfflineServiceController::Stop() {
@@ -40,8 +59,29 @@ Status OfflineServiceController::StartAdvertising(
   if (stop_) return {Status::kOutOfOrderApiCall};
   NEARBY_LOGS(INFO) << "Client " << client->GetClientId()
                     << " requested advertising to start.";
-  return pcp_manager_.StartAdvertising(client, service_id, advertising_options,
-                                       info);
+  absl::Time start_time = SystemClock::ElapsedRealtime();
+  Status status = pcp_manager_.StartAdvertising(
+      client, service_id, advertising_options, info);
+  if (!advertised_.Set(true)) LogStartupProfile(start_time);
+  return status;
+}
+
+void OfflineServiceController::LogStartupProfile(
+    absl::Time advertising_start_time) {
+  absl::Time now = SystemClock::ElapsedRealtime();
+  std::vector<std::string> medium_init_times;
+  for (const Mediums::InitTime& init_time : mediums_.GetInitTimes()) {
+    medium_init_times.push_back(absl::StrCat(
+        init_time.medium, "=", absl::FormatDuration(init_time.duration)));
+  }
+  absl::Duration before_call =
+      advertising_start_time - created_at_ - construction_duration_;
+  NEARBY_LOGS(INFO) << "Time to first StartAdvertising: " << now - created_at_
+                    << " (construction=" << construction_duration_
+                    << ", before call=" << before_call
+                    << ", StartAdvertising=" << now - advertising_start_time
+                    << "); mediums initialized so far: "
+                    << absl::StrJoin(medium_init_times, ", ");
 }
 
 void OfflineServiceController::StopAdvertising(ClientProxy* client) {
@@ -16,9 +16,11 @@
 #define CORE_INTERNAL_OFFLINE_SERVICE_CONTROLLER_H_
 
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "absl/time/time.h"
 #include "connections/implementation/bwu_manager.h"
 #include "connections/implementation/client_proxy.h"
 #include "connections/implementation/endpoint_channel_manager.h"
@@ -32,13 +34,15 @@
 #include "connections/payload.h"
 #include "connections/status.h"
 #include "connections/v3/connection_listening_options.h"
+#include "internal/platform/single_thread_executor.h"
+#include "internal/platform/system_clock.h"
 
 namespace nearby {
 namespace connections {
 
 class OfflineServiceController : public ServiceController {
  public:
-  OfflineServiceController() = default;
+  OfflineServiceController();
   ~OfflineServiceController() override;
 
   Status StartAdvertising(ClientProxy* client, const std::string& service_id,
@@ -98,11 +102,20 @@ class OfflineServiceController : public ServiceController {
   void ShutdownBwuManagerExecutors() override;
 
  private:
+  // Logs how long it took from construction until the first StartAdvertising()
+  // returned, and what the time went to.
+  void LogStartupProfile(absl::Time advertising_start_time);
+
   // Note that the order of declaration of these is crucial, because we depend
   // on the destructors running (strictly) in the reverse order; a deviation
   // from that will lead to crashes at runtime.
+  absl::Time created_at_ = SystemClock::ElapsedRealtime();
+  absl::Duration construction_duration_;
+  AtomicBoolean advertised_{false};
   AtomicBoolean stop_{false};
   Mediums mediums_;
+  // Creates the mediums ahead of first use, with kEnableMediumPrewarm.
+  std::unique_ptr<SingleThreadExecutor> prewarm_executor_;
   EndpointChannelManager channel_manager_;
   EndpointManager endpoint_manager_{&channel_manager_};
   PayloadManager payload_manager_{endpoint_manager_};
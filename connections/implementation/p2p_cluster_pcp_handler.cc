@@ -15,13 +15,17 @@
 #include "connections/implementation/p2p_cluster_pcp_handler.h"
 
 #include <algorithm>
+#include <cstddef>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/functional/any_invocable.h"
 #include "absl/functional/bind_front.h"
 #include "absl/strings/escaping.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 #include "connections/implementation/base_pcp_handler.h"
 #include "connections/implementation/ble_advertisement.h"
 #include "connections/implementation/ble_endpoint_channel.h"
@@ -36,14 +40,37 @@
 #include "connections/status.h"
 #include "internal/flags/nearby_flags.h"
 #include "internal/interop/device.h"
+#include "internal/platform/count_down_latch.h"
 #include "internal/platform/logging.h"
 #include "internal/platform/nsd_service_info.h"
+#include "internal/platform/system_clock.h"
 #include "internal/platform/types.h"
 #include "proto/connections_enums.pb.h"
 
 namespace nearby {
 namespace connections {
 
+namespace {
+
+// Starts a medium with `start` and logs how long it took until the medium was
+// advertising or discovering.
+Medium StartAndLogDuration(absl::string_view operation,
+                           absl::AnyInvocable<Medium()> start) {
+  absl::Time start_time = SystemClock::ElapsedRealtime();
+  Medium medium = start();
+  absl::Duration duration = SystemClock::ElapsedRealtime() - start_time;
+  if (medium != location::nearby::proto::connections::UNKNOWN_MEDIUM) {
+    NEARBY_LOGS(INFO) << operation << " started in "
+                      << absl::FormatDuration(duration);
+  } else {
+    NEARBY_LOGS(INFO) << operation << " failed after "
+                      << absl::FormatDuration(duration);
+  }
+  return medium;
+}
+
+}  // namespace
+
 ByteArray P2pClusterPcpHandler::GenerateHash(const std::string& source,
                                              size_t size) {
   return Utils::Sha256Hash(source, size);
@@ -65,14 +92,6 @@ P2pClusterPcpHandler::P2pClusterPcpHandler(
     InjectedBluetoothDeviceStore& injected_bluetooth_device_store, Pcp pcp)
     : BasePcpHandler(mediums, endpoint_manager, endpoint_channel_manager,
                      bwu_manager, pcp),
-      bluetooth_radio_(mediums->GetBluetoothRadio()),
-      bluetooth_medium_(mediums->GetBluetoothClassic()),
-      ble_medium_(mediums->GetBle()),
-      ble_v2_medium_(mediums->GetBleV2()),
-      wifi_lan_medium_(mediums->GetWifiLan()),
-      wifi_hotspot_medium_(mediums->GetWifiHotspot()),
-      wifi_direct_medium_(mediums->GetWifiDirect()),
-      webrtc_medium_(mediums->GetWebRtc()),
       injected_bluetooth_device_store_(injected_bluetooth_device_store) {}
 
 P2pClusterPcpHandler::~P2pClusterPcpHandler() {
@@ -81,26 +100,27 @@ P2pClusterPcpHandler::~P2pClusterPcpHandler() {
 }
 
 // Returns a vector or mediums sorted in order or decreasing priority for
-// all the supported mediums.
+// the allowed mediums that are available.
 // Example: WiFi_LAN, WEB_RTC, BT, BLE
-std::vector<Medium> P2pClusterPcpHandler::GetConnectionMediumsByPriority() {
+std::vector<Medium> P2pClusterPcpHandler::GetConnectionMediumsByPriority(
+    const BooleanMediumSelector& allowed) {
   std::vector<Medium> mediums;
-  if (wifi_lan_medium_.IsAvailable()) {
+  if (allowed.wifi_lan && mediums_->GetWifiLan().IsAvailable()) {
     mediums.push_back(location::nearby::proto::connections::WIFI_LAN);
   }
-  if (webrtc_medium_.IsAvailable()) {
+  if (allowed.web_rtc && mediums_->GetWebRtc().IsAvailable()) {
     mediums.push_back(location::nearby::proto::connections::WEB_RTC);
   }
-  if (bluetooth_medium_.IsAvailable()) {
+  if (allowed.bluetooth && mediums_->GetBluetoothClassic().IsAvailable()) {
     mediums.push_back(location::nearby::proto::connections::BLUETOOTH);
   }
   if (NearbyFlags::GetInstance().GetBoolFlag(
           config_package_nearby::nearby_connections_feature::kEnableBleV2)) {
-    if (ble_v2_medium_.IsAvailable()) {
+    if (allowed.ble && mediums_->GetBleV2().IsAvailable()) {
       mediums.push_back(location::nearby::proto::connections::BLE);
     }
   } else {
-    if (ble_medium_.IsAvailable()) {
+    if (allowed.ble && mediums_->GetBle().IsAvailable()) {
       mediums.push_back(location::nearby::proto::connections::BLE);
     }
   }
@@ -120,54 +140,61 @@ BasePcpHandler::StartOperationResult P2pClusterPcpHandler::StartAdvertisingImpl(
 
   WebRtcState web_rtc_state{WebRtcState::kUnconnectable};
 
+  Medium wifi_lan_medium = location::nearby::proto::connections::UNKNOWN_MEDIUM;
+  Medium bluetooth_medium =
+      location::nearby::proto::connections::UNKNOWN_MEDIUM;
+  Medium ble_medium = location::nearby::proto::connections::UNKNOWN_MEDIUM;
+  std::vector<absl::AnyInvocable<void()>> startups;
   if (advertising_options.allowed.wifi_lan) {
-    Medium wifi_lan_medium =
-        StartWifiLanAdvertising(client, service_id, local_endpoint_id,
-                                local_endpoint_info, web_rtc_state);
-    if (wifi_lan_medium !=
-        location::nearby::proto::connections::UNKNOWN_MEDIUM) {
-      NEARBY_LOGS(INFO)
-          << "P2pClusterPcpHandler::StartAdvertisingImpl: WifiLan added";
-      mediums_started_successfully.push_back(wifi_lan_medium);
+    startups.push_back([&]() {
+      wifi_lan_medium = StartAndLogDuration("WifiLan advertising", [&]() {
+        return StartWifiLanAdvertising(client, service_id, local_endpoint_id,
+                                       local_endpoint_info, web_rtc_state);
+      });
+    });
+  }
+  // Bluetooth and BLE share the Bluetooth radio, so they start in turn.
+  startups.push_back([&]() {
+    if (advertising_options.allowed.bluetooth) {
+      bluetooth_medium = StartAndLogDuration("BT advertising", [&]() {
+        const ByteArray bluetooth_hash =
+            GenerateHash(service_id, BluetoothDeviceName::kServiceIdHashLength);
+        return StartBluetoothAdvertising(client, service_id, bluetooth_hash,
+                                         local_endpoint_id, local_endpoint_info,
+                                         web_rtc_state);
+      });
     }
-  }
-
-  if (advertising_options.allowed.bluetooth) {
-    const ByteArray bluetooth_hash =
-        GenerateHash(service_id, BluetoothDeviceName::kServiceIdHashLength);
-    Medium bluetooth_medium = StartBluetoothAdvertising(
-        client, service_id, bluetooth_hash, local_endpoint_id,
-        local_endpoint_info, web_rtc_state);
-    if (bluetooth_medium !=
-        location::nearby::proto::connections::UNKNOWN_MEDIUM) {
-      NEARBY_LOG(INFO, "P2pClusterPcpHandler::StartAdvertisingImpl: BT added");
-      mediums_started_successfully.push_back(bluetooth_medium);
-      bluetooth_classic_advertiser_client_id_ = client->GetClientId();
+    if (advertising_options.allowed.ble) {
+      ble_medium = StartAndLogDuration("Ble advertising", [&]() {
+        if (NearbyFlags::GetInstance().GetBoolFlag(
+                config_package_nearby::nearby_connections_feature::
+                    kEnableBleV2)) {
+          return StartBleV2Advertising(client, service_id, local_endpoint_id,
+                                       local_endpoint_info, advertising_options,
+                                       web_rtc_state);
+        }
+        return StartBleAdvertising(client, service_id, local_endpoint_id,
+                                   local_endpoint_info, advertising_options,
+                                   web_rtc_state);
+      });
     }
-  }
+  });
+  RunMediumStartups(std::move(startups));
 
-  if (advertising_options.allowed.ble) {
-    if (NearbyFlags::GetInstance().GetBoolFlag(
-            config_package_nearby::nearby_connections_feature::kEnableBleV2)) {
-      Medium ble_v2_medium = StartBleV2Advertising(
-          client, service_id, local_endpoint_id, local_endpoint_info,
-          advertising_options, web_rtc_state);
-      if (ble_v2_medium !=
-          location::nearby::proto::connections::UNKNOWN_MEDIUM) {
-        NEARBY_LOGS(INFO)
-            << "P2pClusterPcpHandler::StartAdvertisingImpl: Ble added";
-        mediums_started_successfully.push_back(ble_v2_medium);
-      }
-    } else {
-      Medium ble_medium = StartBleAdvertising(
-          client, service_id, local_endpoint_id, local_endpoint_info,
-          advertising_options, web_rtc_state);
-      if (ble_medium != location::nearby::proto::connections::UNKNOWN_MEDIUM) {
-        NEARBY_LOGS(INFO)
-            << "P2pClusterPcpHandler::StartAdvertisingImpl: Ble added";
-        mediums_started_successfully.push_back(ble_medium);
-      }
-    }
+  if (wifi_lan_medium != location::nearby::proto::connections::UNKNOWN_MEDIUM) {
+    NEARBY_LOGS(INFO)
+        << "P2pClusterPcpHandler::StartAdvertisingImpl: WifiLan added";
+    mediums_started_successfully.push_back(wifi_lan_medium);
+  }
+  if (bluetooth_medium !=
+      location::nearby::proto::connections::UNKNOWN_MEDIUM) {
+    NEARBY_LOG(INFO, "P2pClusterPcpHandler::StartAdvertisingImpl: BT added");
+    mediums_started_successfully.push_back(bluetooth_medium);
+    bluetooth_classic_advertiser_client_id_ = client->GetClientId();
+  }
+  if (ble_medium != location::nearby::proto::connections::UNKNOWN_MEDIUM) {
+    NEARBY_LOGS(INFO) << "P2pClusterPcpHandler::StartAdvertisingImpl: Ble added";
+    mediums_started_successfully.push_back(ble_medium);
   }
 
   if (mediums_started_successfully.empty()) {
@@ -190,29 +217,41 @@ BasePcpHandler::StartOperationResult P2pClusterPcpHandler::StartAdvertisingImpl(
 }
 
 Status P2pClusterPcpHandler::StopAdvertisingImpl(ClientProxy* client) {
-  if (client->GetClientId() == bluetooth_classic_advertiser_client_id_) {
-    bluetooth_medium_.TurnOffDiscoverability();
-    bluetooth_classic_advertiser_client_id_ = 0;
-  } else {
-    NEARBY_LOGS(INFO) << "Skipped BT TurnOffDiscoverability for client="
-                      << client->GetClientId()
-                      << ", client that turned on discoverability is "
-                      << bluetooth_classic_advertiser_client_id_;
-  }
+  // Mediums that were never created have nothing to stop, and getting them
+  // here would create them.
+  if (mediums_->IsBluetoothClassicCreated()) {
+    if (client->GetClientId() == bluetooth_classic_advertiser_client_id_) {
+      mediums_->GetBluetoothClassic().TurnOffDiscoverability();
+      bluetooth_classic_advertiser_client_id_ = 0;
+    } else {
+      NEARBY_LOGS(INFO) << "Skipped BT TurnOffDiscoverability for client="
+                        << client->GetClientId()
+                        << ", client that turned on discoverability is "
+                        << bluetooth_classic_advertiser_client_id_;
+    }
 
-  bluetooth_medium_.StopAcceptingConnections(client->GetAdvertisingServiceId());
+    mediums_->GetBluetoothClassic().StopAcceptingConnections(
+        client->GetAdvertisingServiceId());
+  }
 
   if (NearbyFlags::GetInstance().GetBoolFlag(
           config_package_nearby::nearby_connections_feature::kEnableBleV2)) {
-    ble_v2_medium_.StopAdvertising(client->GetAdvertisingServiceId());
-    ble_v2_medium_.StopAcceptingConnections(client->GetAdvertisingServiceId());
-  } else {
-    ble_medium_.StopAdvertising(client->GetAdvertisingServiceId());
-    ble_medium_.StopAcceptingConnections(client->GetAdvertisingServiceId());
+    if (mediums_->IsBleV2Created()) {
+      mediums_->GetBleV2().StopAdvertising(client->GetAdvertisingServiceId());
+      mediums_->GetBleV2().StopAcceptingConnections(
+          client->GetAdvertisingServiceId());
+    }
+  } else if (mediums_->IsBleCreated()) {
+    mediums_->GetBle().StopAdvertising(client->GetAdvertisingServiceId());
+    mediums_->GetBle().StopAcceptingConnections(
+        client->GetAdvertisingServiceId());
   }
 
-  wifi_lan_medium_.StopAdvertising(client->GetAdvertisingServiceId());
-  wifi_lan_medium_.StopAcceptingConnections(client->GetAdvertisingServiceId());
+  if (mediums_->IsWifiLanCreated()) {
+    mediums_->GetWifiLan().StopAdvertising(client->GetAdvertisingServiceId());
+    mediums_->GetWifiLan().StopAcceptingConnections(
+        client->GetAdvertisingServiceId());
+  }
 
   return {Status::kSuccess};
 }
@@ -512,7 +551,8 @@ void P2pClusterPcpHandler::BlePeripheralDiscoveredHandler(
         }
 
         BluetoothDevice remote_bluetooth_device =
-            bluetooth_medium_.GetRemoteDevice(remote_bluetooth_mac_address);
+            mediums_->GetBluetoothClassic().GetRemoteDevice(
+                remote_bluetooth_mac_address);
         if (!remote_bluetooth_device.IsValid()) {
           NEARBY_LOGS(INFO)
               << "A valid Bluetooth device could not be derived from the MAC "
@@ -684,7 +724,8 @@ void P2pClusterPcpHandler::BleV2PeripheralDiscoveredHandler(
         }
 
         BluetoothDevice remote_bluetooth_device =
-            bluetooth_medium_.GetRemoteDevice(remote_bluetooth_mac_address);
+            mediums_->GetBluetoothClassic().GetRemoteDevice(
+                remote_bluetooth_mac_address);
         if (!remote_bluetooth_device.IsValid()) {
           NEARBY_LOGS(INFO)
               << "A valid Bluetooth device could not be derived from the MAC "
@@ -919,47 +960,54 @@ BasePcpHandler::StartOperationResult P2pClusterPcpHandler::StartDiscoveryImpl(
 
   std::vector<Medium> mediums_started_successfully;
 
+  Medium wifi_lan_medium = location::nearby::proto::connections::UNKNOWN_MEDIUM;
+  Medium bluetooth_medium =
+      location::nearby::proto::connections::UNKNOWN_MEDIUM;
+  Medium ble_medium = location::nearby::proto::connections::UNKNOWN_MEDIUM;
+  std::vector<absl::AnyInvocable<void()>> startups;
   if (discovery_options.allowed.wifi_lan) {
-    Medium wifi_lan_medium = StartWifiLanDiscovery(client, service_id);
-    if (wifi_lan_medium !=
-        location::nearby::proto::connections::UNKNOWN_MEDIUM) {
-      NEARBY_LOGS(INFO)
-          << "P2pClusterPcpHandler::StartDiscoveryImpl: WifiLan added";
-      mediums_started_successfully.push_back(wifi_lan_medium);
-    }
+    startups.push_back([&]() {
+      wifi_lan_medium = StartAndLogDuration("WifiLan discovery", [&]() {
+        return StartWifiLanDiscovery(client, service_id);
+      });
+    });
   }
-
-  if (discovery_options.allowed.bluetooth) {
-    Medium bluetooth_medium = StartBluetoothDiscovery(client, service_id);
-    if (bluetooth_medium !=
-        location::nearby::proto::connections::UNKNOWN_MEDIUM) {
-      NEARBY_LOG(INFO, "P2pClusterPcpHandler::StartDiscoveryImpl: BT added");
-      mediums_started_successfully.push_back(bluetooth_medium);
-      bluetooth_classic_discoverer_client_id_ = client->GetClientId();
+  // Bluetooth and BLE share the Bluetooth radio, so they start in turn.
+  startups.push_back([&]() {
+    if (discovery_options.allowed.bluetooth) {
+      bluetooth_medium = StartAndLogDuration("BT discovery", [&]() {
+        return StartBluetoothDiscovery(client, service_id);
+      });
     }
-  }
-
-  if (discovery_options.allowed.ble) {
-    if (NearbyFlags::GetInstance().GetBoolFlag(
-            config_package_nearby::nearby_connections_feature::kEnableBleV2)) {
-      Medium ble_v2_medium =
-          StartBleV2Scanning(client, service_id, discovery_options);
-      if (ble_v2_medium !=
-          location::nearby::proto::connections::UNKNOWN_MEDIUM) {
-        NEARBY_LOGS(INFO)
-            << "P2pClusterPcpHandler::StartDiscoveryImpl: Ble added.";
-        mediums_started_successfully.push_back(ble_v2_medium);
-      }
-    } else {
-      Medium ble_medium =
-          StartBleScanning(client, service_id,
-                           discovery_options.fast_advertisement_service_uuid);
-      if (ble_medium != location::nearby::proto::connections::UNKNOWN_MEDIUM) {
-        NEARBY_LOGS(INFO)
-            << "P2pClusterPcpHandler::StartDiscoveryImpl: Ble added.";
-        mediums_started_successfully.push_back(ble_medium);
-      }
+    if (discovery_options.allowed.ble) {
+      ble_medium = StartAndLogDuration("Ble discovery", [&]() {
+        if (NearbyFlags::GetInstance().GetBoolFlag(
+                config_package_nearby::nearby_connections_feature::
+                    kEnableBleV2)) {
+          return StartBleV2Scanning(client, service_id, discovery_options);
+        }
+        return StartBleScanning(
+            client, service_id,
+            discovery_options.fast_advertisement_service_uuid);
+      });
     }
+  });
+  RunMediumStartups(std::move(startups));
+
+  if (wifi_lan_medium != location::nearby::proto::connections::UNKNOWN_MEDIUM) {
+    NEARBY_LOGS(INFO)
+        << "P2pClusterPcpHandler::StartDiscoveryImpl: WifiLan added";
+    mediums_started_successfully.push_back(wifi_lan_medium);
+  }
+  if (bluetooth_medium !=
+      location::nearby::proto::connections::UNKNOWN_MEDIUM) {
+    NEARBY_LOG(INFO, "P2pClusterPcpHandler::StartDiscoveryImpl: BT added");
+    mediums_started_successfully.push_back(bluetooth_medium);
+    bluetooth_classic_discoverer_client_id_ = client->GetClientId();
+  }
+  if (ble_medium != location::nearby::proto::connections::UNKNOWN_MEDIUM) {
+    NEARBY_LOGS(INFO) << "P2pClusterPcpHandler::StartDiscoveryImpl: Ble added.";
+    mediums_started_successfully.push_back(ble_medium);
   }
 
   if (mediums_started_successfully.empty()) {
@@ -979,23 +1027,55 @@ BasePcpHandler::StartOperationResult P2pClusterPcpHandler::StartDiscoveryImpl(
   };
 }
 
+void P2pClusterPcpHandler::RunMediumStartups(
+    std::vector<absl::AnyInvocable<void()>> startups) {
+  if (startups.size() < 2 ||
+      !NearbyFlags::GetInstance().GetBoolFlag(
+          config_package_nearby::nearby_connections_feature::
+              kEnableParallelMediumStartup)) {
+    for (auto& startup : startups) {
+      startup();
+    }
+    return;
+  }
+
+  // All but the last radio start on the executor, the last one right here.
+  CountDownLatch latch(startups.size() - 1);
+  for (std::size_t i = 0; i + 1 < startups.size(); ++i) {
+    medium_startup_executor_.Execute(
+        "p2p-start-medium", [startup = &startups[i], &latch]() {
+          (*startup)();
+          latch.CountDown();
+        });
+  }
+  startups.back()();
+  latch.Await();
+}
+
 Status P2pClusterPcpHandler::StopDiscoveryImpl(ClientProxy* client) {
-  wifi_lan_medium_.StopDiscovery(client->GetDiscoveryServiceId());
-  if (client->GetClientId() == bluetooth_classic_discoverer_client_id_) {
-    bluetooth_medium_.StopDiscovery();
-    bluetooth_classic_discoverer_client_id_ = 0;
-  } else {
-    NEARBY_LOGS(INFO) << "Skipped BT StopDiscovery for client="
-                      << client->GetClientId()
-                      << ", client that started discovery is "
-                      << bluetooth_classic_discoverer_client_id_;
+  // As in StopAdvertisingImpl(), skip mediums that were never created.
+  if (mediums_->IsWifiLanCreated()) {
+    mediums_->GetWifiLan().StopDiscovery(client->GetDiscoveryServiceId());
+  }
+  if (mediums_->IsBluetoothClassicCreated()) {
+    if (client->GetClientId() == bluetooth_classic_discoverer_client_id_) {
+      mediums_->GetBluetoothClassic().StopDiscovery();
+      bluetooth_classic_discoverer_client_id_ = 0;
+    } else {
+      NEARBY_LOGS(INFO) << "Skipped BT StopDiscovery for client="
+                        << client->GetClientId()
+                        << ", client that started discovery is "
+                        << bluetooth_classic_discoverer_client_id_;
+    }
   }
 
   if (NearbyFlags::GetInstance().GetBoolFlag(
           config_package_nearby::nearby_connections_feature::kEnableBleV2)) {
-    ble_v2_medium_.StopScanning(client->GetDiscoveryServiceId());
-  } else {
-    ble_medium_.StopScanning(client->GetDiscoveryServiceId());
+    if (mediums_->IsBleV2Created()) {
+      mediums_->GetBleV2().StopScanning(client->GetDiscoveryServiceId());
+    }
+  } else if (mediums_->IsBleCreated()) {
+    mediums_->GetBle().StopScanning(client->GetDiscoveryServiceId());
   }
   return {Status::kSuccess};
 }
@@ -1084,8 +1164,9 @@ P2pClusterPcpHandler::StartListeningForIncomingConnectionsImpl(
     v3::ConnectionListeningOptions options) {
   std::vector<Medium> started_mediums;
   if (options.enable_bluetooth_listening &&
-      !bluetooth_medium_.IsAcceptingConnections(std::string(service_id))) {
-    if (!bluetooth_medium_.StartAcceptingConnections(
+      !mediums_->GetBluetoothClassic().IsAcceptingConnections(
+          std::string(service_id))) {
+    if (!mediums_->GetBluetoothClassic().StartAcceptingConnections(
             std::string(service_id),
             absl::bind_front(
                 &P2pClusterPcpHandler::BluetoothConnectionAcceptedHandler, this,
@@ -1103,8 +1184,8 @@ P2pClusterPcpHandler::StartListeningForIncomingConnectionsImpl(
           config_package_nearby::nearby_connections_feature::kEnableBleV2)) {
     // ble_v2
     if (options.enable_ble_listening &&
-        !ble_v2_medium_.IsAcceptingConnections(std::string(service_id))) {
-      if (!ble_v2_medium_.StartAcceptingConnections(
+        !mediums_->GetBleV2().IsAcceptingConnections(std::string(service_id))) {
+      if (!mediums_->GetBleV2().StartAcceptingConnections(
               std::string(service_id),
               absl::bind_front(
                   &P2pClusterPcpHandler::BleV2ConnectionAcceptedHandler, this,
@@ -1119,8 +1200,8 @@ P2pClusterPcpHandler::StartListeningForIncomingConnectionsImpl(
   } else {
     // ble v1
     if (options.enable_ble_listening &&
-        !ble_medium_.IsAcceptingConnections(std::string(service_id))) {
-      if (!ble_medium_.StartAcceptingConnections(
+        !mediums_->GetBle().IsAcceptingConnections(std::string(service_id))) {
+      if (!mediums_->GetBle().StartAcceptingConnections(
               std::string(service_id),
               absl::bind_front(
                   &P2pClusterPcpHandler::BleConnectionAcceptedHandler, this,
@@ -1134,8 +1215,8 @@ P2pClusterPcpHandler::StartListeningForIncomingConnectionsImpl(
     }
   }
   if (options.enable_wlan_listening &&
-      !wifi_lan_medium_.IsAcceptingConnections(std::string(service_id))) {
-    if (!wifi_lan_medium_.StartAcceptingConnections(
+      !mediums_->GetWifiLan().IsAcceptingConnections(std::string(service_id))) {
+    if (!mediums_->GetWifiLan().StartAcceptingConnections(
             std::string(service_id),
             absl::bind_front(
                 &P2pClusterPcpHandler::WifiLanConnectionAcceptedHandler, this,
@@ -1162,17 +1243,17 @@ P2pClusterPcpHandler::StartListeningForIncomingConnectionsImpl(
 
 void P2pClusterPcpHandler::StopListeningForIncomingConnectionsImpl(
     ClientProxy* client) {
-  if (wifi_lan_medium_.IsAcceptingConnections(
+  if (mediums_->GetWifiLan().IsAcceptingConnections(
           client->GetListeningForIncomingConnectionsServiceId())) {
-    if (!wifi_lan_medium_.StopAcceptingConnections(
+    if (!mediums_->GetWifiLan().StopAcceptingConnections(
             client->GetListeningForIncomingConnectionsServiceId())) {
       NEARBY_LOGS(WARNING)
           << "Unable to stop wifi lan from accepting connections.";
     }
   }
-  if (bluetooth_medium_.IsAcceptingConnections(
+  if (mediums_->GetBluetoothClassic().IsAcceptingConnections(
           client->GetListeningForIncomingConnectionsServiceId())) {
-    if (!bluetooth_medium_.StopAcceptingConnections(
+    if (!mediums_->GetBluetoothClassic().StopAcceptingConnections(
             client->GetListeningForIncomingConnectionsServiceId())) {
       NEARBY_LOGS(WARNING)
           << "Unable to stop bluetooth medium from accepting connections.";
@@ -1180,18 +1261,18 @@ void P2pClusterPcpHandler::StopListeningForIncomingConnectionsImpl(
   }
   if (NearbyFlags::GetInstance().GetBoolFlag(
           config_package_nearby::nearby_connections_feature::kEnableBleV2)) {
-    if (ble_v2_medium_.IsAcceptingConnections(
+    if (mediums_->GetBleV2().IsAcceptingConnections(
             client->GetListeningForIncomingConnectionsServiceId())) {
-      if (!ble_v2_medium_.StopAcceptingConnections(
+      if (!mediums_->GetBleV2().StopAcceptingConnections(
               client->GetListeningForIncomingConnectionsServiceId())) {
         NEARBY_LOGS(WARNING)
             << "Unable to stop ble_v2 medium from accepting connections.";
       }
     }
   } else {
-    if (ble_medium_.IsAcceptingConnections(
+    if (mediums_->GetBle().IsAcceptingConnections(
             client->GetListeningForIncomingConnectionsServiceId())) {
-      if (!ble_medium_.StopAcceptingConnections(
+      if (!mediums_->GetBle().StopAcceptingConnections(
               client->GetListeningForIncomingConnectionsServiceId())) {
         NEARBY_LOGS(WARNING)
             << "Unable to stop ble medium from accepting connections.";
@@ -1240,7 +1321,7 @@ P2pClusterPcpHandler::UpdateAdvertisingOptionsImpl(
   // restart
   std::vector<Medium> restarted_mediums;
   Status status = {Status::kSuccess};
-  WebRtcState web_rtc_state = webrtc_medium_.IsAvailable()
+  WebRtcState web_rtc_state = mediums_->GetWebRtc().IsAvailable()
                                   ? WebRtcState::kConnectable
                                   : WebRtcState::kUndefined;
   // ble
@@ -1325,9 +1406,9 @@ P2pClusterPcpHandler::UpdateDiscoveryOptionsImpl(
                                     discovery_options)) {
     if (NearbyFlags::GetInstance().GetBoolFlag(
             config_package_nearby::nearby_connections_feature::kEnableBleV2)) {
-      ble_v2_medium_.StopScanning(std::string(service_id));
+      mediums_->GetBleV2().StopScanning(std::string(service_id));
     } else {
-      ble_medium_.StopScanning(std::string(service_id));
+      mediums_->GetBle().StopScanning(std::string(service_id));
     }
     StartEndpointLostByMediumAlarms(client, Medium::BLE);
   }
@@ -1335,7 +1416,7 @@ P2pClusterPcpHandler::UpdateDiscoveryOptionsImpl(
   if (NeedsToTurnOffDiscoveryMedium(Medium::BLUETOOTH, old_options,
                                     discovery_options) ||
       needs_restart) {
-    bluetooth_medium_.StopDiscovery();
+    mediums_->GetBluetoothClassic().StopDiscovery();
     StartEndpointLostByMediumAlarms(client, Medium::BLUETOOTH);
   }
   // wifi lan
@@ -1454,9 +1535,9 @@ Medium P2pClusterPcpHandler::StartBluetoothAdvertising(
       INFO,
       "P2pClusterPcpHandler::StartBluetoothAdvertising: service=%s: start",
       service_id.c_str());
-  if (!bluetooth_medium_.IsAcceptingConnections(service_id)) {
-    if (!bluetooth_radio_.Enable() ||
-        !bluetooth_medium_.StartAcceptingConnections(
+  if (!mediums_->GetBluetoothClassic().IsAcceptingConnections(service_id)) {
+    if (!mediums_->GetBluetoothRadio().Enable() ||
+        !mediums_->GetBluetoothClassic().StartAcceptingConnections(
             service_id,
             absl::bind_front(
                 &P2pClusterPcpHandler::BluetoothConnectionAcceptedHandler, this,
@@ -1499,7 +1580,7 @@ Medium P2pClusterPcpHandler::StartBluetoothAdvertising(
                          << ", endpoint_info="
                          << absl::BytesToHexString(local_endpoint_info.data())
                          << "}.";
-    bluetooth_medium_.StopAcceptingConnections(service_id);
+    mediums_->GetBluetoothClassic().StopAcceptingConnections(service_id);
     return location::nearby::proto::connections::UNKNOWN_MEDIUM;
   }
   NEARBY_LOGS(INFO) << "In StartBluetoothAdvertising("
@@ -1509,14 +1590,14 @@ Medium P2pClusterPcpHandler::StartBluetoothAdvertising(
                     << " with service_id=" << service_id;
 
   // Become Bluetooth discoverable.
-  if (!bluetooth_medium_.TurnOnDiscoverability(device_name)) {
+  if (!mediums_->GetBluetoothClassic().TurnOnDiscoverability(device_name)) {
     NEARBY_LOGS(INFO)
         << "In StartBluetoothAdvertising("
         << absl::BytesToHexString(local_endpoint_info.data())
         << "), client=" << client->GetClientId()
         << " couldn't start Bluetooth advertising with BluetoothDeviceName "
         << device_name;
-    bluetooth_medium_.StopAcceptingConnections(service_id);
+    mediums_->GetBluetoothClassic().StopAcceptingConnections(service_id);
     return location::nearby::proto::connections::UNKNOWN_MEDIUM;
   }
   NEARBY_LOGS(INFO)
@@ -1530,8 +1611,8 @@ Medium P2pClusterPcpHandler::StartBluetoothAdvertising(
 
 Medium P2pClusterPcpHandler::StartBluetoothDiscovery(
     ClientProxy* client, const std::string& service_id) {
-  if (bluetooth_radio_.Enable() &&
-      bluetooth_medium_.StartDiscovery({
+  if (mediums_->GetBluetoothRadio().Enable() &&
+      mediums_->GetBluetoothClassic().StartDiscovery({
           .device_discovered_cb = absl::bind_front(
               &P2pClusterPcpHandler::BluetoothDeviceDiscoveredHandler, this,
               client, service_id),
@@ -1563,7 +1644,7 @@ BasePcpHandler::ConnectImplResult P2pClusterPcpHandler::BluetoothConnectImpl(
                        << endpoint->endpoint_id << ") over Bluetooth Classic.";
   BluetoothDevice& device = endpoint->bluetooth_device;
 
-  BluetoothSocket bluetooth_socket = bluetooth_medium_.Connect(
+  BluetoothSocket bluetooth_socket = mediums_->GetBluetoothClassic().Connect(
       device, endpoint->service_id,
       client->GetCancellationFlag(endpoint->endpoint_id));
   if (!bluetooth_socket.IsValid()) {
@@ -1632,9 +1713,9 @@ Medium P2pClusterPcpHandler::StartBleAdvertising(
   // Bluetooth Classic.
   NEARBY_LOGS(INFO) << "P2pClusterPcpHandler::StartBleAdvertising: service_id="
                     << service_id << " : start";
-  if (!ble_medium_.IsAcceptingConnections(service_id)) {
-    if (!bluetooth_radio_.Enable() ||
-        !ble_medium_.StartAcceptingConnections(
+  if (!mediums_->GetBle().IsAcceptingConnections(service_id)) {
+    if (!mediums_->GetBluetoothRadio().Enable() ||
+        !mediums_->GetBle().StartAcceptingConnections(
             service_id, absl::bind_front(
                             &P2pClusterPcpHandler::BleConnectionAcceptedHandler,
                             this, client, local_endpoint_info.AsStringView(),
@@ -1658,10 +1739,10 @@ Medium P2pClusterPcpHandler::StartBleAdvertising(
 
   if (ShouldAdvertiseBluetoothMacOverBle(power_level) ||
       ShouldAcceptBluetoothConnections(advertising_options)) {
-    if (bluetooth_medium_.IsAvailable() &&
-        !bluetooth_medium_.IsAcceptingConnections(service_id)) {
-      if (!bluetooth_radio_.Enable() ||
-          !bluetooth_medium_.StartAcceptingConnections(
+    if (mediums_->GetBluetoothClassic().IsAvailable() &&
+        !mediums_->GetBluetoothClassic().IsAcceptingConnections(service_id)) {
+      if (!mediums_->GetBluetoothRadio().Enable() ||
+          !mediums_->GetBluetoothClassic().StartAcceptingConnections(
               service_id,
               absl::bind_front(
                   &P2pClusterPcpHandler::BluetoothConnectionAcceptedHandler,
@@ -1674,7 +1755,7 @@ Medium P2pClusterPcpHandler::StartBleAdvertising(
             << " failed to start accepting for incoming BLE connections to "
                "service_id="
             << service_id;
-        ble_medium_.StopAcceptingConnections(service_id);
+        mediums_->GetBle().StopAcceptingConnections(service_id);
         return location::nearby::proto::connections::UNKNOWN_MEDIUM;
       }
       NEARBY_LOGS(INFO)
@@ -1704,9 +1785,9 @@ Medium P2pClusterPcpHandler::StartBleAdvertising(
     const ByteArray service_id_hash =
         GenerateHash(service_id, BleAdvertisement::kServiceIdHashLength);
     std::string bluetooth_mac_address;
-    if (bluetooth_medium_.IsAvailable() &&
+    if (mediums_->GetBluetoothClassic().IsAvailable() &&
         ShouldAdvertiseBluetoothMacOverBle(power_level))
-      bluetooth_mac_address = bluetooth_medium_.GetMacAddress();
+      bluetooth_mac_address = mediums_->GetBluetoothClassic().GetMacAddress();
 
     advertisement_bytes = ByteArray(
         BleAdvertisement(kBleAdvertisementVersion, GetPcp(), service_id_hash,
@@ -1718,7 +1799,7 @@ Medium P2pClusterPcpHandler::StartBleAdvertising(
                          << absl::BytesToHexString(local_endpoint_info.data())
                          << "), client=" << client->GetClientId()
                          << " failed to create an advertisement.";
-    ble_medium_.StopAcceptingConnections(service_id);
+    mediums_->GetBle().StopAcceptingConnections(service_id);
     return location::nearby::proto::connections::UNKNOWN_MEDIUM;
   }
 
@@ -1728,7 +1809,7 @@ Medium P2pClusterPcpHandler::StartBleAdvertising(
                     << " generated BleAdvertisement with service_id="
                     << service_id;
 
-  if (!ble_medium_.StartAdvertising(
+  if (!mediums_->GetBle().StartAdvertising(
           service_id, advertisement_bytes,
           advertising_options.fast_advertisement_service_uuid)) {
     NEARBY_LOGS(WARNING)
@@ -1737,7 +1818,7 @@ Medium P2pClusterPcpHandler::StartBleAdvertising(
         << "), client=" << client->GetClientId()
         << " couldn't start BLE Advertising with BleAdvertisement "
         << absl::BytesToHexString(advertisement_bytes.data());
-    ble_medium_.StopAcceptingConnections(service_id);
+    mediums_->GetBle().StopAcceptingConnections(service_id);
     return location::nearby::proto::connections::UNKNOWN_MEDIUM;
   }
   NEARBY_LOGS(INFO) << "In startBleAdvertising("
@@ -1751,8 +1832,8 @@ Medium P2pClusterPcpHandler::StartBleAdvertising(
 Medium P2pClusterPcpHandler::StartBleScanning(
     ClientProxy* client, const std::string& service_id,
     const std::string& fast_advertisement_service_uuid) {
-  if (bluetooth_radio_.Enable() &&
-      ble_medium_.StartScanning(
+  if (mediums_->GetBluetoothRadio().Enable() &&
+      mediums_->GetBle().StartScanning(
           service_id, fast_advertisement_service_uuid,
           {
               .peripheral_discovered_cb = absl::bind_front(
@@ -1785,7 +1866,7 @@ BasePcpHandler::ConnectImplResult P2pClusterPcpHandler::BleConnectImpl(
   BlePeripheral& peripheral = endpoint->ble_peripheral;
 
   BleSocket ble_socket =
-      ble_medium_.Connect(peripheral, endpoint->service_id,
+      mediums_->GetBle().Connect(peripheral, endpoint->service_id,
                           client->GetCancellationFlag(endpoint->endpoint_id));
   if (!ble_socket.IsValid()) {
     NEARBY_LOGS(ERROR)
@@ -1840,9 +1921,9 @@ Medium P2pClusterPcpHandler::StartBleV2Advertising(
   // Bluetooth Classic.
   NEARBY_LOGS(INFO) << "P2pClusterPcpHandler::StartBleAdvertising: service_id="
                     << service_id << " : start";
-  if (!ble_v2_medium_.IsAcceptingConnections(service_id)) {
-    if (!bluetooth_radio_.Enable() ||
-        !ble_v2_medium_.StartAcceptingConnections(
+  if (!mediums_->GetBleV2().IsAcceptingConnections(service_id)) {
+    if (!mediums_->GetBluetoothRadio().Enable() ||
+        !mediums_->GetBleV2().StartAcceptingConnections(
             service_id,
             absl::bind_front(
                 &P2pClusterPcpHandler::BleV2ConnectionAcceptedHandler, this,
@@ -1870,10 +1951,10 @@ Medium P2pClusterPcpHandler::StartBleV2Advertising(
                                : PowerLevel::kHighPower;
   if (ShouldAdvertiseBluetoothMacOverBle(power_level) ||
       ShouldAcceptBluetoothConnections(advertising_options)) {
-    if (bluetooth_medium_.IsAvailable() &&
-        !bluetooth_medium_.IsAcceptingConnections(service_id)) {
-      if (!bluetooth_radio_.Enable() ||
-          !bluetooth_medium_.StartAcceptingConnections(
+    if (mediums_->GetBluetoothClassic().IsAvailable() &&
+        !mediums_->GetBluetoothClassic().IsAcceptingConnections(service_id)) {
+      if (!mediums_->GetBluetoothRadio().Enable() ||
+          !mediums_->GetBluetoothClassic().StartAcceptingConnections(
               service_id,
               absl::bind_front(
                   &P2pClusterPcpHandler::BluetoothConnectionAcceptedHandler,
@@ -1886,7 +1967,7 @@ Medium P2pClusterPcpHandler::StartBleV2Advertising(
             << " failed to start accepting for incoming BLE connections to "
                "service_id="
             << service_id;
-        ble_v2_medium_.StopAcceptingConnections(service_id);
+        mediums_->GetBleV2().StopAcceptingConnections(service_id);
         return location::nearby::proto::connections::UNKNOWN_MEDIUM;
       }
       NEARBY_LOGS(INFO)
@@ -1917,9 +1998,9 @@ Medium P2pClusterPcpHandler::StartBleV2Advertising(
     const ByteArray service_id_hash =
         GenerateHash(service_id, BleAdvertisement::kServiceIdHashLength);
     std::string bluetooth_mac_address;
-    if (bluetooth_medium_.IsAvailable() &&
+    if (mediums_->GetBluetoothClassic().IsAvailable() &&
         ShouldAdvertiseBluetoothMacOverBle(power_level))
-      bluetooth_mac_address = bluetooth_medium_.GetMacAddress();
+      bluetooth_mac_address = mediums_->GetBluetoothClassic().GetMacAddress();
 
     advertisement_bytes = ByteArray(BleAdvertisement(
         kBleAdvertisementVersion, GetPcp(), service_id_hash, local_endpoint_id,
@@ -1931,7 +2012,7 @@ Medium P2pClusterPcpHandler::StartBleV2Advertising(
                          << absl::BytesToHexString(local_endpoint_info.data())
                          << "), client=" << client->GetClientId()
                          << " failed to create an advertisement.";
-    ble_v2_medium_.StopAcceptingConnections(service_id);
+    mediums_->GetBleV2().StopAcceptingConnections(service_id);
     return location::nearby::proto::connections::UNKNOWN_MEDIUM;
   }
 
@@ -1941,7 +2022,7 @@ Medium P2pClusterPcpHandler::StartBleV2Advertising(
                     << " generated BleAdvertisement with service_id="
                     << service_id;
 
-  if (!ble_v2_medium_.StartAdvertising(
+  if (!mediums_->GetBleV2().StartAdvertising(
           service_id, advertisement_bytes, power_level,
           !advertising_options.fast_advertisement_service_uuid.empty())) {
     NEARBY_LOGS(WARNING)
@@ -1950,7 +2031,7 @@ Medium P2pClusterPcpHandler::StartBleV2Advertising(
         << "), client=" << client->GetClientId()
         << " couldn't start BLE Advertising with BleAdvertisement "
         << absl::BytesToHexString(advertisement_bytes.data());
-    ble_v2_medium_.StopAcceptingConnections(service_id);
+    mediums_->GetBleV2().StopAcceptingConnections(service_id);
     return location::nearby::proto::connections::UNKNOWN_MEDIUM;
   }
   NEARBY_LOGS(INFO) << "In startBleAdvertising("
@@ -1966,8 +2047,8 @@ Medium P2pClusterPcpHandler::StartBleV2Scanning(
     const DiscoveryOptions& discovery_options) {
   PowerLevel power_level = discovery_options.low_power ? PowerLevel::kLowPower
                                                        : PowerLevel::kHighPower;
-  if (bluetooth_radio_.Enable() &&
-      ble_v2_medium_.StartScanning(
+  if (mediums_->GetBluetoothRadio().Enable() &&
+      mediums_->GetBleV2().StartScanning(
           service_id, power_level,
           {
               .peripheral_discovered_cb = absl::bind_front(
@@ -1998,7 +2079,7 @@ BasePcpHandler::ConnectImplResult P2pClusterPcpHandler::BleV2ConnectImpl(
 
   BleV2Peripheral& peripheral = endpoint->ble_peripheral;
 
-  BleV2Socket ble_socket = ble_v2_medium_.Connect(
+  BleV2Socket ble_socket = mediums_->GetBleV2().Connect(
       endpoint->service_id, peripheral,
       client->GetCancellationFlag(endpoint->endpoint_id));
   if (!ble_socket.IsValid()) {
@@ -2053,8 +2134,8 @@ Medium P2pClusterPcpHandler::StartWifiLanAdvertising(
   // request comes in very quickly.
   NEARBY_LOGS(INFO) << "P2pClusterPcpHandler::StartWifiLanAdvertising: service="
                     << service_id << ": start";
-  if (!wifi_lan_medium_.IsAcceptingConnections(service_id)) {
-    if (!wifi_lan_medium_.StartAcceptingConnections(
+  if (!mediums_->GetWifiLan().IsAcceptingConnections(service_id)) {
+    if (!mediums_->GetWifiLan().StartAcceptingConnections(
             service_id,
             absl::bind_front(
                 &P2pClusterPcpHandler::WifiLanConnectionAcceptedHandler, this,
@@ -2102,7 +2183,7 @@ Medium P2pClusterPcpHandler::StartWifiLanAdvertising(
                          << ", endpoint_info="
                          << absl::BytesToHexString(local_endpoint_info.data())
                          << "}.";
-    wifi_lan_medium_.StopAcceptingConnections(service_id);
+    mediums_->GetWifiLan().StopAcceptingConnections(service_id);
     return location::nearby::proto::connections::UNKNOWN_MEDIUM;
   }
   NEARBY_LOGS(INFO) << "In StartWifiLanAdvertising("
@@ -2112,13 +2193,13 @@ Medium P2pClusterPcpHandler::StartWifiLanAdvertising(
                     << nsd_service_info.GetServiceName()
                     << " with service_id=" << service_id;
 
-  if (!wifi_lan_medium_.StartAdvertising(service_id, nsd_service_info)) {
+  if (!mediums_->GetWifiLan().StartAdvertising(service_id, nsd_service_info)) {
     NEARBY_LOGS(INFO) << "In StartWifiLanAdvertising("
                       << absl::BytesToHexString(local_endpoint_info.data())
                       << "), client=" << client->GetClientId()
                       << " couldn't advertise with WifiLanServiceInfo "
                       << nsd_service_info.GetServiceName();
-    wifi_lan_medium_.StopAcceptingConnections(service_id);
+    mediums_->GetWifiLan().StopAcceptingConnections(service_id);
     return location::nearby::proto::connections::UNKNOWN_MEDIUM;
   }
   NEARBY_LOGS(INFO) << "In StartWifiLanAdvertising("
@@ -2131,7 +2212,7 @@ Medium P2pClusterPcpHandler::StartWifiLanAdvertising(
 
 Medium P2pClusterPcpHandler::StartWifiLanDiscovery(
     ClientProxy* client, const std::string& service_id) {
-  if (wifi_lan_medium_.StartDiscovery(
+  if (mediums_->GetWifiLan().StartDiscovery(
           service_id,
           {
               .service_discovered_cb = absl::bind_front(
@@ -2160,7 +2241,7 @@ BasePcpHandler::ConnectImplResult P2pClusterPcpHandler::WifiLanConnectImpl(
   NEARBY_LOGS(INFO) << "Client " << client->GetClientId()
                     << " is attempting to connect to endpoint(id="
                     << endpoint->endpoint_id << ") over WifiLan.";
-  WifiLanSocket socket = wifi_lan_medium_.Connect(
+  WifiLanSocket socket = mediums_->GetWifiLan().Connect(
       endpoint->service_id, endpoint->service_info,
       client->GetCancellationFlag(endpoint->endpoint_id));
   if (!socket.IsValid()) {
@@ -19,6 +19,7 @@
 #include <string>
 #include <vector>
 
+#include "absl/functional/any_invocable.h"
 #include "connections/implementation/base_pcp_handler.h"
 #include "connections/implementation/ble_advertisement.h"
 #include "connections/implementation/bluetooth_device_name.h"
@@ -38,6 +39,7 @@
 #include "connections/implementation/pcp.h"
 #include "connections/implementation/wifi_lan_service_info.h"
 #include "internal/platform/byte_array.h"
+#include "internal/platform/multi_thread_executor.h"
 
 namespace nearby {
 namespace connections {
@@ -60,7 +62,8 @@ class P2pClusterPcpHandler : public BasePcpHandler {
 
  protected:
   std::vector<location::nearby::proto::connections::Medium>
-  GetConnectionMediumsByPriority() override;
+  GetConnectionMediumsByPriority(
+      const BooleanMediumSelector& allowed) override;
   location::nearby::proto::connections::Medium GetDefaultUpgradeMedium()
       override;
 
@@ -261,18 +264,18 @@ class P2pClusterPcpHandler : public BasePcpHandler {
   BasePcpHandler::ConnectImplResult WifiLanConnectImpl(
       ClientProxy* client, WifiLanEndpoint* endpoint);
 
-  BluetoothRadio& bluetooth_radio_;
-  BluetoothClassic& bluetooth_medium_;
-  Ble& ble_medium_;
-  BleV2& ble_v2_medium_;
-  WifiLan& wifi_lan_medium_;
-  WifiHotspot& wifi_hotspot_medium_;
-  WifiDirect& wifi_direct_medium_;
-  mediums::WebRtc& webrtc_medium_;
+  // Runs `startups`, each of which starts the mediums of one radio, and
+  // returns once all of them are done. With kEnableParallelMediumStartup, the
+  // radios start at the same time instead of one after another.
+  void RunMediumStartups(std::vector<absl::AnyInvocable<void()>> startups);
+
   InjectedBluetoothDeviceStore& injected_bluetooth_device_store_;
   std::int64_t bluetooth_classic_discoverer_client_id_{0};
   std::int64_t bluetooth_classic_advertiser_client_id_{0};
 
+  // Starts WifiLan while the calling thread starts Bluetooth and BLE.
+  MultiThreadExecutor medium_startup_executor_{1};
+
   // Maps a BlePeripheral to its corresponding BleEndpointState.
   absl::flat_hash_map<std::string, BleEndpointState> found_ble_endpoints_;
 
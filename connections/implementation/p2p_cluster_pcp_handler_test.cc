@@ -33,6 +33,7 @@
 #include "internal/platform/count_down_latch.h"
 #include "internal/platform/logging.h"
 #include "internal/platform/medium_environment.h"
+#include "internal/platform/system_clock.h"
 
 namespace nearby {
 namespace connections {
@@ -77,6 +78,10 @@ class P2pClusterPcpHandlerTest
     NearbyFlags::GetInstance().OverrideBoolFlagValue(
         config_package_nearby::nearby_connections_feature::kEnableBleV2,
         std::get<1>(GetParam()));
+    NearbyFlags::GetInstance().OverrideBoolFlagValue(
+        config_package_nearby::nearby_connections_feature::
+            kEnableParallelMediumStartup,
+        false);
     if (advertising_options_.allowed.ble) {
       NEARBY_LOG(INFO, "SetUp: BLE enabled");
     }
@@ -160,6 +165,50 @@ TEST_P(P2pClusterPcpHandlerTest, CanAdvertise) {
   env_.Stop();
 }
 
+TEST_P(P2pClusterPcpHandlerTest, AdvertisingOnlyCreatesAllowedMediums) {
+  env_.Start();
+  std::string endpoint_name{"endpoint_name"};
+  Mediums mediums_a;
+  EndpointChannelManager ecm_a;
+  EndpointManager em_a(&ecm_a);
+  BwuManager bwu_a(mediums_a, em_a, ecm_a, {}, {});
+  InjectedBluetoothDeviceStore ibds_a;
+  P2pClusterPcpHandler handler_a(&mediums_a, &em_a, &ecm_a, &bwu_a, ibds_a);
+
+  absl::Time start_time = SystemClock::ElapsedRealtime();
+  EXPECT_EQ(
+      handler_a.StartAdvertising(&client_a_, service_id_, advertising_options_,
+                                 {.endpoint_info = ByteArray{endpoint_name}}),
+      Status{Status::kSuccess});
+  absl::Duration time_to_advertise =
+      SystemClock::ElapsedRealtime() - start_time;
+
+  // Break the time to first advertisement down by the mediums created for it.
+  absl::Duration init_time_total = absl::ZeroDuration();
+  for (const Mediums::InitTime& init_time : mediums_a.GetInitTimes()) {
+    NEARBY_LOGS(INFO) << "Creating " << init_time.medium << " took "
+                      << init_time.duration << " of " << time_to_advertise
+                      << " to start advertising";
+    init_time_total += init_time.duration;
+  }
+  EXPECT_LE(init_time_total, time_to_advertise);
+
+  handler_a.StopAdvertising(&client_a_);
+  const BooleanMediumSelector& allowed = advertising_options_.allowed;
+  EXPECT_EQ(mediums_a.IsWifiLanCreated(), allowed.wifi_lan);
+  EXPECT_FALSE(mediums_a.IsWebRtcCreated());
+  EXPECT_FALSE(mediums_a.IsWifiHotspotCreated());
+  EXPECT_FALSE(mediums_a.IsWifiDirectCreated());
+  if (!allowed.ble) {
+    EXPECT_FALSE(mediums_a.IsBleCreated());
+    EXPECT_FALSE(mediums_a.IsBleV2Created());
+  }
+  if (!allowed.bluetooth && !allowed.ble) {
+    EXPECT_FALSE(mediums_a.IsBluetoothRadioCreated());
+  }
+  env_.Stop();
+}
+
 TEST_P(P2pClusterPcpHandlerTest, CanUpdateAdvertisingOptions) {
   bool ble_v2_enabled = std::get<1>(GetParam());
   if (!ble_v2_enabled) {
@@ -338,6 +387,59 @@ TEST_P(P2pClusterPcpHandlerTest, CanDiscover) {
   env_.Stop();
 }
 
+TEST_P(P2pClusterPcpHandlerTest, CanAdvertiseAndDiscoverInParallel) {
+  NearbyFlags::GetInstance().OverrideBoolFlagValue(
+      config_package_nearby::nearby_connections_feature::
+          kEnableParallelMediumStartup,
+      true);
+  bool ble_v2_enabled = std::get<1>(GetParam());
+  env_.Start();
+  std::string endpoint_name{"endpoint_name"};
+  Mediums mediums_a;
+  Mediums mediums_b;
+  EndpointChannelManager ecm_a;
+  EndpointChannelManager ecm_b;
+  EndpointManager em_a(&ecm_a);
+  EndpointManager em_b(&ecm_b);
+  BwuManager bwu_a(mediums_a, em_a, ecm_a, {}, {});
+  BwuManager bwu_b(mediums_b, em_b, ecm_b, {}, {});
+  InjectedBluetoothDeviceStore ibds_a;
+  InjectedBluetoothDeviceStore ibds_b;
+  P2pClusterPcpHandler handler_a(&mediums_a, &em_a, &ecm_a, &bwu_a, ibds_a);
+  P2pClusterPcpHandler handler_b(&mediums_b, &em_b, &ecm_b, &bwu_b, ibds_b);
+  CountDownLatch latch(1);
+  EXPECT_EQ(
+      handler_a.StartAdvertising(&client_a_, service_id_, advertising_options_,
+                                 {.endpoint_info = ByteArray{endpoint_name}}),
+      Status{Status::kSuccess});
+  BooleanMediumSelector enabled = advertising_options_.allowed;
+  EXPECT_EQ(enabled.wifi_lan,
+            mediums_a.GetWifiLan().IsAdvertising(service_id_));
+  if (ble_v2_enabled) {
+    EXPECT_EQ(enabled.ble, mediums_a.GetBleV2().IsAdvertising(service_id_));
+  } else {
+    EXPECT_EQ(enabled.ble, mediums_a.GetBle().IsAdvertising(service_id_));
+  }
+  EXPECT_EQ(
+      enabled.bluetooth || enabled.ble,
+      mediums_a.GetBluetoothClassic().IsAcceptingConnections(service_id_));
+  EXPECT_EQ(handler_b.StartDiscovery(
+                &client_b_, service_id_, discovery_options_,
+                {
+                    .endpoint_found_cb =
+                        [&latch](const std::string& endpoint_id,
+                                 const ByteArray& endpoint_info,
+                                 const std::string& service_id) {
+                          latch.CountDown();
+                        },
+                }),
+            Status{Status::kSuccess});
+  EXPECT_TRUE(latch.Await(absl::Milliseconds(1000)).result());
+  handler_b.StopDiscovery(&client_b_);
+  handler_a.StopAdvertising(&client_a_);
+  env_.Stop();
+}
+
 TEST_P(P2pClusterPcpHandlerTest, CanBluetoothDiscoverChangeName) {
   env_.Start();
   std::string endpoint_name{"endpoint_name"};
@@ -27,26 +27,27 @@ P2pPointToPointPcpHandler::P2pPointToPointPcpHandler(
                         injected_bluetooth_device_store, pcp) {}
 
 std::vector<location::nearby::proto::connections::Medium>
-P2pPointToPointPcpHandler::GetConnectionMediumsByPriority() {
+P2pPointToPointPcpHandler::GetConnectionMediumsByPriority(
+    const BooleanMediumSelector& allowed) {
   std::vector<location::nearby::proto::connections::Medium> mediums;
-  if (mediums_->GetWifiLan().IsAvailable()) {
+  if (allowed.wifi_lan && mediums_->GetWifiLan().IsAvailable()) {
     mediums.push_back(location::nearby::proto::connections::WIFI_LAN);
   }
-  if (mediums_->GetWifi().IsAvailable() &&
+  if (allowed.wifi_direct && mediums_->GetWifi().IsAvailable() &&
       mediums_->GetWifiDirect().IsGCAvailable()) {
     mediums.push_back(location::nearby::proto::connections::WIFI_DIRECT);
   }
-  if (mediums_->GetWifi().IsAvailable() &&
+  if (allowed.wifi_hotspot && mediums_->GetWifi().IsAvailable() &&
       mediums_->GetWifiHotspot().IsClientAvailable()) {
     mediums.push_back(location::nearby::proto::connections::WIFI_HOTSPOT);
   }
-  if (mediums_->GetWebRtc().IsAvailable()) {
+  if (allowed.web_rtc && mediums_->GetWebRtc().IsAvailable()) {
     mediums.push_back(location::nearby::proto::connections::WEB_RTC);
   }
-  if (mediums_->GetBluetoothClassic().IsAvailable()) {
+  if (allowed.bluetooth && mediums_->GetBluetoothClassic().IsAvailable()) {
     mediums.push_back(location::nearby::proto::connections::BLUETOOTH);
   }
-  if (mediums_->GetBle().IsAvailable()) {
+  if (allowed.ble && mediums_->GetBle().IsAvailable()) {
     mediums.push_back(location::nearby::proto::connections::BLE);
   }
   return mediums;
@@ -41,7 +41,8 @@ class P2pPointToPointPcpHandler : public P2pStarPcpHandler {
 
  protected:
   std::vector<location::nearby::proto::connections::Medium>
-  GetConnectionMediumsByPriority() override;
+  GetConnectionMediumsByPriority(
+      const BooleanMediumSelector& allowed) override;
 
   bool CanSendOutgoingConnection(ClientProxy* client) const override;
   bool CanReceiveIncomingConnection(ClientProxy* client) const override;
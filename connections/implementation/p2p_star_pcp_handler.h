@@ -44,7 +44,8 @@ class P2pStarPcpHandler : public P2pClusterPcpHandler {
 
  protected:
   std::vector<location::nearby::proto::connections::Medium>
-  GetConnectionMediumsByPriority() override;
+  GetConnectionMediumsByPriority(
+      const BooleanMediumSelector& allowed) override;
   location::nearby::proto::connections::Medium GetDefaultUpgradeMedium()
       override;
 
@@ -0,0 +1,89 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "connections/implementation/payload_compression.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "absl/strings/string_view.h"
+#include "internal/platform/exception.h"
+#include "zlib.h"
+
+namespace nearby {
+namespace connections {
+
+namespace {
+constexpr std::size_t kSizeHeaderLength = 4;
+}  // namespace
+
+std::optional<std::string> PayloadCompression::Compress(
+    absl::string_view body) {
+  if (body.size() < kMinCompressedBodySize ||
+      body.size() > kMaxDecompressedBodySize) {
+    return std::nullopt;
+  }
+
+  std::string compressed_body(
+      kSizeHeaderLength + compressBound(static_cast<uLong>(body.size())), '\0');
+  for (std::size_t i = 0; i < kSizeHeaderLength; ++i) {
+    compressed_body[i] =
+        static_cast<char>(body.size() >> (8 * (kSizeHeaderLength - 1 - i)));
+  }
+  uLongf compressed_size = compressed_body.size() - kSizeHeaderLength;
+  if (compress2(reinterpret_cast<Bytef*>(&compressed_body[kSizeHeaderLength]),
+                &compressed_size, reinterpret_cast<const Bytef*>(body.data()),
+                static_cast<uLong>(body.size()), Z_BEST_SPEED) != Z_OK) {
+    return std::nullopt;
+  }
+  compressed_body.resize(kSizeHeaderLength + compressed_size);
+
+  if (compressed_body.size() * 8 > body.size() * kMaxCompressionRatioEighths) {
+    return std::nullopt;
+  }
+  return compressed_body;
+}
+
+ExceptionOr<std::string> PayloadCompression::Decompress(
+    absl::string_view compressed_body) {
+  if (compressed_body.size() < kSizeHeaderLength) {
+    return ExceptionOr<std::string>(Exception::kInvalidProtocolBuffer);
+  }
+  std::size_t body_size = 0;
+  for (std::size_t i = 0; i < kSizeHeaderLength; ++i) {
+    body_size =
+        (body_size << 8) | static_cast<std::uint8_t>(compressed_body[i]);
+  }
+  if (body_size > kMaxDecompressedBodySize) {
+    return ExceptionOr<std::string>(Exception::kInvalidProtocolBuffer);
+  }
+
+  std::string body(body_size, '\0');
+  uLongf decompressed_size = body_size;
+  if (uncompress(reinterpret_cast<Bytef*>(body.data()), &decompressed_size,
+                 reinterpret_cast<const Bytef*>(
+                     compressed_body.data() + kSizeHeaderLength),
+                 static_cast<uLong>(compressed_body.size() -
+                                    kSizeHeaderLength)) != Z_OK ||
+      decompressed_size != body_size) {
+    return ExceptionOr<std::string>(Exception::kInvalidProtocolBuffer);
+  }
+  return ExceptionOr<std::string>(std::move(body));
+}
+
+}  // namespace connections
+}  // namespace nearby
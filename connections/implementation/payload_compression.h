@@ -0,0 +1,55 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_NEARBY_CONNECTIONS_IMPLEMENTATION_PAYLOAD_COMPRESSION_H_
+#define THIRD_PARTY_NEARBY_CONNECTIONS_IMPLEMENTATION_PAYLOAD_COMPRESSION_H_
+
+#include <cstddef>
+#include <optional>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "internal/platform/exception.h"
+
+namespace nearby {
+namespace connections {
+
+// Compresses the bodies of payload chunks sent to endpoints that announced
+// they can decompress them.
+//
+// A compressed body is the 4-byte big-endian size of the original body
+// followed by the body deflated with zlib at its fastest level.
+class PayloadCompression {
+ public:
+  // Bodies smaller than this don't gain enough to pay for the header.
+  static constexpr std::size_t kMinCompressedBodySize = 256;
+  // A body must shrink to at most 7/8 of its size to be sent compressed.
+  static constexpr std::size_t kMaxCompressionRatioEighths = 7;
+  // The largest original body a compressed body may claim. Chunks are far
+  // smaller; this only bounds what a misbehaving peer can make us allocate.
+  static constexpr std::size_t kMaxDecompressedBodySize = 4 * 1024 * 1024;
+
+  // Returns `body` compressed, or std::nullopt if it's too small or doesn't
+  // compress well, e.g. because it's already compressed media.
+  static std::optional<std::string> Compress(absl::string_view body);
+
+  // Returns the original body of a body returned by Compress().
+  // Returns Exception::kInvalidProtocolBuffer if `compressed_body` is corrupt.
+  static ExceptionOr<std::string> Decompress(absl::string_view compressed_body);
+};
+
+}  // namespace connections
+}  // namespace nearby
+
+#endif  // THIRD_PARTY_NEARBY_CONNECTIONS_IMPLEMENTATION_PAYLOAD_COMPRESSION_H_
@@ -0,0 +1,101 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "connections/implementation/payload_compression.h"
+
+#include <cstddef>
+#include <optional>
+#include <random>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "internal/platform/exception.h"
+
+namespace nearby {
+namespace connections {
+namespace {
+
+constexpr std::size_t kChunkSize = 64 * 1024;
+
+// Log lines in JSON, like the ones apps send to each other.
+std::string MakeTextBody(std::size_t size) {
+  std::string body;
+  for (int i = 0; body.size() < size; ++i) {
+    absl::StrAppend(&body, "{\"timestamp\":", 1690000000 + i * 37,
+                    ",\"level\":\"INFO\",\"tag\":\"transfer\",\"message\":"
+                    "\"sent chunk ",
+                    i, " of payload ", i % 13, "\"}\n");
+  }
+  body.resize(size);
+  return body;
+}
+
+// Random bytes, like already compressed media.
+std::string MakeRandomBody(std::size_t size) {
+  std::mt19937 random(42);
+  std::string body(size, '\0');
+  for (char& c : body) c = static_cast<char>(random());
+  return body;
+}
+
+TEST(PayloadCompressionTest, RoundTripsText) {
+  std::string body = MakeTextBody(kChunkSize);
+
+  std::optional<std::string> compressed_body =
+      PayloadCompression::Compress(body);
+
+  ASSERT_TRUE(compressed_body.has_value());
+  EXPECT_LT(compressed_body->size(), body.size() / 2);
+  ExceptionOr<std::string> decompressed_body =
+      PayloadCompression::Decompress(*compressed_body);
+  ASSERT_TRUE(decompressed_body.ok());
+  EXPECT_EQ(decompressed_body.result(), body);
+}
+
+TEST(PayloadCompressionTest, SkipsIncompressibleBody) {
+  EXPECT_FALSE(
+      PayloadCompression::Compress(MakeRandomBody(kChunkSize)).has_value());
+}
+
+TEST(PayloadCompressionTest, SkipsSmallBody) {
+  EXPECT_FALSE(PayloadCompression::Compress(
+                   MakeTextBody(PayloadCompression::kMinCompressedBodySize - 1))
+                   .has_value());
+}
+
+TEST(PayloadCompressionTest, RejectsCorruptBody) {
+  std::optional<std::string> compressed_body =
+      PayloadCompression::Compress(MakeTextBody(kChunkSize));
+  ASSERT_TRUE(compressed_body.has_value());
+
+  EXPECT_EQ(PayloadCompression::Decompress("").exception(),
+            Exception::kInvalidProtocolBuffer);
+  EXPECT_EQ(
+      PayloadCompression::Decompress(compressed_body->substr(0, 100))
+          .exception(),
+      Exception::kInvalidProtocolBuffer);
+  std::string wrong_size = *compressed_body;
+  wrong_size[3] ^= 1;
+  EXPECT_EQ(PayloadCompression::Decompress(wrong_size).exception(),
+            Exception::kInvalidProtocolBuffer);
+  std::string too_large = *compressed_body;
+  too_large[0] = 0x7f;
+  EXPECT_EQ(PayloadCompression::Decompress(too_large).exception(),
+            Exception::kInvalidProtocolBuffer);
+}
+
+}  // namespace
+}  // namespace connections
+}  // namespace nearby
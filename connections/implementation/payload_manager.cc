@@ -18,6 +18,7 @@
 #include <cstdint>
 #include <limits>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -32,12 +33,15 @@
 #include "connections/implementation/endpoint_channel_manager.h"
 #include "connections/implementation/flags/nearby_connections_feature_flags.h"
 #include "connections/implementation/internal_payload_factory.h"
+#include "connections/implementation/payload_compression.h"
 #include "connections/payload_type.h"
 #include "internal/flags/nearby_flags.h"
+#include "internal/platform/byte_buffer_pool.h"
 #include "internal/platform/count_down_latch.h"
 #include "internal/platform/exception.h"
 #include "internal/platform/feature_flags.h"
 #include "internal/platform/logging.h"
+#include "internal/platform/memory_budget.h"
 #include "internal/platform/mutex_lock.h"
 #include "internal/platform/single_thread_executor.h"
 #include "proto/connections_enums.pb.h"
@@ -56,6 +60,11 @@ using ::nearby::connections::PayloadDirection;
 // TODO(apolyudov): remove when migration to c++17 is possible.
 constexpr absl::Duration PayloadManager::kWaitCloseTimeout;
 
+namespace {
+// How long a send waits for memory before checking whether it's still needed.
+constexpr absl::Duration kChunkMemoryWaitTime = absl::Milliseconds(100);
+}  // namespace
+
 bool PayloadManager::SendPayloadLoop(
     ClientProxy* client, PendingPayload& pending_payload,
     PayloadTransferFrame::PayloadHeader& payload_header,
@@ -98,6 +107,24 @@ bool PayloadManager::SendPayloadLoop(
     return false;
   }
 
+  // Chunks read from files are held to the memory budget: while it's spent,
+  // wait for memory rather than read more. BYTES and streams are already in
+  // memory, and charged where they are held.
+  int chunk_size = GetOptimalChunkSize(available_endpoint_ids);
+  MemoryBudget::Charge chunk_charge;
+  if (payload_header.type() == PayloadTransferFrame::PayloadHeader::FILE ||
+      payload_header.type() ==
+          PayloadTransferFrame::PayloadHeader::FILE_BATCH) {
+    std::optional<MemoryBudget::Charge> reserved =
+        MemoryBudget::GetInstance().Reserve(
+            MemoryBudget::Subsystem::kOutgoingChunks, chunk_size,
+            kChunkMemoryWaitTime);
+    // Loop back around, to stop waiting if the payload was canceled or its
+    // endpoints went away meanwhile.
+    if (!reserved.has_value()) return true;
+    chunk_charge = std::move(*reserved);
+  }
+
   // Update the current offsets for all endpoints still active for this
   // payload. For the sake of accuracy, we update the pending payload here
   // because it's after all payload terminating events are handled, but
@@ -126,7 +153,6 @@ bool PayloadManager::SendPayloadLoop(
 
   // This will block if there is no data to transfer.
   // It will resume when new data arrives, or if Close() is called.
-  int chunk_size = GetOptimalChunkSize(available_endpoint_ids);
   packet_meta_data.StartFileIo();
   ByteArray next_chunk =
       pending_payload.GetInternalPayload()->DetachNextChunk(chunk_size);
@@ -135,9 +161,10 @@ bool PayloadManager::SendPayloadLoop(
   // Save chunk size. We'll need it after we move next_chunk.
   auto next_chunk_size = next_chunk.size();
   if (!next_chunk_size &&
-      pending_payload.GetInternalPayload()->GetTotalSize() > 0 &&
-      pending_payload.GetInternalPayload()->GetTotalSize() <
-          next_chunk_offset) {
+      (pending_payload.GetInternalPayload()->IsDetachFailed() ||
+       (pending_payload.GetInternalPayload()->GetTotalSize() > 0 &&
+        pending_payload.GetInternalPayload()->GetTotalSize() <
+            next_chunk_offset))) {
     NEARBY_LOGS(INFO) << "Payload xfer failed: payload_id="
                       << pending_payload.GetInternalPayload()->GetId();
     HandleFinishedOutgoingPayload(
@@ -152,10 +179,22 @@ bool PayloadManager::SendPayloadLoop(
   // happened.
   PayloadTransferFrame::PayloadChunk payload_chunk(CreatePayloadChunk(
       next_chunk_offset - resume_offset, std::move(next_chunk)));
+  MaybeCompressPayloadChunk(client, available_endpoint_ids, pending_payload,
+                            payload_header, payload_chunk);
   const EndpointIds& failed_endpoint_ids = endpoint_manager_->SendPayloadChunk(
       payload_header, payload_chunk, available_endpoint_ids, packet_meta_data);
+  // The chunk has been written out. Don't hold its memory while waiting for
+  // acks, which are only read while there is memory to spare.
+  chunk_charge = {};
+  PooledByteArray written_body(std::move(*payload_chunk.mutable_body()));
+  // Files of a batch whose last byte went out with this chunk.
+  std::vector<InternalPayload::BatchFile> finished_files =
+      pending_payload.GetInternalPayload()->TakeFinishedFiles();
   // Check whether at least one endpoint failed.
   if (!failed_endpoint_ids.empty()) {
+    SendClientCallbacksForFinishedFiles(
+        client, failed_endpoint_ids, payload_header, finished_files,
+        location::nearby::proto::connections::PayloadStatus::ENDPOINT_IO_ERROR);
     NEARBY_LOGS(INFO) << "Payload xfer: endpoints failed: payload_id="
                       << payload_header.id() << "; endpoint_ids={"
                       << ToString(failed_endpoint_ids) << "}",
@@ -169,6 +208,7 @@ bool PayloadManager::SendPayloadLoop(
   // we'll just go right back to the top of the loop and break out when
   // availableEndpointIds is re-synced and found to be empty at that point.
   if (failed_endpoint_ids.size() < available_endpoint_ids.size()) {
+    EndpointIds succeeded_endpoint_ids;
     for (const auto& endpoint_id : available_endpoint_ids) {
       if (std::find(failed_endpoint_ids.begin(), failed_endpoint_ids.end(),
                     endpoint_id) == failed_endpoint_ids.end()) {
@@ -180,9 +220,14 @@ bool PayloadManager::SendPayloadLoop(
 
         HandleSuccessfulOutgoingChunk(
             client, endpoint_id, payload_header, payload_chunk.flags(),
-            payload_chunk.offset(), payload_chunk.body().size());
+            payload_chunk.offset(), next_chunk_size);
+        succeeded_endpoint_ids.push_back(endpoint_id);
       }
     }
+    SendClientCallbacksForFinishedFiles(
+        client, succeeded_endpoint_ids, payload_header,
+        std::move(finished_files),
+        location::nearby::proto::connections::PayloadStatus::SUCCESS);
     NEARBY_LOGS(VERBOSE) << "PayloadManager done sending chunk at offset "
                          << next_chunk_offset << " of payload_id="
                          << pending_payload.GetInternalPayload()->GetId();
@@ -268,6 +313,8 @@ std::string PayloadManager::ToString(PayloadType type) {
       return std::string("Stream");
     case PayloadType::kFile:
       return std::string("File");
+    case PayloadType::kFileBatch:
+      return std::string("FileBatch");
     case PayloadType::kUnknown:
       return std::string("Unknown");
   }
@@ -307,6 +354,8 @@ PayloadManager::PayloadManager(EndpointManager& endpoint_manager)
     : endpoint_manager_(&endpoint_manager) {
   endpoint_manager_->RegisterFrameProcessor(V1Frame::PAYLOAD_TRANSFER, this);
   custom_save_path_ = "";
+  MemoryBudget::GetInstance().SetLimit(NearbyFlags::GetInstance().GetInt64Flag(
+      config_package_nearby::nearby_connections_feature::kMemoryBudgetBytes));
 }
 
 void PayloadManager::CancelAllPayloads() {
@@ -386,6 +435,32 @@ void PayloadManager::SendPayload(ClientProxy* client,
   if (shutdown_.Get()) return;
   NEARBY_LOG(INFO, "SendPayload: endpoint_ids={%s}",
              ToString(endpoint_ids).c_str());
+  if (payload.GetType() == PayloadType::kFileBatch) {
+    std::vector<Payload>& files = *payload.AsFileBatch();
+    if (std::any_of(files.begin(), files.end(), [](const Payload& file) {
+          return file.GetType() != PayloadType::kFile;
+        })) {
+      RecordInvalidPayloadAnalytics(client, endpoint_ids, payload.GetId(),
+                                    payload.GetType(), payload.GetOffset(),
+                                    /*total_size=*/-1);
+      NEARBY_LOGS(INFO) << "PayloadManager rejected file batch payload_id="
+                        << payload.GetId() << " holding non-file payloads.";
+      return;
+    }
+    // Endpoints that can't receive the batch get its files one by one.
+    if (!std::all_of(endpoint_ids.begin(), endpoint_ids.end(),
+                     [client](const std::string& endpoint_id) {
+                       return client->IsFileBatchEnabled(endpoint_id);
+                     })) {
+      NEARBY_LOGS(INFO) << "PayloadManager sending the " << files.size()
+                        << " files of batch payload_id=" << payload.GetId()
+                        << " as separate payloads.";
+      for (Payload& file : files) {
+        SendPayload(client, endpoint_ids, std::move(file));
+      }
+      return;
+    }
+  }
   // Before transfer to internal payload, retrieves the Payload size for
   // analytics.
   std::int64_t payload_total_size;
@@ -396,6 +471,12 @@ void PayloadManager::SendPayload(ClientProxy* client,
     case connections::PayloadType::kFile:
       payload_total_size = payload.AsFile()->GetTotalSize();
       break;
+    case connections::PayloadType::kFileBatch:
+      payload_total_size = 0;
+      for (Payload& file : *payload.AsFileBatch()) {
+        payload_total_size += file.AsFile()->GetTotalSize();
+      }
+      break;
     case connections::PayloadType::kStream:
     case connections::PayloadType::kUnknown:
       payload_total_size = -1;
@@ -654,6 +735,7 @@ SingleThreadExecutor* PayloadManager::GetOutgoingPayloadExecutor(
     case PayloadType::kBytes:
       return &bytes_payload_executor_;
     case PayloadType::kFile:
+    case PayloadType::kFileBatch:
       return &file_payload_executor_;
     case PayloadType::kStream:
       return &stream_payload_executor_;
@@ -709,6 +791,38 @@ PayloadTransferFrame::PayloadChunk PayloadManager::CreatePayloadChunk(
   return payload_chunk;
 }
 
+void PayloadManager::MaybeCompressPayloadChunk(
+    ClientProxy* client, const EndpointIds& endpoint_ids,
+    PendingPayload& pending_payload,
+    const PayloadTransferFrame::PayloadHeader& payload_header,
+    PayloadTransferFrame::PayloadChunk& payload_chunk) {
+  // Streams are usually live or already encoded media, and their chunks are
+  // too small to compress well.
+  if (payload_header.type() == PayloadTransferFrame::PayloadHeader::STREAM ||
+      pending_payload.IsIncompressible() ||
+      payload_chunk.body().size() <
+          PayloadCompression::kMinCompressedBodySize) {
+    return;
+  }
+  for (const auto& endpoint_id : endpoint_ids) {
+    if (!client->IsPayloadCompressionEnabled(endpoint_id)) return;
+  }
+
+  std::optional<std::string> compressed_body =
+      PayloadCompression::Compress(payload_chunk.body());
+  if (!compressed_body.has_value()) {
+    NEARBY_LOGS(INFO) << "Sending the rest of payload_id="
+                      << payload_header.id()
+                      << " uncompressed since it doesn't compress.";
+    pending_payload.MarkIncompressible();
+    return;
+  }
+  PooledByteArray uncompressed_body(std::move(*payload_chunk.mutable_body()));
+  payload_chunk.set_body(*std::move(compressed_body));
+  payload_chunk.set_flags(payload_chunk.flags() |
+                          PayloadTransferFrame::PayloadChunk::COMPRESSED);
+}
+
 PayloadManager::PendingPayloadHandle PayloadManager::CreateIncomingPayload(
     const PayloadTransferFrame& frame, const std::string& endpoint_id) {
   auto internal_payload =
@@ -760,6 +874,8 @@ void PayloadManager::SendClientCallbacksForFinishedOutgoingPayload(
             payload_header.id(),
             PayloadManager::PayloadStatusToTransferUpdateStatus(status),
             payload_header.total_size(), num_bytes_successfully_transferred};
+        std::vector<InternalPayload::BatchFile> unfinished_files =
+            pending_payload->GetInternalPayload()->GetUnfinishedFiles();
         for (const auto& endpoint_id : finished_endpoint_ids) {
           // Skip sending notifications if we have stopped tracking this
           // endpoint.
@@ -767,8 +883,13 @@ void PayloadManager::SendClientCallbacksForFinishedOutgoingPayload(
             continue;
           }
 
-          // Notify the client.
-          client->OnPayloadProgress(endpoint_id, update);
+          // Notify the client. A batch is reported file by file.
+          if (!IsFileBatch(payload_header)) {
+            client->OnPayloadProgress(endpoint_id, update);
+          }
+          NotifyClientOfFinishedFiles(client, endpoint_id,
+                                      /*is_incoming=*/false, unfinished_files,
+                                      status);
 
           // Mark this payload as done for analytics.
           client->GetAnalyticsRecorder().OnOutgoingPayloadDone(
@@ -807,7 +928,15 @@ void PayloadManager::SendClientCallbacksForFinishedIncomingPayload(
             payload_header.id(),
             PayloadManager::PayloadStatusToTransferUpdateStatus(status),
             payload_header.total_size(), offset_bytes};
-        NotifyClientOfIncomingPayloadProgressInfo(client, endpoint_id, update);
+        // A batch is reported file by file.
+        if (!IsFileBatch(payload_header)) {
+          NotifyClientOfIncomingPayloadProgressInfo(client, endpoint_id,
+                                                    update);
+        }
+        NotifyClientOfFinishedFiles(
+            client, endpoint_id, /*is_incoming=*/true,
+            pending_payload->GetInternalPayload()->GetUnfinishedFiles(),
+            status);
         DestroyPendingPayload(payload_header.id());
 
         // Analyze
@@ -816,6 +945,53 @@ void PayloadManager::SendClientCallbacksForFinishedIncomingPayload(
       });
 }
 
+void PayloadManager::SendClientCallbacksForFinishedFiles(
+    ClientProxy* client, const EndpointIds& endpoint_ids,
+    const PayloadTransferFrame::PayloadHeader& payload_header,
+    std::vector<InternalPayload::BatchFile> files,
+    location::nearby::proto::connections::PayloadStatus status) {
+  if (files.empty()) return;
+  RunOnStatusUpdateThread(
+      "batch-file-callbacks",
+      [this, client, endpoint_ids, payload_header, files = std::move(files),
+       status]() RUN_ON_PAYLOAD_STATUS_UPDATE_THREAD() {
+        // Make sure we're still tracking this payload.
+        PendingPayloadHandle pending_payload = GetPayload(payload_header.id());
+        if (!pending_payload) {
+          return;
+        }
+
+        for (const auto& endpoint_id : endpoint_ids) {
+          // Skip sending notifications if we have stopped tracking this
+          // endpoint.
+          if (!pending_payload->GetEndpoint(endpoint_id)) {
+            continue;
+          }
+          NotifyClientOfFinishedFiles(client, endpoint_id,
+                                      pending_payload->IsIncoming(), files,
+                                      status);
+        }
+      });
+}
+
+void PayloadManager::NotifyClientOfFinishedFiles(
+    ClientProxy* client, const std::string& endpoint_id, bool is_incoming,
+    const std::vector<InternalPayload::BatchFile>& files,
+    location::nearby::proto::connections::PayloadStatus status) {
+  for (const auto& file : files) {
+    PayloadProgressInfo update{
+        file.id, PayloadManager::PayloadStatusToTransferUpdateStatus(status),
+        file.size,
+        status == location::nearby::proto::connections::SUCCESS ? file.size
+                                                                 : 0};
+    if (is_incoming) {
+      NotifyClientOfIncomingPayloadProgressInfo(client, endpoint_id, update);
+    } else {
+      client->OnPayloadProgress(endpoint_id, update);
+    }
+  }
+}
+
 void PayloadManager::SendControlMessage(
     const EndpointIds& endpoint_ids,
     const PayloadTransferFrame::PayloadHeader& payload_header,
@@ -1055,8 +1231,10 @@ void PayloadManager::HandleSuccessfulOutgoingChunk(
             is_last_chunk ? payload_chunk_offset
                           : payload_chunk_offset + payload_chunk_body_size};
 
-        // Notify the client.
-        client->OnPayloadProgress(endpoint_id, update);
+        // Notify the client. A batch is reported file by file.
+        if (!IsFileBatch(payload_header)) {
+          client->OnPayloadProgress(endpoint_id, update);
+        }
 
         if (is_last_chunk) {
           client->GetAnalyticsRecorder().OnOutgoingPayloadDone(
@@ -1135,8 +1313,12 @@ void PayloadManager::HandleSuccessfulIncomingChunk(
             is_last_chunk ? payload_chunk_offset
                           : payload_chunk_offset + payload_chunk_body_size};
 
-        // Notify the client of this update.
-        NotifyClientOfIncomingPayloadProgressInfo(client, endpoint_id, update);
+        // Notify the client of this update. A batch is reported file by
+        // file.
+        if (!IsFileBatch(payload_header)) {
+          NotifyClientOfIncomingPayloadProgressInfo(client, endpoint_id,
+                                                    update);
+        }
 
         // Analyze the success.
         if (is_last_chunk) {
@@ -1163,6 +1345,24 @@ void PayloadManager::ProcessDataPacket(
                        << payload_header.id()
                        << " from endpoint_id=" << from_endpoint_id
                        << " at offset " << payload_chunk.offset();
+  // Decompress first: a BYTES payload is created from its first chunk.
+  if ((payload_chunk.flags() &
+       PayloadTransferFrame::PayloadChunk::COMPRESSED) != 0) {
+    ExceptionOr<std::string> body =
+        PayloadCompression::Decompress(payload_chunk.body());
+    if (!body.ok()) {
+      NEARBY_LOGS(ERROR)
+          << "ProcessDataPacket: [decompress: error] endpoint_id="
+          << from_endpoint_id << "; payload_id=" << payload_header.id();
+      HandleFinishedIncomingPayload(
+          to_client, from_endpoint_id, payload_header, payload_chunk.offset(),
+          location::nearby::proto::connections::PayloadStatus::LOCAL_ERROR);
+      return;
+    }
+    PooledByteArray compressed_body(std::move(*payload_chunk.mutable_body()));
+    payload_chunk.set_body(std::move(body.result()));
+  }
+
   Payload::Id payload_id = payload_header.id();
   PendingPayloadHandle pending_payload;
   if (payload_chunk.offset() == 0) {
@@ -1196,21 +1396,24 @@ void PayloadManager::ProcessDataPacket(
                          PayloadTransferFrame::ControlMessage::PAYLOAD_ERROR);
       return;
     }
-    // Also, let the client know of this new incoming payload.
-    RunOnStatusUpdateThread(
-        "process-data-packet",
-        [to_client, from_endpoint_id,
-         pending_payload = GetPayload(payload_id)]()
-            RUN_ON_PAYLOAD_STATUS_UPDATE_THREAD() {
-              if (!pending_payload) return;
-              NEARBY_LOGS(INFO)
-                  << "PayloadManager received new payload_id="
-                  << pending_payload->GetInternalPayload()->GetId()
-                  << " from endpoint_id=" << from_endpoint_id;
-              to_client->OnPayload(
-                  from_endpoint_id,
-                  pending_payload->GetInternalPayload()->ReleasePayload());
-            });
+    // Also, let the client know of this new incoming payload. A batch is
+    // handed over file by file instead, as they arrive.
+    if (!IsFileBatch(payload_header)) {
+      RunOnStatusUpdateThread(
+          "process-data-packet",
+          [to_client, from_endpoint_id,
+           pending_payload = GetPayload(payload_id)]()
+              RUN_ON_PAYLOAD_STATUS_UPDATE_THREAD() {
+                if (!pending_payload) return;
+                NEARBY_LOGS(INFO)
+                    << "PayloadManager received new payload_id="
+                    << pending_payload->GetInternalPayload()->GetId()
+                    << " from endpoint_id=" << from_endpoint_id;
+                to_client->OnPayload(
+                    from_endpoint_id,
+                    pending_payload->GetInternalPayload()->ReleasePayload());
+              });
+    }
   } else {
     pending_payload = GetPayload(payload_header.id());
   }
@@ -1246,9 +1449,22 @@ void PayloadManager::ProcessDataPacket(
   std::int64_t payload_body_size = payload_chunk.body().size();
 
   packet_meta_data.StartFileIo();
-  if (pending_payload->GetInternalPayload()
-          ->AttachNextChunk(ByteArray(std::move(*payload_chunk.mutable_body())))
-          .Raised()) {
+  PooledByteArray chunk_body(std::move(*payload_chunk.mutable_body()));
+  Exception attach_exception =
+      pending_payload->GetInternalPayload()->AttachNextChunk(chunk_body.get());
+  std::vector<Payload> started_files =
+      pending_payload->GetInternalPayload()->TakeStartedFiles();
+  if (!started_files.empty()) {
+    RunOnStatusUpdateThread(
+        "process-data-packet",
+        [to_client, from_endpoint_id,
+         started_files = std::move(started_files)]() mutable {
+          for (Payload& file : started_files) {
+            to_client->OnPayload(from_endpoint_id, std::move(file));
+          }
+        });
+  }
+  if (attach_exception.Raised()) {
     NEARBY_LOGS(ERROR) << "ProcessDataPacket: [data: error] endpoint_id="
                        << from_endpoint_id
                        << "; payload_id=" << pending_payload->GetId();
@@ -1257,7 +1473,14 @@ void PayloadManager::ProcessDataPacket(
         location::nearby::proto::connections::PayloadStatus::LOCAL_ERROR);
     return;
   }
+  if (payload_header.type() == PayloadTransferFrame::PayloadHeader::BYTES) {
+    pending_payload->ChargeMemory(payload_body_size);
+  }
   packet_meta_data.StopFileIo();
+  SendClientCallbacksForFinishedFiles(
+      to_client, {from_endpoint_id}, payload_header,
+      pending_payload->GetInternalPayload()->TakeFinishedFiles(),
+      location::nearby::proto::connections::PayloadStatus::SUCCESS);
   bool is_last_chunk = (payload_chunk.flags() &
                         PayloadTransferFrame::PayloadChunk::LAST_CHUNK) != 0;
   SendPayloadReceivedAck(
@@ -1388,6 +1611,8 @@ PayloadType PayloadManager::FramePayloadTypeToPayloadType(
       return connections::PayloadType::kFile;
     case PayloadTransferFrame::PayloadHeader::STREAM:
       return connections::PayloadType::kStream;
+    case PayloadTransferFrame::PayloadHeader::FILE_BATCH:
+      return connections::PayloadType::kFileBatch;
     default:
       return connections::PayloadType::kUnknown;
   }
@@ -1453,6 +1678,13 @@ PayloadManager::PendingPayload::PendingPayload(
     : is_incoming_(is_incoming),
       internal_payload_(std::move(internal_payload)),
       destroy_callback_(std::move(destroy_callback)) {
+  // An outgoing BYTES payload is in memory as a whole already; an incoming
+  // one is charged chunk by chunk as it arrives.
+  if (!is_incoming_ && internal_payload_->GetType() ==
+                           PayloadTransferFrame::PayloadHeader::BYTES) {
+    memory_charge_ = MemoryBudget::GetInstance().ChargeUnconditionally(
+        MemoryBudget::Subsystem::kPayloads, internal_payload_->GetTotalSize());
+  }
   // Initially we mark all endpoints as available.
   // Later on some may become canceled, some may experience data transfer
   // failures. Any of these situations will cause endpoint to be marked as
@@ -1482,6 +1714,22 @@ void PayloadManager::PendingPayload::MarkLocallyCanceled() {
   is_locally_canceled_.Set(true);
 }
 
+void PayloadManager::PendingPayload::ChargeMemory(std::int64_t size) {
+  MemoryBudget::Charge charge =
+      MemoryBudget::GetInstance().ChargeUnconditionally(
+          MemoryBudget::Subsystem::kPayloads, size);
+  MutexLock lock(&mutex_);
+  memory_charge_.Absorb(std::move(charge));
+}
+
+bool PayloadManager::PendingPayload::IsIncompressible() const {
+  return is_incompressible_.Get();
+}
+
+void PayloadManager::PendingPayload::MarkIncompressible() {
+  is_incompressible_.Set(true);
+}
+
 void PayloadManager::PendingPayload::MarkReceivedAckFromEndpoint(
     const std::string& from_endpoint_id) {
   auto info = GetEndpoint(from_endpoint_id);
@@ -37,6 +37,7 @@
 #include "internal/platform/byte_array.h"
 #include "internal/platform/condition_variable.h"
 #include "internal/platform/count_down_latch.h"
+#include "internal/platform/memory_budget.h"
 #include "internal/platform/mutex.h"
 
 namespace nearby {
@@ -130,8 +131,14 @@ class PayloadManager : public EndpointManager::FrameProcessor {
 
     bool IsLocallyCanceled() const;
     void MarkLocallyCanceled();
+    // Whether a chunk of this payload didn't compress, in which case the rest
+    // of it is sent as is.
+    bool IsIncompressible() const;
+    void MarkIncompressible();
     void MarkReceivedAckFromEndpoint(const std::string& from_endpoint_id);
     bool IsIncoming() const;
+    // Charges `size` more bytes of the payload that are now held in memory.
+    void ChargeMemory(std::int64_t size);
 
     // Gets the EndpointInfo objects for the endpoints (still) associated with
     // this payload.
@@ -172,8 +179,11 @@ class PayloadManager : public EndpointManager::FrameProcessor {
     mutable Mutex mutex_;
     bool is_incoming_;
     AtomicBoolean is_locally_canceled_{false};
+    AtomicBoolean is_incompressible_{false};
     AtomicBoolean is_closed_;
     std::unique_ptr<InternalPayload> internal_payload_;
+    // The memory taken up by a BYTES payload, until it's done with.
+    MemoryBudget::Charge memory_charge_ ABSL_GUARDED_BY(mutex_);
     DestroyCallback destroy_callback_;
     absl::flat_hash_map<std::string, EndpointInfo> endpoints_
         ABSL_GUARDED_BY(mutex_);
@@ -299,10 +309,22 @@ class PayloadManager : public EndpointManager::FrameProcessor {
 
   PayloadTransferFrame::PayloadChunk CreatePayloadChunk(std::int64_t offset,
                                                         ByteArray body);
+  // Compresses the body of `payload_chunk` if all of `endpoint_ids` can
+  // decompress it and it shrinks enough to be worth it.
+  void MaybeCompressPayloadChunk(
+      ClientProxy* client, const EndpointIds& endpoint_ids,
+      PendingPayload& pending_payload,
+      const PayloadTransferFrame::PayloadHeader& payload_header,
+      PayloadTransferFrame::PayloadChunk& payload_chunk);
   bool IsLastChunk(PayloadTransferFrame::PayloadChunk payload_chunk) {
     return ((payload_chunk.flags() &
              PayloadTransferFrame::PayloadChunk::LAST_CHUNK) != 0);
   }
+  static bool IsFileBatch(
+      const PayloadTransferFrame::PayloadHeader& payload_header) {
+    return payload_header.type() ==
+           PayloadTransferFrame::PayloadHeader::FILE_BATCH;
+  }
 
   PendingPayloadHandle CreateIncomingPayload(const PayloadTransferFrame& frame,
                                              const std::string& endpoint_id)
@@ -322,6 +344,18 @@ class PayloadManager : public EndpointManager::FrameProcessor {
       const PayloadTransferFrame::PayloadHeader& payload_header,
       std::int64_t offset_bytes,
       location::nearby::proto::connections::PayloadStatus status);
+  // Sends the final update of each of `files` of a FILE_BATCH payload to the
+  // client, for the endpoints still tracked.
+  void SendClientCallbacksForFinishedFiles(
+      ClientProxy* client, const EndpointIds& endpoint_ids,
+      const PayloadTransferFrame::PayloadHeader& payload_header,
+      std::vector<InternalPayload::BatchFile> files,
+      location::nearby::proto::connections::PayloadStatus status);
+  void NotifyClientOfFinishedFiles(
+      ClientProxy* client, const std::string& endpoint_id, bool is_incoming,
+      const std::vector<InternalPayload::BatchFile>& files,
+      location::nearby::proto::connections::PayloadStatus status)
+      RUN_ON_PAYLOAD_STATUS_UPDATE_THREAD();
 
   void SendControlMessage(
       const EndpointIds& endpoint_ids,
@@ -15,22 +15,30 @@
 #include "connections/implementation/payload_manager.h"
 
 #include <cstddef>
+#include <cstdint>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
+#include "connections/implementation/flags/nearby_connections_feature_flags.h"
 #include "connections/implementation/simulation_user.h"
 #include "connections/listeners.h"
 #include "connections/medium_selector.h"
 #include "connections/payload.h"
 #include "connections/status.h"
+#include "internal/flags/nearby_flags.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/count_down_latch.h"
+#include "internal/platform/file.h"
 #include "internal/platform/logging.h"
 #include "internal/platform/medium_environment.h"
+#include "internal/platform/memory_budget.h"
 #include "internal/platform/pipe.h"
+#include "internal/platform/system_clock.h"
 
 namespace nearby {
 namespace connections {
@@ -43,6 +51,7 @@ constexpr absl::string_view kDeviceB = "device-b";
 constexpr absl::string_view kMessage = "message";
 constexpr absl::Duration kProgressTimeout = absl::Milliseconds(1000);
 constexpr absl::Duration kDefaultTimeout = absl::Milliseconds(1000);
+constexpr absl::Duration kTransferTimeout = absl::Seconds(10);
 
 constexpr BooleanMediumSelector kTestCases[] = {
     BooleanMediumSelector{
@@ -102,12 +111,23 @@ class PayloadSimulationUser : public SimulationUser {
     return client_.IsConnectedToEndpoint(discovered_.endpoint_id);
   }
 
+  bool IsPayloadCompressionEnabled() const {
+    return client_.IsPayloadCompressionEnabled(discovered_.endpoint_id);
+  }
+
+  void DisablePayloadCompression() {
+    connection_options_.enable_payload_compression = false;
+  }
+
+  void SetCustomSavePath(const std::string& path) {
+    pm_.SetCustomSavePath(&client_, path);
+  }
+
  protected:
   Payload::Id sender_payload_id_ = 0;
 };
 
-class PayloadManagerTest
-    : public ::testing::TestWithParam<BooleanMediumSelector> {
+class PayloadManagerTestBase : public ::testing::Test {
  protected:
   bool SetupConnection(PayloadSimulationUser& user_a,
                        PayloadSimulationUser& user_b) {
@@ -132,6 +152,15 @@ class PayloadManagerTest
     return user_a.IsConnected() && user_b.IsConnected();
   }
 
+  // Text-like contents that span several chunks and compress well.
+  static std::string CreateCompressibleContents() {
+    std::string contents;
+    for (int i = 0; contents.size() < 2 * kChunkSize + 100; ++i) {
+      absl::StrAppend(&contents, "line ", i, ": the quick brown fox\n");
+    }
+    return contents;
+  }
+
   CountDownLatch discovery_latch_{1};
   CountDownLatch connection_latch_{2};
   CountDownLatch accept_latch_{2};
@@ -139,6 +168,44 @@ class PayloadManagerTest
   MediumEnvironment& env_{MediumEnvironment::Instance()};
 };
 
+class PayloadManagerTest
+    : public PayloadManagerTestBase,
+      public ::testing::WithParamInterface<BooleanMediumSelector> {};
+
+class PayloadManagerFileBatchTest : public PayloadManagerTestBase {
+ protected:
+  // Creates `count` files of `size` bytes to send, and returns their paths.
+  static std::vector<std::string> CreateSourceFiles(int count,
+                                                    std::int64_t size) {
+    std::vector<std::string> paths;
+    for (int i = 0; i < count; ++i) {
+      std::string path = absl::StrCat(::testing::TempDir(), "/source-", size,
+                                      "-", i);
+      OutputFile file(path);
+      EXPECT_TRUE(file.Write(ByteArray(std::string(size, 'a' + i % 26))).Ok());
+      EXPECT_TRUE(file.Close().Ok());
+      paths.push_back(std::move(path));
+    }
+    return paths;
+  }
+
+  // Returns FILE payloads for `paths`, saved under names starting with
+  // `prefix` on the receiver.
+  static std::vector<Payload> CreateFilePayloads(
+      const std::vector<std::string>& paths, std::int64_t size,
+      absl::string_view prefix) {
+    std::vector<Payload> payloads;
+    payloads.reserve(paths.size());
+    for (const std::string& path : paths) {
+      Payload::Id payload_id = Payload::GenerateId();
+      payloads.emplace_back(payload_id, "",
+                            absl::StrCat(prefix, "-", payload_id),
+                            InputFile(path, size));
+    }
+    return payloads;
+  }
+};
+
 TEST_P(PayloadManagerTest, CanCreateOne) {
   env_.Start();
   PayloadSimulationUser user_a(kDeviceA, GetParam());
@@ -169,6 +236,30 @@ TEST_P(PayloadManagerTest, CanSendBytePayload) {
   env_.Stop();
 }
 
+TEST_P(PayloadManagerTest, CanSendBytePayloadLargerThanMemoryBudget) {
+  NearbyFlags::GetInstance().OverrideInt64FlagValue(
+      config_package_nearby::nearby_connections_feature::kMemoryBudgetBytes,
+      kChunkSize);
+  env_.Start();
+  PayloadSimulationUser user_a(kDeviceA, GetParam());
+  PayloadSimulationUser user_b(kDeviceB, GetParam());
+  ASSERT_TRUE(SetupConnection(user_a, user_b));
+
+  // Both sides hold more than the budget, and acks have to get through.
+  const ByteArray message{std::string(4 * kChunkSize + 7, 'm')};
+  user_a.ExpectPayload(payload_latch_);
+  user_b.SendPayload(Payload(message));
+  EXPECT_TRUE(payload_latch_.Await(kTransferTimeout).result());
+  EXPECT_EQ(user_a.GetPayload().AsBytes(), message);
+  EXPECT_TRUE(user_a.IsConnected());
+
+  user_a.Stop();
+  user_b.Stop();
+  env_.Stop();
+  NearbyFlags::GetInstance().ResetOverridedValues();
+  MemoryBudget::GetInstance().SetLimit(0);
+}
+
 TEST_P(PayloadManagerTest, CanSendStreamPayload) {
   env_.Start();
   PayloadSimulationUser user_a(kDeviceA, GetParam());
@@ -369,6 +460,131 @@ TEST_P(PayloadManagerTest, SendPayloadWithSkip_StreamPayload) {
   env_.Stop();
 }
 
+TEST_P(PayloadManagerTest, CanSendCompressedBytePayload) {
+  NearbyFlags::GetInstance().OverrideBoolFlagValue(
+      config_package_nearby::nearby_connections_feature::
+          kEnablePayloadCompression,
+      true);
+  env_.Start();
+  PayloadSimulationUser user_a(kDeviceA, GetParam());
+  PayloadSimulationUser user_b(kDeviceB, GetParam());
+  ASSERT_TRUE(SetupConnection(user_a, user_b));
+  EXPECT_TRUE(user_a.IsPayloadCompressionEnabled());
+  EXPECT_TRUE(user_b.IsPayloadCompressionEnabled());
+
+  const ByteArray message{CreateCompressibleContents()};
+  user_a.ExpectPayload(payload_latch_);
+  user_b.SendPayload(Payload(message));
+  EXPECT_TRUE(payload_latch_.Await(kTransferTimeout).result());
+  EXPECT_EQ(user_a.GetPayload().AsBytes(), message);
+
+  user_a.Stop();
+  user_b.Stop();
+  env_.Stop();
+  NearbyFlags::GetInstance().ResetOverridedValues();
+}
+
+TEST_P(PayloadManagerTest, CanSendCompressedFilePayload) {
+  NearbyFlags::GetInstance().OverrideBoolFlagValue(
+      config_package_nearby::nearby_connections_feature::
+          kEnablePayloadCompression,
+      true);
+  env_.Start();
+  PayloadSimulationUser user_a(kDeviceA, GetParam());
+  PayloadSimulationUser user_b(kDeviceB, GetParam());
+  ASSERT_TRUE(SetupConnection(user_a, user_b));
+  EXPECT_TRUE(user_b.IsPayloadCompressionEnabled());
+  user_a.SetCustomSavePath(::testing::TempDir());
+
+  const ByteArray contents{CreateCompressibleContents()};
+  Payload::Id payload_id = Payload::GenerateId();
+  std::string source_path =
+      absl::StrCat(::testing::TempDir(), "/source-", payload_id);
+  {
+    OutputFile file(source_path);
+    ASSERT_TRUE(file.Write(contents).Ok());
+    ASSERT_TRUE(file.Close().Ok());
+  }
+  user_a.ExpectPayload(payload_latch_);
+  user_b.SendPayload(Payload(payload_id, "",
+                             absl::StrCat("received-", payload_id),
+                             InputFile(source_path, contents.size())));
+  ASSERT_TRUE(payload_latch_.Await(kTransferTimeout).result());
+  EXPECT_TRUE(user_a.WaitForProgress(
+      [payload_id](const PayloadProgressInfo& info) {
+        return info.payload_id == payload_id &&
+               info.status == PayloadProgressInfo::Status::kSuccess;
+      },
+      kTransferTimeout));
+  ASSERT_NE(user_a.GetPayload().AsFile(), nullptr);
+  InputFile received(user_a.GetPayload().AsFile()->GetFilePath(),
+                     contents.size());
+  EXPECT_EQ(received.Read(contents.size()).result(), contents);
+  received.Close();
+
+  user_a.Stop();
+  user_b.Stop();
+  env_.Stop();
+  NearbyFlags::GetInstance().ResetOverridedValues();
+}
+
+TEST_P(PayloadManagerTest, ConnectionOptionsCanDisablePayloadCompression) {
+  NearbyFlags::GetInstance().OverrideBoolFlagValue(
+      config_package_nearby::nearby_connections_feature::
+          kEnablePayloadCompression,
+      true);
+  env_.Start();
+  PayloadSimulationUser user_a(kDeviceA, GetParam());
+  PayloadSimulationUser user_b(kDeviceB, GetParam());
+  user_b.DisablePayloadCompression();
+  ASSERT_TRUE(SetupConnection(user_a, user_b));
+  // Neither side compresses: user_b doesn't want to, and user_a learns from
+  // user_b's connection response that it can't decompress.
+  EXPECT_FALSE(user_a.IsPayloadCompressionEnabled());
+  EXPECT_FALSE(user_b.IsPayloadCompressionEnabled());
+
+  const ByteArray message{CreateCompressibleContents()};
+  user_b.ExpectPayload(payload_latch_);
+  user_a.SendPayload(Payload(message));
+  EXPECT_TRUE(payload_latch_.Await(kTransferTimeout).result());
+  EXPECT_EQ(user_b.GetPayload().AsBytes(), message);
+
+  user_a.Stop();
+  user_b.Stop();
+  env_.Stop();
+  NearbyFlags::GetInstance().ResetOverridedValues();
+}
+
+TEST_F(PayloadManagerFileBatchTest, CanSendManySmallFilesAsOneBatch) {
+  constexpr int kFileCount = 100;
+  constexpr std::int64_t kFileSize = 4 * 1024;
+  NearbyFlags::GetInstance().OverrideBoolFlagValue(
+      config_package_nearby::nearby_connections_feature::
+          kEnableFileBatchPayloads,
+      true);
+  std::vector<std::string> files = CreateSourceFiles(kFileCount, kFileSize);
+  env_.Start();
+  PayloadSimulationUser user_a(kDeviceA, {.wifi_lan = true});
+  PayloadSimulationUser user_b(kDeviceB, {.wifi_lan = true});
+  ASSERT_TRUE(SetupConnection(user_a, user_b));
+  user_a.SetCustomSavePath(::testing::TempDir());
+
+  user_b.SendPayload(Payload(CreateFilePayloads(files, kFileSize, "batched")));
+  ASSERT_TRUE(user_a.WaitForSucceededPayloads(kFileCount, kTransferTimeout));
+
+  // Files are handed over in the order they were sent.
+  ASSERT_NE(user_a.GetPayload().AsFile(), nullptr);
+  InputFile received(user_a.GetPayload().AsFile()->GetFilePath(), kFileSize);
+  EXPECT_EQ(received.Read(kFileSize).result(),
+            ByteArray(std::string(kFileSize, 'a' + (kFileCount - 1) % 26)));
+  received.Close();
+
+  user_a.Stop();
+  user_b.Stop();
+  env_.Stop();
+  NearbyFlags::GetInstance().ResetOverridedValues();
+}
+
 INSTANTIATE_TEST_SUITE_P(ParametrisedPayloadManagerTest, PayloadManagerTest,
                          ::testing::ValuesIn(kTestCases));
 
@@ -14,12 +14,17 @@
 
 #include "connections/implementation/pcp_manager.h"
 
+#include <memory>
+#include <utility>
 #include <vector>
 
+#include "absl/time/time.h"
 #include "connections/implementation/p2p_cluster_pcp_handler.h"
 #include "connections/implementation/p2p_point_to_point_pcp_handler.h"
 #include "connections/implementation/p2p_star_pcp_handler.h"
 #include "connections/implementation/pcp_handler.h"
+#include "internal/platform/logging.h"
+#include "internal/platform/system_clock.h"
 
 namespace nearby {
 namespace connections {
@@ -27,18 +32,12 @@ namespace connections {
 PcpManager::PcpManager(
     Mediums& mediums, EndpointChannelManager& channel_manager,
     EndpointManager& endpoint_manager, BwuManager& bwu_manager,
-    InjectedBluetoothDeviceStore& injected_bluetooth_device_store) {
-  handlers_[Pcp::kP2pCluster] = std::make_unique<P2pClusterPcpHandler>(
-      &mediums, &endpoint_manager, &channel_manager, &bwu_manager,
-      injected_bluetooth_device_store);
-  handlers_[Pcp::kP2pStar] = std::make_unique<P2pStarPcpHandler>(
-      mediums, endpoint_manager, channel_manager, bwu_manager,
-      injected_bluetooth_device_store);
-  handlers_[Pcp::kP2pPointToPoint] =
-      std::make_unique<P2pPointToPointPcpHandler>(
-          mediums, endpoint_manager, channel_manager, bwu_manager,
-          injected_bluetooth_device_store);
-}
+    InjectedBluetoothDeviceStore& injected_bluetooth_device_store)
+    : mediums_(mediums),
+      channel_manager_(channel_manager),
+      endpoint_manager_(endpoint_manager),
+      bwu_manager_(bwu_manager),
+      injected_bluetooth_device_store_(injected_bluetooth_device_store) {}
 
 void PcpManager::DisconnectFromEndpointManager() {
   if (shutdown_.Set(true)) return;
@@ -178,9 +177,37 @@ bool PcpManager::SetCurrentPcpHandler(Strategy strategy) {
   return current_;
 }
 
-PcpHandler* PcpManager::GetPcpHandler(Pcp pcp) const {
+PcpHandler* PcpManager::GetPcpHandler(Pcp pcp) {
   auto item = handlers_.find(pcp);
-  return item != handlers_.end() ? item->second.get() : nullptr;
+  if (item != handlers_.end()) return item->second.get();
+  if (shutdown_) return nullptr;
+
+  absl::Time start_time = SystemClock::ElapsedRealtime();
+  std::unique_ptr<BasePcpHandler> handler = CreatePcpHandler(pcp);
+  if (!handler) return nullptr;
+  NEARBY_LOGS(INFO) << "Created PCP handler for "
+                    << handler->GetStrategy().GetName() << " in "
+                    << SystemClock::ElapsedRealtime() - start_time;
+  return handlers_.emplace(pcp, std::move(handler)).first->second.get();
+}
+
+std::unique_ptr<BasePcpHandler> PcpManager::CreatePcpHandler(Pcp pcp) {
+  switch (pcp) {
+    case Pcp::kP2pCluster:
+      return std::make_unique<P2pClusterPcpHandler>(
+          &mediums_, &endpoint_manager_, &channel_manager_, &bwu_manager_,
+          injected_bluetooth_device_store_);
+    case Pcp::kP2pStar:
+      return std::make_unique<P2pStarPcpHandler>(
+          mediums_, endpoint_manager_, channel_manager_, bwu_manager_,
+          injected_bluetooth_device_store_);
+    case Pcp::kP2pPointToPoint:
+      return std::make_unique<P2pPointToPointPcpHandler>(
+          mediums_, endpoint_manager_, channel_manager_, bwu_manager_,
+          injected_bluetooth_device_store_);
+    default:
+      return nullptr;
+  }
 }
 
 }  // namespace connections
@@ -15,6 +15,7 @@
 #ifndef CORE_INTERNAL_PCP_MANAGER_H_
 #define CORE_INTERNAL_PCP_MANAGER_H_
 
+#include <memory>
 #include <string>
 
 #include "absl/container/flat_hash_map.h"
@@ -88,8 +89,16 @@ class PcpManager {
 
  private:
   bool SetCurrentPcpHandler(Strategy strategy);
-  PcpHandler* GetPcpHandler(Pcp pcp) const;
-
+  // Returns the handler for `pcp`, creating it on first use; each handler
+  // starts its own threads, so only the strategies a client uses get one.
+  PcpHandler* GetPcpHandler(Pcp pcp);
+  std::unique_ptr<BasePcpHandler> CreatePcpHandler(Pcp pcp);
+
+  Mediums& mediums_;
+  EndpointChannelManager& channel_manager_;
+  EndpointManager& endpoint_manager_;
+  BwuManager& bwu_manager_;
+  InjectedBluetoothDeviceStore& injected_bluetooth_device_store_;
   AtomicBoolean shutdown_{false};
   absl::flat_hash_map<Pcp, std::unique_ptr<BasePcpHandler>> handlers_;
   PcpHandler* current_ = nullptr;
@@ -72,6 +72,10 @@ void SimulationUser::OnPayloadProgress(absl::string_view endpoint_id,
                                        const PayloadProgressInfo& info) {
   MutexLock lock(&progress_mutex_);
   progress_info_ = info;
+  if (info.status == PayloadProgressInfo::Status::kSuccess) {
+    succeeded_payloads_++;
+    progress_sync_.Notify();
+  }
   if (future_ && predicate_ && predicate_(info)) future_->Set(true);
 }
 
@@ -94,6 +98,18 @@ bool SimulationUser::WaitForProgress(
   return response.ok() && response.result();
 }
 
+bool SimulationUser::WaitForSucceededPayloads(int count,
+                                              absl::Duration timeout) {
+  absl::Time deadline = SystemClock::ElapsedRealtime() + timeout;
+  MutexLock lock(&progress_mutex_);
+  while (succeeded_payloads_ < count) {
+    absl::Duration remaining = deadline - SystemClock::ElapsedRealtime();
+    if (remaining <= absl::ZeroDuration()) return false;
+    progress_sync_.Wait(remaining);
+  }
+  return true;
+}
+
 void SimulationUser::StartAdvertising(const std::string& service_id,
                                       CountDownLatch* latch) {
   initiated_latch_ = latch;
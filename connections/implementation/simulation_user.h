@@ -161,6 +161,9 @@ class SimulationUser {
       absl::AnyInvocable<bool(const PayloadProgressInfo&)> pred,
       absl::Duration timeout);
 
+  // Waits until `count` payloads, or files of a batch, reported success.
+  bool WaitForSucceededPayloads(int count, absl::Duration timeout);
+
  protected:
   // ConnectionListener callbacks
   void OnConnectionInitiated(const std::string& endpoint_id,
@@ -185,6 +188,7 @@ class SimulationUser {
   Mutex progress_mutex_;
   ConditionVariable progress_sync_{&progress_mutex_};
   PayloadProgressInfo progress_info_;
+  int succeeded_payloads_ = 0;
   Payload payload_;
   CountDownLatch* initiated_latch_ = nullptr;
   CountDownLatch* accept_latch_ = nullptr;
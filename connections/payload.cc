@@ -21,6 +21,7 @@
 #include <string>
 #include <utility>
 #include <variant>
+#include <vector>
 
 #include "connections/payload_type.h"
 #include "internal/platform/byte_array.h"
@@ -48,7 +49,7 @@ std::string getFileName(const std::string& s) {
 
 // Payload is default-constructible, and moveable, but not copyable container
 // that holds at most one instance of one of:
-// ByteArray, InputStream, or InputFile.
+// ByteArray, InputStream, InputFile, or a batch of file Payloads.
 Payload::Payload(Payload&& other) noexcept = default;
 Payload::~Payload() = default;
 Payload& Payload::operator=(Payload&& other) noexcept = default;
@@ -86,6 +87,9 @@ Payload::Payload(std::string parent_folder, std::string file_name,
 Payload::Payload(std::unique_ptr<InputStream> stream)
     : type_(PayloadType::kStream), content_(std::move(stream)) {}
 
+Payload::Payload(std::vector<Payload> files)
+    : type_(PayloadType::kFileBatch), content_(std::move(files)) {}
+
 // Constructors for incoming payloads.
 Payload::Payload(Id id, ByteArray&& bytes)
     : id_(id), type_(PayloadType::kBytes), content_(std::move(bytes)) {}
@@ -104,6 +108,9 @@ Payload::Payload(Id id, std::string parent_folder, std::string file_name,
 Payload::Payload(Id id, std::unique_ptr<InputStream> stream)
     : id_(id), type_(PayloadType::kStream), content_(std::move(stream)) {}
 
+Payload::Payload(Id id, std::vector<Payload> files)
+    : id_(id), type_(PayloadType::kFileBatch), content_(std::move(files)) {}
+
 // Returns ByteArray payload, if it has been defined, or empty ByteArray.
 const ByteArray& Payload::AsBytes() const& {
   static const ByteArray empty;  // NOLINT: function-level static is OK.
@@ -119,6 +126,11 @@ InputStream* Payload::AsStream() {
 // Returns InputFile* payload, if it has been defined, or nullptr.
 InputFile* Payload::AsFile() { return std::get_if<InputFile>(&content_); }
 
+// Returns the files of a batch payload, if it has been defined, or nullptr.
+std::vector<Payload>* Payload::AsFileBatch() {
+  return std::get_if<std::vector<Payload>>(&content_);
+}
+
 // Returns Payload unique ID.
 Payload::Id Payload::GetId() const { return id_; }
 
@@ -20,6 +20,7 @@
 #include <memory>
 #include <utility>
 #include <variant>
+#include <vector>
 
 #include "absl/types/variant.h"
 #include "connections/payload_type.h"
@@ -41,8 +42,9 @@ class Payload {
   using Id = PayloadId;
   // Order of types in variant, and values in Type enum is important.
   // Enum values must match respective variant types.
-  using Content = std::variant<std::monostate, ByteArray,
-                               std::unique_ptr<InputStream>, InputFile>;
+  using Content =
+      std::variant<std::monostate, ByteArray, std::unique_ptr<InputStream>,
+                   InputFile, std::vector<Payload>>;
 
   Payload(Payload&& other) noexcept;
   ~Payload();
@@ -74,6 +76,17 @@ class Payload {
 
   explicit Payload(std::unique_ptr<InputStream> stream);
 
+  // A batch of FILE payloads, sent back-to-back as one transfer. Meant for
+  // many small files, where the cost of sending each one on its own
+  // dominates.
+  //
+  // The batch is only a way to send the files: the receiver gets each file as
+  // its own FILE payload, and both sides get the final PayloadProgressInfo of
+  // each file under the file's ID. The batch's own ID is only used to cancel
+  // the files not sent yet. If a remote endpoint can't receive batches, the
+  // files are sent to it one by one, as separate payloads.
+  explicit Payload(std::vector<Payload> files);
+
   // Constructors for incoming payloads.
   Payload(Id id, ByteArray&& bytes);
   Payload(Id id, const ByteArray& bytes);
@@ -81,6 +94,7 @@ class Payload {
   Payload(Id id, std::string parent_folder, std::string file_name,
           InputFile input_file);
   Payload(Id id, std::unique_ptr<InputStream> stream);
+  Payload(Id id, std::vector<Payload> files);
 
   // Returns ByteArray payload, if it has been defined, or empty ByteArray.
   const ByteArray& AsBytes() const&;
@@ -88,6 +102,8 @@ class Payload {
   InputStream* AsStream();
   // Returns InputFile* payload, if it has been defined, or nullptr.
   InputFile* AsFile();
+  // Returns the files of a batch payload, if it has been defined, or nullptr.
+  std::vector<Payload>* AsFileBatch();
 
   // Returns Payload unique ID.
   Id GetId() const;
@@ -17,6 +17,7 @@
 #include <memory>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "protobuf-matchers/protocol-buffer-matchers.h"
@@ -109,6 +110,22 @@ TEST(PayloadTest, SupportsStreamType) {
   EXPECT_EQ(payload.GetOffset(), kOffset);
 }
 
+TEST(PayloadTest, SupportsFileBatchType) {
+  const auto file_id = Payload::GenerateId();
+  std::vector<Payload> files;
+  files.emplace_back(file_id, InputFile(file_id, 0));
+
+  Payload payload(std::move(files));
+
+  EXPECT_EQ(payload.GetType(), PayloadType::kFileBatch);
+  ASSERT_NE(payload.AsFileBatch(), nullptr);
+  ASSERT_EQ(payload.AsFileBatch()->size(), 1);
+  EXPECT_EQ(payload.AsFileBatch()->front().GetId(), file_id);
+  EXPECT_EQ(payload.AsFile(), nullptr);
+  EXPECT_EQ(payload.AsStream(), nullptr);
+  EXPECT_EQ(payload.AsBytes(), ByteArray{});
+}
+
 TEST(PayloadTest, PayloadIsMoveable) {
   Payload payload1;
   Payload payload2(ByteArray("bytes"));
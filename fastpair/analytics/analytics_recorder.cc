@@ -16,6 +16,7 @@
 
 #include <memory>
 
+#include "absl/time/time.h"
 #include "internal/analytics/event_logger.h"
 #include "internal/proto/analytics/fast_pair_log.proto.h"
 #include "proto/fast_pair_enums.proto.h"
@@ -116,6 +117,21 @@ void AnalyticsRecorder::NewKeyBasedPairingInfo(int request_flag,
   LogEvent(*fast_pair_log);
 }
 
+void AnalyticsRecorder::NewHandshakeStageInfo(
+    FastPairLog::HandshakeStageInfo::Stage stage, bool success,
+    absl::Duration duration) {
+  auto fast_pair_log = std::make_unique<FastPairLog>();
+
+  auto handshake_stage_info =
+      FastPairLog::HandshakeStageInfo::default_instance().New();
+  handshake_stage_info->set_stage(stage);
+  handshake_stage_info->set_success(success);
+
+  fast_pair_log->set_allocated_handshake_stage_info(handshake_stage_info);
+  fast_pair_log->set_duration(absl::ToInt64Milliseconds(duration));
+  LogEvent(*fast_pair_log);
+}
+
 // start private methods
 
 void AnalyticsRecorder::LogEvent(const ::google::protobuf::MessageLite& message) {
@@ -17,6 +17,7 @@
 
 #include <memory>
 
+#include "absl/time/time.h"
 #include "internal/analytics/event_logger.h"
 #include "internal/proto/analytics/fast_pair_log.proto.h"
 #include "proto/fast_pair_enums.proto.h"
@@ -55,6 +56,10 @@ class AnalyticsRecorder {
   void NewKeyBasedPairingInfo(int request_flag, int response_type,
                               int response_flag, int response_device_count);
 
+  void NewHandshakeStageInfo(
+      ::nearby::proto::fastpair::FastPairLog::HandshakeStageInfo::Stage stage,
+      bool success, absl::Duration duration);
+
  private:
   std::unique_ptr<::nearby::proto::fastpair::FastPairLog> createFastPairLog();
   void LogEvent(const ::google::protobuf::MessageLite& message);
@@ -19,6 +19,7 @@
 #include "gmock/gmock.h"
 #include "protobuf-matchers/protocol-buffer-matchers.h"
 #include "gtest/gtest.h"
+#include "absl/time/time.h"
 #include "internal/analytics/event_logger.h"
 #include "internal/proto/analytics/fast_pair_log.proto.h"
 #include "proto/fast_pair_enums.proto.h"
@@ -134,6 +135,21 @@ TEST_F(AnalyticsRecorderTest, NewKeyBasedPairingInfo) {
   analytics_recoder().NewKeyBasedPairingInfo(16, 17, 18, 19);
 }
 
+TEST_F(AnalyticsRecorderTest, NewHandshakeStageInfo) {
+  EXPECT_CALL(event_logger(), Log)
+      .WillOnce([=](const ::google::protobuf::MessageLite& message) {
+        auto log = dynamic_cast<const FastPairLog*>(&message);
+        ASSERT_NE(log, nullptr);
+        ASSERT_EQ(log->handshake_stage_info().stage(),
+                  FastPairLog::HandshakeStageInfo::GATT_CONNECTION);
+        ASSERT_TRUE(log->handshake_stage_info().success());
+        ASSERT_EQ(log->duration(), 250);
+      });
+  analytics_recoder().NewHandshakeStageInfo(
+      FastPairLog::HandshakeStageInfo::GATT_CONNECTION, /*success=*/true,
+      absl::Milliseconds(250));
+}
+
 }  // namespace
 }  // namespace analytics
 }  // namespace fastpair
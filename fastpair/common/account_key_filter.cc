@@ -20,8 +20,11 @@
 #include <vector>
 
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "fastpair/common/battery_notification.h"
+#include "fastpair/common/fast_pair_service_data.h"
 #include "fastpair/common/non_discoverable_advertisement.h"
+#include "internal/base/bluetooth_address.h"
 #include "internal/crypto_cros/sha2.h"
 #include "internal/platform/logging.h"
 
@@ -29,6 +32,7 @@ namespace nearby {
 namespace fastpair {
 namespace {
 constexpr int kBitsInByte = 8;
+constexpr int kAddressByteSize = 6;
 
 // SASS enabled peripherals create their Bloom filters with the first byte
 // equals to either `the account key in use`
@@ -95,6 +99,24 @@ AccountKeyFilter::AccountKeyFilter(
     const std::vector<uint8_t>& salt_values)
     : bit_sets_(account_key_filter_bytes), salt_values_(salt_values) {}
 
+// static
+AccountKeyFilter AccountKeyFilter::FromServiceData(
+    const FastPairServiceData& service_data, absl::string_view address) {
+  std::vector<uint8_t> salt_values(service_data.salt.begin(),
+                                   service_data.salt.end());
+  if (salt_values.empty()) {
+    salt_values.resize(kAddressByteSize);
+    device::ParseBluetoothAddress(address, absl::MakeSpan(salt_values));
+  }
+  // The battery field is mixed into the filter as advertised, header included.
+  salt_values.insert(salt_values.end(), service_data.battery_field.begin(),
+                     service_data.battery_field.end());
+  return AccountKeyFilter(
+      std::vector<uint8_t>(service_data.account_key_filter.begin(),
+                           service_data.account_key_filter.end()),
+      salt_values);
+}
+
 bool AccountKeyFilter::IsPossiblyInSet(const AccountKey& account_key) {
   if (!account_key.Ok()) {
     NEARBY_LOGS(INFO) << __func__ << " Invalid account key.";
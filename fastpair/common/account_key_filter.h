@@ -18,7 +18,9 @@
 #include <cstdint>
 #include <vector>
 
+#include "absl/strings/string_view.h"
 #include "fastpair/common/account_key.h"
+#include "fastpair/common/fast_pair_service_data.h"
 #include "fastpair/common/non_discoverable_advertisement.h"
 
 namespace nearby {
@@ -33,6 +35,11 @@ class AccountKeyFilter {
                    const std::vector<uint8_t>& salt_values);
   ~AccountKeyFilter() = default;
 
+  // Builds the filter straight from parsed service data. If the service data
+  // doesn't contain a salt, the device's BLE `address` is used instead.
+  static AccountKeyFilter FromServiceData(
+      const FastPairServiceData& service_data, absl::string_view address);
+
   // Returns true if the `account_key` is possibly in the account key set
   // defined by the filter.
   // Return false if `account_key` is definitely not in set.
@@ -18,7 +18,9 @@
 #include <vector>
 
 #include "gtest/gtest.h"
+#include "absl/types/span.h"
 #include "fastpair/common/battery_notification.h"
+#include "fastpair/common/fast_pair_service_data.h"
 #include "fastpair/common/non_discoverable_advertisement.h"
 
 namespace nearby {
@@ -112,6 +114,24 @@ TEST_F(AccountKeyFilterTest, AccountKeyWithBatteryData) {
                   .IsPossiblyInSet(AccountKey(account_key_2_)));
 }
 
+TEST_F(AccountKeyFilterTest, ConstructorWithServiceData) {
+  std::vector<uint8_t> bytes = {/*header*/ 0x00, /*filter header*/ 0x40};
+  bytes.insert(bytes.end(), filter_1_with_battery_.begin(),
+               filter_1_with_battery_.end());
+  bytes.push_back(/*salt header*/ 0x21);
+  bytes.insert(bytes.end(), salt_.begin(), salt_.end());
+  bytes.insert(bytes.end(), battery_data_.begin(), battery_data_.end());
+  std::optional<FastPairServiceData> service_data =
+      FastPairServiceData::Parse(absl::MakeConstSpan(bytes));
+  ASSERT_TRUE(service_data.has_value());
+
+  AccountKeyFilter filter =
+      AccountKeyFilter::FromServiceData(*service_data, "11:12:13:14:15:16");
+
+  EXPECT_TRUE(filter.IsPossiblyInSet(AccountKey(account_key_1_)));
+  EXPECT_FALSE(filter.IsPossiblyInSet(AccountKey(account_key_2_)));
+}
+
 TEST_F(AccountKeyFilterTest, SassEnabledPeripheral) {
   // Value source: b/243855406#comment24
   const std::vector<uint8_t> bytes{0x06, 0x3F, 0xC1, 0x8C, 0x63, 0xDC,
@@ -23,6 +23,7 @@
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/functional/any_invocable.h"
 #include "absl/strings/string_view.h"
 #include "fastpair/common/account_key.h"
 #include "fastpair/common/device_metadata.h"
@@ -53,6 +54,7 @@ class FastPairDevice {
 
   void SetPublicAddress(absl::string_view address) {
     public_address_ = std::string(address);
+    NotifyLookupKeysChanged();
   }
 
   std::optional<std::string> GetDisplayName() const { return display_name_; }
@@ -70,7 +72,10 @@ class FastPairDevice {
 
   const AccountKey& GetAccountKey() const { return account_key_; }
 
-  void SetAccountKey(AccountKey account_key) { account_key_ = account_key; }
+  void SetAccountKey(AccountKey account_key) {
+    account_key_ = account_key;
+    NotifyLookupKeysChanged();
+  }
 
   void SetModelId(absl::string_view model_id) {
     model_id_ = std::string(model_id);
@@ -80,6 +85,7 @@ class FastPairDevice {
 
   void SetBleAddress(absl::string_view address) {
     ble_address_ = std::string(address);
+    NotifyLookupKeysChanged();
   }
 
   absl::string_view GetBleAddress() const { return ble_address_; }
@@ -111,7 +117,19 @@ class FastPairDevice {
 
   bool HasStartedPairing() const { return has_started_pairing_; }
 
+  // Sets a callback that runs after the BLE address, public address or account
+  // key changes, so that the owner of the device can keep its lookup indexes
+  // up to date.
+  void SetLookupKeysChangedCallback(
+      absl::AnyInvocable<void(const FastPairDevice&)> callback) {
+    lookup_keys_changed_callback_ = std::move(callback);
+  }
+
  private:
+  void NotifyLookupKeysChanged() {
+    if (lookup_keys_changed_callback_) lookup_keys_changed_callback_(*this);
+  }
+
   std::string model_id_;
 
   // Bluetooth LE address of the device.
@@ -142,6 +160,7 @@ class FastPairDevice {
   std::optional<DeviceMetadata> metadata_;
   std::optional<bool> should_show_ui_notification_;
   bool has_started_pairing_ = false;
+  absl::AnyInvocable<void(const FastPairDevice&)> lookup_keys_changed_callback_;
 };
 
 std::ostream& operator<<(std::ostream& stream, const FastPairDevice& device);
@@ -0,0 +1,164 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "fastpair/common/fast_pair_service_data.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "absl/strings/escaping.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "fastpair/common/battery_notification.h"
+#include "fastpair/common/non_discoverable_advertisement.h"
+#include "internal/platform/logging.h"
+
+namespace nearby {
+namespace fastpair {
+
+namespace {
+constexpr size_t kHeaderIndex = 0;
+constexpr size_t kHeaderLength = 1;
+constexpr uint8_t kHeaderLengthBitmask = 0b00011110;
+constexpr int kHeaderLengthOffset = 1;
+constexpr uint8_t kHeaderVersionBitmask = 0b11100000;
+constexpr int kHeaderVersionOffset = 5;
+constexpr size_t kMinModelIdLength = 3;
+constexpr size_t kMaxModelIdLength = 14;
+
+constexpr uint8_t kFieldTypeBitmask = 0b00001111;
+constexpr uint8_t kFieldLengthBitmask = 0b11110000;
+constexpr int kFieldLengthOffset = 4;
+constexpr uint8_t kFieldTypeAccountKeyFilter = 0;
+constexpr uint8_t kFieldTypeAccountKeyFilterSalt = 1;
+constexpr uint8_t kFieldTypeAccountKeyFilterNoNotification = 2;
+constexpr uint8_t kFieldTypeBattery = 3;
+constexpr uint8_t kFieldTypeBatteryNoNotification = 4;
+constexpr size_t kMaxLengthOfSaltBytes = 2;
+}  // namespace
+
+// static
+std::optional<FastPairServiceData> FastPairServiceData::Parse(
+    absl::Span<const uint8_t> service_data) {
+  if (service_data.empty()) return std::nullopt;
+
+  FastPairServiceData result;
+  // Three bytes without a header are a bare model ID.
+  if (service_data.size() == kMinModelIdLength) {
+    result.model_id = service_data;
+    return result;
+  }
+
+  // Otherwise, the first byte is a header with the format version and the
+  // length of the model ID that follows. We support only format version 0. (A
+  // different version indicates a breaking change in the format.)
+  uint8_t header = service_data[kHeaderIndex];
+  if ((header & kHeaderVersionBitmask) >> kHeaderVersionOffset != 0) {
+    return std::nullopt;
+  }
+  size_t id_length = (header & kHeaderLengthBitmask) >> kHeaderLengthOffset;
+  size_t id_index = kHeaderIndex + kHeaderLength;
+  size_t id_end = id_index + id_length;
+  if (kMinModelIdLength <= id_length && id_length <= kMaxModelIdLength &&
+      id_end <= service_data.size()) {
+    // Ignore leading zeros.
+    while (service_data[id_index] == 0 &&
+           id_end - id_index > kMinModelIdLength) {
+      id_index++;
+    }
+    result.model_id = service_data.subspan(id_index, id_end - id_index);
+  }
+
+  // The extra fields of a not discoverable advertisement follow the model ID.
+  // A later field of the same type replaces an earlier one.
+  std::optional<absl::Span<const uint8_t>> filter;
+  std::optional<absl::Span<const uint8_t>> filter_no_notification;
+  std::optional<absl::Span<const uint8_t>> battery_field;
+  std::optional<absl::Span<const uint8_t>> battery_field_no_notification;
+  size_t field_index = id_end;
+  while (field_index < service_data.size()) {
+    uint8_t field_header = service_data[field_index];
+    size_t length = (field_header & kFieldLengthBitmask) >> kFieldLengthOffset;
+    size_t field_end = field_index + kHeaderLength + length;
+    if (field_end > service_data.size()) break;
+
+    absl::Span<const uint8_t> field =
+        service_data.subspan(field_index, field_end - field_index);
+    absl::Span<const uint8_t> value = field.subspan(kHeaderLength);
+    switch (field_header & kFieldTypeBitmask) {
+      case kFieldTypeAccountKeyFilter:
+        filter = value;
+        break;
+      case kFieldTypeAccountKeyFilterSalt:
+        result.salt = value;
+        break;
+      case kFieldTypeAccountKeyFilterNoNotification:
+        filter_no_notification = value;
+        break;
+      case kFieldTypeBattery:
+        battery_field = field;
+        break;
+      case kFieldTypeBatteryNoNotification:
+        battery_field_no_notification = field;
+        break;
+    }
+    field_index = field_end;
+  }
+
+  // https://developers.google.com/nearby/fast-pair/specifications/service/provider#AccountKeyFilter
+  if (result.salt.size() > kMaxLengthOfSaltBytes) {
+    NEARBY_LOGS(WARNING) << " Parsed a salt field larger than two bytes: "
+                         << result.salt.size();
+    return std::nullopt;
+  }
+
+  if (filter.has_value()) {
+    result.account_key_filter = *filter;
+    result.account_key_filter_type = NonDiscoverableAdvertisement::Type::kShowUi;
+  } else if (filter_no_notification.has_value()) {
+    result.account_key_filter = *filter_no_notification;
+    result.account_key_filter_type = NonDiscoverableAdvertisement::Type::kHideUi;
+  }
+
+  if (battery_field.has_value()) {
+    result.battery_field = *battery_field;
+    result.battery_type = BatteryNotification::Type::kShowUi;
+  } else if (battery_field_no_notification.has_value()) {
+    result.battery_field = *battery_field_no_notification;
+    result.battery_type = BatteryNotification::Type::kHideUi;
+  }
+  if (!result.battery_field.empty()) {
+    result.battery = result.battery_field.subspan(kHeaderLength);
+  }
+  return result;
+}
+
+// static
+std::optional<FastPairServiceData> FastPairServiceData::Parse(
+    absl::string_view service_data) {
+  return Parse(absl::MakeConstSpan(
+      reinterpret_cast<const uint8_t*>(service_data.data()),
+      service_data.size()));
+}
+
+std::optional<std::string> FastPairServiceData::GetHexModelId() const {
+  if (model_id.empty()) return std::nullopt;
+  return absl::BytesToHexString(absl::string_view(
+      reinterpret_cast<const char*>(model_id.data()), model_id.size()));
+}
+
+}  // namespace fastpair
+}  // namespace nearby
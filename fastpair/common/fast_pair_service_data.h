@@ -0,0 +1,69 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_NEARBY_FASTPAIR_COMMON_FAST_PAIR_SERVICE_DATA_H_
+#define THIRD_PARTY_NEARBY_FASTPAIR_COMMON_FAST_PAIR_SERVICE_DATA_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "fastpair/common/battery_notification.h"
+#include "fastpair/common/non_discoverable_advertisement.h"
+
+namespace nearby {
+namespace fastpair {
+
+// A typed view over the Fast Pair service data of a BLE advertisement. See
+// https://developers.google.com/nearby/fast-pair/specifications/service/provider#advertising_payload_fast_pair_account_data
+//
+// The fields point into the buffer passed to `Parse()`, which must outlive the
+// view. Fields that aren't present in the advertisement are empty.
+struct FastPairServiceData {
+  // Parses the untrusted `service_data` in a single pass, without copying or
+  // allocating. Returns nullopt if the data is empty, uses an unsupported
+  // format version or has a salt field longer than two bytes.
+  static std::optional<FastPairServiceData> Parse(
+      absl::Span<const uint8_t> service_data);
+  static std::optional<FastPairServiceData> Parse(
+      absl::string_view service_data);
+
+  // Returns the hex string representation of `model_id`, or nullopt if the
+  // service data doesn't carry a valid model ID.
+  std::optional<std::string> GetHexModelId() const;
+
+  // Big-endian model ID of a discoverable advertisement, without leading
+  // zeros.
+  absl::Span<const uint8_t> model_id;
+
+  // Account key filter of a not discoverable advertisement.
+  absl::Span<const uint8_t> account_key_filter;
+  NonDiscoverableAdvertisement::Type account_key_filter_type =
+      NonDiscoverableAdvertisement::Type::kNone;
+  absl::Span<const uint8_t> salt;
+
+  // Battery values of a not discoverable advertisement, one byte each.
+  absl::Span<const uint8_t> battery;
+  // The battery field including its header byte, as it was mixed into the
+  // account key filter by the provider.
+  absl::Span<const uint8_t> battery_field;
+  BatteryNotification::Type battery_type = BatteryNotification::Type::kNone;
+};
+
+}  // namespace fastpair
+}  // namespace nearby
+
+#endif  // THIRD_PARTY_NEARBY_FASTPAIR_COMMON_FAST_PAIR_SERVICE_DATA_H_
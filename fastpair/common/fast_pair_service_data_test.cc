@@ -0,0 +1,221 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "fastpair/common/fast_pair_service_data.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "testing/fuzzing/fuzztest.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "fastpair/common/battery_notification.h"
+#include "fastpair/common/non_discoverable_advertisement.h"
+#include "fastpair/testing/fast_pair_service_data_creator.h"
+
+namespace nearby {
+namespace fastpair {
+namespace {
+
+constexpr absl::string_view kModelId("aabbcc");
+constexpr absl::string_view kAccountKeyFilter("112233445566");
+constexpr absl::string_view kSalt("01");
+constexpr absl::string_view kBattery("01048F");
+constexpr uint8_t kNotDiscoverableAdvHeader = 0b00000110;
+constexpr uint8_t kAccountKeyFilterHeader = 0b01100000;
+constexpr uint8_t kAccountKeyFilterNoNotificationHeader = 0b01100010;
+constexpr uint8_t kSaltHeader = 0b00010001;
+constexpr uint8_t kBatteryHeader = 0b00110011;
+constexpr uint8_t kBatteryNoNotificationHeader = 0b00110100;
+
+std::string ToHex(absl::Span<const uint8_t> bytes) {
+  return absl::BytesToHexString(absl::string_view(
+      reinterpret_cast<const char*>(bytes.data()), bytes.size()));
+}
+
+std::vector<uint8_t> CreateNotDiscoverableServiceData() {
+  return FastPairServiceDataCreator::Builder()
+      .SetHeader(kNotDiscoverableAdvHeader)
+      .SetModelId(kModelId)
+      .AddExtraFieldHeader(kAccountKeyFilterHeader)
+      .AddExtraField(kAccountKeyFilter)
+      .AddExtraFieldHeader(kSaltHeader)
+      .AddExtraField(kSalt)
+      .AddExtraFieldHeader(kBatteryHeader)
+      .AddExtraField(kBattery)
+      .Build()
+      ->CreateServiceData();
+}
+
+TEST(FastPairServiceDataTest, EmptyData) {
+  EXPECT_FALSE(FastPairServiceData::Parse(absl::string_view()).has_value());
+}
+
+TEST(FastPairServiceDataTest, ThreeByteModelId) {
+  std::vector<uint8_t> bytes = FastPairServiceDataCreator::Builder()
+                                   .SetModelId(kModelId)
+                                   .Build()
+                                   ->CreateServiceData();
+
+  std::optional<FastPairServiceData> service_data =
+      FastPairServiceData::Parse(absl::MakeConstSpan(bytes));
+
+  ASSERT_TRUE(service_data.has_value());
+  EXPECT_EQ(service_data->GetHexModelId(), kModelId);
+  EXPECT_TRUE(service_data->account_key_filter.empty());
+  EXPECT_EQ(service_data->account_key_filter_type,
+            NonDiscoverableAdvertisement::Type::kNone);
+}
+
+TEST(FastPairServiceDataTest, LongModelIdTrimmed) {
+  std::vector<uint8_t> bytes = FastPairServiceDataCreator::Builder()
+                                   .SetHeader(0b00001000)
+                                   .SetModelId("00001111")
+                                   .Build()
+                                   ->CreateServiceData();
+
+  std::optional<FastPairServiceData> service_data =
+      FastPairServiceData::Parse(absl::MakeConstSpan(bytes));
+
+  ASSERT_TRUE(service_data.has_value());
+  EXPECT_EQ(service_data->GetHexModelId(), "001111");
+}
+
+TEST(FastPairServiceDataTest, InvalidModelIdLength) {
+  std::vector<uint8_t> bytes = FastPairServiceDataCreator::Builder()
+                                   .SetHeader(0b00001010)
+                                   .SetModelId("11223344")
+                                   .Build()
+                                   ->CreateServiceData();
+
+  std::optional<FastPairServiceData> service_data =
+      FastPairServiceData::Parse(absl::MakeConstSpan(bytes));
+
+  ASSERT_TRUE(service_data.has_value());
+  EXPECT_FALSE(service_data->GetHexModelId().has_value());
+}
+
+TEST(FastPairServiceDataTest, UnsupportedVersion) {
+  std::vector<uint8_t> bytes = FastPairServiceDataCreator::Builder()
+                                   .SetHeader(0b00101000)
+                                   .SetModelId("11223344")
+                                   .Build()
+                                   ->CreateServiceData();
+
+  EXPECT_FALSE(
+      FastPairServiceData::Parse(absl::MakeConstSpan(bytes)).has_value());
+}
+
+TEST(FastPairServiceDataTest, NotDiscoverableFields) {
+  std::vector<uint8_t> bytes = CreateNotDiscoverableServiceData();
+
+  std::optional<FastPairServiceData> service_data =
+      FastPairServiceData::Parse(absl::MakeConstSpan(bytes));
+
+  ASSERT_TRUE(service_data.has_value());
+  EXPECT_EQ(service_data->GetHexModelId(), kModelId);
+  EXPECT_EQ(ToHex(service_data->account_key_filter), kAccountKeyFilter);
+  EXPECT_EQ(service_data->account_key_filter_type,
+            NonDiscoverableAdvertisement::Type::kShowUi);
+  EXPECT_EQ(ToHex(service_data->salt), kSalt);
+  EXPECT_EQ(ToHex(service_data->battery), "01048f");
+  EXPECT_EQ(ToHex(service_data->battery_field), "3301048f");
+  EXPECT_EQ(service_data->battery_type, BatteryNotification::Type::kShowUi);
+  // The view points into the parsed buffer.
+  EXPECT_GE(service_data->account_key_filter.data(), bytes.data());
+  EXPECT_LE(service_data->battery.data() + service_data->battery.size(),
+            bytes.data() + bytes.size());
+}
+
+TEST(FastPairServiceDataTest, NotDiscoverableNoNotificationFields) {
+  std::vector<uint8_t> bytes =
+      FastPairServiceDataCreator::Builder()
+          .SetHeader(kNotDiscoverableAdvHeader)
+          .SetModelId(kModelId)
+          .AddExtraFieldHeader(kAccountKeyFilterNoNotificationHeader)
+          .AddExtraField(kAccountKeyFilter)
+          .AddExtraFieldHeader(kBatteryNoNotificationHeader)
+          .AddExtraField(kBattery)
+          .Build()
+          ->CreateServiceData();
+
+  std::optional<FastPairServiceData> service_data =
+      FastPairServiceData::Parse(absl::MakeConstSpan(bytes));
+
+  ASSERT_TRUE(service_data.has_value());
+  EXPECT_EQ(service_data->account_key_filter_type,
+            NonDiscoverableAdvertisement::Type::kHideUi);
+  EXPECT_TRUE(service_data->salt.empty());
+  EXPECT_EQ(service_data->battery_type, BatteryNotification::Type::kHideUi);
+}
+
+TEST(FastPairServiceDataTest, TruncatedFieldIsIgnored) {
+  std::vector<uint8_t> bytes = CreateNotDiscoverableServiceData();
+  // Drop the last battery byte.
+  bytes.pop_back();
+
+  std::optional<FastPairServiceData> service_data =
+      FastPairServiceData::Parse(absl::MakeConstSpan(bytes));
+
+  ASSERT_TRUE(service_data.has_value());
+  EXPECT_EQ(ToHex(service_data->account_key_filter), kAccountKeyFilter);
+  EXPECT_TRUE(service_data->battery.empty());
+  EXPECT_EQ(service_data->battery_type, BatteryNotification::Type::kNone);
+}
+
+TEST(FastPairServiceDataTest, SaltTooLarge) {
+  std::vector<uint8_t> bytes = FastPairServiceDataCreator::Builder()
+                                   .SetHeader(kNotDiscoverableAdvHeader)
+                                   .SetModelId(kModelId)
+                                   .AddExtraFieldHeader(kAccountKeyFilterHeader)
+                                   .AddExtraField(kAccountKeyFilter)
+                                   .AddExtraFieldHeader(0b00110001)
+                                   .AddExtraField("C7C8C9")
+                                   .Build()
+                                   ->CreateServiceData();
+
+  EXPECT_FALSE(
+      FastPairServiceData::Parse(absl::MakeConstSpan(bytes)).has_value());
+}
+
+void ParsesAnyInput(const std::string& input) {
+  std::optional<FastPairServiceData> service_data =
+      FastPairServiceData::Parse(absl::string_view(input));
+  if (!service_data.has_value()) return;
+
+  // Every field must stay within the input.
+  const uint8_t* begin = reinterpret_cast<const uint8_t*>(input.data());
+  const uint8_t* end = begin + input.size();
+  for (absl::Span<const uint8_t> field :
+       {service_data->model_id, service_data->account_key_filter,
+        service_data->salt, service_data->battery,
+        service_data->battery_field}) {
+    if (field.empty()) continue;
+    EXPECT_GE(field.data(), begin);
+    EXPECT_LE(field.data() + field.size(), end);
+  }
+  EXPECT_LE(service_data->salt.size(), 2);
+  service_data->GetHexModelId();
+}
+
+FUZZ_TEST(FastPairServiceDataFuzzTest, ParsesAnyInput)
+    .WithDomains(fuzztest::Arbitrary<std::string>());
+
+}  // namespace
+}  // namespace fastpair
+}  // namespace nearby
@@ -26,6 +26,7 @@
 
 #include "absl/functional/any_invocable.h"
 #include "absl/strings/string_view.h"
+#include "fastpair/common/fast_pair_service_data.h"
 #include "fastpair/common/non_discoverable_advertisement.h"
 #include "fastpair/crypto/decrypted_passkey.h"
 #include "fastpair/crypto/decrypted_response.h"
@@ -33,8 +34,6 @@
 namespace nearby {
 namespace fastpair {
 
-
-
 // This class is responsible for parsing the untrusted bytes for Fast Pair.
 class FastPairDataParser {
   using GetHexModelIdFromServiceDataCallback =
@@ -76,6 +75,13 @@ class FastPairDataParser {
   static void ParseNotDiscoverableAdvertisement(
       absl::string_view fast_pair_service_data, absl::string_view address,
       ParseNotDiscoverableAdvertisementCallback callback);
+
+  // Copies the fields of a 'Non Discoverable' advertisement out of the parsed
+  // |service_data|, falling back to |address| as salt. Returns nullopt if
+  // there is no account key filter.
+  static std::optional<NonDiscoverableAdvertisement>
+  ToNotDiscoverableAdvertisement(const FastPairServiceData& service_data,
+                                 absl::string_view address);
 };
 
 }  // namespace fastpair
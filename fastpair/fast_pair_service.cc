@@ -23,6 +23,7 @@
 #include "fastpair/common/fast_pair_prefs.h"
 #include "fastpair/fast_pair_plugin.h"
 #include "fastpair/internal/fast_pair_seeker_impl.h"
+#include "fastpair/internal/mediums/gatt_attribute_cache.h"
 #include "fastpair/repository/fast_pair_repository_impl.h"
 #include "fastpair/server_access/fast_pair_client_impl.h"
 #include "fastpair/server_access/fast_pair_http_notifier.h"
@@ -33,6 +34,7 @@
 #include "internal/platform/device_info_impl.h"
 #include "internal/platform/feature_flags.h"
 #include "internal/platform/flags/nearby_platform_feature_flags.h"
+#include "internal/platform/implementation/platform.h"
 #include "internal/platform/logging.h"
 #include "internal/platform/task_runner_impl.h"
 
@@ -41,6 +43,8 @@ namespace fastpair {
 
 namespace {
 constexpr char kFastPairPreferencesFilePath[] = "Google/Nearby/FastPair";
+constexpr char kGattCachePreferencesFilePath[] =
+    "Google/Nearby/FastPair/GattCache";
 constexpr FeatureFlags::Flags fast_pair_feature_flags = FeatureFlags::Flags{
     .enable_scan_for_fast_pair_advertisement = true,
     .skip_service_discovery_before_connecting_to_rfcomm = true,
@@ -109,9 +113,17 @@ FastPairService::FastPairService(
               }},
       &executor_, account_manager_.get(), &devices_,
       fast_pair_repository_.get());
+  gatt_cache_preferences_ =
+      api::ImplementationPlatform::CreatePreferencesManager(
+          kGattCachePreferencesFilePath);
+  GattAttributeCache::GetInstance().SetPreferencesManager(
+      gatt_cache_preferences_.get());
 }
 
-FastPairService::~FastPairService() { executor_.Shutdown(); }
+FastPairService::~FastPairService() {
+  executor_.Shutdown();
+  GattAttributeCache::GetInstance().SetPreferencesManager(nullptr);
+}
 
 absl::Status FastPairService::RegisterPluginProvider(
     absl::string_view name, std::unique_ptr<FastPairPluginProvider> provider) {
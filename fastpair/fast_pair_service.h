@@ -31,6 +31,7 @@
 #include "internal/auth/authentication_manager.h"
 #include "internal/network/http_client.h"
 #include "internal/platform/device_info.h"
+#include "internal/platform/implementation/preferences_manager.h"
 #include "internal/platform/single_thread_executor.h"
 #include "internal/platform/task_runner.h"
 #include "internal/preferences/preferences_manager.h"
@@ -105,6 +106,8 @@ class FastPairService {
   std::unique_ptr<DeviceInfo> device_info_;
   std::unique_ptr<TaskRunner> task_runner_;
   std::unique_ptr<preferences::PreferencesManager> preferences_manager_;
+  // Backs the process-wide GattAttributeCache while the service runs.
+  std::unique_ptr<api::PreferencesManager> gatt_cache_preferences_;
   std::unique_ptr<AccountManager> account_manager_;
   std::unique_ptr<FastPairClient> fast_pair_client_;
   std::unique_ptr<FastPairRepository> fast_pair_repository_;
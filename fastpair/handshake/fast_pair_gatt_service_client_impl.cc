@@ -111,6 +111,10 @@ FastPairGattServiceClientImpl::FastPairGattServiceClientImpl(
       kPasskeyCharacteristicUuidV2, kPasskeyCharacteristicUuidV1};
   gatt_connection_params_.characteristic_uuids[kAccountKeyCharacteristicIndex] =
       {kAccountKeyCharacteristicUuidV2, kAccountKeyCharacteristicUuidV1};
+  // Devices of the same model expose the same characteristics, so later
+  // connections to any of them can skip probing for the V1 UUIDs.
+  gatt_connection_params_.attribute_cache_key =
+      std::string(device.GetModelId());
 }
 
 void FastPairGattServiceClientImpl::InitializeGattConnection(
@@ -20,6 +20,8 @@
 #include <vector>
 
 #include "absl/functional/bind_front.h"
+#include "absl/time/time.h"
+#include "fastpair/analytics/analytics_recorder.h"
 #include "fastpair/common/constant.h"
 #include "fastpair/common/pair_failure.h"
 #include "fastpair/handshake/fast_pair_data_encryptor_impl.h"
@@ -27,55 +29,80 @@
 #include "internal/base/bluetooth_address.h"
 #include "internal/platform/logging.h"
 #include "internal/platform/single_thread_executor.h"
+#include "internal/platform/system_clock.h"
+#include "internal/proto/analytics/fast_pair_log.proto.h"
 
 namespace nearby {
 namespace fastpair {
 
-FastPairHandshakeImpl::FastPairHandshakeImpl(FastPairDevice& device,
-                                             Mediums& mediums,
-                                             OnCompleteCallback on_complete,
-                                             SingleThreadExecutor* executor)
-    : FastPairHandshake(std::move(on_complete), nullptr, nullptr) {
+FastPairHandshakeImpl::FastPairHandshakeImpl(
+    FastPairDevice& device, Mediums& mediums, OnCompleteCallback on_complete,
+    SingleThreadExecutor* executor,
+    analytics::AnalyticsRecorder* analytics_recorder)
+    : FastPairHandshake(std::move(on_complete), nullptr, nullptr),
+      analytics_recorder_(analytics_recorder),
+      start_time_(SystemClock::ElapsedRealtime()) {
   fast_pair_gatt_service_client_ =
       FastPairGattServiceClientImpl::Factory::Create(device, mediums, executor);
   fast_pair_gatt_service_client_->InitializeGattConnection(
       [&](std::optional<PairFailure> failure) {
         OnGattClientInitializedCallback(device, failure);
       });
+  // The key exchange only needs the device metadata, so it runs on the
+  // executor while the GATT connection is being set up in the background.
+  executor->Execute("create-data-encryptor", [&]() {
+    FastPairDataEncryptorImpl::Factory::CreateAsync(
+        device,
+        [&](std::unique_ptr<FastPairDataEncryptor> fast_pair_data_encryptor) {
+          OnDataEncryptorCreateAsync(device,
+                                     std::move(fast_pair_data_encryptor));
+        });
+  });
 }
 
 void FastPairHandshakeImpl::OnGattClientInitializedCallback(
     FastPairDevice& device, std::optional<PairFailure> failure) {
+  RecordStage(HandshakeStageInfo::GATT_CONNECTION, !failure.has_value(),
+              start_time_);
   if (failure.has_value()) {
     NEARBY_LOGS(WARNING) << __func__
                          << ": Failed to init gatt client with failure = "
                          << failure.value();
-    std::move(on_complete_callback_)(device, failure.value());
+    NotifyComplete(device, failure.value());
     return;
   }
 
   NEARBY_LOGS(INFO)
       << __func__
       << ": Fast Pair GATT service client initialization successful.";
-  FastPairDataEncryptorImpl::Factory::CreateAsync(
-      device,
-      [&](std::unique_ptr<FastPairDataEncryptor> fast_pair_data_encryptor) {
-        OnDataEncryptorCreateAsync(device, std::move(fast_pair_data_encryptor));
-      });
+  gatt_client_initialized_ = true;
+  MaybeStartKeyBasedPairing(device);
 }
 
 void FastPairHandshakeImpl::OnDataEncryptorCreateAsync(
     FastPairDevice& device,
     std::unique_ptr<FastPairDataEncryptor> fast_pair_data_encryptor) {
+  RecordStage(HandshakeStageInfo::DATA_ENCRYPTOR,
+              fast_pair_data_encryptor != nullptr, start_time_);
   if (!fast_pair_data_encryptor) {
     NEARBY_LOGS(WARNING) << __func__
                          << ": Failed to create Fast Pair Data Encryptor.";
-    std::move(on_complete_callback_)(device,
-                                     PairFailure::kDataEncryptorRetrieval);
+    NotifyComplete(device, PairFailure::kDataEncryptorRetrieval);
     return;
   }
 
   fast_pair_data_encryptor_ = std::move(fast_pair_data_encryptor);
+  MaybeStartKeyBasedPairing(device);
+}
+
+void FastPairHandshakeImpl::MaybeStartKeyBasedPairing(FastPairDevice& device) {
+  if (!gatt_client_initialized_ || !fast_pair_data_encryptor_ ||
+      !on_complete_callback_ || key_based_pairing_started_) {
+    return;
+  }
+
+  key_based_pairing_started_ = true;
+  key_based_pairing_start_time_ = SystemClock::ElapsedRealtime();
   NEARBY_LOGS(INFO) << __func__ << ": Beginning key-based pairing protocol";
   fast_pair_gatt_service_client_->WriteRequestAsync(
       /*message_type=*/kKeyBasedPairingType,
@@ -95,7 +122,9 @@ void FastPairHandshakeImpl::OnWriteResponse(
         << __func__
         << ": Failed during key-based pairing protocol with failure = "
         << failure.value();
-    std::move(on_complete_callback_)(device, failure.value());
+    RecordStage(HandshakeStageInfo::KEY_BASED_PAIRING, false,
+                key_based_pairing_start_time_);
+    NotifyComplete(device, failure.value());
     return;
   }
 
@@ -104,8 +133,10 @@ void FastPairHandshakeImpl::OnWriteResponse(
   if (response.size() != kAesBlockByteSize) {
     NEARBY_LOGS(WARNING)
         << __func__ << ": Handshake failed because of incorrect response size.";
-    std::move(on_complete_callback_)(
-        device, PairFailure::kKeybasedPairingResponseDecryptFailure);
+    RecordStage(HandshakeStageInfo::KEY_BASED_PAIRING, false,
+                key_based_pairing_start_time_);
+    NotifyComplete(device,
+                   PairFailure::kKeybasedPairingResponseDecryptFailure);
     return;
   }
 
@@ -118,11 +149,13 @@ void FastPairHandshakeImpl::OnWriteResponse(
 
 void FastPairHandshakeImpl::OnParseDecryptedResponse(
     FastPairDevice& device, std::optional<DecryptedResponse>& response) {
+  RecordStage(HandshakeStageInfo::KEY_BASED_PAIRING, response.has_value(),
+              key_based_pairing_start_time_);
   if (!response.has_value()) {
     NEARBY_LOGS(WARNING) << __func__
                          << ": Missing decrypted response from parse.";
-    std::move(on_complete_callback_)(
-        device, PairFailure::kKeybasedPairingResponseDecryptFailure);
+    NotifyComplete(device,
+                   PairFailure::kKeybasedPairingResponseDecryptFailure);
     return;
   }
   NEARBY_LOGS(INFO) << __func__
@@ -131,7 +164,29 @@ void FastPairHandshakeImpl::OnParseDecryptedResponse(
   device.SetPublicAddress(
       device::CanonicalizeBluetoothAddress(response->address_bytes));
   completed_successfully_ = true;
-  std::move(on_complete_callback_)(device, std::nullopt);
+  NotifyComplete(device, std::nullopt);
+}
+
+void FastPairHandshakeImpl::NotifyComplete(FastPairDevice& device,
+                                           std::optional<PairFailure> failure) {
+  if (!on_complete_callback_) return;
+  RecordStage(HandshakeStageInfo::HANDSHAKE, !failure.has_value(),
+              start_time_);
+  OnCompleteCallback on_complete = std::move(on_complete_callback_);
+  on_complete_callback_ = nullptr;
+  std::move(on_complete)(device, failure);
+}
+
+void FastPairHandshakeImpl::RecordStage(HandshakeStageInfo::Stage stage,
+                                        bool success, absl::Time start_time) {
+  absl::Duration duration = SystemClock::ElapsedRealtime() - start_time;
+  NEARBY_LOGS(INFO) << __func__ << ": Handshake stage "
+                    << HandshakeStageInfo::Stage_Name(stage)
+                    << (success ? " succeeded" : " failed") << " after "
+                    << duration;
+  if (analytics_recorder_ != nullptr) {
+    analytics_recorder_->NewHandshakeStageInfo(stage, success, duration);
+  }
 }
 
 }  // namespace fastpair
@@ -18,33 +18,58 @@
 #include <memory>
 #include <optional>
 
+#include "absl/time/time.h"
+#include "fastpair/analytics/analytics_recorder.h"
 #include "fastpair/common/fast_pair_device.h"
 #include "fastpair/common/pair_failure.h"
 #include "fastpair/crypto/decrypted_response.h"
 #include "fastpair/handshake/fast_pair_handshake.h"
 #include "fastpair/internal/mediums/mediums.h"
+#include "internal/platform/single_thread_executor.h"
+#include "internal/proto/analytics/fast_pair_log.proto.h"
 
 namespace nearby {
 namespace fastpair {
 
+// The GATT connection and the data encryptor are set up in parallel, and the
+// key-based pairing request is written once both are ready. If
+// `analytics_recorder` is set, the time each stage took is reported to it.
 class FastPairHandshakeImpl : public FastPairHandshake {
  public:
-  explicit FastPairHandshakeImpl(FastPairDevice& device, Mediums& mediums,
-                                 OnCompleteCallback on_complete,
-                                 SingleThreadExecutor* executor);
+  explicit FastPairHandshakeImpl(
+      FastPairDevice& device, Mediums& mediums, OnCompleteCallback on_complete,
+      SingleThreadExecutor* executor,
+      analytics::AnalyticsRecorder* analytics_recorder = nullptr);
   FastPairHandshakeImpl(const FastPairHandshakeImpl&) = delete;
   FastPairHandshakeImpl& operator=(const FastPairHandshakeImpl&) = delete;
 
  private:
+  using HandshakeStageInfo =
+      ::nearby::proto::fastpair::FastPairLog::HandshakeStageInfo;
+
   void OnGattClientInitializedCallback(FastPairDevice& device,
                                        std::optional<PairFailure> failure);
   void OnDataEncryptorCreateAsync(
       FastPairDevice& device,
       std::unique_ptr<FastPairDataEncryptor> fast_pair_data_encryptor);
+  // Writes the key-based pairing request once the GATT connection and the
+  // data encryptor are both ready.
+  void MaybeStartKeyBasedPairing(FastPairDevice& device);
   void OnWriteResponse(FastPairDevice& device, absl::string_view response,
                        std::optional<PairFailure> failure);
   void OnParseDecryptedResponse(FastPairDevice& device,
                                 std::optional<DecryptedResponse>& response);
+  // Calls the complete callback, unless it has already been called.
+  void NotifyComplete(FastPairDevice& device,
+                      std::optional<PairFailure> failure);
+  void RecordStage(HandshakeStageInfo::Stage stage, bool success,
+                   absl::Time start_time);
+
+  analytics::AnalyticsRecorder* analytics_recorder_;
+  absl::Time start_time_;
+  absl::Time key_based_pairing_start_time_;
+  bool gatt_client_initialized_ = false;
+  bool key_based_pairing_started_ = false;
 };
 
 }  // namespace fastpair
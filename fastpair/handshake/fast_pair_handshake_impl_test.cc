@@ -19,10 +19,13 @@
 #include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 
+#include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/functional/any_invocable.h"
 #include "absl/status/status.h"
+#include "fastpair/analytics/analytics_recorder.h"
 #include "fastpair/common/fast_pair_device.h"
 #include "fastpair/common/pair_failure.h"
 #include "fastpair/common/protocol.h"
@@ -34,6 +37,8 @@
 #include "internal/platform/count_down_latch.h"
 #include "internal/platform/medium_environment.h"
 #include "internal/platform/single_thread_executor.h"
+#include "internal/proto/analytics/fast_pair_log.proto.h"
+#include "third_party/protobuf/message_lite.h"
 
 namespace nearby {
 namespace fastpair {
@@ -42,6 +47,9 @@ namespace {
 using Property = nearby::api::ble_v2::GattCharacteristic::Property;
 using Permission = nearby::api::ble_v2::GattCharacteristic::Permission;
 using ::nearby::api::ble_v2::GattCharacteristic;
+using ::nearby::proto::fastpair::FastPairLog;
+using ::testing::UnorderedElementsAre;
+using HandshakeStageInfo = FastPairLog::HandshakeStageInfo;
 
 constexpr absl::string_view kMetadataId("718c17");
 constexpr absl::string_view kPublicAddress("5E:3F:45:61:C3:32");
@@ -61,6 +69,29 @@ constexpr std::array<uint8_t, 9> salt = {0x08, 0x09, 0x0A, 0x0B, 0x0C,
                                          0x0D, 0x0E, 0x0F, 0x00};
 }  // namespace
 
+// Collects the successful handshake stages that were logged.
+class StageEventLogger : public ::nearby::analytics::EventLogger {
+ public:
+  void Log(const ::google::protobuf::MessageLite& message) override {
+    auto log = dynamic_cast<const FastPairLog*>(&message);
+    ASSERT_NE(log, nullptr);
+    ASSERT_TRUE(log->has_handshake_stage_info());
+    MutexLock lock(&mutex_);
+    if (log->handshake_stage_info().success()) {
+      stages_.push_back(log->handshake_stage_info().stage());
+    }
+  }
+
+  std::vector<HandshakeStageInfo::Stage> GetStages() {
+    MutexLock lock(&mutex_);
+    return stages_;
+  }
+
+ private:
+  Mutex mutex_;
+  std::vector<HandshakeStageInfo::Stage> stages_ ABSL_GUARDED_BY(mutex_);
+};
+
 class MediumEnvironmentStarter {
  public:
   MediumEnvironmentStarter() { MediumEnvironment::Instance().Start(); }
@@ -321,5 +352,50 @@ TEST_F(FastPairHandshakeImplTest, ParseResponseError) {
   latch.Await();
   EXPECT_FALSE(handshake_->completed_successfully());
 }
+TEST_F(FastPairHandshakeImplTest, DataEncryptorErrorDoesNotWaitForGatt) {
+  // The provider has no Fast Pair characteristics, so the GATT connection
+  // would only fail after the discovery timeout.
+  StartGattServer();
+  fast_pair_device_ = std::make_unique<FastPairDevice>(
+      kMetadataId, provider_address_, Protocol::kFastPairInitialPairing);
+  fake_data_encryptor_factory_.SetFailedRetrieval();
+  CountDownLatch latch(1);
+  handshake_ = std::make_unique<FastPairHandshakeImpl>(
+      *fast_pair_device_, mediums_,
+      [&](FastPairDevice& callback_device, std::optional<PairFailure> failure) {
+        EXPECT_EQ(failure.value(), PairFailure::kDataEncryptorRetrieval);
+        latch.CountDown();
+      },
+      &executor_);
+  EXPECT_TRUE(latch.Await(absl::Seconds(5)).result());
+  EXPECT_FALSE(handshake_->completed_successfully());
+}
+
+TEST_F(FastPairHandshakeImplTest, ReportsStageTimings) {
+  StartGattServer();
+  InsertCorrectGattCharacteristics();
+  SetNotifyResponse(*key_based_characteristic_, kKeyBasedResponse);
+  fast_pair_device_ = std::make_unique<FastPairDevice>(
+      kMetadataId, provider_address_, Protocol::kFastPairInitialPairing);
+  SetDecryptedResponse();
+  StageEventLogger event_logger;
+  analytics::AnalyticsRecorder analytics_recorder(&event_logger);
+  CountDownLatch latch(1);
+  handshake_ = std::make_unique<FastPairHandshakeImpl>(
+      *fast_pair_device_, mediums_,
+      [&](FastPairDevice& callback_device, std::optional<PairFailure> failure) {
+        EXPECT_FALSE(failure.has_value());
+        latch.CountDown();
+      },
+      &executor_, &analytics_recorder);
+  latch.Await();
+
+  EXPECT_THAT(event_logger.GetStages(),
+              UnorderedElementsAre(HandshakeStageInfo::GATT_CONNECTION,
+                                   HandshakeStageInfo::DATA_ENCRYPTOR,
+                                   HandshakeStageInfo::KEY_BASED_PAIRING,
+                                   HandshakeStageInfo::HANDSHAKE));
+}
+
 }  // namespace fastpair
 }  // namespace nearby
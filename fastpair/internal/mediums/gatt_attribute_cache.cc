@@ -0,0 +1,146 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "fastpair/internal/mediums/gatt_attribute_cache.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "nlohmann/json.hpp"
+#include "internal/platform/implementation/preferences_manager.h"
+#include "internal/platform/logging.h"
+#include "internal/platform/mutex_lock.h"
+#include "internal/platform/uuid.h"
+
+namespace nearby {
+namespace fastpair {
+namespace {
+
+using json = ::nlohmann::json;
+
+constexpr char kPreferencesKey[] = "nearby_fastpair.gatt_attribute_cache";
+constexpr char kEntryKey[] = "key";
+constexpr char kUuidsKey[] = "uuids";
+
+}  // namespace
+
+GattAttributeCache& GattAttributeCache::GetInstance() {
+  static GattAttributeCache* cache = new GattAttributeCache();
+  return *cache;
+}
+
+std::optional<std::vector<Uuid>> GattAttributeCache::Get(
+    absl::string_view key) const {
+  MutexLock lock(&mutex_);
+  auto it = entries_.find(key);
+  if (it == entries_.end()) return std::nullopt;
+  return it->second;
+}
+
+void GattAttributeCache::Put(absl::string_view key,
+                             std::vector<Uuid> characteristic_uuids) {
+  MutexLock lock(&mutex_);
+  InsertLocked(std::string(key), std::move(characteristic_uuids));
+  SaveLocked();
+}
+
+void GattAttributeCache::Remove(absl::string_view key) {
+  MutexLock lock(&mutex_);
+  if (entries_.erase(key) == 0) return;
+  insertion_order_.erase(
+      std::find(insertion_order_.begin(), insertion_order_.end(), key));
+  SaveLocked();
+}
+
+void GattAttributeCache::Clear() {
+  MutexLock lock(&mutex_);
+  entries_.clear();
+  insertion_order_.clear();
+  SaveLocked();
+}
+
+size_t GattAttributeCache::GetSize() const {
+  MutexLock lock(&mutex_);
+  return entries_.size();
+}
+
+void GattAttributeCache::SetPreferencesManager(
+    api::PreferencesManager* preferences_manager) {
+  MutexLock lock(&mutex_);
+  preferences_manager_ = preferences_manager;
+  if (preferences_manager_ == nullptr) return;
+  entries_.clear();
+  insertion_order_.clear();
+  json saved = preferences_manager_->Get(kPreferencesKey, json::array());
+  if (!saved.is_array()) {
+    NEARBY_LOGS(WARNING) << "Ignoring malformed gatt attribute cache.";
+    return;
+  }
+  // Entries are saved oldest first.
+  for (const json& entry : saved) {
+    if (!entry.is_object() || !entry.contains(kEntryKey) ||
+        !entry[kEntryKey].is_string() || !entry.contains(kUuidsKey) ||
+        !entry[kUuidsKey].is_array()) {
+      continue;
+    }
+    std::vector<Uuid> uuids;
+    for (const json& uuid : entry[kUuidsKey]) {
+      // Each UUID is saved as its most and least significant bits.
+      if (!uuid.is_array() || uuid.size() != 2 ||
+          !uuid[0].is_number_unsigned() || !uuid[1].is_number_unsigned()) {
+        uuids.clear();
+        break;
+      }
+      uuids.push_back(
+          Uuid(uuid[0].get<std::uint64_t>(), uuid[1].get<std::uint64_t>()));
+    }
+    if (uuids.empty()) continue;
+    InsertLocked(entry[kEntryKey].get<std::string>(), std::move(uuids));
+  }
+}
+
+void GattAttributeCache::InsertLocked(std::string key,
+                                      std::vector<Uuid> characteristic_uuids) {
+  auto [it, inserted] = entries_.insert_or_assign(
+      std::move(key), std::move(characteristic_uuids));
+  if (!inserted) return;
+  insertion_order_.push_back(it->first);
+  if (insertion_order_.size() > kMaxEntries) {
+    entries_.erase(insertion_order_.front());
+    insertion_order_.pop_front();
+  }
+}
+
+void GattAttributeCache::SaveLocked() {
+  if (preferences_manager_ == nullptr) return;
+  // Changes are rare, about one per new device model, so they are written
+  // under the lock, which keeps concurrent writes in order.
+  json saved = json::array();
+  for (const std::string& key : insertion_order_) {
+    json uuids = json::array();
+    for (const Uuid& uuid : entries_[key]) {
+      uuids.push_back({uuid.GetMostSigBits(), uuid.GetLeastSigBits()});
+    }
+    saved.push_back({{kEntryKey, key}, {kUuidsKey, std::move(uuids)}});
+  }
+  preferences_manager_->Set(kPreferencesKey, saved);
+}
+
+}  // namespace fastpair
+}  // namespace nearby
@@ -0,0 +1,91 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_NEARBY_FASTPAIR_INTERNAL_MEDIUMS_GATT_ATTRIBUTE_CACHE_H_
+#define THIRD_PARTY_NEARBY_FASTPAIR_INTERNAL_MEDIUMS_GATT_ATTRIBUTE_CACHE_H_
+
+#include <cstddef>
+#include <deque>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "internal/platform/implementation/preferences_manager.h"
+#include "internal/platform/mutex.h"
+#include "internal/platform/uuid.h"
+
+namespace nearby {
+namespace fastpair {
+
+// Remembers which characteristic UUIDs a GATT server turned out to have, keyed
+// by something that identifies the server's layout, such as a Fast Pair model
+// ID. Reconnecting clients discover exactly those characteristics instead of
+// probing the primary and then the fallback UUIDs.
+//
+// The platform GATT API doesn't expose attribute handles, so the resolved UUIDs
+// are the most that can be reused across connections.
+//
+// If a PreferencesManager is set, entries are loaded from it and every change
+// is written back, so the cache survives restarts.
+class GattAttributeCache {
+ public:
+  // The oldest entry is evicted once the cache holds this many.
+  static constexpr size_t kMaxEntries = 64;
+
+  // The instance shared by all GATT clients. Never destroyed.
+  static GattAttributeCache& GetInstance();
+
+  GattAttributeCache() = default;
+  GattAttributeCache(const GattAttributeCache&) = delete;
+  GattAttributeCache& operator=(const GattAttributeCache&) = delete;
+
+  // Returns the characteristic UUIDs resolved for `key`, in the order of the
+  // `RobustGattClient::ConnectionParams::characteristic_uuids` they were
+  // resolved from.
+  std::optional<std::vector<Uuid>> Get(absl::string_view key) const
+      ABSL_LOCKS_EXCLUDED(mutex_);
+  void Put(absl::string_view key, std::vector<Uuid> characteristic_uuids)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+  void Remove(absl::string_view key) ABSL_LOCKS_EXCLUDED(mutex_);
+  void Clear() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  size_t GetSize() const ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Replaces the entries with those saved in `preferences_manager`, and saves
+  // later changes to it. Pass null to stop saving; the entries are kept.
+  // `preferences_manager` must outlive the cache or be unset first.
+  void SetPreferencesManager(api::PreferencesManager* preferences_manager)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  void InsertLocked(std::string key, std::vector<Uuid> characteristic_uuids)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void SaveLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  mutable Mutex mutex_;
+  api::PreferencesManager* preferences_manager_ ABSL_GUARDED_BY(mutex_) =
+      nullptr;
+  absl::flat_hash_map<std::string, std::vector<Uuid>> entries_
+      ABSL_GUARDED_BY(mutex_);
+  // Keys in `entries_`, oldest first.
+  std::deque<std::string> insertion_order_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace fastpair
+}  // namespace nearby
+
+#endif  // THIRD_PARTY_NEARBY_FASTPAIR_INTERNAL_MEDIUMS_GATT_ATTRIBUTE_CACHE_H_
@@ -0,0 +1,107 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "fastpair/internal/mediums/gatt_attribute_cache.h"
+
+#include <memory>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "internal/platform/implementation/platform.h"
+#include "internal/platform/implementation/preferences_manager.h"
+#include "internal/platform/uuid.h"
+
+namespace nearby {
+namespace fastpair {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Optional;
+
+constexpr Uuid kKeyBasedCharacteristicUuidV1(0x0000123400001000,
+                                             0x800000805F9B34FB);
+constexpr Uuid kKeyBasedCharacteristicUuidV2(0xFE2C123483664814,
+                                             0x8EB001DE32100BEA);
+
+TEST(GattAttributeCacheTest, GetReturnsStoredUuids) {
+  GattAttributeCache cache;
+
+  cache.Put("718c17", {kKeyBasedCharacteristicUuidV2});
+
+  EXPECT_THAT(cache.Get("718c17"),
+              Optional(ElementsAre(kKeyBasedCharacteristicUuidV2)));
+  EXPECT_FALSE(cache.Get("9adb11").has_value());
+}
+
+TEST(GattAttributeCacheTest, PutReplacesUuids) {
+  GattAttributeCache cache;
+  cache.Put("718c17", {kKeyBasedCharacteristicUuidV2});
+
+  cache.Put("718c17", {kKeyBasedCharacteristicUuidV1});
+
+  EXPECT_THAT(cache.Get("718c17"),
+              Optional(ElementsAre(kKeyBasedCharacteristicUuidV1)));
+  EXPECT_EQ(cache.GetSize(), 1);
+}
+
+TEST(GattAttributeCacheTest, Remove) {
+  GattAttributeCache cache;
+  cache.Put("718c17", {kKeyBasedCharacteristicUuidV2});
+
+  cache.Remove("718c17");
+  cache.Remove("9adb11");
+
+  EXPECT_FALSE(cache.Get("718c17").has_value());
+  EXPECT_EQ(cache.GetSize(), 0);
+}
+
+TEST(GattAttributeCacheTest, EvictsOldestEntry) {
+  GattAttributeCache cache;
+
+  for (int i = 0; i <= GattAttributeCache::kMaxEntries; ++i) {
+    cache.Put(absl::StrCat(i), {kKeyBasedCharacteristicUuidV2});
+  }
+
+  EXPECT_EQ(cache.GetSize(), GattAttributeCache::kMaxEntries);
+  EXPECT_FALSE(cache.Get("0").has_value());
+  EXPECT_TRUE(cache.Get("1").has_value());
+}
+
+TEST(GattAttributeCacheTest, PersistsEntriesAcrossInstances) {
+  std::unique_ptr<api::PreferencesManager> preferences_manager =
+      api::ImplementationPlatform::CreatePreferencesManager(
+          "gatt_attribute_cache_test");
+  {
+    GattAttributeCache cache;
+    cache.SetPreferencesManager(preferences_manager.get());
+    cache.Clear();
+    cache.Put("718c17", {kKeyBasedCharacteristicUuidV2});
+    cache.Put("9adb11", {kKeyBasedCharacteristicUuidV1});
+    cache.Remove("9adb11");
+  }
+
+  GattAttributeCache cache;
+  cache.SetPreferencesManager(preferences_manager.get());
+
+  EXPECT_THAT(cache.Get("718c17"),
+              Optional(ElementsAre(kKeyBasedCharacteristicUuidV2)));
+  EXPECT_EQ(cache.GetSize(), 1);
+  cache.SetPreferencesManager(nullptr);
+}
+
+}  // namespace
+}  // namespace fastpair
+}  // namespace nearby
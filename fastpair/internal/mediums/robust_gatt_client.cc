@@ -27,6 +27,7 @@
 #include "absl/status/status.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "fastpair/internal/mediums/gatt_attribute_cache.h"
 #include "internal/platform/single_thread_executor.h"
 
 namespace nearby {
@@ -87,14 +88,45 @@ absl::Status RobustGattClient::TryConnect() {
 }
 
 absl::Status RobustGattClient::TryDiscoverServices() {
+  std::optional<std::vector<Uuid>> cached_characteristic_uuids;
+  if (!params_.attribute_cache_key.empty()) {
+    cached_characteristic_uuids =
+        GattAttributeCache::GetInstance().Get(params_.attribute_cache_key);
+    if (cached_characteristic_uuids.has_value() &&
+        cached_characteristic_uuids->size() !=
+            params_.characteristic_uuids.size()) {
+      cached_characteristic_uuids.reset();
+    }
+  }
+
+  if (cached_characteristic_uuids.has_value() &&
+      ResolveCachedCharacteristics(*cached_characteristic_uuids)) {
+    NEARBY_LOGS(INFO) << "Skipped gatt discovery using cached attributes";
+    resolved_characteristic_uuids_ = *std::move(cached_characteristic_uuids);
+    return absl::OkStatus();
+  }
+
   ExpBackOff back_off(params_);
   absl::Time start_time = SystemClock().ElapsedRealtime();
   while (!stopped_ && SystemClock().ElapsedRealtime() - start_time <
                           params_.discovery_timeout) {
+    if (cached_characteristic_uuids.has_value()) {
+      if (DiscoverServices(params_.service_uuid,
+                           *cached_characteristic_uuids)) {
+        resolved_characteristic_uuids_ =
+            *std::move(cached_characteristic_uuids);
+        return absl::OkStatus();
+      }
+      // The server doesn't match the cache, so fall back to probing.
+      NEARBY_LOGS(INFO) << "Dropping stale gatt attribute cache entry";
+      GattAttributeCache::GetInstance().Remove(params_.attribute_cache_key);
+      cached_characteristic_uuids.reset();
+    }
     if (DiscoverServices(params_.service_uuid,
                          GetPrimaryCharacteristicList()) ||
         DiscoverServices(params_.service_uuid,
                          GetFallbackCharacteristicList())) {
+      CacheResolvedCharacteristics();
       return absl::OkStatus();
     }
     SystemClock().Sleep(back_off.NextBackOff());
@@ -102,6 +134,40 @@ absl::Status RobustGattClient::TryDiscoverServices() {
   return absl::DeadlineExceededError("gatt discovery time-out");
 }
 
+bool RobustGattClient::ResolveCachedCharacteristics(
+    const std::vector<Uuid>& characteristic_uuids) {
+  // Platforms that keep the server's attributes across connections can return
+  // characteristics before discovery; the others return none.
+  absl::flat_hash_map<int, GattCharacteristic> characteristics;
+  for (int i = 0; i < static_cast<int>(characteristic_uuids.size()); ++i) {
+    if (stopped_) return false;
+    std::optional<GattCharacteristic> characteristic =
+        gatt_client_->GetCharacteristic(params_.service_uuid,
+                                        characteristic_uuids[i]);
+    if (!characteristic.has_value()) return false;
+    characteristics[i] = *characteristic;
+  }
+  characteristics_ = std::move(characteristics);
+  return true;
+}
+
+void RobustGattClient::CacheResolvedCharacteristics() {
+  resolved_characteristic_uuids_.clear();
+  std::vector<Uuid> resolved;
+  resolved.reserve(params_.characteristic_uuids.size());
+  for (int i = 0; i < static_cast<int>(params_.characteristic_uuids.size());
+       ++i) {
+    const GattCharacteristic* characteristic = GetCharacteristic(i);
+    if (characteristic == nullptr) return;
+    resolved.push_back(characteristic->uuid);
+  }
+  resolved_characteristic_uuids_ = resolved;
+  if (!params_.attribute_cache_key.empty()) {
+    GattAttributeCache::GetInstance().Put(params_.attribute_cache_key,
+                                          std::move(resolved));
+  }
+}
+
 bool RobustGattClient::DiscoverServices(
     const Uuid& service_uuid, const std::vector<Uuid>& characteristic_uuids) {
   if (service_uuid.IsEmpty() || characteristic_uuids.empty()) {
@@ -135,14 +201,21 @@ const RobustGattClient::GattCharacteristic* RobustGattClient::GetCharacteristic(
     return &it->second;
   }
   const UuidPair& uuid_pair = params_.characteristic_uuids[uuid_pair_index];
-  std::optional<GattCharacteristic> characteristic =
-      GetCharacteristic(params_.service_uuid, uuid_pair);
+  std::optional<GattCharacteristic> characteristic;
+  if (!resolved_characteristic_uuids_.empty()) {
+    if (stopped_) return nullptr;
+    characteristic = gatt_client_->GetCharacteristic(
+        params_.service_uuid, resolved_characteristic_uuids_[uuid_pair_index]);
+  } else {
+    characteristic = GetCharacteristic(params_.service_uuid, uuid_pair);
+  }
   if (!characteristic.has_value()) {
     NEARBY_LOGS(WARNING) << absl::StrFormat(
         "Characteristic (%s, %s) not found on service %s",
         std::string(uuid_pair.primary_uuid),
         std::string(uuid_pair.fallback_uuid),
         std::string(params_.service_uuid));
+    return nullptr;
   }
   characteristics_[uuid_pair_index] = *characteristic;
   return &characteristics_[uuid_pair_index];
@@ -411,6 +484,7 @@ void RobustGattClient::Cleanup() {
   }
   gatt_client_.reset();
   characteristics_.clear();
+  resolved_characteristic_uuids_.clear();
   MutexLock lock(&mutex_);
   notify_callbacks_.clear();
 }
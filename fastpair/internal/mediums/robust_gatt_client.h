@@ -85,6 +85,11 @@ class RobustGattClient {
     absl::Duration initial_back_off_step = absl::Milliseconds(100);
     absl::Duration max_back_off = absl::Seconds(3);
     float back_off_multiplier = 1.5;
+    // If not empty, the characteristic UUIDs resolved on the server are kept in
+    // `GattAttributeCache` under this key, and later connections with the same
+    // key discover only those. Servers sharing a key must have the same
+    // characteristics, for example devices of the same Fast Pair model.
+    std::string attribute_cache_key;
   };
 
   // Creates the GATT client, connects to the server, and discovers
@@ -218,6 +223,13 @@ class RobustGattClient {
   void Connect();
   absl::Status TryConnect() ABSL_EXCLUSIVE_LOCKS_REQUIRED(executor_);
   absl::Status TryDiscoverServices() ABSL_EXCLUSIVE_LOCKS_REQUIRED(executor_);
+  // Looks up the cached characteristics without discovery. Returns false,
+  // leaving discovery to run, unless all of them are available.
+  bool ResolveCachedCharacteristics(
+      const std::vector<Uuid>& characteristic_uuids)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(executor_);
+  // Stores the characteristic UUIDs found by discovery in the attribute cache.
+  void CacheResolvedCharacteristics() ABSL_EXCLUSIVE_LOCKS_REQUIRED(executor_);
   std::vector<Uuid> GetPrimaryCharacteristicList();
   std::vector<Uuid> GetFallbackCharacteristicList();
   bool DiscoverServices(const Uuid& service_uuid,
@@ -252,6 +264,9 @@ class RobustGattClient {
   // The entries are lazily initialized.
   absl::flat_hash_map<int, GattCharacteristic> characteristics_
       ABSL_GUARDED_BY(executor_);
+  // The characteristic UUIDs found on the server, indexed by
+  // `uuid_pair_index`. Empty until discovery has resolved all of them.
+  std::vector<Uuid> resolved_characteristic_uuids_ ABSL_GUARDED_BY(executor_);
   // Mapping from `uuid_pair_index` to subscription callbacks.
   struct NotifyCallbackInfo {
     NotifyCallback callback;
@@ -24,6 +24,7 @@
 #include "absl/status/status.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "fastpair/internal/mediums/gatt_attribute_cache.h"
 #include "internal/platform/ble_v2.h"
 #include "internal/platform/bluetooth_adapter.h"
 #include "internal/platform/count_down_latch.h"
@@ -33,6 +34,8 @@ namespace nearby {
 namespace fastpair {
 namespace {
 
+using ::testing::ElementsAre;
+using ::testing::Optional;
 using ::testing::status::StatusIs;
 using Property = nearby::api::ble_v2::GattCharacteristic::Property;
 using Permission = nearby::api::ble_v2::GattCharacteristic::Permission;
@@ -41,6 +44,7 @@ using GattCharacteristic = nearby::api::ble_v2::GattCharacteristic;
 // Short timeout for operation that we expect to timeout.
 constexpr absl::Duration kFailureTimeout = absl::Milliseconds(100);
 constexpr absl::string_view kModelId = "123456";
+constexpr absl::string_view kAttributeCacheKey = "model-123456";
 constexpr Uuid kFastPairServiceUuid(0x0000FE2C00001000, 0x800000805F9B34FB);
 constexpr Uuid kKeyBasedCharacteristicUuidV1(0x0000123400001000,
                                              0x800000805F9B34FB);
@@ -629,6 +633,90 @@ TEST_F(RobustGattClientTest, ReadFromWrongCharacteristicFails) {
   EXPECT_TRUE(latch.Await().Ok());
 }
 
+TEST_F(RobustGattClientTest, CachesResolvedCharacteristics) {
+  GattAttributeCache::GetInstance().Clear();
+  CountDownLatch latch(1);
+  BleV2Peripheral provider = seeker_ble_.GetRemotePeripheral(provider_address_);
+  InsertCorrectV1GattCharacteristics();
+  RobustGattClient::ConnectionParams params;
+  params.tx_power_level = api::ble_v2::TxPowerLevel::kMedium;
+  params.service_uuid = kFastPairServiceUuid;
+  params.characteristic_uuids.push_back(
+      {kKeyBasedCharacteristicUuidV2, kKeyBasedCharacteristicUuidV1});
+  params.characteristic_uuids.push_back(
+      {kPasskeyCharacteristicUuidV2, kPasskeyCharacteristicUuidV1});
+  params.attribute_cache_key = std::string(kAttributeCacheKey);
+
+  RobustGattClient gatt_client(seeker_ble_, provider, params);
+  gatt_client.WriteCharacteristic(
+      0, "hello", api::ble_v2::GattClient::WriteType::kWithResponse,
+      [&](absl::Status status) {
+        EXPECT_OK(status);
+        latch.CountDown();
+      });
+
+  EXPECT_TRUE(latch.Await().Ok());
+  EXPECT_THAT(GattAttributeCache::GetInstance().Get(kAttributeCacheKey),
+              Optional(ElementsAre(kKeyBasedCharacteristicUuidV1,
+                                   kPasskeyCharacteristicUuidV1)));
+}
+
+TEST_F(RobustGattClientTest, WritesUsingCachedCharacteristics) {
+  constexpr absl::string_view kData = "hello";
+  GattAttributeCache::GetInstance().Clear();
+  GattAttributeCache::GetInstance().Put(kAttributeCacheKey,
+                                        {kKeyBasedCharacteristicUuidV1});
+  CountDownLatch latch(1);
+  BleV2Peripheral provider = seeker_ble_.GetRemotePeripheral(provider_address_);
+  InsertCorrectV1GattCharacteristics();
+  RobustGattClient::ConnectionParams params;
+  params.tx_power_level = api::ble_v2::TxPowerLevel::kMedium;
+  params.service_uuid = kFastPairServiceUuid;
+  params.characteristic_uuids.push_back(
+      {kKeyBasedCharacteristicUuidV2, kKeyBasedCharacteristicUuidV1});
+  params.attribute_cache_key = std::string(kAttributeCacheKey);
+
+  RobustGattClient gatt_client(seeker_ble_, provider, params);
+  gatt_client.WriteCharacteristic(
+      0, kData, api::ble_v2::GattClient::WriteType::kWithResponse,
+      [&](absl::Status status) {
+        EXPECT_OK(status);
+        latch.CountDown();
+      });
+
+  EXPECT_TRUE(latch.Await().Ok());
+  EXPECT_EQ(GetWrittenData(*key_based_characteristic_), kData);
+}
+
+TEST_F(RobustGattClientTest, ReplacesStaleCachedCharacteristics) {
+  constexpr absl::string_view kData = "hello";
+  GattAttributeCache::GetInstance().Clear();
+  GattAttributeCache::GetInstance().Put(kAttributeCacheKey,
+                                        {kKeyBasedCharacteristicUuidV1});
+  CountDownLatch latch(1);
+  BleV2Peripheral provider = seeker_ble_.GetRemotePeripheral(provider_address_);
+  InsertCorrectV2GattCharacteristics();
+  RobustGattClient::ConnectionParams params;
+  params.tx_power_level = api::ble_v2::TxPowerLevel::kMedium;
+  params.service_uuid = kFastPairServiceUuid;
+  params.characteristic_uuids.push_back(
+      {kKeyBasedCharacteristicUuidV2, kKeyBasedCharacteristicUuidV1});
+  params.attribute_cache_key = std::string(kAttributeCacheKey);
+
+  RobustGattClient gatt_client(seeker_ble_, provider, params);
+  gatt_client.WriteCharacteristic(
+      0, kData, api::ble_v2::GattClient::WriteType::kWithResponse,
+      [&](absl::Status status) {
+        EXPECT_OK(status);
+        latch.CountDown();
+      });
+
+  EXPECT_TRUE(latch.Await().Ok());
+  EXPECT_EQ(GetWrittenData(*key_based_characteristic_), kData);
+  EXPECT_THAT(GattAttributeCache::GetInstance().Get(kAttributeCacheKey),
+              Optional(ElementsAre(kKeyBasedCharacteristicUuidV2)));
+}
+
 }  // namespace
 
 }  // namespace fastpair
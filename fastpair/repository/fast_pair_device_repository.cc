@@ -15,89 +15,253 @@
 #include "fastpair/repository/fast_pair_device_repository.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <optional>
+#include <string>
 #include <utility>
+#include <vector>
 
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 #include "fastpair/common/account_key.h"
 #include "fastpair/common/fast_pair_device.h"
+#include "internal/platform/clock.h"
+#include "internal/platform/clock_impl.h"
 #include "internal/platform/logging.h"
 #include "internal/platform/mutex_lock.h"
 
 namespace nearby {
 namespace fastpair {
+FastPairDeviceRepository::FastPairDeviceRepository(
+    SingleThreadExecutor* executor, Clock* clock)
+    : executor_(executor),
+      clock_(clock != nullptr ? clock : &ClockImpl::GetInstance()),
+      last_expiry_check_(clock_->Now()) {}
+
+FastPairDeviceRepository::~FastPairDeviceRepository() {
+  MutexLock lock(&mutex_);
+  for (auto& [device, entry] : entries_) {
+    entry->device->SetLookupKeysChangedCallback(nullptr);
+  }
+}
 
 FastPairDevice* FastPairDeviceRepository::AddDevice(
     std::unique_ptr<FastPairDevice> device) {
-  const auto& id = device->GetUniqueId();
-  MutexLock lock(&mutex_);
-  for (auto& item : devices_) {
-    if (item->GetUniqueId() == id) {
+  bool check_expiry;
+  FastPairDevice* result;
+  {
+    MutexLock lock(&mutex_);
+    absl::Time now = clock_->Now();
+    check_expiry = now - last_expiry_check_ >= kExpiryCheckInterval;
+    Entry* entry = FindInIndex(by_unique_id_, device->GetUniqueId());
+    if (entry != nullptr) {
       // Overwrite the existing object.
-      *item = std::move(*device);
-      return item.get();
+      *entry->device = std::move(*device);
+    } else {
+      auto new_entry = std::make_unique<Entry>();
+      new_entry->device = std::move(device);
+      new_entry->sequence = next_sequence_++;
+      entry = new_entry.get();
+      entries_.emplace(entry->device.get(), std::move(new_entry));
     }
+    entry->last_seen = now;
+    entry->device->SetLookupKeysChangedCallback(
+        [this](const FastPairDevice& device) { OnLookupKeysChanged(device); });
+    Reindex(entry);
+    result = entry->device.get();
   }
-  FastPairDevice* ptr = device.get();
-  devices_.push_back(std::move(device));
-  return ptr;
+  if (check_expiry) RemoveExpiredDevices();
+  return result;
 }
 
 void FastPairDeviceRepository::RemoveDevice(const FastPairDevice* device) {
   std::unique_ptr<FastPairDevice> fast_pair_device = ExtractDevice(device);
   if (fast_pair_device == nullptr) return;
-  // Tasks running in the background may still be referencing `device`.
-  // Deferring the destruction to the background thread should prevent
-  // use-after-free errors.
-  executor_->Execute([this, fast_pair_device = std::move(fast_pair_device)]() {
-    for (auto* callback : observers_.GetObservers()) {
-      (*callback)(*fast_pair_device);
-    }
-    NEARBY_LOGS(VERBOSE) << "Destroyed FP device: " << *fast_pair_device;
-  });
+  DestroyDevice(std::move(fast_pair_device));
 }
 
 std::optional<FastPairDevice*> FastPairDeviceRepository::FindDevice(
     absl::string_view mac_address) {
   MutexLock lock(&mutex_);
-  auto it = std::find_if(devices_.begin(), devices_.end(),
-                         [&](const std::unique_ptr<FastPairDevice>& device) {
-                           return device->GetBleAddress() == mac_address ||
-                                  device->GetPublicAddress() == mac_address;
-                         });
-  if (it != devices_.end()) {
-    return it->get();
+  Entry* entry;
+  if (mac_address.empty()) {
+    entry = FindOldest([](const FastPairDevice& device) {
+      return device.GetBleAddress().empty() ||
+             device.GetPublicAddress() == std::string();
+    });
   } else {
-    return std::nullopt;
+    entry = FindInIndex(by_ble_address_, mac_address);
+    Entry* public_entry = FindInIndex(by_public_address_, mac_address);
+    if (entry == nullptr ||
+        (public_entry != nullptr && public_entry->sequence < entry->sequence)) {
+      entry = public_entry;
+    }
   }
+  if (entry == nullptr) return std::nullopt;
+  entry->last_seen = clock_->Now();
+  return entry->device.get();
 }
 
 std::optional<FastPairDevice*> FastPairDeviceRepository::FindDevice(
     const AccountKey& account_key) {
   MutexLock lock(&mutex_);
-  auto it = std::find_if(devices_.begin(), devices_.end(),
-                         [&](const std::unique_ptr<FastPairDevice>& device) {
-                           return device->GetAccountKey() == account_key;
-                         });
-  if (it != devices_.end()) {
-    return it->get();
+  Entry* entry;
+  if (account_key.GetAsBytes().empty()) {
+    entry = FindOldest([](const FastPairDevice& device) {
+      return device.GetAccountKey().GetAsBytes().empty();
+    });
   } else {
-    return std::nullopt;
+    entry = FindInIndex(by_account_key_, account_key.GetAsBytes());
   }
+  if (entry == nullptr) return std::nullopt;
+  entry->last_seen = clock_->Now();
+  return entry->device.get();
+}
+
+int FastPairDeviceRepository::RemoveExpiredDevices() {
+  std::vector<std::unique_ptr<FastPairDevice>> expired;
+  {
+    MutexLock lock(&mutex_);
+    absl::Time now = clock_->Now();
+    last_expiry_check_ = now;
+    for (auto it = entries_.begin(); it != entries_.end();) {
+      Entry* entry = it->second.get();
+      const FastPairDevice& device = *entry->device;
+      // Devices that are pairing or paired are in use even when they aren't
+      // advertising.
+      if (now - entry->last_seen < kDeviceTimeout ||
+          device.HasStartedPairing() || !entry->account_key.empty()) {
+        ++it;
+        continue;
+      }
+      Unindex(entry);
+      entry->device->SetLookupKeysChangedCallback(nullptr);
+      expired.push_back(std::move(entry->device));
+      entries_.erase(it++);
+    }
+  }
+  for (auto& device : expired) {
+    NEARBY_LOGS(VERBOSE) << "Removing expired FP device: " << *device;
+    DestroyDevice(std::move(device));
+  }
+  return static_cast<int>(expired.size());
+}
+
+size_t FastPairDeviceRepository::GetDeviceCount() {
+  MutexLock lock(&mutex_);
+  return entries_.size();
+}
+
+void FastPairDeviceRepository::AddToIndex(Index& index, absl::string_view key,
+                                          Entry* entry) {
+  if (key.empty()) return;
+  index[key].push_back(entry);
+}
+
+void FastPairDeviceRepository::RemoveFromIndex(Index& index,
+                                               absl::string_view key,
+                                               Entry* entry) {
+  if (key.empty()) return;
+  auto it = index.find(key);
+  if (it == index.end()) return;
+  std::vector<Entry*>& entries = it->second;
+  entries.erase(std::remove(entries.begin(), entries.end(), entry),
+                entries.end());
+  if (entries.empty()) index.erase(it);
+}
+
+FastPairDeviceRepository::Entry* FastPairDeviceRepository::FindInIndex(
+    const Index& index, absl::string_view key) {
+  auto it = index.find(key);
+  if (it == index.end()) return nullptr;
+  return *std::min_element(
+      it->second.begin(), it->second.end(),
+      [](Entry* a, Entry* b) { return a->sequence < b->sequence; });
+}
+
+void FastPairDeviceRepository::Reindex(Entry* entry) {
+  const FastPairDevice& device = *entry->device;
+  if (entry->unique_id != device.GetUniqueId()) {
+    RemoveFromIndex(by_unique_id_, entry->unique_id, entry);
+    entry->unique_id = device.GetUniqueId();
+    AddToIndex(by_unique_id_, entry->unique_id, entry);
+  }
+  if (entry->ble_address != device.GetBleAddress()) {
+    RemoveFromIndex(by_ble_address_, entry->ble_address, entry);
+    entry->ble_address = std::string(device.GetBleAddress());
+    AddToIndex(by_ble_address_, entry->ble_address, entry);
+  }
+  if (entry->public_address != device.GetPublicAddress()) {
+    if (entry->public_address.has_value()) {
+      RemoveFromIndex(by_public_address_, *entry->public_address, entry);
+    }
+    entry->public_address = device.GetPublicAddress();
+    if (entry->public_address.has_value()) {
+      AddToIndex(by_public_address_, *entry->public_address, entry);
+    }
+  }
+  if (entry->account_key != device.GetAccountKey().GetAsBytes()) {
+    RemoveFromIndex(by_account_key_, entry->account_key, entry);
+    entry->account_key = std::string(device.GetAccountKey().GetAsBytes());
+    AddToIndex(by_account_key_, entry->account_key, entry);
+  }
+}
+
+void FastPairDeviceRepository::Unindex(Entry* entry) {
+  RemoveFromIndex(by_unique_id_, entry->unique_id, entry);
+  RemoveFromIndex(by_ble_address_, entry->ble_address, entry);
+  if (entry->public_address.has_value()) {
+    RemoveFromIndex(by_public_address_, *entry->public_address, entry);
+  }
+  RemoveFromIndex(by_account_key_, entry->account_key, entry);
+}
+
+void FastPairDeviceRepository::OnLookupKeysChanged(
+    const FastPairDevice& device) {
+  MutexLock lock(&mutex_);
+  auto it = entries_.find(&device);
+  if (it == entries_.end()) return;
+  Reindex(it->second.get());
+}
+
+FastPairDeviceRepository::Entry* FastPairDeviceRepository::FindOldest(
+    absl::AnyInvocable<bool(const FastPairDevice&)> predicate) {
+  Entry* oldest = nullptr;
+  for (auto& [device, entry] : entries_) {
+    if (!predicate(*device)) continue;
+    if (oldest == nullptr || entry->sequence < oldest->sequence) {
+      oldest = entry.get();
+    }
+  }
+  return oldest;
 }
 
 std::unique_ptr<FastPairDevice> FastPairDeviceRepository::ExtractDevice(
     const FastPairDevice* device) {
   MutexLock lock(&mutex_);
-  auto it = std::find_if(devices_.begin(), devices_.end(),
-                         [&](const std::unique_ptr<FastPairDevice>& item) {
-                           return item.get() == device;
-                         });
-  if (it == devices_.end()) return nullptr;
-  std::unique_ptr<FastPairDevice> fast_pair_device = std::move(*it);
-  devices_.erase(it);
+  auto it = entries_.find(device);
+  if (it == entries_.end()) return nullptr;
+  Entry* entry = it->second.get();
+  Unindex(entry);
+  entry->device->SetLookupKeysChangedCallback(nullptr);
+  std::unique_ptr<FastPairDevice> fast_pair_device = std::move(entry->device);
+  entries_.erase(it);
   return fast_pair_device;
 }
 
+void FastPairDeviceRepository::DestroyDevice(
+    std::unique_ptr<FastPairDevice> device) {
+  // Tasks running in the background may still be referencing `device`.
+  // Deferring the destruction to the background thread should prevent
+  // use-after-free errors.
+  executor_->Execute([this, fast_pair_device = std::move(device)]() {
+    for (auto* callback : observers_.GetObservers()) {
+      (*callback)(*fast_pair_device);
+    }
+    NEARBY_LOGS(VERBOSE) << "Destroyed FP device: " << *fast_pair_device;
+  });
+}
+
 }  // namespace fastpair
 }  // namespace nearby
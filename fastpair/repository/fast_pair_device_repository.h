@@ -15,13 +15,20 @@
 #ifndef THIRD_PARTY_NEARBY_FASTPAIR_REPOSITORY_FAST_PAIR_DEVICE_REPOSITORY_H_
 #define THIRD_PARTY_NEARBY_FASTPAIR_REPOSITORY_FAST_PAIR_DEVICE_REPOSITORY_H_
 
+#include <cstdint>
 #include <memory>
 #include <optional>
+#include <string>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/functional/any_invocable.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "fastpair/common/account_key.h"
 #include "fastpair/common/fast_pair_device.h"
 #include "internal/base/observer_list.h"
+#include "internal/platform/clock.h"
 #include "internal/platform/mutex.h"
 #include "internal/platform/single_thread_executor.h"
 
@@ -29,16 +36,27 @@ namespace nearby {
 namespace fastpair {
 
 // Owner of `FastPairDevice` instances.
+//
+// Devices are indexed by unique ID, BLE address, public address and account
+// key, and re-indexed whenever one of those changes on the device. Devices
+// that haven't been seen for `kDeviceTimeout` are removed, unless they are
+// pairing or have an account key.
 class FastPairDeviceRepository {
  public:
+  // How long a device is kept after it was last added or found.
+  static constexpr absl::Duration kDeviceTimeout = absl::Minutes(10);
+  // How often `AddDevice()` looks for devices to remove.
+  static constexpr absl::Duration kExpiryCheckInterval = absl::Minutes(1);
+
   // Called on the background thread right before `device` is destroyed.
   // The callbacks are not called when FastPairDeviceRepository is
   // destructing.
   using RemoveDeviceCallback =
       absl::AnyInvocable<void(const FastPairDevice& device)>;
 
-  explicit FastPairDeviceRepository(SingleThreadExecutor* executor)
-      : executor_(executor) {}
+  explicit FastPairDeviceRepository(SingleThreadExecutor* executor,
+                                    Clock* clock = nullptr);
+  ~FastPairDeviceRepository();
 
   // Adds device to the repository and takes over ownership.
   // If a device with the same MAC address is already in the repository, it is
@@ -57,6 +75,12 @@ class FastPairDeviceRepository {
   // Finds a device matching the account key.
   std::optional<FastPairDevice*> FindDevice(const AccountKey& account_key);
 
+  // Removes devices that haven't been seen for `kDeviceTimeout`. Returns the
+  // number of devices removed.
+  int RemoveExpiredDevices();
+
+  size_t GetDeviceCount();
+
   void AddObserver(RemoveDeviceCallback* observer) {
     observers_.AddObserver(observer);
   }
@@ -65,11 +89,51 @@ class FastPairDeviceRepository {
   }
 
  private:
-  // Removes `device` from `devices_`.
-  std::unique_ptr<FastPairDevice> ExtractDevice(const FastPairDevice* device);
+  struct Entry {
+    std::unique_ptr<FastPairDevice> device;
+    // Insertion order. When several devices share a key, lookups return the
+    // oldest one.
+    std::uint64_t sequence;
+    absl::Time last_seen;
+    // The keys the device is currently indexed under.
+    std::string unique_id;
+    std::string ble_address;
+    std::optional<std::string> public_address;
+    std::string account_key;
+  };
+  // Maps a key to the devices that have it, which is nearly always one.
+  using Index = absl::flat_hash_map<std::string, std::vector<Entry*>>;
+
+  static void AddToIndex(Index& index, absl::string_view key, Entry* entry);
+  static void RemoveFromIndex(Index& index, absl::string_view key,
+                              Entry* entry);
+  static Entry* FindInIndex(const Index& index, absl::string_view key);
+
+  // Updates the indexes after the keys of `entry` changed.
+  void Reindex(Entry* entry) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void Unindex(Entry* entry) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void OnLookupKeysChanged(const FastPairDevice& device)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+  // Lookups of empty keys, which aren't indexed.
+  Entry* FindOldest(absl::AnyInvocable<bool(const FastPairDevice&)> predicate)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Removes `device` from `entries_`.
+  std::unique_ptr<FastPairDevice> ExtractDevice(const FastPairDevice* device)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+  // Hands the device over to the executor for destruction.
+  void DestroyDevice(std::unique_ptr<FastPairDevice> device);
+
   Mutex mutex_;
   SingleThreadExecutor* executor_;
-  std::vector<std::unique_ptr<FastPairDevice>> devices_ ABSL_GUARDED_BY(mutex_);
+  Clock* clock_;
+  absl::flat_hash_map<const FastPairDevice*, std::unique_ptr<Entry>> entries_
+      ABSL_GUARDED_BY(mutex_);
+  Index by_unique_id_ ABSL_GUARDED_BY(mutex_);
+  Index by_ble_address_ ABSL_GUARDED_BY(mutex_);
+  Index by_public_address_ ABSL_GUARDED_BY(mutex_);
+  Index by_account_key_ ABSL_GUARDED_BY(mutex_);
+  std::uint64_t next_sequence_ ABSL_GUARDED_BY(mutex_) = 0;
+  absl::Time last_expiry_check_ ABSL_GUARDED_BY(mutex_);
   ObserverList<RemoveDeviceCallback> observers_;
 };
 
@@ -15,14 +15,20 @@
 #include "fastpair/repository/fast_pair_device_repository.h"
 
 #include <memory>
+#include <optional>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "gtest/gtest.h"
+#include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 #include "fastpair/common/account_key.h"
 #include "fastpair/common/fast_pair_device.h"
 #include "fastpair/common/protocol.h"
 #include "internal/platform/single_thread_executor.h"
+#include "internal/test/fake_clock.h"
 
 namespace nearby {
 namespace fastpair {
@@ -32,6 +38,13 @@ constexpr absl::string_view kModelId = "123456";
 constexpr absl::string_view kBleAddress = "AA:BB:CC:DD:EE:FF";
 constexpr absl::string_view kBtAddress = "12:34:56:78:90:AB";
 constexpr absl::string_view kAccountKey = "04b85786180add47fb81a04a8ce6b0de";
+constexpr absl::string_view kRotatedBleAddress = "11:22:33:44:55:66";
+constexpr int kManyDeviceCount = 1000;
+
+std::string MakeAddress(int i) {
+  return absl::StrFormat("AA:BB:CC:%02X:%02X:%02X", (i >> 16) & 0xff,
+                         (i >> 8) & 0xff, i & 0xff);
+}
 
 TEST(FastPairDeviceRepositoryTest, AddDevice) {
   SingleThreadExecutor executor;
@@ -138,6 +151,134 @@ TEST(FastPairDeviceRepositoryTest, RemovingDeviceCallsCallback) {
   executor.Shutdown();
 }
 
+TEST(FastPairDeviceRepositoryTest, AddDeviceWithSameIdReplacesDevice) {
+  SingleThreadExecutor executor;
+  FastPairDeviceRepository repo(&executor);
+  FastPairDevice* device = repo.AddDevice(std::make_unique<FastPairDevice>(
+      kModelId, kBleAddress, Protocol::kFastPairInitialPairing));
+
+  FastPairDevice* replaced = repo.AddDevice(std::make_unique<FastPairDevice>(
+      "654321", kBleAddress, Protocol::kFastPairInitialPairing));
+
+  EXPECT_EQ(replaced, device);
+  EXPECT_EQ(device->GetModelId(), "654321");
+  EXPECT_EQ(repo.GetDeviceCount(), 1);
+  executor.Shutdown();
+}
+
+TEST(FastPairDeviceRepositoryTest, FindDeviceAfterAddressRotation) {
+  SingleThreadExecutor executor;
+  FastPairDeviceRepository repo(&executor);
+  FastPairDevice* device = repo.AddDevice(std::make_unique<FastPairDevice>(
+      kModelId, kBleAddress, Protocol::kFastPairInitialPairing));
+
+  device->SetBleAddress(kRotatedBleAddress);
+  device->SetPublicAddress(kBtAddress);
+
+  EXPECT_FALSE(repo.FindDevice(kBleAddress).has_value());
+  EXPECT_EQ(repo.FindDevice(kRotatedBleAddress), device);
+  EXPECT_EQ(repo.FindDevice(kBtAddress), device);
+  // The unique ID is now the public address.
+  EXPECT_EQ(repo.AddDevice(std::make_unique<FastPairDevice>(
+                kModelId, kBtAddress, Protocol::kFastPairInitialPairing)),
+            device);
+  executor.Shutdown();
+}
+
+TEST(FastPairDeviceRepositoryTest, FindDeviceAfterAccountKeyChange) {
+  SingleThreadExecutor executor;
+  FastPairDeviceRepository repo(&executor);
+  FastPairDevice* device = repo.AddDevice(std::make_unique<FastPairDevice>(
+      kModelId, kBleAddress, Protocol::kFastPairInitialPairing));
+  EXPECT_FALSE(repo.FindDevice(AccountKey(kAccountKey)).has_value());
+
+  device->SetAccountKey(AccountKey(kAccountKey));
+
+  EXPECT_EQ(repo.FindDevice(AccountKey(kAccountKey)), device);
+  executor.Shutdown();
+}
+
+TEST(FastPairDeviceRepositoryTest, RemovesDevicesNotSeenRecently) {
+  SingleThreadExecutor executor;
+  FakeClock clock;
+  FastPairDeviceRepository repo(&executor, &clock);
+  repo.AddDevice(std::make_unique<FastPairDevice>(
+      kModelId, kBleAddress, Protocol::kFastPairInitialPairing));
+  repo.AddDevice(std::make_unique<FastPairDevice>(
+      kModelId, kRotatedBleAddress, Protocol::kFastPairInitialPairing));
+
+  clock.FastForward(FastPairDeviceRepository::kDeviceTimeout / 2);
+  // Seeing the device again keeps it.
+  repo.AddDevice(std::make_unique<FastPairDevice>(
+      kModelId, kBleAddress, Protocol::kFastPairInitialPairing));
+  clock.FastForward(FastPairDeviceRepository::kDeviceTimeout / 2);
+
+  EXPECT_EQ(repo.RemoveExpiredDevices(), 1);
+  EXPECT_TRUE(repo.FindDevice(kBleAddress).has_value());
+  EXPECT_FALSE(repo.FindDevice(kRotatedBleAddress).has_value());
+  executor.Shutdown();
+}
+
+TEST(FastPairDeviceRepositoryTest, KeepsPairingAndPairedDevices) {
+  SingleThreadExecutor executor;
+  FakeClock clock;
+  FastPairDeviceRepository repo(&executor, &clock);
+  FastPairDevice* pairing = repo.AddDevice(std::make_unique<FastPairDevice>(
+      kModelId, kBleAddress, Protocol::kFastPairInitialPairing));
+  pairing->StartedPairing(true);
+  auto paired = std::make_unique<FastPairDevice>(
+      kModelId, kRotatedBleAddress, Protocol::kFastPairInitialPairing);
+  paired->SetAccountKey(AccountKey(kAccountKey));
+  repo.AddDevice(std::move(paired));
+
+  clock.FastForward(FastPairDeviceRepository::kDeviceTimeout);
+
+  EXPECT_EQ(repo.RemoveExpiredDevices(), 0);
+  EXPECT_EQ(repo.GetDeviceCount(), 2);
+  executor.Shutdown();
+}
+
+TEST(FastPairDeviceRepositoryTest, AddDevicePeriodicallyRemovesExpiredDevices) {
+  SingleThreadExecutor executor;
+  FakeClock clock;
+  FastPairDeviceRepository repo(&executor, &clock);
+  FastPairDeviceRepository::RemoveDeviceCallback callback =
+      [&](const FastPairDevice& device) {
+        EXPECT_EQ(device.GetBleAddress(), kBleAddress);
+      };
+  repo.AddObserver(&callback);
+  repo.AddDevice(std::make_unique<FastPairDevice>(
+      kModelId, kBleAddress, Protocol::kFastPairInitialPairing));
+
+  clock.FastForward(FastPairDeviceRepository::kDeviceTimeout);
+  repo.AddDevice(std::make_unique<FastPairDevice>(
+      kModelId, kRotatedBleAddress, Protocol::kFastPairInitialPairing));
+
+  EXPECT_EQ(repo.GetDeviceCount(), 1);
+  EXPECT_FALSE(repo.FindDevice(kBleAddress).has_value());
+  executor.Shutdown();
+  repo.RemoveObserver(&callback);
+}
+
+TEST(FastPairDeviceRepositoryTest, FindsEachOfManyDevices) {
+  SingleThreadExecutor executor;
+  FastPairDeviceRepository repo(&executor);
+  std::vector<std::string> addresses;
+  for (int i = 0; i < kManyDeviceCount; ++i) {
+    addresses.push_back(MakeAddress(i));
+    repo.AddDevice(std::make_unique<FastPairDevice>(
+        kModelId, addresses.back(), Protocol::kFastPairInitialPairing));
+  }
+
+  EXPECT_EQ(repo.GetDeviceCount(), kManyDeviceCount);
+  for (const std::string& address : addresses) {
+    std::optional<FastPairDevice*> device = repo.FindDevice(address);
+    ASSERT_TRUE(device.has_value()) << address;
+    EXPECT_EQ((*device)->GetBleAddress(), address);
+  }
+  executor.Shutdown();
+}
+
 }  // namespace
 
 }  // namespace fastpair
@@ -14,6 +14,11 @@
 
 #include "fastpair/scanning/fastpair/fake_fast_pair_scanner.h"
 
+#include <string>
+#include <vector>
+
+#include "internal/platform/mutex_lock.h"
+
 namespace nearby {
 namespace fastpair {
 
@@ -33,5 +38,22 @@ void FakeFastPairScanner::NotifyDeviceLost(const BlePeripheral& peripheral) {
   for (auto& obs : observer_.GetObservers()) obs->OnDeviceLost(peripheral);
 }
 
+void FakeFastPairScanner::NotifyDeviceStillPresent(
+    const BlePeripheral& peripheral) {
+  for (auto& obs : observer_.GetObservers()) {
+    obs->OnDeviceStillPresent(peripheral);
+  }
+}
+
+void FakeFastPairScanner::ForgetAdvertisement(const std::string& address) {
+  MutexLock lock(&mutex_);
+  forgotten_advertisements_.push_back(address);
+}
+
+std::vector<std::string> FakeFastPairScanner::GetForgottenAdvertisements() {
+  MutexLock lock(&mutex_);
+  return forgotten_advertisements_;
+}
+
 }  // namespace fastpair
 }  // namespace nearby
@@ -16,9 +16,12 @@
 #define THIRD_PARTY_NEARBY_FASTPAIR_SCANNING_FASTPAIR_FAKE_FAST_PAIR_SCANNER_H_
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "fastpair/scanning/fastpair/fast_pair_scanner.h"
 #include "internal/base/observer_list.h"
+#include "internal/platform/mutex.h"
 
 namespace nearby {
 namespace fastpair {
@@ -34,12 +37,18 @@ class FakeFastPairScanner final : public FastPairScanner {
   void RemoveObserver(Observer* observer) override;
   void NotifyDeviceFound(const BlePeripheral& peripheral);
   void NotifyDeviceLost(const BlePeripheral& peripheral);
+  void NotifyDeviceStillPresent(const BlePeripheral& peripheral);
   std::unique_ptr<ScanningSession> StartScanning() override {
     return std::make_unique<ScanningSession>();
   };
+  void ForgetAdvertisement(const std::string& address) override;
+
+  std::vector<std::string> GetForgottenAdvertisements();
 
  private:
+  Mutex mutex_;
   ObserverList<FastPairScanner::Observer> observer_;
+  std::vector<std::string> forgotten_advertisements_ ABSL_GUARDED_BY(mutex_);
 };
 
 }  // namespace fastpair
@@ -14,21 +14,17 @@
 
 #include "fastpair/scanning/fastpair/fast_pair_discoverable_scanner.h"
 
-#include <algorithm>
-#include <cstdint>
-#include <iterator>
 #include <memory>
 #include <optional>
 #include <string>
 #include <utility>
-#include <vector>
 
 #include "absl/functional/bind_front.h"
 #include "absl/strings/string_view.h"
 #include "fastpair/common/constant.h"
 #include "fastpair/common/fast_pair_device.h"
+#include "fastpair/common/fast_pair_service_data.h"
 #include "fastpair/common/protocol.h"
-#include "fastpair/dataparser/fast_pair_data_parser.h"
 #include "fastpair/proto/fastpair_rpcs.pb.h"
 #include "fastpair/repository/fast_pair_repository.h"
 #include "internal/platform/byte_array.h"
@@ -119,19 +115,13 @@ void FastPairDiscoverableScanner::OnDeviceFound(
        address = peripheral.GetName()]()
           ABSL_EXCLUSIVE_LOCKS_REQUIRED(*executor_) {
             NEARBY_LOGS(INFO) << __func__ << ": Attempting to get model ID";
-            std::vector<uint8_t> service_data;
-            std::move(std::begin(fast_pair_service_data),
-                      std::end(fast_pair_service_data),
-                      std::back_inserter(service_data));
-
-            // TODO(jsobczak): GetHexModelIdFromServiceData() callback is
-            // synchronous. It would be simpler if
-            // GetHexModelIdFromServiceData() used return value rather than a
-            // callback.
-            FastPairDataParser::GetHexModelIdFromServiceData(
-                service_data, {[&](std::optional<absl::string_view> model_id) {
-                  OnModelIdRetrieved(address, model_id);
-                }});
+            std::optional<FastPairServiceData> service_data =
+                FastPairServiceData::Parse(fast_pair_service_data);
+            std::optional<std::string> model_id;
+            if (service_data.has_value()) {
+              model_id = service_data->GetHexModelId();
+            }
+            OnModelIdRetrieved(address, model_id);
           });
 }
 
@@ -165,6 +155,8 @@ void FastPairDiscoverableScanner::OnDeviceMetadataRetrieved(
     std::optional<DeviceMetadata> device_metadata) {
   if (!device_metadata.has_value()) {
     NEARBY_LOGS(WARNING) << __func__ << ": Failed to get device metadata";
+    // Look the device up again on its next advertisement.
+    scanner_.ForgetAdvertisement(address);
     return;
   }
   // Ignore advertisements that aren't for Fast Pair but leverage the service
@@ -218,6 +210,7 @@ void FastPairDiscoverableScanner::OnDeviceLost(
     auto node = notified_devices_.extract(peripheral.GetName());
     // Don't invoke callback if we didn't notify this device.
     if (node.empty()) return;
+    pending_refreshes_.erase(peripheral.GetName());
   }
   executor_->Execute("device-lost",
                      [this, address = peripheral.GetName()]()
@@ -231,5 +224,31 @@ void FastPairDiscoverableScanner::OnDeviceLost(
                          });
 }
 
+void FastPairDiscoverableScanner::OnDeviceStillPresent(
+    const BlePeripheral& peripheral) {
+  std::string address = peripheral.GetName();
+  {
+    MutexLock lock(&mutex_);
+    // Only notified devices are in the repository. Queue at most one refresh
+    // per device, since this is called at the raw scan rate.
+    if (!notified_devices_.contains(address) ||
+        !pending_refreshes_.insert(address).second) {
+      return;
+    }
+  }
+  executor_->Execute(
+      "device-still-present",
+      [this, address = std::move(address)]()
+          ABSL_EXCLUSIVE_LOCKS_REQUIRED(*executor_) {
+            {
+              MutexLock lock(&mutex_);
+              pending_refreshes_.erase(address);
+            }
+            // Looking the device up refreshes its last-seen time, so the
+            // repository doesn't expire a device that is still advertising.
+            device_repository_->FindDevice(address);
+          });
+}
+
 }  // namespace fastpair
 }  // namespace nearby
@@ -20,6 +20,8 @@
 #include <string>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "fastpair/common/device_metadata.h"
 #include "fastpair/common/fast_pair_device.h"
 #include "fastpair/repository/fast_pair_device_repository.h"
@@ -75,6 +77,7 @@ class FastPairDiscoverableScanner : public FastPairScanner::Observer {
   // FastPairScanner::Observer
   void OnDeviceFound(const BlePeripheral& peripheral) override;
   void OnDeviceLost(const BlePeripheral& peripheral) override;
+  void OnDeviceStillPresent(const BlePeripheral& peripheral) override;
 
  private:
   void OnModelIdRetrieved(const std::string& address,
@@ -91,6 +94,8 @@ class FastPairDiscoverableScanner : public FastPairScanner::Observer {
   SingleThreadExecutor* executor_;
   absl::flat_hash_map<std::string, FastPairDevice*> notified_devices_
       ABSL_GUARDED_BY(mutex_);
+  // Notified devices with a last-seen refresh queued on `executor_`.
+  absl::flat_hash_set<std::string> pending_refreshes_ ABSL_GUARDED_BY(mutex_);
   FastPairDeviceRepository* device_repository_ ABSL_GUARDED_BY(*executor_);
   ObserverList<FastPairScanner::Observer> observer_list_;
 };
@@ -18,6 +18,7 @@
 #include <string>
 #include <vector>
 
+#include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/synchronization/notification.h"
 #include "fastpair/repository/fake_fast_pair_repository.h"
@@ -25,6 +26,7 @@
 #include "fastpair/scanning/fastpair/fake_fast_pair_scanner.h"
 #include "fastpair/testing/fast_pair_service_data_creator.h"
 #include "internal/platform/bluetooth_adapter.h"
+#include "internal/test/fake_clock.h"
 
 namespace nearby {
 namespace fastpair {
@@ -311,6 +313,53 @@ TEST_F(FastPairDiscoverableScannerTest,
   EXPECT_FALSE(lost_notification.WaitForNotificationWithTimeout(kWaitTimeout));
 }
 
+TEST_F(FastPairDiscoverableScannerTest,
+       ForgetsAdvertisementWhenMetadataFetchFails) {
+  scanner_ = std::make_unique<FakeFastPairScanner>();
+  auto repository = std::make_unique<FakeFastPairRepository>();
+  absl::Notification found_notification;
+  discoverable_scanner_ = FastPairDiscoverableScanner::Factory::Create(
+      *scanner_, [&](FastPairDevice& device) { found_notification.Notify(); },
+      [&](FastPairDevice& device) {}, &executor_, &devices_);
+
+  auto ble_peripheral =
+      std::make_unique<FakeBlePeripheral>(kTestBleDeviceAddress, kValidModelId);
+  scanner_->NotifyDeviceFound(BlePeripheral(ble_peripheral.get()));
+  EXPECT_FALSE(found_notification.WaitForNotificationWithTimeout(kWaitTimeout));
+
+  EXPECT_THAT(scanner_->GetForgottenAdvertisements(),
+              ::testing::ElementsAre(kTestBleDeviceAddress));
+}
+
+TEST_F(FastPairDiscoverableScannerTest, StillPresentDeviceIsNotExpired) {
+  FakeClock clock;
+  FastPairDeviceRepository devices(&executor_, &clock);
+  scanner_ = std::make_unique<FakeFastPairScanner>();
+  auto repository = std::make_unique<FakeFastPairRepository>();
+  proto::Device metadata;
+  metadata.set_device_type(proto::DeviceType::TRUE_WIRELESS_HEADPHONES);
+  repository->SetFakeMetadata(kValidModelId, metadata);
+  absl::Notification found_notification;
+  discoverable_scanner_ = FastPairDiscoverableScanner::Factory::Create(
+      *scanner_, [&](FastPairDevice& device) { found_notification.Notify(); },
+      [&](FastPairDevice& device) {}, &executor_, &devices);
+  auto ble_peripheral =
+      std::make_unique<FakeBlePeripheral>(kTestBleDeviceAddress, kValidModelId);
+  scanner_->NotifyDeviceFound(BlePeripheral(ble_peripheral.get()));
+  found_notification.WaitForNotification();
+
+  clock.FastForward(FastPairDeviceRepository::kDeviceTimeout / 2);
+  scanner_->NotifyDeviceStillPresent(BlePeripheral(ble_peripheral.get()));
+  absl::Notification refreshed;
+  executor_.Execute([&]() { refreshed.Notify(); });
+  refreshed.WaitForNotification();
+  clock.FastForward(FastPairDeviceRepository::kDeviceTimeout / 2);
+
+  EXPECT_EQ(devices.RemoveExpiredDevices(), 0);
+  discoverable_scanner_.reset();
+  executor_.Shutdown();
+}
+
 }  // namespace
 }  // namespace fastpair
 }  // namespace nearby
@@ -20,10 +20,11 @@
 #include <string_view>
 #include <utility>
 
+#include "fastpair/common/account_key_filter.h"
 #include "fastpair/common/constant.h"
 #include "fastpair/common/fast_pair_device.h"
+#include "fastpair/common/fast_pair_service_data.h"
 #include "fastpair/common/non_discoverable_advertisement.h"
-#include "fastpair/dataparser/fast_pair_data_parser.h"
 #include "fastpair/repository/fast_pair_repository.h"
 #include "internal/platform/logging.h"
 
@@ -89,39 +90,38 @@ void FastPairNonDiscoverableScanner::OnDeviceFound(
        address =
            peripheral.GetName()]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(*executor_) {
         NEARBY_LOGS(INFO) << __func__ << ": Attempting to parse advertisement.";
-        FastPairDataParser::ParseNotDiscoverableAdvertisement(
-            fast_pair_service_data, address,
-            [&](std::optional<NonDiscoverableAdvertisement> advertisement) {
-              OnAdvertisementParsed(address, advertisement);
-            });
+        std::optional<FastPairServiceData> service_data =
+            FastPairServiceData::Parse(fast_pair_service_data);
+        if (!service_data.has_value() ||
+            service_data->account_key_filter.empty()) {
+          NEARBY_LOGS(INFO) << __func__
+                            << ": Returning early because no advertisement was "
+                               "parsed.";
+          return;
+        }
+        OnAdvertisementParsed(address, *service_data);
       });
 }
 
 void FastPairNonDiscoverableScanner::OnAdvertisementParsed(
-    absl::string_view address,
-    std::optional<NonDiscoverableAdvertisement> advertisement) {
-  if (!advertisement.has_value()) {
-    NEARBY_LOGS(INFO)
-        << __func__ << ": Returning early because no advertisement was parsed.";
-    return;
-  }
+    absl::string_view address, const FastPairServiceData& service_data) {
   NEARBY_LOGS(INFO)
       << __func__
       << ": Attempting to check if device is associated with current account.";
-  AccountKeyFilter account_filter(advertisement.value());
+  AccountKeyFilter account_filter =
+      AccountKeyFilter::FromServiceData(service_data, address);
   FastPairRepository::Get()->CheckIfAssociatedWithCurrentAccount(
-      account_filter, [&, address = std::string(address),
-                       advertisement = std::move(advertisement)](
-                          std::optional<AccountKey> account_key,
-                          std::optional<absl::string_view> model_id) {
-        OnAccountKeyFilterCheckResult(address, advertisement, account_key,
-                                      model_id);
+      account_filter,
+      [&, address = std::string(address),
+       type = service_data.account_key_filter_type](
+          std::optional<AccountKey> account_key,
+          std::optional<absl::string_view> model_id) {
+        OnAccountKeyFilterCheckResult(address, type, account_key, model_id);
       });
 }
 
 void FastPairNonDiscoverableScanner::OnAccountKeyFilterCheckResult(
-    absl::string_view address,
-    std::optional<NonDiscoverableAdvertisement> advertisement,
+    absl::string_view address, NonDiscoverableAdvertisement::Type type,
     std::optional<AccountKey> account_key,
     std::optional<absl::string_view> model_id) {
   if (!account_key.has_value() || !model_id.has_value()) {
@@ -130,22 +130,22 @@ void FastPairNonDiscoverableScanner::OnAccountKeyFilterCheckResult(
   NEARBY_LOGS(INFO) << __func__ << ": Attempting to get device metadata.";
   FastPairRepository::Get()->GetDeviceMetadata(
       model_id.value(),
-      [&, address = std::string(address),
-       advertisement = std::move(advertisement), model_id = model_id.value(),
+      [&, address = std::string(address), type, model_id = model_id.value(),
        account_key =
            account_key.value()](std::optional<DeviceMetadata> device_metadata) {
-        OnDeviceMetadataRetrieved(address, advertisement, model_id, account_key,
+        OnDeviceMetadataRetrieved(address, type, model_id, account_key,
                                   device_metadata);
       });
 }
 
 void FastPairNonDiscoverableScanner::OnDeviceMetadataRetrieved(
-    absl::string_view address,
-    std::optional<NonDiscoverableAdvertisement> advertisement,
+    absl::string_view address, NonDiscoverableAdvertisement::Type type,
     absl::string_view model_id, AccountKey account_key,
     std::optional<DeviceMetadata> device_metadata) {
   if (!device_metadata.has_value()) {
     NEARBY_LOGS(WARNING) << __func__ << ": Failed to get device metadata";
+    // Look the device up again on its next advertisement.
+    scanner_.ForgetAdvertisement(std::string(address));
     return;
   }
 
@@ -154,7 +154,7 @@ void FastPairNonDiscoverableScanner::OnDeviceMetadataRetrieved(
   fast_pair_device->SetAccountKey(account_key);
   fast_pair_device->SetMetadata(device_metadata.value());
   fast_pair_device->SetShowUiNotification(
-      advertisement->type == NonDiscoverableAdvertisement::Type::kShowUi);
+      type == NonDiscoverableAdvertisement::Type::kShowUi);
   executor_->Execute(
       "add-device",
       [this, fast_pair_device = std::move(fast_pair_device)]()
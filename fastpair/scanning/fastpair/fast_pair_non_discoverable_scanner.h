@@ -20,6 +20,7 @@
 
 #include "absl/functional/any_invocable.h"
 #include "fastpair/common/fast_pair_device.h"
+#include "fastpair/common/fast_pair_service_data.h"
 #include "fastpair/common/non_discoverable_advertisement.h"
 #include "fastpair/repository/fast_pair_device_repository.h"
 #include "fastpair/scanning/fastpair/fast_pair_scanner.h"
@@ -75,17 +76,14 @@ class FastPairNonDiscoverableScanner : public FastPairScanner::Observer {
   void OnDeviceLost(const BlePeripheral& peripheral) override;
 
  private:
-  void OnAdvertisementParsed(
-      absl::string_view address,
-      std::optional<NonDiscoverableAdvertisement> advertisement);
+  void OnAdvertisementParsed(absl::string_view address,
+                             const FastPairServiceData& service_data);
   void OnAccountKeyFilterCheckResult(
-      absl::string_view address,
-      std::optional<NonDiscoverableAdvertisement> advertisement,
+      absl::string_view address, NonDiscoverableAdvertisement::Type type,
       std::optional<AccountKey> account_key,
       std::optional<absl::string_view> model_id);
   void OnDeviceMetadataRetrieved(
-      absl::string_view address,
-      std::optional<NonDiscoverableAdvertisement> advertisement,
+      absl::string_view address, NonDiscoverableAdvertisement::Type type,
       absl::string_view model_id, AccountKey account_key,
       std::optional<DeviceMetadata> device_metadata);
   void NotifyDeviceFound(FastPairDevice& device)
@@ -19,6 +19,7 @@
 #include <string>
 #include <vector>
 
+#include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "fastpair/common/account_key.h"
 #include "fastpair/repository/fake_fast_pair_repository.h"
@@ -236,6 +237,9 @@ TEST_F(FastPairNonDiscoverableScannerTest, FailedToGetDeviceMetadata) {
   scanner_->NotifyDeviceFound(BlePeripheral(ble_peripheral.get()));
   EXPECT_FALSE(
       found_notification.WaitForNotificationWithTimeout(kFailureTimeout));
+  // The device is looked up again on its next advertisement.
+  EXPECT_THAT(scanner_->GetForgottenAdvertisements(),
+              ::testing::ElementsAre(kBleAddress));
   scanner_->NotifyDeviceLost(BlePeripheral(ble_peripheral.get()));
   EXPECT_FALSE(
       lost_notification.WaitForNotificationWithTimeout(kFailureTimeout));
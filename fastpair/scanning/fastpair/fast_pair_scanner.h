@@ -16,6 +16,7 @@
 #define THIRD_PARTY_NEARBY_FASTPAIR_SCANNING_FASTPAIR_FAST_PAIR_SCANNER_H_
 
 #include <memory>
+#include <string>
 
 #include "fastpair/common/fast_pair_device.h"
 #include "internal/platform/bluetooth_adapter.h"
@@ -32,8 +33,12 @@ class FastPairScanner {
     virtual ~Observer() = default;
 
     // The callbacks are called on platform thread.
+    // Called for new or changed advertisements.
     virtual void OnDeviceFound(const BlePeripheral& peripheral) = 0;
     virtual void OnDeviceLost(const BlePeripheral& peripheral) = 0;
+    // Called when a device repeats an advertisement that was already reported
+    // by `OnDeviceFound()`. Called at the raw scan rate, so it must be cheap.
+    virtual void OnDeviceStillPresent(const BlePeripheral& peripheral) {}
   };
 
   // Represents scanning session. Must be destroyed before FastPairScanner.
@@ -47,6 +52,12 @@ class FastPairScanner {
 
   virtual std::unique_ptr<ScanningSession> StartScanning() = 0;
 
+  // Called by an observer that failed to handle the advertisement last
+  // reported for `address`, e.g. because its metadata couldn't be fetched.
+  // The device's next advertisement is reported by `OnDeviceFound()` again
+  // instead of being treated as a repeat.
+  virtual void ForgetAdvertisement(const std::string& address) = 0;
+
   virtual ~FastPairScanner() = default;
 };
 
@@ -21,7 +21,10 @@
 #include "absl/time/time.h"
 #include "fastpair/common/constant.h"
 #include "internal/platform/byte_array.h"
+#include "internal/platform/clock.h"
+#include "internal/platform/clock_impl.h"
 #include "internal/platform/logging.h"
+#include "internal/platform/mutex_lock.h"
 
 namespace nearby {
 namespace fastpair {
@@ -48,11 +51,16 @@ class ScanningSessionImpl : public FastPairScanner::ScanningSession {
 
 // FastPairScannerImpl
 FastPairScannerImpl::FastPairScannerImpl(Mediums& mediums,
-                                         SingleThreadExecutor* executor)
-    : mediums_(mediums), executor_(executor) {}
+                                         SingleThreadExecutor* executor,
+                                         Clock* clock)
+    : mediums_(mediums),
+      executor_(executor),
+      clock_(clock != nullptr ? clock : &ClockImpl::GetInstance()) {}
 
 void FastPairScannerImpl::AddObserver(FastPairScanner::Observer* observer) {
   observer_.AddObserver(observer);
+  // The new observer hasn't seen any advertisements yet.
+  ClearAdvertisements();
 }
 
 void FastPairScannerImpl::RemoveObserver(FastPairScanner::Observer* observer) {
@@ -114,6 +122,7 @@ void FastPairScannerImpl::StopScanning() {
                        NEARBY_LOGS(VERBOSE) << __func__ << " in background";
                        timer_.reset();
                        mediums_.GetBle().StopScanning(kServiceId);
+                       ClearAdvertisements();
                      });
 }
 
@@ -137,8 +146,7 @@ void FastPairScannerImpl::StartTimer(absl::Duration delay,
 }
 
 void FastPairScannerImpl::OnDeviceFound(const BlePeripheral& peripheral) {
-  NEARBY_LOGS(INFO) << __func__ << "Found device with ble Address = "
-                    << peripheral.GetName();
+  std::string address = peripheral.GetName();
   std::string service_data =
       peripheral.GetAdvertisementBytes(kServiceId).string_data();
   if (service_data.empty()) {
@@ -146,22 +154,56 @@ void FastPairScannerImpl::OnDeviceFound(const BlePeripheral& peripheral) {
     return;
   }
 
-  device_address_advertisement_data_map_[peripheral.GetName()].insert(
-      service_data);
+  if (!UpdateAdvertisement(address, std::move(service_data))) {
+    for (auto& observer : observer_.GetObservers()) {
+      observer->OnDeviceStillPresent(peripheral);
+    }
+    return;
+  }
 
+  NEARBY_LOGS(INFO) << __func__
+                    << "Found device with ble Address = " << address;
   NotifyDeviceFound(peripheral);
 }
 
 void FastPairScannerImpl::OnDeviceLost(const BlePeripheral& peripheral) {
   NEARBY_LOGS(INFO) << __func__ << "Lost device with ble Address = "
                     << peripheral.GetName();
-  device_address_advertisement_data_map_.erase(peripheral.GetName());
+  {
+    MutexLock lock(&mutex_);
+    advertisements_.erase(peripheral.GetName());
+  }
 
   for (auto& observer : observer_.GetObservers()) {
     observer->OnDeviceLost(peripheral);
   }
 }
 
+bool FastPairScannerImpl::UpdateAdvertisement(const std::string& address,
+                                              std::string service_data) {
+  absl::Time now = clock_->Now();
+  MutexLock lock(&mutex_);
+  auto [it, inserted] = advertisements_.try_emplace(address);
+  Advertisement& advertisement = it->second;
+  if (!inserted && advertisement.service_data == service_data &&
+      now - advertisement.last_forwarded < kAdvertisementRefreshInterval) {
+    return false;
+  }
+  advertisement.service_data = std::move(service_data);
+  advertisement.last_forwarded = now;
+  return true;
+}
+
+void FastPairScannerImpl::ForgetAdvertisement(const std::string& address) {
+  MutexLock lock(&mutex_);
+  advertisements_.erase(address);
+}
+
+void FastPairScannerImpl::ClearAdvertisements() {
+  MutexLock lock(&mutex_);
+  advertisements_.clear();
+}
+
 void FastPairScannerImpl::NotifyDeviceFound(const BlePeripheral& peripheral) {
   for (auto& observer : observer_.GetObservers()) {
     observer->OnDeviceFound(peripheral);
@@ -16,13 +16,16 @@
 #define THIRD_PARTY_NEARBY_FASTPAIR_SCANNING_FASTPAIR_FAST_PAIR_SCANNER_IMPL_H_
 
 #include <memory>
-#include <set>
 #include <string>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/time/time.h"
 #include "fastpair/internal/mediums/mediums.h"
 #include "fastpair/scanning/fastpair/fast_pair_scanner.h"
 #include "internal/base/observer_list.h"
 #include "internal/platform/bluetooth_adapter.h"
+#include "internal/platform/clock.h"
+#include "internal/platform/mutex.h"
 #include "internal/platform/single_thread_executor.h"
 #include "internal/platform/timer_impl.h"
 
@@ -31,8 +34,15 @@ namespace fastpair {
 
 class FastPairScannerImpl : public FastPairScanner {
  public:
-  explicit FastPairScannerImpl(Mediums& mediums,
-                               SingleThreadExecutor* executor);
+  // Unchanged advertisements are forwarded to `OnDeviceFound()` again after
+  // this long, so that downstream state such as the device repository's
+  // last-seen time stays fresh.
+  static constexpr absl::Duration kAdvertisementRefreshInterval =
+      absl::Minutes(1);
+
+  // `clock` defaults to the system clock.
+  FastPairScannerImpl(Mediums& mediums, SingleThreadExecutor* executor,
+                      Clock* clock = nullptr);
   FastPairScannerImpl(const FastPairScannerImpl&) = delete;
   FastPairScannerImpl& operator=(const FastPairScannerImpl&) = delete;
   ~FastPairScannerImpl() override = default;
@@ -51,6 +61,8 @@ class FastPairScannerImpl : public FastPairScanner {
 
   std::unique_ptr<ScanningSession> StartScanning() override;
   void StopScanning();
+  void ForgetAdvertisement(const std::string& address) override
+      ABSL_LOCKS_EXCLUDED(mutex_);
 
  private:
   void StartScanningInternal() ABSL_EXCLUSIVE_LOCKS_REQUIRED(*executor_);
@@ -58,15 +70,29 @@ class FastPairScannerImpl : public FastPairScanner {
   void PauseScanning() ABSL_EXCLUSIVE_LOCKS_REQUIRED(*executor_);
   void StartTimer(absl::Duration delay, absl::AnyInvocable<void()> callback)
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(*executor_);
+  // Records `service_data` as the latest advertisement from `address`. Returns
+  // true if it is new, changed, or due for a refresh.
+  bool UpdateAdvertisement(const std::string& address,
+                           std::string service_data)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+  void ClearAdvertisements() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  struct Advertisement {
+    std::string service_data;
+    // When `service_data` was last forwarded to `OnDeviceFound()`.
+    absl::Time last_forwarded;
+  };
 
   Mediums& mediums_;
   SingleThreadExecutor* executor_;
+  Clock* clock_;
   std::unique_ptr<TimerImpl> timer_ ABSL_GUARDED_BY(*executor_);
 
-  // Map of a Bluetooth device address to a set of advertisement data we have
-  // seen.
-  absl::flat_hash_map<std::string, std::set<std::string>>
-      device_address_advertisement_data_map_;
+  Mutex mutex_;
+  // Map of a Bluetooth device address to the last advertisement forwarded to
+  // observers.
+  absl::flat_hash_map<std::string, Advertisement> advertisements_
+      ABSL_GUARDED_BY(mutex_);
   ObserverList<FastPairScanner::Observer> observer_;
 };
 
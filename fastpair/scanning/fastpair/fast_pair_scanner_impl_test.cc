@@ -27,7 +27,9 @@
 #include "internal/platform/byte_array.h"
 #include "internal/platform/count_down_latch.h"
 #include "internal/platform/medium_environment.h"
+#include "internal/platform/implementation/bluetooth_adapter.h"
 #include "internal/platform/single_thread_executor.h"
+#include "internal/test/fake_clock.h"
 
 namespace nearby {
 namespace fastpair {
@@ -39,6 +41,44 @@ constexpr absl::string_view kServiceID{"Fast Pair"};
 constexpr absl::string_view kModelId{"718c17"};
 constexpr absl::string_view kFastPairServiceUuid{
     "0000FE2C-0000-1000-8000-00805F9B34FB"};
+constexpr absl::string_view kOtherModelId{"9adb11"};
+constexpr absl::string_view kTestBleDeviceAddress{"11:12:13:14:15:16"};
+constexpr absl::string_view kOtherBleDeviceAddress{"11:12:13:14:15:17"};
+
+class FakeBlePeripheral : public api::BlePeripheral {
+ public:
+  FakeBlePeripheral(absl::string_view name, absl::string_view model_id)
+      : name_(name),
+        advertisement_data_(absl::HexStringToBytes(model_id)) {}
+
+  std::string GetName() const override { return name_; }
+
+  ByteArray GetAdvertisementBytes(
+      const std::string& service_id) const override {
+    return advertisement_data_;
+  }
+
+  void SetModelId(absl::string_view model_id) {
+    advertisement_data_ = ByteArray(absl::HexStringToBytes(model_id));
+  }
+
+ private:
+  std::string name_;
+  ByteArray advertisement_data_;
+};
+
+class CountingObserver : public FastPairScanner::Observer {
+ public:
+  void OnDeviceFound(const BlePeripheral& peripheral) override { found_++; }
+  void OnDeviceLost(const BlePeripheral& peripheral) override { lost_++; }
+  void OnDeviceStillPresent(const BlePeripheral& peripheral) override {
+    still_present_++;
+  }
+
+  int found_ = 0;
+  int lost_ = 0;
+  int still_present_ = 0;
+};
 
 class FastPairScannerObserver : public FastPairScanner::Observer {
  public:
@@ -123,6 +163,116 @@ TEST_F(FastPairScannerImplTest, StopScanning) {
   DestroyOnExecutor(std::move(scanner), &executor);
 }
 
+TEST_F(FastPairScannerImplTest, ForwardsOnlyNewOrChangedAdvertisements) {
+  Mediums mediums;
+  SingleThreadExecutor executor;
+  FakeClock clock;
+  auto scanner =
+      std::make_unique<FastPairScannerImpl>(mediums, &executor, &clock);
+  CountingObserver observer;
+  scanner->AddObserver(&observer);
+  FakeBlePeripheral fake_peripheral(kTestBleDeviceAddress, kModelId);
+  FakeBlePeripheral other_fake_peripheral(kOtherBleDeviceAddress, kModelId);
+  BlePeripheral peripheral(&fake_peripheral);
+
+  for (int i = 0; i < 10; ++i) {
+    scanner->OnDeviceFound(peripheral);
+  }
+  EXPECT_EQ(observer.found_, 1);
+  EXPECT_EQ(observer.still_present_, 9);
+
+  fake_peripheral.SetModelId(kOtherModelId);
+  scanner->OnDeviceFound(peripheral);
+  EXPECT_EQ(observer.found_, 2);
+
+  scanner->OnDeviceFound(BlePeripheral(&other_fake_peripheral));
+  EXPECT_EQ(observer.found_, 3);
+  EXPECT_EQ(observer.still_present_, 9);
+  scanner->RemoveObserver(&observer);
+  DestroyOnExecutor(std::move(scanner), &executor);
+}
+
+TEST_F(FastPairScannerImplTest, RefreshesUnchangedAdvertisements) {
+  Mediums mediums;
+  SingleThreadExecutor executor;
+  FakeClock clock;
+  auto scanner =
+      std::make_unique<FastPairScannerImpl>(mediums, &executor, &clock);
+  CountingObserver observer;
+  scanner->AddObserver(&observer);
+  FakeBlePeripheral fake_peripheral(kTestBleDeviceAddress, kModelId);
+  BlePeripheral peripheral(&fake_peripheral);
+
+  scanner->OnDeviceFound(peripheral);
+  clock.FastForward(FastPairScannerImpl::kAdvertisementRefreshInterval / 2);
+  scanner->OnDeviceFound(peripheral);
+  EXPECT_EQ(observer.found_, 1);
+
+  clock.FastForward(FastPairScannerImpl::kAdvertisementRefreshInterval / 2);
+  scanner->OnDeviceFound(peripheral);
+  EXPECT_EQ(observer.found_, 2);
+  scanner->RemoveObserver(&observer);
+  DestroyOnExecutor(std::move(scanner), &executor);
+}
+
+TEST_F(FastPairScannerImplTest, ForwardsForgottenAdvertisementAgain) {
+  Mediums mediums;
+  SingleThreadExecutor executor;
+  auto scanner = std::make_unique<FastPairScannerImpl>(mediums, &executor);
+  CountingObserver observer;
+  scanner->AddObserver(&observer);
+  FakeBlePeripheral fake_peripheral(kTestBleDeviceAddress, kModelId);
+  BlePeripheral peripheral(&fake_peripheral);
+
+  scanner->OnDeviceFound(peripheral);
+  scanner->ForgetAdvertisement(std::string(kTestBleDeviceAddress));
+  scanner->OnDeviceFound(peripheral);
+
+  EXPECT_EQ(observer.found_, 2);
+  EXPECT_EQ(observer.still_present_, 0);
+  scanner->RemoveObserver(&observer);
+  DestroyOnExecutor(std::move(scanner), &executor);
+}
+
+TEST_F(FastPairScannerImplTest, ForwardsAdvertisementAgainAfterDeviceLost) {
+  Mediums mediums;
+  SingleThreadExecutor executor;
+  auto scanner = std::make_unique<FastPairScannerImpl>(mediums, &executor);
+  CountingObserver observer;
+  scanner->AddObserver(&observer);
+  FakeBlePeripheral fake_peripheral(kTestBleDeviceAddress, kModelId);
+  BlePeripheral peripheral(&fake_peripheral);
+
+  scanner->OnDeviceFound(peripheral);
+  scanner->OnDeviceLost(peripheral);
+  scanner->OnDeviceFound(peripheral);
+
+  EXPECT_EQ(observer.found_, 2);
+  EXPECT_EQ(observer.lost_, 1);
+  scanner->RemoveObserver(&observer);
+  DestroyOnExecutor(std::move(scanner), &executor);
+}
+
+TEST_F(FastPairScannerImplTest, NewObserverSeesKnownAdvertisements) {
+  Mediums mediums;
+  SingleThreadExecutor executor;
+  auto scanner = std::make_unique<FastPairScannerImpl>(mediums, &executor);
+  CountingObserver observer;
+  scanner->AddObserver(&observer);
+  FakeBlePeripheral fake_peripheral(kTestBleDeviceAddress, kModelId);
+  BlePeripheral peripheral(&fake_peripheral);
+  scanner->OnDeviceFound(peripheral);
+
+  CountingObserver late_observer;
+  scanner->AddObserver(&late_observer);
+  scanner->OnDeviceFound(peripheral);
+
+  EXPECT_EQ(late_observer.found_, 1);
+  scanner->RemoveObserver(&observer);
+  scanner->RemoveObserver(&late_observer);
+  DestroyOnExecutor(std::move(scanner), &executor);
+}
+
 }  // namespace
 }  // namespace fastpair
 }  // namespace nearby
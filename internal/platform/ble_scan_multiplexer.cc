@@ -0,0 +1,360 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/platform/ble_scan_multiplexer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "internal/platform/logging.h"
+#include "internal/platform/mutex_lock.h"
+
+namespace nearby {
+
+using ::nearby::api::ble_v2::BleAdvertisementData;
+
+namespace {
+// The subscriber whose callback this thread is running, if any. Lets a callback
+// stop its own session without waiting for itself.
+thread_local const void* current_subscriber = nullptr;
+}  // namespace
+
+BleScanMultiplexer& BleScanMultiplexer::GetInstance() {
+  static BleScanMultiplexer* multiplexer = new BleScanMultiplexer();
+  return *multiplexer;
+}
+
+BleScanMultiplexer::~BleScanMultiplexer() {
+  absl::flat_hash_map<ScanKey, PlatformScan> platform_scans;
+  {
+    MutexLock lock(&mutex_);
+    platform_scans = std::move(platform_scans_);
+    platform_scans_.clear();
+  }
+  for (auto& [key, scan] : platform_scans) {
+    if (scan.session == nullptr) continue;
+    absl::Status status = scan.session->stop_scanning();
+    if (!status.ok()) {
+      NEARBY_LOGS(WARNING) << "Failed to stop BLE scan for "
+                           << key.second.Get16BitAsString() << ": " << status;
+    }
+  }
+}
+
+std::unique_ptr<BleScanMultiplexer::ScanningSession>
+BleScanMultiplexer::StartScanning(BleV2Medium& medium,
+                                  const Uuid& service_uuid,
+                                  TxPowerLevel tx_power_level,
+                                  ScanningCallback callback) {
+  ScanKey key = {medium.GetAdapter().GetMacAddress(), service_uuid};
+  std::uint64_t subscriber_id;
+  {
+    MutexLock lock(&mutex_);
+    subscriber_id = next_subscriber_id_++;
+    platform_scans_[key].subscribers.insert(
+        {subscriber_id, std::make_shared<Subscriber>(Subscriber{
+                            .medium = &medium,
+                            .tx_power_level = tx_power_level,
+                            .callback = std::move(callback),
+                        })});
+  }
+  UpdatePlatformScan(key);
+  ReportStartStatus(key);
+  bool failed = false;
+  {
+    MutexLock lock(&mutex_);
+    auto it = platform_scans_.find(key);
+    // If another thread is still starting the scan, its result is reported
+    // through the callback.
+    if (it != platform_scans_.end() && !it->second.updating &&
+        it->second.session == nullptr) {
+      NEARBY_LOGS(WARNING) << "Failed to start BLE scan for "
+                           << service_uuid.Get16BitAsString();
+      auto subscriber_it = it->second.subscribers.find(subscriber_id);
+      if (subscriber_it != it->second.subscribers.end()) {
+        std::shared_ptr<Subscriber> subscriber = subscriber_it->second;
+        it->second.subscribers.erase(subscriber_it);
+        subscriber->unsubscribed = true;
+        WaitForDeliveries(*subscriber);
+      }
+      failed = true;
+    }
+  }
+  if (failed) {
+    UpdatePlatformScan(key);
+    return nullptr;
+  }
+  return std::make_unique<ScanningSession>(ScanningSession{
+      .stop_scanning =
+          [this, key, subscriber_id]() {
+            return StopScanning(key, subscriber_id);
+          },
+  });
+}
+
+int BleScanMultiplexer::GetPlatformScanCount() const {
+  MutexLock lock(&mutex_);
+  return std::count_if(
+      platform_scans_.begin(), platform_scans_.end(),
+      [](const auto& entry) { return entry.second.session != nullptr; });
+}
+
+std::int64_t BleScanMultiplexer::GetPlatformAdvertisementCount() const {
+  MutexLock lock(&mutex_);
+  return platform_advertisement_count_;
+}
+
+absl::Status BleScanMultiplexer::StopScanning(const ScanKey& key,
+                                              std::uint64_t subscriber_id) {
+  std::shared_ptr<Subscriber> subscriber;
+  {
+    MutexLock lock(&mutex_);
+    auto it = platform_scans_.find(key);
+    if (it == platform_scans_.end()) {
+      return absl::NotFoundError("Scanning session is already stopped");
+    }
+    auto subscriber_it = it->second.subscribers.find(subscriber_id);
+    if (subscriber_it == it->second.subscribers.end()) {
+      return absl::NotFoundError("Scanning session is already stopped");
+    }
+    subscriber = subscriber_it->second;
+    it->second.subscribers.erase(subscriber_it);
+    subscriber->unsubscribed = true;
+  }
+  UpdatePlatformScan(key);
+  // The caller may free what its callbacks use once this returns.
+  MutexLock lock(&mutex_);
+  WaitForDeliveries(*subscriber);
+  return absl::OkStatus();
+}
+
+void BleScanMultiplexer::WaitForDeliveries(const Subscriber& subscriber) {
+  int own_deliveries = current_subscriber == &subscriber ? 1 : 0;
+  while (subscriber.deliveries_in_flight > own_deliveries) {
+    deliveries_done_.Wait();
+  }
+}
+
+void BleScanMultiplexer::Deliver(Subscriber& subscriber,
+                                 absl::AnyInvocable<void()> deliver) {
+  bool unsubscribed;
+  {
+    MutexLock lock(&mutex_);
+    unsubscribed = subscriber.unsubscribed;
+  }
+  if (!unsubscribed) {
+    const void* outer_subscriber = current_subscriber;
+    current_subscriber = &subscriber;
+    deliver();
+    current_subscriber = outer_subscriber;
+  }
+  MutexLock lock(&mutex_);
+  if (--subscriber.deliveries_in_flight == 0) {
+    deliveries_done_.Notify();
+  }
+}
+
+void BleScanMultiplexer::UpdatePlatformScan(const ScanKey& key) {
+  const Uuid& service_uuid = key.second;
+  bool done = false;
+  while (!done) {
+    std::unique_ptr<ScanningSession> old_session;
+    BleV2Medium* medium = nullptr;
+    TxPowerLevel tx_power_level = TxPowerLevel::kUnknown;
+    std::uint64_t generation = 0;
+    int subscriber_count = 0;
+    {
+      MutexLock lock(&mutex_);
+      auto it = platform_scans_.find(key);
+      if (it == platform_scans_.end()) return;
+      PlatformScan& scan = it->second;
+      if (scan.updating) {
+        scan.needs_update = true;
+        return;
+      }
+      if (scan.subscribers.empty()) {
+        if (scan.session == nullptr) {
+          platform_scans_.erase(it);
+          return;
+        }
+        old_session = std::move(scan.session);
+      } else {
+        // Keep scanning on the current medium while one of its subscribers is
+        // left, since its owner may destroy it once they are all gone.
+        for (const auto& [id, subscriber] : scan.subscribers) {
+          tx_power_level = std::max(tx_power_level, subscriber->tx_power_level);
+          if (medium == nullptr || subscriber->medium == scan.medium) {
+            medium = subscriber->medium;
+          }
+        }
+        if (scan.session != nullptr && tx_power_level == scan.tx_power_level &&
+            medium == scan.medium) {
+          return;
+        }
+        old_session = std::move(scan.session);
+        scan.medium = medium;
+        scan.tx_power_level = tx_power_level;
+        scan.start_status.reset();
+        generation = ++scan.generation;
+        subscriber_count = scan.subscribers.size();
+      }
+      scan.updating = true;
+      scan.needs_update = false;
+    }
+
+    // Platform calls are made without `mutex_` held, since platforms may block
+    // or call back synchronously. Most platforms can't run two scans with the
+    // same filter, so the old scan has to stop before the new one starts.
+    if (old_session != nullptr) {
+      absl::Status status = old_session->stop_scanning();
+      if (!status.ok()) {
+        NEARBY_LOGS(WARNING) << "Failed to stop BLE scan for "
+                             << service_uuid.Get16BitAsString() << ": "
+                             << status;
+      }
+    }
+    std::unique_ptr<ScanningSession> session;
+    if (medium != nullptr) {
+      NEARBY_LOGS(INFO) << "Starting BLE scan for "
+                        << service_uuid.Get16BitAsString() << " with "
+                        << subscriber_count
+                        << " subscribers, tx_power_level="
+                        << static_cast<int>(tx_power_level);
+      session = medium->StartScanning(
+          service_uuid, tx_power_level,
+          ScanningCallback{
+              .start_scanning_result =
+                  [this, key, generation](absl::Status status) {
+                    OnStartScanningResult(key, generation, status);
+                  },
+              .advertisement_found_cb =
+                  [this, key, generation](
+                      api::ble_v2::BlePeripheral& peripheral,
+                      BleAdvertisementData advertisement) {
+                    OnAdvertisementFound(key, generation, peripheral,
+                                         std::move(advertisement));
+                  },
+          });
+    }
+
+    {
+      MutexLock lock(&mutex_);
+      // The entry is not erased while `updating` is set.
+      PlatformScan& scan = platform_scans_[key];
+      scan.updating = false;
+      if (medium != nullptr) {
+        if (session != nullptr) {
+          scan.session = std::move(session);
+        } else if (!scan.start_status.has_value()) {
+          scan.start_status = absl::InternalError("Failed to start scan");
+        }
+      }
+      // After only stopping, loop once more to erase the entry. A failed start
+      // is not retried unless the subscribers changed.
+      done = medium != nullptr && !scan.needs_update;
+    }
+  }
+  ReportStartStatus(key);
+}
+
+void BleScanMultiplexer::ReportStartStatus(const ScanKey& key) {
+  std::vector<std::shared_ptr<Subscriber>> subscribers;
+  absl::Status status;
+  {
+    MutexLock lock(&mutex_);
+    auto it = platform_scans_.find(key);
+    if (it == platform_scans_.end() || !it->second.start_status.has_value()) {
+      return;
+    }
+    status = *it->second.start_status;
+    for (auto& [id, subscriber] : it->second.subscribers) {
+      if (subscriber->start_reported) continue;
+      subscriber->start_reported = true;
+      ++subscriber->deliveries_in_flight;
+      subscribers.push_back(subscriber);
+    }
+  }
+  for (auto& subscriber : subscribers) {
+    Deliver(*subscriber,
+            [&]() { subscriber->callback.start_scanning_result(status); });
+  }
+}
+
+void BleScanMultiplexer::OnStartScanningResult(const ScanKey& key,
+                                               std::uint64_t generation,
+                                               absl::Status status) {
+  {
+    MutexLock lock(&mutex_);
+    auto it = platform_scans_.find(key);
+    if (it == platform_scans_.end() || it->second.generation != generation) {
+      return;
+    }
+    it->second.start_status = status;
+  }
+  ReportStartStatus(key);
+}
+
+void BleScanMultiplexer::OnAdvertisementFound(
+    const ScanKey& key, std::uint64_t generation,
+    api::ble_v2::BlePeripheral& peripheral,
+    BleAdvertisementData advertisement) {
+  std::vector<std::shared_ptr<Subscriber>> subscribers;
+  BleV2Medium* scan_medium;
+  {
+    MutexLock lock(&mutex_);
+    auto it = platform_scans_.find(key);
+    if (it == platform_scans_.end() || it->second.generation != generation) {
+      return;
+    }
+    ++platform_advertisement_count_;
+    scan_medium = it->second.medium;
+    subscribers.reserve(it->second.subscribers.size());
+    for (const auto& [id, subscriber] : it->second.subscribers) {
+      ++subscriber->deliveries_in_flight;
+      subscribers.push_back(subscriber);
+    }
+  }
+  // Callbacks run without the lock, so that they can stop their own session.
+  for (size_t i = 0; i < subscribers.size(); ++i) {
+    Subscriber& subscriber = *subscribers[i];
+    BleAdvertisementData data = i + 1 == subscribers.size()
+                                    ? std::move(advertisement)
+                                    : advertisement;
+    Deliver(subscriber, [&]() {
+      if (subscriber.medium == scan_medium) {
+        subscriber.callback.advertisement_found_cb(peripheral,
+                                                   std::move(data));
+        return;
+      }
+      // Peripherals belong to the medium that found them; look this one up on
+      // the subscriber's medium so it can be used there, e.g. to connect.
+      if (!subscriber.medium->GetImpl()->GetRemotePeripheral(
+              peripheral.GetAddress(),
+              [&](api::ble_v2::BlePeripheral& own_peripheral) {
+                subscriber.callback.advertisement_found_cb(own_peripheral,
+                                                           std::move(data));
+              })) {
+        NEARBY_LOGS(WARNING)
+            << "Dropping advertisement from unknown peripheral "
+            << peripheral.GetAddress();
+      }
+    });
+  }
+}
+
+}  // namespace nearby
@@ -0,0 +1,160 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PLATFORM_PUBLIC_BLE_SCAN_MULTIPLEXER_H_
+#define PLATFORM_PUBLIC_BLE_SCAN_MULTIPLEXER_H_
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/status/status.h"
+#include "internal/platform/ble_v2.h"
+#include "internal/platform/condition_variable.h"
+#include "internal/platform/implementation/ble_v2.h"
+#include "internal/platform/mutex.h"
+#include "internal/platform/uuid.h"
+
+namespace nearby {
+
+// Shares platform BLE scans between clients in the process.
+//
+// Scan requests for the same service UUID on the same Bluetooth adapter are
+// merged into a single platform scan, running at the highest TX power level any
+// subscriber asked for, even if the subscribers use different `BleV2Medium`s.
+// Every advertisement the platform reports is delivered once to the multiplexer
+// and then fanned out to the subscribers of that service UUID. Subscribers on a
+// different medium than the one running the scan get the peripheral as known to
+// their own medium. The platform scan is restarted when the required power
+// level changes or its medium's last subscriber leaves, and stopped when the
+// last subscriber leaves.
+//
+// Platform calls and subscriber callbacks are made without holding the
+// multiplexer's lock. Stopping a session waits for its callbacks that are
+// already running, so none run once `stop_scanning` has returned.
+class BleScanMultiplexer {
+ public:
+  using TxPowerLevel = api::ble_v2::TxPowerLevel;
+  using ScanningSession = api::ble_v2::BleMedium::ScanningSession;
+  using ScanningCallback = api::ble_v2::BleMedium::ScanningCallback;
+
+  // Returns the process-wide multiplexer.
+  static BleScanMultiplexer& GetInstance();
+
+  // Only tests should create their own multiplexer; it must outlive the
+  // sessions it returns.
+  BleScanMultiplexer() = default;
+  ~BleScanMultiplexer();
+
+  BleScanMultiplexer(const BleScanMultiplexer&) = delete;
+  BleScanMultiplexer& operator=(const BleScanMultiplexer&) = delete;
+
+  // Subscribes to advertisements with `service_uuid` in their service data,
+  // seen by the adapter of `medium`. Has the same contract as
+  // `BleV2Medium::StartScanning`: returns nullptr if the platform scan could
+  // not be started, otherwise the caller should use the returned
+  // `ScanningSession` to unsubscribe. `medium` must outlive the session.
+  std::unique_ptr<ScanningSession> StartScanning(BleV2Medium& medium,
+                                                 const Uuid& service_uuid,
+                                                 TxPowerLevel tx_power_level,
+                                                 ScanningCallback callback)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Returns the number of platform scans currently running.
+  int GetPlatformScanCount() const ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Returns the number of advertisements reported by the platform so far.
+  std::int64_t GetPlatformAdvertisementCount() const
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  // Adapter MAC address and service UUID.
+  using ScanKey = std::pair<std::string, Uuid>;
+
+  struct Subscriber {
+    BleV2Medium* medium;
+    TxPowerLevel tx_power_level;
+    ScanningCallback callback;
+    // True once `callback.start_scanning_result` has been called.
+    bool start_reported = false;
+    // The fields below are guarded by `mutex_`.
+    // Callbacks handed to this subscriber that haven't returned yet.
+    int deliveries_in_flight = 0;
+    // True once the subscriber's session has stopped; pending deliveries are
+    // dropped.
+    bool unsubscribed = false;
+  };
+
+  struct PlatformScan {
+    std::unique_ptr<ScanningSession> session;
+    // Medium the platform scan runs on.
+    BleV2Medium* medium = nullptr;
+    TxPowerLevel tx_power_level = TxPowerLevel::kUnknown;
+    // Incremented every time the platform scan is (re)started, so that late
+    // callbacks from a replaced session are ignored.
+    std::uint64_t generation = 0;
+    // Result of starting the current platform session, once known.
+    std::optional<absl::Status> start_status;
+    // True while a thread is stopping or starting the platform scan. Only that
+    // thread touches the platform scan; others set `needs_update` instead.
+    bool updating = false;
+    bool needs_update = false;
+    absl::flat_hash_map<std::uint64_t, std::shared_ptr<Subscriber>> subscribers;
+  };
+
+  absl::Status StopScanning(const ScanKey& key, std::uint64_t subscriber_id)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Waits until no callback of `subscriber`, other than one this thread is
+  // running, is in progress.
+  void WaitForDeliveries(const Subscriber& subscriber)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Runs `deliver` unless `subscriber` has unsubscribed, then ends the delivery
+  // counted in `subscriber.deliveries_in_flight`.
+  void Deliver(Subscriber& subscriber, absl::AnyInvocable<void()> deliver)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Starts, restarts or stops the platform scan for `key` until it matches the
+  // current subscribers. Returns immediately if another thread is already
+  // updating it; that thread picks up the change.
+  void UpdatePlatformScan(const ScanKey& key) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Reports the platform start result to subscribers that haven't seen it.
+  void ReportStartStatus(const ScanKey& key) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  void OnStartScanningResult(const ScanKey& key, std::uint64_t generation,
+                             absl::Status status) ABSL_LOCKS_EXCLUDED(mutex_);
+  void OnAdvertisementFound(const ScanKey& key, std::uint64_t generation,
+                            api::ble_v2::BlePeripheral& peripheral,
+                            api::ble_v2::BleAdvertisementData advertisement)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  mutable Mutex mutex_;
+  // Notified when a subscriber's last in-flight delivery ends.
+  ConditionVariable deliveries_done_{&mutex_};
+  absl::flat_hash_map<ScanKey, PlatformScan> platform_scans_
+      ABSL_GUARDED_BY(mutex_);
+  std::uint64_t next_subscriber_id_ ABSL_GUARDED_BY(mutex_) = 0;
+  std::int64_t platform_advertisement_count_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace nearby
+
+#endif  // PLATFORM_PUBLIC_BLE_SCAN_MULTIPLEXER_H_
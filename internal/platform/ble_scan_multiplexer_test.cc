@@ -0,0 +1,397 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/platform/ble_scan_multiplexer.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "protobuf-matchers/protocol-buffer-matchers.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/time/time.h"
+#include "internal/platform/ble_v2.h"
+#include "internal/platform/bluetooth_adapter.h"
+#include "internal/platform/count_down_latch.h"
+#include "internal/platform/implementation/ble_v2.h"
+#include "internal/platform/medium_environment.h"
+#include "internal/platform/mutex.h"
+#include "internal/platform/mutex_lock.h"
+#include "internal/platform/single_thread_executor.h"
+#include "internal/platform/uuid.h"
+
+namespace nearby {
+namespace {
+
+using ::nearby::api::ble_v2::BleAdvertisementData;
+using ::nearby::api::ble_v2::BleMedium;
+using ::nearby::api::ble_v2::BlePeripheral;
+using ::nearby::api::ble_v2::TxPowerLevel;
+using ::testing::status::StatusIs;
+
+constexpr absl::Duration kWaitDuration = absl::Milliseconds(1000);
+constexpr absl::string_view kAdvertisementString = "\x0a\x0b\x0c\x0d";
+constexpr int kSubscriberCount = 3;
+
+class BleScanMultiplexerTest : public ::testing::Test {
+ protected:
+  void SetUp() override { env_.Start(); }
+  void TearDown() override { env_.Stop(); }
+
+  BleMedium::ScanningCallback CountingCallback(CountDownLatch& found_latch,
+                                               std::atomic<int>& found_count) {
+    return BleMedium::ScanningCallback{
+        .advertisement_found_cb =
+            [&](BlePeripheral& peripheral, BleAdvertisementData data) {
+              found_count++;
+              found_latch.CountDown();
+            },
+    };
+  }
+
+  void StartAdvertising(BleV2Medium& medium, const Uuid& service_uuid) {
+    BleAdvertisementData advertising_data;
+    advertising_data.is_extended_advertisement = false;
+    advertising_data.service_data = {
+        {service_uuid, ByteArray(std::string(kAdvertisementString))}};
+    EXPECT_TRUE(medium.StartAdvertising(
+        advertising_data,
+        {.tx_power_level = TxPowerLevel::kHigh, .is_connectable = true}));
+  }
+
+  MediumEnvironment& env_{MediumEnvironment::Instance()};
+};
+
+TEST_F(BleScanMultiplexerTest, SharesOnePlatformScanBetweenSubscribers) {
+  BluetoothAdapter adapter_a;
+  BluetoothAdapter adapter_b;
+  BleV2Medium ble_a(adapter_a);
+  BleV2Medium ble_b(adapter_b);
+  BleScanMultiplexer multiplexer;
+  Uuid service_uuid(1234, 5678);
+  CountDownLatch found_latch(kSubscriberCount);
+  std::atomic<int> found_count = 0;
+
+  std::vector<std::unique_ptr<BleMedium::ScanningSession>> sessions;
+  for (int i = 0; i < kSubscriberCount; ++i) {
+    sessions.push_back(multiplexer.StartScanning(
+        ble_a, service_uuid, TxPowerLevel::kHigh,
+        CountingCallback(found_latch, found_count)));
+    ASSERT_NE(sessions.back(), nullptr);
+  }
+  StartAdvertising(ble_b, service_uuid);
+
+  EXPECT_TRUE(found_latch.Await(kWaitDuration).result());
+  EXPECT_EQ(found_count, kSubscriberCount);
+  // Every subscriber saw the advertisement, but the platform ran one scan and
+  // reported it once.
+  EXPECT_EQ(multiplexer.GetPlatformScanCount(), 1);
+  EXPECT_EQ(multiplexer.GetPlatformAdvertisementCount(), 1);
+  for (auto& session : sessions) {
+    EXPECT_OK(session->stop_scanning());
+  }
+  EXPECT_TRUE(ble_b.StopAdvertising());
+}
+
+TEST_F(BleScanMultiplexerTest, IndependentScansReportEachAdvertisementPerScan) {
+  BluetoothAdapter adapter_a;
+  BluetoothAdapter adapter_b;
+  BleV2Medium ble_a(adapter_a);
+  BleV2Medium ble_b(adapter_b);
+  Uuid service_uuid(1234, 5678);
+  CountDownLatch found_latch(kSubscriberCount);
+  std::atomic<int> found_count = 0;
+
+  // Baseline without the multiplexer: one platform scan and one platform
+  // callback per client.
+  std::vector<std::unique_ptr<BleMedium::ScanningSession>> sessions;
+  for (int i = 0; i < kSubscriberCount; ++i) {
+    sessions.push_back(ble_a.StartScanning(
+        service_uuid, TxPowerLevel::kHigh,
+        CountingCallback(found_latch, found_count)));
+  }
+  StartAdvertising(ble_b, service_uuid);
+
+  EXPECT_TRUE(found_latch.Await(kWaitDuration).result());
+  EXPECT_EQ(found_count, kSubscriberCount);
+  for (auto& session : sessions) {
+    EXPECT_OK(session->stop_scanning());
+  }
+  EXPECT_TRUE(ble_b.StopAdvertising());
+}
+
+TEST_F(BleScanMultiplexerTest, StartsOnePlatformScanPerServiceUuid) {
+  BluetoothAdapter adapter_a;
+  BluetoothAdapter adapter_b;
+  BleV2Medium ble_a(adapter_a);
+  BleV2Medium ble_b(adapter_b);
+  BleScanMultiplexer multiplexer;
+  Uuid service_uuid_1(1234, 5678);
+  Uuid service_uuid_2(4321, 8765);
+  CountDownLatch found_latch_1(1);
+  CountDownLatch found_latch_2(1);
+  std::atomic<int> found_count_1 = 0;
+  std::atomic<int> found_count_2 = 0;
+
+  auto session_1 = multiplexer.StartScanning(
+      ble_a, service_uuid_1, TxPowerLevel::kLow,
+      CountingCallback(found_latch_1, found_count_1));
+  auto session_2 = multiplexer.StartScanning(
+      ble_a, service_uuid_2, TxPowerLevel::kLow,
+      CountingCallback(found_latch_2, found_count_2));
+  StartAdvertising(ble_b, service_uuid_2);
+
+  EXPECT_EQ(multiplexer.GetPlatformScanCount(), 2);
+  EXPECT_TRUE(found_latch_2.Await(kWaitDuration).result());
+  EXPECT_FALSE(found_latch_1.Await(absl::Milliseconds(100)).result());
+  EXPECT_EQ(found_count_1, 0);
+  EXPECT_OK(session_1->stop_scanning());
+  EXPECT_OK(session_2->stop_scanning());
+  EXPECT_TRUE(ble_b.StopAdvertising());
+}
+
+TEST_F(BleScanMultiplexerTest, StopsPlatformScanWithLastSubscriber) {
+  BluetoothAdapter adapter;
+  BleV2Medium ble(adapter);
+  BleScanMultiplexer multiplexer;
+  Uuid service_uuid(1234, 5678);
+
+  auto session_1 = multiplexer.StartScanning(
+      ble, service_uuid, TxPowerLevel::kLow, BleMedium::ScanningCallback{});
+  auto session_2 = multiplexer.StartScanning(
+      ble, service_uuid, TxPowerLevel::kLow, BleMedium::ScanningCallback{});
+  EXPECT_TRUE(env_.GetBleV2MediumStatus(*ble.GetImpl()).value().is_scanning);
+
+  EXPECT_OK(session_1->stop_scanning());
+  EXPECT_EQ(multiplexer.GetPlatformScanCount(), 1);
+  EXPECT_TRUE(env_.GetBleV2MediumStatus(*ble.GetImpl()).value().is_scanning);
+
+  EXPECT_OK(session_2->stop_scanning());
+  EXPECT_EQ(multiplexer.GetPlatformScanCount(), 0);
+  EXPECT_FALSE(env_.GetBleV2MediumStatus(*ble.GetImpl()).value().is_scanning);
+}
+
+TEST_F(BleScanMultiplexerTest, StopTwiceFails) {
+  BluetoothAdapter adapter;
+  BleV2Medium ble(adapter);
+  BleScanMultiplexer multiplexer;
+
+  auto session = multiplexer.StartScanning(ble, Uuid(1234, 5678),
+                                           TxPowerLevel::kLow,
+                                           BleMedium::ScanningCallback{});
+
+  EXPECT_OK(session->stop_scanning());
+  EXPECT_THAT(session->stop_scanning(),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+TEST_F(BleScanMultiplexerTest, StopWaitsForCallbackInProgress) {
+  BluetoothAdapter adapter_a;
+  BluetoothAdapter adapter_b;
+  BleV2Medium ble_a(adapter_a);
+  BleV2Medium ble_b(adapter_b);
+  BleScanMultiplexer multiplexer;
+  Uuid service_uuid(1234, 5678);
+  CountDownLatch callback_entered(1);
+  CountDownLatch callback_released(1);
+  std::atomic<bool> callback_done = false;
+
+  auto session = multiplexer.StartScanning(
+      ble_a, service_uuid, TxPowerLevel::kHigh,
+      BleMedium::ScanningCallback{
+          .advertisement_found_cb =
+              [&](BlePeripheral& peripheral, BleAdvertisementData data) {
+                if (callback_done) return;
+                callback_entered.CountDown();
+                callback_released.Await();
+                callback_done = true;
+              },
+      });
+  ASSERT_NE(session, nullptr);
+  StartAdvertising(ble_b, service_uuid);
+  ASSERT_TRUE(callback_entered.Await(kWaitDuration).result());
+
+  CountDownLatch stopped(1);
+  SingleThreadExecutor executor;
+  executor.Execute([&]() {
+    EXPECT_OK(session->stop_scanning());
+    // The callback must have returned before stop_scanning() does.
+    EXPECT_TRUE(callback_done);
+    stopped.CountDown();
+  });
+  EXPECT_FALSE(stopped.Await(absl::Milliseconds(100)).result());
+  callback_released.CountDown();
+
+  EXPECT_TRUE(stopped.Await(kWaitDuration).result());
+  EXPECT_TRUE(ble_b.StopAdvertising());
+}
+
+TEST_F(BleScanMultiplexerTest, CallbackCanStopItsOwnSession) {
+  BluetoothAdapter adapter_a;
+  BluetoothAdapter adapter_b;
+  BleV2Medium ble_a(adapter_a);
+  BleV2Medium ble_b(adapter_b);
+  BleScanMultiplexer multiplexer;
+  Uuid service_uuid(1234, 5678);
+  CountDownLatch stopped(1);
+  std::unique_ptr<BleMedium::ScanningSession> session;
+  Mutex session_mutex;
+
+  {
+    MutexLock lock(&session_mutex);
+    session = multiplexer.StartScanning(
+        ble_a, service_uuid, TxPowerLevel::kHigh,
+        BleMedium::ScanningCallback{
+            .advertisement_found_cb =
+                [&](BlePeripheral& peripheral, BleAdvertisementData data) {
+                  MutexLock callback_lock(&session_mutex);
+                  if (session == nullptr) return;
+                  EXPECT_OK(session->stop_scanning());
+                  session.reset();
+                  stopped.CountDown();
+                },
+        });
+    ASSERT_NE(session, nullptr);
+  }
+  StartAdvertising(ble_b, service_uuid);
+
+  EXPECT_TRUE(stopped.Await(kWaitDuration).result());
+  EXPECT_EQ(multiplexer.GetPlatformScanCount(), 0);
+  EXPECT_TRUE(ble_b.StopAdvertising());
+}
+
+TEST_F(BleScanMultiplexerTest, ReportsStartResultToEverySubscriber) {
+  BluetoothAdapter adapter;
+  BleV2Medium ble(adapter);
+  BleScanMultiplexer multiplexer;
+  Uuid service_uuid(1234, 5678);
+  CountDownLatch started_latch_1(1);
+  CountDownLatch started_latch_2(1);
+
+  auto session_1 = multiplexer.StartScanning(
+      ble, service_uuid, TxPowerLevel::kLow,
+      BleMedium::ScanningCallback{.start_scanning_result =
+                                      [&](absl::Status status) {
+                                        EXPECT_OK(status);
+                                        started_latch_1.CountDown();
+                                      }});
+  EXPECT_TRUE(started_latch_1.Await(kWaitDuration).result());
+  auto session_2 = multiplexer.StartScanning(
+      ble, service_uuid, TxPowerLevel::kLow,
+      BleMedium::ScanningCallback{.start_scanning_result =
+                                      [&](absl::Status status) {
+                                        EXPECT_OK(status);
+                                        started_latch_2.CountDown();
+                                      }});
+
+  EXPECT_TRUE(started_latch_2.Await(kWaitDuration).result());
+  EXPECT_OK(session_1->stop_scanning());
+  EXPECT_OK(session_2->stop_scanning());
+}
+
+TEST_F(BleScanMultiplexerTest, KeepsDeliveringAfterPowerLevelChange) {
+  BluetoothAdapter adapter_a;
+  BluetoothAdapter adapter_b;
+  BleV2Medium ble_a(adapter_a);
+  BleV2Medium ble_b(adapter_b);
+  BleScanMultiplexer multiplexer;
+  Uuid service_uuid(1234, 5678);
+  CountDownLatch found_latch(2);
+  std::atomic<int> found_count = 0;
+
+  auto low_power_session =
+      multiplexer.StartScanning(ble_a, service_uuid, TxPowerLevel::kLow,
+                                CountingCallback(found_latch, found_count));
+  // Restarts the platform scan at the higher power level.
+  auto high_power_session =
+      multiplexer.StartScanning(ble_a, service_uuid, TxPowerLevel::kHigh,
+                                CountingCallback(found_latch, found_count));
+  StartAdvertising(ble_b, service_uuid);
+
+  EXPECT_EQ(multiplexer.GetPlatformScanCount(), 1);
+  EXPECT_TRUE(found_latch.Await(kWaitDuration).result());
+  EXPECT_OK(low_power_session->stop_scanning());
+  EXPECT_OK(high_power_session->stop_scanning());
+  EXPECT_TRUE(ble_b.StopAdvertising());
+}
+
+TEST_F(BleScanMultiplexerTest, SharesPlatformScanBetweenMediumsOnOneAdapter) {
+  BluetoothAdapter adapter_a;
+  BluetoothAdapter adapter_b;
+  BleV2Medium ble_a_1(adapter_a);
+  BleV2Medium ble_a_2(adapter_a);
+  BleV2Medium ble_b(adapter_b);
+  BleScanMultiplexer multiplexer;
+  Uuid service_uuid(1234, 5678);
+  CountDownLatch found_latch(2);
+  std::atomic<int> found_count = 0;
+
+  auto session_1 =
+      multiplexer.StartScanning(ble_a_1, service_uuid, TxPowerLevel::kLow,
+                                CountingCallback(found_latch, found_count));
+  auto session_2 =
+      multiplexer.StartScanning(ble_a_2, service_uuid, TxPowerLevel::kLow,
+                                CountingCallback(found_latch, found_count));
+  StartAdvertising(ble_b, service_uuid);
+
+  EXPECT_EQ(multiplexer.GetPlatformScanCount(), 1);
+  EXPECT_TRUE(found_latch.Await(kWaitDuration).result());
+  EXPECT_EQ(found_count, 2);
+  EXPECT_OK(session_1->stop_scanning());
+  EXPECT_OK(session_2->stop_scanning());
+  EXPECT_TRUE(ble_b.StopAdvertising());
+}
+
+TEST_F(BleScanMultiplexerTest, MovesPlatformScanWhenItsMediumLeaves) {
+  BluetoothAdapter adapter_a;
+  BluetoothAdapter adapter_b;
+  BleV2Medium ble_a_1(adapter_a);
+  BleV2Medium ble_a_2(adapter_a);
+  BleV2Medium ble_b(adapter_b);
+  BleScanMultiplexer multiplexer;
+  Uuid service_uuid(1234, 5678);
+  CountDownLatch unused_latch(1);
+  std::atomic<int> unused_count = 0;
+  CountDownLatch found_latch(1);
+  std::atomic<int> found_count = 0;
+
+  auto session_1 =
+      multiplexer.StartScanning(ble_a_1, service_uuid, TxPowerLevel::kLow,
+                                CountingCallback(unused_latch, unused_count));
+  auto session_2 =
+      multiplexer.StartScanning(ble_a_2, service_uuid, TxPowerLevel::kLow,
+                                CountingCallback(found_latch, found_count));
+  EXPECT_OK(session_1->stop_scanning());
+  StartAdvertising(ble_b, service_uuid);
+
+  EXPECT_EQ(multiplexer.GetPlatformScanCount(), 1);
+  EXPECT_FALSE(
+      env_.GetBleV2MediumStatus(*ble_a_1.GetImpl()).value().is_scanning);
+  EXPECT_TRUE(
+      env_.GetBleV2MediumStatus(*ble_a_2.GetImpl()).value().is_scanning);
+  EXPECT_TRUE(found_latch.Await(kWaitDuration).result());
+  EXPECT_OK(session_2->stop_scanning());
+  EXPECT_TRUE(ble_b.StopAdvertising());
+}
+
+TEST_F(BleScanMultiplexerTest, GetInstanceReturnsProcessWideMultiplexer) {
+  EXPECT_EQ(&BleScanMultiplexer::GetInstance(),
+            &BleScanMultiplexer::GetInstance());
+}
+
+}  // namespace
+}  // namespace nearby
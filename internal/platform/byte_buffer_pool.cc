@@ -0,0 +1,263 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/platform/byte_buffer_pool.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace nearby {
+
+namespace {
+
+// Bytes of storage a thread keeps per size class, and the shared free list
+// keeps per size class. Each holds at least one buffer.
+constexpr size_t kThreadCacheBytesPerClass = 256 * 1024;
+constexpr size_t kSharedBytesPerClass = 2 * 1024 * 1024;
+// Storage with a capacity this many times larger than the largest class is
+// freed rather than pooled.
+constexpr size_t kMaxCapacityRatio = 2;
+// Buffers that sat unused in a cache for a whole interval are trimmed: a
+// thread's idle buffers move to the shared free list, and the shared list's
+// idle buffers are freed.
+constexpr absl::Duration kTrimInterval = absl::Seconds(10);
+
+size_t MaxBuffers(size_t budget, size_t class_size) {
+  return std::max<size_t>(1, budget / class_size);
+}
+
+}  // namespace
+
+struct ByteBufferPool::ThreadCache {
+  std::array<std::vector<std::string>, kNumSizeClasses> free_lists;
+  // The fewest buffers each free list held since `last_trim`.
+  std::array<size_t, kNumSizeClasses> low_water = {};
+  absl::Time last_trim = absl::Now();
+};
+
+ByteBufferPool::ThreadCache& ByteBufferPool::GetThreadCache() {
+  thread_local ThreadCache cache;
+  return cache;
+}
+
+PooledByteBuffer& PooledByteBuffer::operator=(PooledByteBuffer&& other) {
+  if (this != &other) {
+    ByteBufferPool::GetInstance().Release(std::move(storage_));
+    storage_ = std::move(other.storage_);
+  }
+  return *this;
+}
+
+PooledByteBuffer::~PooledByteBuffer() {
+  ByteBufferPool::GetInstance().Release(std::move(storage_));
+}
+
+PooledByteArray::~PooledByteArray() {
+  ByteBufferPool::GetInstance().Release(std::move(bytes_));
+}
+
+ByteBufferPool& ByteBufferPool::GetInstance() {
+  // Never destroyed, so buffers released during static destruction are safe.
+  static ByteBufferPool* pool = new ByteBufferPool();
+  return *pool;
+}
+
+int ByteBufferPool::GetSizeClassForSize(size_t size) {
+  for (int i = 0; i < kNumSizeClasses; ++i) {
+    if (size <= kSizeClasses[i]) return i;
+  }
+  return -1;
+}
+
+int ByteBufferPool::GetSizeClassForCapacity(size_t capacity) {
+  if (capacity > kSizeClasses.back() * kMaxCapacityRatio) return -1;
+  for (int i = kNumSizeClasses - 1; i >= 0; --i) {
+    if (capacity >= kSizeClasses[i]) return i;
+  }
+  return -1;
+}
+
+PooledByteBuffer ByteBufferPool::Acquire(size_t size) {
+  int size_class = size > kMinPooledSize ? GetSizeClassForSize(size) : -1;
+  std::string storage;
+  if (size_class >= 0) {
+    ThreadCache& cache = GetThreadCache();
+    std::vector<std::string>& cached = cache.free_lists[size_class];
+    if (!cached.empty()) {
+      storage = std::move(cached.back());
+      cached.pop_back();
+      cache.low_water[size_class] =
+          std::min(cache.low_water[size_class], cached.size());
+    } else {
+      storage = TakeShared(size_class);
+    }
+    if (storage.capacity() >= kSizeClasses[size_class]) {
+      reuses_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      storage.reserve(kSizeClasses[size_class]);
+      allocations_.fetch_add(1, std::memory_order_relaxed);
+    }
+  } else if (size > kMinPooledSize) {
+    allocations_.fetch_add(1, std::memory_order_relaxed);
+  }
+  storage.resize(size);
+  return PooledByteBuffer(std::move(storage));
+}
+
+PooledByteBuffer ByteBufferPool::CopyOf(absl::string_view data) {
+  PooledByteBuffer buffer = Acquire(data.size());
+  if (!data.empty()) {
+    std::memcpy(buffer.data(), data.data(), data.size());
+  }
+  return buffer;
+}
+
+void ByteBufferPool::Release(ByteArray&& bytes) {
+  Release(std::string(std::move(bytes)));
+}
+
+void ByteBufferPool::Release(std::string&& storage) {
+  int size_class = GetSizeClassForCapacity(storage.capacity());
+  if (size_class < 0) return;
+  storage.clear();
+  ThreadCache& cache = GetThreadCache();
+  MaybeTrimThreadCache(cache);
+  std::vector<std::string>& cached = cache.free_lists[size_class];
+  cached.push_back(std::move(storage));
+  recycled_.fetch_add(1, std::memory_order_relaxed);
+  size_t max_cached =
+      MaxBuffers(kThreadCacheBytesPerClass, kSizeClasses[size_class]);
+  if (cached.size() > max_cached) {
+    // Spill half of the cache, so a thread that only releases buffers (e.g. a
+    // writer freeing what a reader allocated) doesn't hit the lock every time.
+    std::vector<std::string> spilled;
+    size_t keep = (max_cached + 1) / 2;
+    std::move(cached.begin() + keep, cached.end(), std::back_inserter(spilled));
+    cached.resize(keep);
+    cache.low_water[size_class] = std::min(cache.low_water[size_class], keep);
+    PutShared(size_class, spilled);
+  }
+}
+
+void ByteBufferPool::MaybeTrimThreadCache(ThreadCache& cache) {
+  absl::Time now = absl::Now();
+  if (now - cache.last_trim < kTrimInterval) return;
+  cache.last_trim = now;
+  for (int i = 0; i < kNumSizeClasses; ++i) {
+    std::vector<std::string>& cached = cache.free_lists[i];
+    // The oldest buffers are at the front.
+    size_t idle = std::min(cache.low_water[i], cached.size());
+    if (idle > 0) {
+      std::vector<std::string> spilled(
+          std::make_move_iterator(cached.begin()),
+          std::make_move_iterator(cached.begin() + idle));
+      cached.erase(cached.begin(), cached.begin() + idle);
+      PutShared(i, spilled);
+    }
+    cache.low_water[i] = cached.size();
+  }
+}
+
+void ByteBufferPool::Trim() {
+  ThreadCache& cache = GetThreadCache();
+  std::int64_t trimmed = 0;
+  for (int i = 0; i < kNumSizeClasses; ++i) {
+    trimmed += cache.free_lists[i].size();
+    cache.free_lists[i] = {};
+    cache.low_water[i] = 0;
+  }
+  std::array<std::vector<std::string>, kNumSizeClasses> free_lists;
+  {
+    absl::MutexLock lock(&mutex_);
+    for (int i = 0; i < kNumSizeClasses; ++i) {
+      trimmed += free_lists_[i].size();
+      free_lists[i] = std::move(free_lists_[i]);
+      free_lists_[i] = {};
+      shared_low_water_[i] = 0;
+    }
+  }
+  trimmed_.fetch_add(trimmed, std::memory_order_relaxed);
+}
+
+ByteBufferPool::Stats ByteBufferPool::GetStats() const {
+  return Stats{
+      .allocations = allocations_.load(std::memory_order_relaxed),
+      .reuses = reuses_.load(std::memory_order_relaxed),
+      .recycled = recycled_.load(std::memory_order_relaxed),
+      .trimmed = trimmed_.load(std::memory_order_relaxed),
+  };
+}
+
+std::string ByteBufferPool::TakeShared(int size_class) {
+  std::vector<std::string> idle;
+  std::string storage;
+  {
+    absl::MutexLock lock(&mutex_);
+    idle = MaybeTrimSharedLocked();
+    std::vector<std::string>& free_list = free_lists_[size_class];
+    if (!free_list.empty()) {
+      storage = std::move(free_list.back());
+      free_list.pop_back();
+      shared_low_water_[size_class] =
+          std::min(shared_low_water_[size_class], free_list.size());
+    }
+  }
+  // `idle` is freed here, outside the lock.
+  return storage;
+}
+
+void ByteBufferPool::PutShared(int size_class,
+                               std::vector<std::string>& buffers) {
+  size_t max_buffers =
+      MaxBuffers(kSharedBytesPerClass, kSizeClasses[size_class]);
+  std::vector<std::string> idle;
+  {
+    absl::MutexLock lock(&mutex_);
+    idle = MaybeTrimSharedLocked();
+    std::vector<std::string>& free_list = free_lists_[size_class];
+    for (std::string& storage : buffers) {
+      if (free_list.size() >= max_buffers) break;
+      free_list.push_back(std::move(storage));
+    }
+  }
+  // Buffers over the bound are freed with `buffers` by the caller.
+}
+
+std::vector<std::string> ByteBufferPool::MaybeTrimSharedLocked() {
+  std::vector<std::string> idle;
+  absl::Time now = absl::Now();
+  if (now - last_shared_trim_ < kTrimInterval) return idle;
+  last_shared_trim_ = now;
+  for (int i = 0; i < kNumSizeClasses; ++i) {
+    std::vector<std::string>& free_list = free_lists_[i];
+    size_t count = std::min(shared_low_water_[i], free_list.size());
+    std::move(free_list.begin(), free_list.begin() + count,
+              std::back_inserter(idle));
+    free_list.erase(free_list.begin(), free_list.begin() + count);
+    shared_low_water_[i] = free_list.size();
+  }
+  trimmed_.fetch_add(idle.size(), std::memory_order_relaxed);
+  return idle;
+}
+
+}  // namespace nearby
@@ -0,0 +1,177 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PLATFORM_BASE_BYTE_BUFFER_POOL_H_
+#define PLATFORM_BASE_BYTE_BUFFER_POOL_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "internal/platform/byte_array.h"
+
+namespace nearby {
+
+// A move-only byte buffer backed by storage from `ByteBufferPool`. The storage
+// goes back to the pool when the buffer is destroyed, unless ownership was
+// transferred to a `ByteArray` or `std::string` first.
+class PooledByteBuffer {
+ public:
+  PooledByteBuffer() = default;
+  PooledByteBuffer(const PooledByteBuffer&) = delete;
+  PooledByteBuffer& operator=(const PooledByteBuffer&) = delete;
+  PooledByteBuffer(PooledByteBuffer&&) = default;
+  PooledByteBuffer& operator=(PooledByteBuffer&& other);
+  ~PooledByteBuffer();
+
+  char* data() { return storage_.data(); }
+  const char* data() const { return storage_.data(); }
+  size_t size() const { return storage_.size(); }
+  bool Empty() const { return storage_.empty(); }
+
+  absl::string_view AsStringView() const { return storage_; }
+
+  // Transfers the storage to a `ByteArray` without copying. Hand the
+  // `ByteArray` back with `ByteBufferPool::Release()`, or hold it in a
+  // `PooledByteArray`, once it is consumed.
+  ByteArray ToByteArray() && { return ByteArray(std::move(storage_)); }
+
+  // Transfers the storage to a `std::string` without copying.
+  std::string ToString() && { return std::move(storage_); }
+
+ private:
+  friend class ByteBufferPool;
+  explicit PooledByteBuffer(std::string storage)
+      : storage_(std::move(storage)) {}
+
+  std::string storage_;
+};
+
+// Owns a `ByteArray` on the frame path and hands its storage back to
+// `ByteBufferPool` when destroyed, e.g. a chunk body once it has been written
+// out or copied into a payload.
+class PooledByteArray {
+ public:
+  explicit PooledByteArray(ByteArray bytes) : bytes_(std::move(bytes)) {}
+  explicit PooledByteArray(std::string&& storage)
+      : bytes_(std::move(storage)) {}
+  PooledByteArray(const PooledByteArray&) = delete;
+  PooledByteArray& operator=(const PooledByteArray&) = delete;
+  ~PooledByteArray();
+
+  ByteArray& get() { return bytes_; }
+  const ByteArray& get() const { return bytes_; }
+
+ private:
+  ByteArray bytes_;
+};
+
+// A process-wide pool of byte buffers for the frame path, where buffers are
+// allocated and freed at a high rate.
+//
+// Storage is kept in size classes. Each thread caches a few buffers per class
+// and spills the rest to a shared, bounded free list, so steady-state traffic
+// on one thread doesn't contend on a lock. Buffers too small or too large to
+// be worth pooling are allocated and freed as usual. Cached buffers that go
+// unused for a while are trimmed, so a burst of traffic doesn't pin its peak
+// memory for the life of the process.
+class ByteBufferPool {
+ public:
+  struct Stats {
+    // Buffers handed out with new storage.
+    std::int64_t allocations = 0;
+    // Buffers handed out with recycled storage.
+    std::int64_t reuses = 0;
+    // Released buffers kept for reuse.
+    std::int64_t recycled = 0;
+    // Cached buffers freed because they sat unused.
+    std::int64_t trimmed = 0;
+  };
+
+  // Buffers of this many bytes or fewer are not pooled.
+  static constexpr size_t kMinPooledSize = 256;
+  // Capacity of each size class. Requests are rounded up to the next class.
+  static constexpr std::array<size_t, 6> kSizeClasses = {
+      1024, 4 * 1024, 16 * 1024, 64 * 1024, 256 * 1024, 1024 * 1024};
+
+  static ByteBufferPool& GetInstance();
+
+  ByteBufferPool(const ByteBufferPool&) = delete;
+  ByteBufferPool& operator=(const ByteBufferPool&) = delete;
+
+  // Returns a buffer of `size` bytes with unspecified contents.
+  PooledByteBuffer Acquire(size_t size);
+
+  // Returns a buffer holding a copy of `data`.
+  PooledByteBuffer CopyOf(absl::string_view data);
+
+  // Keeps the storage behind `bytes` for reuse. Call this instead of letting a
+  // large `ByteArray` on the frame path go out of scope.
+  void Release(ByteArray&& bytes);
+  void Release(std::string&& storage);
+
+  // Frees every buffer cached by the shared free lists and by the calling
+  // thread. Other threads' caches are trimmed on their next release.
+  void Trim();
+
+  Stats GetStats() const;
+
+ private:
+  static constexpr int kNumSizeClasses = kSizeClasses.size();
+
+  struct ThreadCache;
+  static ThreadCache& GetThreadCache();
+
+  ByteBufferPool() = default;
+
+  // Returns the smallest class that fits `size` bytes, or -1 if there is none.
+  static int GetSizeClassForSize(size_t size);
+  // Returns the largest class whose buffers fit in `capacity`, or -1.
+  static int GetSizeClassForCapacity(size_t capacity);
+
+  std::string TakeShared(int size_class);
+  void PutShared(int size_class, std::vector<std::string>& buffers);
+  // Moves buffers idle since the last trim out of `cache` into the shared
+  // free lists.
+  void MaybeTrimThreadCache(ThreadCache& cache);
+  // Removes buffers idle since the last trim from the shared free lists and
+  // returns them, to be freed after the lock is released.
+  std::vector<std::string> MaybeTrimSharedLocked()
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  mutable absl::Mutex mutex_;
+  std::array<std::vector<std::string>, kNumSizeClasses> free_lists_
+      ABSL_GUARDED_BY(mutex_);
+  // The fewest buffers each shared free list held since `last_shared_trim_`.
+  std::array<size_t, kNumSizeClasses> shared_low_water_ ABSL_GUARDED_BY(
+      mutex_) = {};
+  absl::Time last_shared_trim_ ABSL_GUARDED_BY(mutex_) = absl::Now();
+  std::atomic<std::int64_t> allocations_ = 0;
+  std::atomic<std::int64_t> reuses_ = 0;
+  std::atomic<std::int64_t> recycled_ = 0;
+  std::atomic<std::int64_t> trimmed_ = 0;
+};
+
+}  // namespace nearby
+
+#endif  // PLATFORM_BASE_BYTE_BUFFER_POOL_H_
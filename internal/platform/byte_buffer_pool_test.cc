@@ -0,0 +1,187 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/platform/byte_buffer_pool.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/strings/string_view.h"
+#include "internal/platform/byte_array.h"
+
+// Counts heap allocations, so that the test can report allocations per MB on
+// the frame path. This is why the test runs in its own binary.
+namespace {
+std::atomic<std::int64_t> g_allocations = 0;
+}  // namespace
+
+void* operator new(std::size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size == 0 ? 1 : size)) return ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace nearby {
+namespace {
+
+constexpr size_t kFrameSize = 32 * 1024;
+constexpr size_t kBytesToTransfer = 16 * 1024 * 1024;
+constexpr int kFrames = kBytesToTransfer / kFrameSize;
+
+TEST(ByteBufferPoolTest, AcquireReturnsRequestedSize) {
+  PooledByteBuffer buffer = ByteBufferPool::GetInstance().Acquire(3000);
+
+  EXPECT_EQ(buffer.size(), 3000);
+  EXPECT_FALSE(buffer.Empty());
+}
+
+TEST(ByteBufferPoolTest, CopyOfCopiesData) {
+  std::string data(2000, 'x');
+
+  PooledByteBuffer buffer = ByteBufferPool::GetInstance().CopyOf(data);
+
+  EXPECT_EQ(buffer.AsStringView(), data);
+}
+
+TEST(ByteBufferPoolTest, ToByteArrayTransfersStorage) {
+  PooledByteBuffer buffer = ByteBufferPool::GetInstance().Acquire(5000);
+  const char* data = buffer.data();
+
+  ByteArray bytes = std::move(buffer).ToByteArray();
+
+  EXPECT_EQ(bytes.size(), 5000);
+  EXPECT_EQ(bytes.data(), data);
+}
+
+TEST(ByteBufferPoolTest, ReusesReleasedStorage) {
+  ByteBufferPool& pool = ByteBufferPool::GetInstance();
+  ByteArray bytes = pool.Acquire(10000).ToByteArray();
+  const char* data = bytes.data();
+  pool.Release(std::move(bytes));
+  ByteBufferPool::Stats before = pool.GetStats();
+
+  PooledByteBuffer buffer = pool.Acquire(9000);
+
+  EXPECT_EQ(buffer.data(), data);
+  EXPECT_EQ(pool.GetStats().reuses, before.reuses + 1);
+  EXPECT_EQ(pool.GetStats().allocations, before.allocations);
+}
+
+TEST(ByteBufferPoolTest, DestroyedBufferReturnsToPool) {
+  ByteBufferPool& pool = ByteBufferPool::GetInstance();
+  const char* data;
+  {
+    PooledByteBuffer buffer = pool.Acquire(60000);
+    data = buffer.data();
+  }
+
+  PooledByteBuffer buffer = pool.Acquire(60000);
+
+  EXPECT_EQ(buffer.data(), data);
+}
+
+TEST(ByteBufferPoolTest, PooledByteArrayReturnsToPool) {
+  ByteBufferPool& pool = ByteBufferPool::GetInstance();
+  const char* data;
+  {
+    PooledByteArray bytes(pool.Acquire(60000).ToByteArray());
+    data = bytes.get().data();
+  }
+
+  PooledByteBuffer buffer = pool.Acquire(60000);
+
+  EXPECT_EQ(buffer.data(), data);
+}
+
+TEST(ByteBufferPoolTest, TrimFreesCachedBuffers) {
+  ByteBufferPool& pool = ByteBufferPool::GetInstance();
+  { PooledByteBuffer buffer = pool.Acquire(60000); }
+  ByteBufferPool::Stats before = pool.GetStats();
+
+  pool.Trim();
+  PooledByteBuffer buffer = pool.Acquire(60000);
+
+  EXPECT_GT(pool.GetStats().trimmed, before.trimmed);
+  EXPECT_EQ(pool.GetStats().reuses, before.reuses);
+  EXPECT_EQ(pool.GetStats().allocations, before.allocations + 1);
+}
+
+TEST(ByteBufferPoolTest, DoesNotPoolSmallBuffers) {
+  ByteBufferPool& pool = ByteBufferPool::GetInstance();
+  ByteBufferPool::Stats before = pool.GetStats();
+
+  pool.Release(ByteArray(std::string(16, 'x')));
+  PooledByteBuffer buffer = pool.Acquire(4);
+
+  EXPECT_EQ(buffer.size(), 4);
+  EXPECT_EQ(pool.GetStats().recycled, before.recycled);
+  EXPECT_EQ(pool.GetStats().reuses, before.reuses);
+}
+
+TEST(ByteBufferPoolTest, SharesStorageBetweenThreads) {
+  ByteBufferPool& pool = ByteBufferPool::GetInstance();
+  // Enough 256 KiB buffers to overflow the releasing thread's cache.
+  std::thread releaser([&pool]() {
+    std::vector<PooledByteBuffer> buffers;
+    for (int i = 0; i < 4; ++i) {
+      buffers.push_back(pool.Acquire(200 * 1024));
+    }
+  });
+  releaser.join();
+  ByteBufferPool::Stats before = pool.GetStats();
+
+  PooledByteBuffer buffer = pool.Acquire(200 * 1024);
+
+  EXPECT_EQ(pool.GetStats().reuses, before.reuses + 1);
+}
+
+TEST(ByteBufferPoolTest, ReducesAllocationsPerMegabyte) {
+  std::string chunk(kFrameSize, 'x');
+
+  // Frame path before pooling: every frame gets fresh storage.
+  std::int64_t start = g_allocations.load();
+  for (int i = 0; i < kFrames; ++i) {
+    ByteArray frame(kFrameSize);
+    std::memcpy(frame.data(), chunk.data(), kFrameSize);
+    ASSERT_EQ(frame.data()[0], 'x');
+  }
+  std::int64_t unpooled = g_allocations.load() - start;
+
+  // With pooling: storage is handed to a ByteArray and released once the frame
+  // is consumed.
+  ByteBufferPool& pool = ByteBufferPool::GetInstance();
+  start = g_allocations.load();
+  for (int i = 0; i < kFrames; ++i) {
+    ByteArray frame = pool.CopyOf(chunk).ToByteArray();
+    ASSERT_EQ(frame.data()[0], 'x');
+    pool.Release(std::move(frame));
+  }
+  std::int64_t pooled = g_allocations.load() - start;
+
+  EXPECT_EQ(unpooled, kFrames);
+  EXPECT_LT(pooled * 10, unpooled);
+}
+
+}  // namespace
+}  // namespace nearby
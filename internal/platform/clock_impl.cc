@@ -18,6 +18,11 @@
 
 namespace nearby {
 
+ClockImpl& ClockImpl::GetInstance() {
+  static ClockImpl* clock = new ClockImpl();
+  return *clock;
+}
+
 absl::Time ClockImpl::Now() const { return absl::Now(); }
 
 }  // namespace nearby
@@ -22,6 +22,9 @@ namespace nearby {
 
 class ClockImpl : public Clock {
  public:
+  // Returns the process-wide real-time clock. Never destroyed.
+  static ClockImpl& GetInstance();
+
   absl::Time Now() const override;
 };
 
@@ -314,6 +314,43 @@ TEST(CredentialStorageImplTest, ReplaceAndGetRemotePublicCredentials) {
       UnorderedPointwise(EqualsProto(), BuildPublicCreds(kAnotherSecretId)));
 }
 
+TEST(CredentialStorageImplTest, GetPublicCredentialsSeesSavesOfAllAccounts) {
+  constexpr absl::string_view kAnotherAccountName = "another_account";
+  constexpr absl::string_view kAnotherSecretId = "another secret id";
+  CredentialStorageImpl credential_storage;
+
+  EXPECT_OK(SaveCredentials(credential_storage, kManagerAppId, kAccountName,
+                            std::vector<LocalCredential>(),
+                            BuildPublicCreds(kSecretId),
+                            PublicCredentialType::kRemotePublicCredential));
+  ASSERT_OK(GetPublicCredentials(
+      credential_storage, IdentityType::IDENTITY_TYPE_UNSPECIFIED,
+      PublicCredentialType::kRemotePublicCredential));
+  EXPECT_OK(SaveCredentials(
+      credential_storage, kManagerAppId, kAnotherAccountName,
+      std::vector<LocalCredential>(), BuildPublicCreds(kSecretId),
+      PublicCredentialType::kRemotePublicCredential));
+  EXPECT_OK(SaveCredentials(
+      credential_storage, kManagerAppId, kAnotherAccountName,
+      std::vector<LocalCredential>(), BuildPublicCreds(kAnotherSecretId),
+      PublicCredentialType::kRemotePublicCredential));
+
+  auto fetched_public_credentials = GetPublicCredentials(
+      credential_storage, IdentityType::IDENTITY_TYPE_UNSPECIFIED,
+      PublicCredentialType::kRemotePublicCredential);
+  ASSERT_OK(fetched_public_credentials);
+  EXPECT_THAT(*fetched_public_credentials,
+              UnorderedPointwise(EqualsProto(), BuildPublicCreds(kSecretId)));
+  fetched_public_credentials = GetPublicCredentials(
+      credential_storage, IdentityType::IDENTITY_TYPE_UNSPECIFIED,
+      PublicCredentialType::kRemotePublicCredential, kManagerAppId,
+      kAnotherAccountName);
+  ASSERT_OK(fetched_public_credentials);
+  EXPECT_THAT(
+      *fetched_public_credentials,
+      UnorderedPointwise(EqualsProto(), BuildPublicCreds(kAnotherSecretId)));
+}
+
 TEST(CredentialStorageImplTest, SavePrivateAndLocalPublicCredentials) {
   std::vector<LocalCredential> private_creds = BuildPrivateCreds(kSecretId);
   std::vector<SharedCredential> public_creds = BuildPublicCreds(kSecretId);
@@ -323,8 +323,6 @@ class BleV2Medium : public api::ble_v2::BleMedium {
       ABSL_GUARDED_BY(mutex_);
   absl::flat_hash_set<std::pair<Uuid, std::uint32_t>>
       scanning_internal_session_ids_ ABSL_GUARDED_BY(mutex_);
-  // TODO(edwinwu): Adds extended advertisement for testing.
-  bool is_support_extended_advertisement_ = false;
 };
 
 }  // namespace g3
@@ -21,7 +21,9 @@
 #include <vector>
 
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
+#include "internal/platform/implementation/shared/credential_store.h"
 #include "internal/platform/logging.h"
 #include "internal/proto/credential.pb.h"
 
@@ -84,15 +86,17 @@ void CredentialStorageImpl::SaveCredentials(
                       << account_name << "], manager app ID:[" << manager_app_id
                       << "]";
     absl::MutexLock lock(&public_mutex_);
-    PublicCredentialKey key = CreatePublicCredentialKey(
-        manager_app_id, account_name, public_credential_type);
-    auto public_result =
-        public_credentials_map_.insert(std::make_pair(key, public_credentials));
-    if (!public_result.second) {
+    PublicCredentialKey key(std::string(manager_app_id),
+                            std::string(account_name), public_credential_type);
+    if (pending_public_credentials_.contains(key) ||
+        !public_credentials_
+             .Find(manager_app_id, account_name, public_credential_type,
+                   IdentityType::IDENTITY_TYPE_UNSPECIFIED)
+             .empty()) {
       NEARBY_LOGS(WARNING)
           << "Credentials already saved in map. Overwriting previous creds!";
-      public_credentials_map_[key] = public_credentials;
     }
+    pending_public_credentials_[key] = public_credentials;
   }
   std::move(callback.credentials_saved_cb)(absl::OkStatus());
 }
@@ -174,27 +178,54 @@ void CredentialStorageImpl::GetPublicCredentials(
     PublicCredentialType public_credential_type,
     GetPublicCredentialsResultCallback callback) {
   NEARBY_LOGS(INFO) << "G3 Get Public Credentials for " << credential_selector;
-  absl::MutexLock lock(&public_mutex_);
-  PublicCredentialKey key = CreatePublicCredentialKey(
-      credential_selector.manager_app_id, credential_selector.account_name,
-      public_credential_type);
-  if (public_credentials_map_.find(key) == public_credentials_map_.end()) {
-    NEARBY_LOGS(WARNING) << "There are no Public Credentials stored for key:"
-                         << std::get<0>(key) << ", " << std::get<1>(key) << ", "
-                         << std::get<2>(key);
-    std::move(callback.credentials_fetched_cb)(absl::NotFoundError(
-        absl::StrFormat("No public credentials for %v", credential_selector)));
-    return;
+  std::vector<SharedCredential> public_credentials;
+  {
+    absl::MutexLock lock(&public_mutex_);
+    absl::Status status = FlushPublicCredentialsLocked();
+    if (!status.ok()) {
+      NEARBY_LOGS(ERROR) << "Failed to update Public Credentials: " << status;
+      std::move(callback.credentials_fetched_cb)(status);
+      return;
+    }
+    // The index only yields credentials of the requested identity type, so
+    // nothing else gets parsed or copied.
+    std::vector<shared::PublicCredentialView> views = public_credentials_.Find(
+        credential_selector.manager_app_id, credential_selector.account_name,
+        public_credential_type, credential_selector.identity_type);
+    public_credentials.reserve(views.size());
+    for (const shared::PublicCredentialView& view : views) {
+      public_credentials.push_back(view.ToCredential());
+    }
   }
-  std::vector<SharedCredential> public_credentials =
-      public_credentials_map_[key];
-  FilterIdentityType(public_credentials, credential_selector.identity_type);
   if (public_credentials.empty()) {
+    NEARBY_LOGS(WARNING) << "There are no Public Credentials stored for "
+                         << credential_selector << ", "
+                         << public_credential_type;
     std::move(callback.credentials_fetched_cb)(absl::NotFoundError(
         absl::StrFormat("No public credentials for %v", credential_selector)));
     return;
   }
-  std::move(callback.credentials_fetched_cb)(public_credentials);
+  std::move(callback.credentials_fetched_cb)(std::move(public_credentials));
+}
+
+absl::Status CredentialStorageImpl::FlushPublicCredentialsLocked() {
+  if (pending_public_credentials_.empty()) {
+    return absl::OkStatus();
+  }
+  shared::PublicCredentialStore::Builder builder;
+  builder.Add(public_credentials_);
+  for (const auto& [key, credentials] : pending_public_credentials_) {
+    const auto& [manager_app_id, account_name, credential_type] = key;
+    builder.Set(manager_app_id, account_name, credential_type, credentials);
+  }
+  absl::StatusOr<shared::PublicCredentialStore> store =
+      shared::PublicCredentialStore::Create(builder.Build());
+  if (!store.ok()) {
+    return store.status();
+  }
+  public_credentials_ = *std::move(store);
+  pending_public_credentials_.clear();
+  return absl::OkStatus();
 }
 
 }  // namespace g3
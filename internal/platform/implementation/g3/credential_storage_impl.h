@@ -21,11 +21,14 @@
 #include <utility>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
 #include "internal/platform/implementation/credential_callbacks.h"
 #include "internal/platform/implementation/credential_storage.h"
+#include "internal/platform/implementation/shared/credential_store.h"
 #include "internal/proto/credential.pb.h"
 
 namespace nearby {
@@ -78,22 +81,27 @@ class CredentialStorageImpl : public api::CredentialStorage {
     return std::make_tuple(std::string(manager_app_id),
                            std::string(account_name));
   }
-  PublicCredentialKey CreatePublicCredentialKey(
-      absl::string_view manager_app_id, absl::string_view account_name,
-      PublicCredentialType credential_type) {
-    return std::make_tuple(std::string(manager_app_id),
-                           std::string(account_name), credential_type);
-  }
   absl::StatusOr<std::vector<LocalCredential>> GetLocalCredentialsLocked(
       const CredentialSelector& credential_selector);
   void SaveLocalCredentialsLocked(
       absl::string_view manager_app_id, absl::string_view account_name,
       const std::vector<LocalCredential>& private_credentials);
+  // Writes the saves held in `pending_public_credentials_` into
+  // `public_credentials_`.
+  absl::Status FlushPublicCredentialsLocked()
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(public_mutex_);
 
   absl::flat_hash_map<LocalCredentialKey, std::vector<LocalCredential>>
       private_credentials_map_;
+  // Public credentials are looked up for every scan session, so they are
+  // kept in the compact format instead of as protos.
+  shared::PublicCredentialStore public_credentials_
+      ABSL_GUARDED_BY(public_mutex_);
+  // Saves that are not in `public_credentials_` yet. Rewriting the store costs
+  // as much as all credentials in it, so it happens once on the next lookup
+  // rather than on every save.
   absl::flat_hash_map<PublicCredentialKey, std::vector<SharedCredential>>
-      public_credentials_map_;
+      pending_public_credentials_ ABSL_GUARDED_BY(public_mutex_);
   absl::Mutex private_mutex_;
   absl::Mutex public_mutex_;
 };
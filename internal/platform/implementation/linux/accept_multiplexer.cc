@@ -0,0 +1,333 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/platform/implementation/linux/accept_multiplexer.h"
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "internal/platform/exception.h"
+#include "internal/platform/logging.h"
+
+namespace nearby {
+namespace linux {
+namespace {
+
+constexpr int kMaxEvents = 16;
+
+bool SetNonBlocking(int fd, bool non_blocking) {
+  int flags = fcntl(fd, F_GETFL);
+  if (flags < 0) return false;
+  flags = non_blocking ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+  return fcntl(fd, F_SETFL, flags) == 0;
+}
+
+}  // namespace
+
+AcceptMultiplexer &AcceptMultiplexer::GetInstance() {
+  static AcceptMultiplexer *multiplexer = new AcceptMultiplexer();
+  return *multiplexer;
+}
+
+AcceptMultiplexer::AcceptMultiplexer()
+    : epoll_fd_(epoll_create1(EPOLL_CLOEXEC)),
+      wake_fd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) {
+  if (epoll_fd_ < 0 || wake_fd_ < 0) {
+    NEARBY_LOGS(ERROR) << __func__ << ": Error creating epoll instance: "
+                       << std::strerror(errno);
+    return;
+  }
+
+  struct epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.fd = wake_fd_;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event) < 0) {
+    NEARBY_LOGS(ERROR) << __func__ << ": Error watching eventfd: "
+                       << std::strerror(errno);
+  }
+}
+
+AcceptMultiplexer::~AcceptMultiplexer() {
+  ShutDown();
+  if (epoll_fd_ >= 0) close(epoll_fd_);
+  if (wake_fd_ >= 0) close(wake_fd_);
+}
+
+bool AcceptMultiplexer::Register(int listen_fd, AcceptCallback callback) {
+  absl::MutexLock l(&mutex_);
+  if (shut_down_ || epoll_fd_ < 0) {
+    NEARBY_LOGS(ERROR) << __func__ << ": accept multiplexer is not running";
+    return false;
+  }
+  if (listeners_.contains(listen_fd)) {
+    NEARBY_LOGS(ERROR) << __func__ << ": socket " << listen_fd
+                       << " is already registered";
+    return false;
+  }
+  if (!SetNonBlocking(listen_fd, true)) {
+    NEARBY_LOGS(ERROR) << __func__ << ": Error making socket " << listen_fd
+                       << " non-blocking: " << std::strerror(errno);
+    return false;
+  }
+
+  struct epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.fd = listen_fd;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd, &event) < 0) {
+    NEARBY_LOGS(ERROR) << __func__ << ": Error watching socket " << listen_fd
+                       << ": " << std::strerror(errno);
+    SetNonBlocking(listen_fd, false);
+    return false;
+  }
+
+  listeners_.emplace(listen_fd,
+                     std::make_shared<Listener>(Listener{std::move(callback)}));
+  if (!thread_.joinable()) {
+    thread_ = std::thread([this]() { Loop(); });
+  }
+  return true;
+}
+
+void AcceptMultiplexer::Unregister(int listen_fd) {
+  absl::MutexLock l(&mutex_);
+  if (listeners_.erase(listen_fd) == 0) return;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, listen_fd, nullptr) < 0) {
+    NEARBY_LOGS(WARNING) << __func__ << ": Error unwatching socket "
+                         << listen_fd << ": " << std::strerror(errno);
+  }
+
+  // A callback may unregister its own listener.
+  if (std::this_thread::get_id() == thread_.get_id()) return;
+  auto not_dispatching = [this, listen_fd]() {
+    mutex_.AssertReaderHeld();
+    return dispatching_fd_ != listen_fd;
+  };
+  mutex_.Await(absl::Condition(&not_dispatching));
+}
+
+void AcceptMultiplexer::ShutDown() {
+  std::thread thread;
+  {
+    absl::MutexLock l(&mutex_);
+    if (shut_down_) return;
+    shut_down_ = true;
+    listeners_.clear();
+    thread = std::move(thread_);
+  }
+
+  Wake();
+  if (thread.joinable()) {
+    if (thread.get_id() == std::this_thread::get_id()) {
+      thread.detach();
+    } else {
+      thread.join();
+    }
+  }
+}
+
+size_t AcceptMultiplexer::GetListenerCount() const {
+  absl::MutexLock l(&mutex_);
+  return listeners_.size();
+}
+
+void AcceptMultiplexer::Loop() {
+  struct epoll_event events[kMaxEvents];
+  while (true) {
+    int count = epoll_wait(epoll_fd_, events, kMaxEvents, -1);
+    if (count < 0) {
+      if (errno == EINTR) continue;
+      NEARBY_LOGS(ERROR) << __func__ << ": Error waiting for connections: "
+                         << std::strerror(errno);
+      return;
+    }
+
+    for (int i = 0; i < count; i++) {
+      if (events[i].data.fd == wake_fd_) {
+        std::uint64_t value;
+        while (read(wake_fd_, &value, sizeof(value)) > 0) {
+        }
+        continue;
+      }
+      AcceptAll(events[i].data.fd);
+    }
+
+    absl::MutexLock l(&mutex_);
+    if (shut_down_) return;
+  }
+}
+
+void AcceptMultiplexer::AcceptAll(int listen_fd) {
+  std::shared_ptr<Listener> listener;
+  {
+    absl::MutexLock l(&mutex_);
+    auto it = listeners_.find(listen_fd);
+    if (shut_down_ || it == listeners_.end()) return;
+    listener = it->second;
+    dispatching_fd_ = listen_fd;
+  }
+
+  // The socket is level-triggered, so anything left in the backlog is picked
+  // up on the next wakeup.
+  while (true) {
+    int connection = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (connection < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        NEARBY_LOGS(ERROR) << __func__ << ": Error accepting connections on "
+                           << "socket " << listen_fd << ": "
+                           << std::strerror(errno);
+      }
+      break;
+    }
+    listener->callback(connection);
+
+    absl::ReaderMutexLock l(&mutex_);
+    if (!listeners_.contains(listen_fd)) break;
+  }
+
+  absl::MutexLock l(&mutex_);
+  dispatching_fd_ = -1;
+}
+
+void AcceptMultiplexer::Wake() {
+  std::uint64_t value = 1;
+  if (write(wake_fd_, &value, sizeof(value)) < 0) {
+    NEARBY_LOGS(ERROR) << __func__ << ": Error waking up accept thread: "
+                       << std::strerror(errno);
+  }
+}
+
+MultiplexedServerSocket::MultiplexedServerSocket(int listen_fd,
+                                                 AcceptMultiplexer &multiplexer)
+    : multiplexer_(multiplexer), fd_(listen_fd) {
+  registered_ = multiplexer_.Register(
+      fd_, [this](int connection_fd) { OnAccepted(connection_fd); });
+  if (!registered_) {
+    NEARBY_LOGS(WARNING) << __func__ << ": Falling back to blocking accept on "
+                         << "socket " << fd_;
+  }
+}
+
+MultiplexedServerSocket::~MultiplexedServerSocket() { Close(); }
+
+bool MultiplexedServerSocket::AddListener(
+    int listen_fd, absl::AnyInvocable<bool(int connection_fd)> filter) {
+  AcceptMultiplexer::AcceptCallback callback =
+      [this, filter = std::move(filter)](int connection_fd) mutable {
+        if (!filter(connection_fd)) {
+          NEARBY_LOGS(WARNING) << "Rejecting connection on socket " << fd_;
+          close(connection_fd);
+          return;
+        }
+        OnAccepted(connection_fd);
+      };
+  if (!registered_ || !multiplexer_.Register(listen_fd, std::move(callback))) {
+    close(listen_fd);
+    return false;
+  }
+
+  bool closed;
+  {
+    absl::MutexLock l(&mutex_);
+    closed = closed_;
+    if (!closed) extra_fds_.push_back(listen_fd);
+  }
+  // Lost a race with Close().
+  if (closed) {
+    multiplexer_.Unregister(listen_fd);
+    close(listen_fd);
+    return false;
+  }
+  return true;
+}
+
+int MultiplexedServerSocket::Accept() {
+  if (!registered_) {
+    {
+      absl::MutexLock l(&mutex_);
+      if (closed_) return -1;
+    }
+    return accept4(fd_, nullptr, nullptr, SOCK_CLOEXEC);
+  }
+
+  auto ready = [this]() {
+    mutex_.AssertReaderHeld();
+    return closed_ || !pending_.empty();
+  };
+  absl::MutexLock l(&mutex_, absl::Condition(&ready));
+  if (closed_) return -1;
+  int connection = pending_.front();
+  pending_.pop_front();
+  return connection;
+}
+
+Exception MultiplexedServerSocket::Close() {
+  {
+    absl::MutexLock l(&mutex_);
+    if (closed_) return {Exception::kSuccess};
+    closed_ = true;
+  }
+
+  if (registered_) multiplexer_.Unregister(fd_);
+  std::vector<int> extra_fds;
+  {
+    absl::MutexLock l(&mutex_);
+    extra_fds.swap(extra_fds_);
+  }
+  for (int extra_fd : extra_fds) {
+    multiplexer_.Unregister(extra_fd);
+    close(extra_fd);
+  }
+
+  absl::MutexLock l(&mutex_);
+  for (int connection : pending_) {
+    close(connection);
+  }
+  pending_.clear();
+  // Wakes up a blocking accept() in fallback mode; close() alone doesn't.
+  shutdown(fd_, SHUT_RDWR);
+  if (close(fd_) < 0) {
+    NEARBY_LOGS(ERROR) << __func__ << ": Error closing socket " << fd_ << ": "
+                       << std::strerror(errno);
+    return {Exception::kFailed};
+  }
+
+  return {Exception::kSuccess};
+}
+
+void MultiplexedServerSocket::OnAccepted(int connection_fd) {
+  absl::MutexLock l(&mutex_);
+  if (closed_ || pending_.size() >= kMaxPendingConnections) {
+    NEARBY_LOGS(WARNING) << __func__ << ": Dropping connection on socket "
+                         << fd_;
+    close(connection_fd);
+    return;
+  }
+  pending_.push_back(connection_fd);
+}
+
+}  // namespace linux
+}  // namespace nearby
@@ -0,0 +1,144 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PLATFORM_IMPL_LINUX_ACCEPT_MULTIPLEXER_H_
+#define PLATFORM_IMPL_LINUX_ACCEPT_MULTIPLEXER_H_
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/synchronization/mutex.h"
+#include "internal/platform/exception.h"
+
+#ifdef linux
+#undef linux
+#endif
+
+namespace nearby {
+namespace linux {
+
+// Accepts connections for any number of listening sockets on a single epoll
+// thread, instead of parking one thread in a blocking accept() per listener.
+class AcceptMultiplexer {
+ public:
+  // Called on the multiplexer thread with each accepted connection, which the
+  // callback takes ownership of.
+  using AcceptCallback = absl::AnyInvocable<void(int connection_fd)>;
+
+  // The instance shared by all mediums. Never destroyed.
+  static AcceptMultiplexer &GetInstance();
+
+  AcceptMultiplexer();
+  AcceptMultiplexer(const AcceptMultiplexer &) = delete;
+  AcceptMultiplexer &operator=(const AcceptMultiplexer &) = delete;
+  ~AcceptMultiplexer();
+
+  // Starts accepting connections on `listen_fd`, which must already be
+  // listening. The socket is switched to non-blocking mode. Returns false if it
+  // could not be watched.
+  bool Register(int listen_fd, AcceptCallback callback)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Stops accepting connections on `listen_fd`. Once this returns, its
+  // callback is not running and won't be called again, so the caller can close
+  // the socket.
+  void Unregister(int listen_fd) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Stops the multiplexer thread. Listeners are dropped without being closed.
+  void ShutDown() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  size_t GetListenerCount() const ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  struct Listener {
+    AcceptCallback callback;
+  };
+
+  void Loop() ABSL_LOCKS_EXCLUDED(mutex_);
+  void AcceptAll(int listen_fd) ABSL_LOCKS_EXCLUDED(mutex_);
+  void Wake();
+
+  int epoll_fd_ = -1;
+  // An eventfd that wakes up the multiplexer thread for shutdown.
+  int wake_fd_ = -1;
+
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<int, std::shared_ptr<Listener>> listeners_
+      ABSL_GUARDED_BY(mutex_);
+  // The listener whose callbacks are running, or -1.
+  int dispatching_fd_ ABSL_GUARDED_BY(mutex_) = -1;
+  bool shut_down_ ABSL_GUARDED_BY(mutex_) = false;
+  std::thread thread_ ABSL_GUARDED_BY(mutex_);
+};
+
+// A listening socket whose connections are accepted by an `AcceptMultiplexer`
+// and handed out by `Accept()`, for server sockets that have to implement a
+// blocking accept. The caller of `Accept()` still waits on its own thread, as
+// the platform API requires; what this saves is a thread stuck in accept(),
+// so that `Close()` reliably wakes it up.
+class MultiplexedServerSocket {
+ public:
+  // Connections accepted beyond this many, while nobody calls `Accept()`, are
+  // dropped.
+  static constexpr size_t kMaxPendingConnections = 64;
+
+  explicit MultiplexedServerSocket(
+      int listen_fd,
+      AcceptMultiplexer &multiplexer = AcceptMultiplexer::GetInstance());
+  MultiplexedServerSocket(const MultiplexedServerSocket &) = delete;
+  MultiplexedServerSocket &operator=(const MultiplexedServerSocket &) = delete;
+  ~MultiplexedServerSocket();
+
+  int GetFd() const { return fd_; }
+
+  // Also hands out the connections accepted on `listen_fd`, e.g. a same-host
+  // listener for the same service, except those `filter` rejects. `listen_fd`
+  // is closed along with this socket, or right away if it can't be watched, in
+  // which case this returns false.
+  bool AddListener(int listen_fd,
+                   absl::AnyInvocable<bool(int connection_fd)> filter)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Blocks until a connection is accepted and returns it, or returns -1 once
+  // the socket is closed.
+  int Accept() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Stops accepting, wakes up blocked `Accept()` calls and closes the socket.
+  Exception Close() ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  void OnAccepted(int connection_fd) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  AcceptMultiplexer &multiplexer_;
+  const int fd_;
+  // False if the multiplexer couldn't watch the socket, in which case
+  // `Accept()` falls back to a blocking accept().
+  bool registered_ = false;
+
+  absl::Mutex mutex_;
+  std::deque<int> pending_ ABSL_GUARDED_BY(mutex_);
+  std::vector<int> extra_fds_ ABSL_GUARDED_BY(mutex_);
+  bool closed_ ABSL_GUARDED_BY(mutex_) = false;
+};
+
+}  // namespace linux
+}  // namespace nearby
+
+#endif  // PLATFORM_IMPL_LINUX_ACCEPT_MULTIPLEXER_H_
@@ -0,0 +1,191 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/platform/implementation/linux/accept_multiplexer.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gtest/gtest.h"
+
+namespace nearby {
+namespace linux {
+namespace {
+
+constexpr int kListenerCount = 8;
+constexpr absl::Duration kShutdownBudget = absl::Milliseconds(100);
+
+// Returns a socket listening on a free loopback port.
+int Listen() {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = 0;
+  EXPECT_EQ(bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)),
+            0);
+  EXPECT_EQ(listen(fd, SOMAXCONN), 0);
+  return fd;
+}
+
+// Returns a socket connected to `listen_fd`.
+int Connect(int listen_fd) {
+  struct sockaddr_in addr{};
+  socklen_t len = sizeof(addr);
+  getsockname(listen_fd, reinterpret_cast<struct sockaddr *>(&addr), &len);
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  EXPECT_EQ(connect(fd, reinterpret_cast<struct sockaddr *>(&addr), len), 0);
+  return fd;
+}
+
+TEST(AcceptMultiplexer, AcceptsForAllListenersOnOneThread) {
+  AcceptMultiplexer multiplexer;
+  absl::BlockingCounter accepted(kListenerCount);
+  absl::Mutex mutex;
+  absl::flat_hash_set<std::thread::id> thread_ids;
+  std::vector<int> listeners;
+  std::vector<int> connections;
+
+  for (int i = 0; i < kListenerCount; ++i) {
+    listeners.push_back(Listen());
+    ASSERT_TRUE(multiplexer.Register(listeners.back(), [&](int fd) {
+      {
+        absl::MutexLock l(&mutex);
+        thread_ids.insert(std::this_thread::get_id());
+      }
+      close(fd);
+      accepted.DecrementCount();
+    }));
+  }
+  for (int fd : listeners) {
+    connections.push_back(Connect(fd));
+  }
+
+  accepted.Wait();
+  EXPECT_EQ(thread_ids.size(), 1);
+  EXPECT_EQ(multiplexer.GetListenerCount(), kListenerCount);
+  multiplexer.ShutDown();
+  for (int fd : listeners) close(fd);
+  for (int fd : connections) close(fd);
+}
+
+TEST(AcceptMultiplexer, UnregisterStopsCallbacks) {
+  AcceptMultiplexer multiplexer;
+  std::atomic<int> accepted = 0;
+  int listener = Listen();
+  ASSERT_TRUE(multiplexer.Register(listener, [&](int fd) {
+    close(fd);
+    accepted++;
+  }));
+
+  multiplexer.Unregister(listener);
+  int connection = Connect(listener);
+  absl::SleepFor(absl::Milliseconds(50));
+
+  EXPECT_EQ(accepted, 0);
+  EXPECT_EQ(multiplexer.GetListenerCount(), 0);
+  close(connection);
+  close(listener);
+}
+
+TEST(AcceptMultiplexer, ShutsDownQuicklyWithIdleListeners) {
+  auto multiplexer = std::make_unique<AcceptMultiplexer>();
+  std::vector<int> listeners;
+  for (int i = 0; i < kListenerCount; ++i) {
+    listeners.push_back(Listen());
+    ASSERT_TRUE(multiplexer->Register(listeners.back(), [](int fd) {
+      close(fd);
+    }));
+  }
+
+  absl::Time start = absl::Now();
+  multiplexer.reset();
+
+  EXPECT_LT(absl::Now() - start, kShutdownBudget);
+  for (int fd : listeners) close(fd);
+}
+
+TEST(MultiplexedServerSocket, AcceptReturnsConnection) {
+  AcceptMultiplexer multiplexer;
+  MultiplexedServerSocket server_socket(Listen(), multiplexer);
+  int client = Connect(server_socket.GetFd());
+
+  int connection = server_socket.Accept();
+
+  EXPECT_GE(connection, 0);
+  EXPECT_EQ(write(client, "x", 1), 1);
+  char byte = 0;
+  EXPECT_EQ(read(connection, &byte, 1), 1);
+  EXPECT_EQ(byte, 'x');
+  close(connection);
+  close(client);
+  EXPECT_TRUE(server_socket.Close().Ok());
+}
+
+TEST(MultiplexedServerSocket, CloseUnblocksAcceptQuickly) {
+  AcceptMultiplexer multiplexer;
+  std::vector<std::unique_ptr<MultiplexedServerSocket>> server_sockets;
+  std::vector<std::thread> accept_threads;
+  std::atomic<int> unblocked = 0;
+  for (int i = 0; i < kListenerCount; ++i) {
+    server_sockets.push_back(
+        std::make_unique<MultiplexedServerSocket>(Listen(), multiplexer));
+    accept_threads.emplace_back([&, socket = server_sockets.back().get()]() {
+      EXPECT_EQ(socket->Accept(), -1);
+      unblocked++;
+    });
+  }
+  absl::SleepFor(absl::Milliseconds(20));
+
+  absl::Time start = absl::Now();
+  for (auto &server_socket : server_sockets) {
+    EXPECT_TRUE(server_socket->Close().Ok());
+  }
+  for (auto &thread : accept_threads) thread.join();
+
+  EXPECT_LT(absl::Now() - start, kShutdownBudget);
+  EXPECT_EQ(unblocked, kListenerCount);
+  EXPECT_EQ(multiplexer.GetListenerCount(), 0);
+}
+
+TEST(MultiplexedServerSocket, DropsPendingConnectionsOnClose) {
+  AcceptMultiplexer multiplexer;
+  auto server_socket =
+      std::make_unique<MultiplexedServerSocket>(Listen(), multiplexer);
+  int client = Connect(server_socket->GetFd());
+  absl::SleepFor(absl::Milliseconds(20));
+
+  EXPECT_TRUE(server_socket->Close().Ok());
+
+  // The queued connection was closed, so the client sees end of stream.
+  char byte;
+  EXPECT_EQ(read(client, &byte, 1), 0);
+  close(client);
+}
+
+}  // namespace
+}  // namespace linux
+}  // namespace nearby
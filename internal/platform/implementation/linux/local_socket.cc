@@ -0,0 +1,140 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/platform/implementation/linux/local_socket.h"
+
+#include <arpa/inet.h>
+#include <ifaddrs.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "internal/platform/logging.h"
+
+namespace nearby {
+namespace linux {
+namespace {
+
+// Abstract socket names live in the network namespace, not the filesystem, so
+// they need no cleanup and disappear with the listening socket.
+socklen_t MakeLocalAddress(int port, struct sockaddr_un &addr) {
+  std::string name = absl::StrCat("nearby-connections/tcp/", port);
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  // The leading NUL byte puts the name in the abstract namespace.
+  std::memcpy(addr.sun_path + 1, name.data(), name.size());
+  return offsetof(struct sockaddr_un, sun_path) + 1 + name.size();
+}
+
+}  // namespace
+
+int ListenLocalSocket(int port) {
+  int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (sock < 0) {
+    NEARBY_LOGS(ERROR) << __func__
+                       << ": Error opening socket: " << std::strerror(errno);
+    return -1;
+  }
+
+  struct sockaddr_un addr;
+  socklen_t len = MakeLocalAddress(port, addr);
+  if (bind(sock, reinterpret_cast<struct sockaddr *>(&addr), len) < 0) {
+    NEARBY_LOGS(WARNING) << __func__ << ": Error binding local socket for port "
+                         << port << ": " << std::strerror(errno);
+    close(sock);
+    return -1;
+  }
+  if (listen(sock, SOMAXCONN) < 0) {
+    NEARBY_LOGS(ERROR) << __func__ << ": Error listening on socket: "
+                       << std::strerror(errno);
+    close(sock);
+    return -1;
+  }
+
+  return sock;
+}
+
+int ConnectLocalSocket(int port) {
+  int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (sock < 0) {
+    NEARBY_LOGS(ERROR) << __func__
+                       << ": Error opening socket: " << std::strerror(errno);
+    return -1;
+  }
+
+  struct sockaddr_un addr;
+  socklen_t len = MakeLocalAddress(port, addr);
+  // Fails right away with ECONNREFUSED if nobody listens on the name.
+  if (connect(sock, reinterpret_cast<struct sockaddr *>(&addr), len) < 0) {
+    close(sock);
+    return -1;
+  }
+  if (!IsSameUserPeer(sock)) {
+    NEARBY_LOGS(WARNING) << __func__ << ": Local socket for port " << port
+                         << " belongs to another user, ignoring it";
+    close(sock);
+    return -1;
+  }
+
+  return sock;
+}
+
+bool IsSameUserPeer(int fd) {
+  struct ucred credentials;
+  socklen_t len = sizeof(credentials);
+  if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &len) < 0) {
+    return false;
+  }
+  return credentials.uid == getuid();
+}
+
+bool IsLocalAddress(const std::string &ip_address) {
+  struct in_addr address;
+  if (inet_pton(AF_INET, ip_address.c_str(), &address) != 1) return false;
+  // 127.0.0.0/8
+  if ((ntohl(address.s_addr) >> 24) == 127) return true;
+
+  struct ifaddrs *interfaces;
+  if (getifaddrs(&interfaces) < 0) {
+    NEARBY_LOGS(ERROR) << __func__ << ": Error listing interfaces: "
+                       << std::strerror(errno);
+    return false;
+  }
+  bool is_local = false;
+  for (struct ifaddrs *interface = interfaces; interface != nullptr;
+       interface = interface->ifa_next) {
+    if (interface->ifa_addr == nullptr ||
+        interface->ifa_addr->sa_family != AF_INET) {
+      continue;
+    }
+    auto *interface_address =
+        reinterpret_cast<struct sockaddr_in *>(interface->ifa_addr);
+    if (interface_address->sin_addr.s_addr == address.s_addr) {
+      is_local = true;
+      break;
+    }
+  }
+  freeifaddrs(interfaces);
+  return is_local;
+}
+
+}  // namespace linux
+}  // namespace nearby
@@ -0,0 +1,55 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PLATFORM_IMPL_LINUX_LOCAL_SOCKET_H_
+#define PLATFORM_IMPL_LINUX_LOCAL_SOCKET_H_
+
+#include <string>
+
+#ifdef linux
+#undef linux
+#endif
+
+namespace nearby {
+namespace linux {
+
+// A same-host shortcut for TCP services. Next to its TCP socket, a server
+// listens on an abstract Unix domain socket named after its TCP port. A client
+// connecting to an address of this host tries that socket first, which skips
+// the TCP/IP stack entirely.
+//
+// Only peers running as the same user connect this way: both sides check the
+// other's credentials, so a process of another user squatting on the name
+// can't intercept the connection. Everyone else falls back to TCP.
+
+// Returns a socket listening for same-host connections to the TCP service on
+// `port`, or -1 if one can't be created, e.g. because the name is taken.
+int ListenLocalSocket(int port);
+
+// Returns a socket connected to the same-host listener of the TCP service on
+// `port`, or -1 if there is none or it belongs to another user.
+int ConnectLocalSocket(int port);
+
+// Returns true if the peer of the connected Unix domain socket `fd` runs as
+// the same user as this process.
+bool IsSameUserPeer(int fd);
+
+// Returns true if the dotted IPv4 `ip_address` belongs to this host,
+// including loopback addresses.
+bool IsLocalAddress(const std::string &ip_address);
+
+}  // namespace linux
+}  // namespace nearby
+
+#endif  // PLATFORM_IMPL_LINUX_LOCAL_SOCKET_H_
@@ -0,0 +1,240 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/platform/implementation/linux/local_socket.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "internal/platform/implementation/linux/accept_multiplexer.h"
+
+namespace nearby {
+namespace linux {
+namespace {
+
+constexpr size_t kTransferBytes = 4 * 1024 * 1024;
+constexpr size_t kTransferWriteSize = 64 * 1024;
+
+// Returns a port number no other test process uses for its local socket
+// name. It doesn't have to be a free TCP port.
+int GetUniquePort() {
+  static std::atomic<int> next_port = getpid() * 16 % 1000000;
+  return next_port++;
+}
+
+// Returns a loopback TCP socket listening on a free port.
+int ListenTcp() {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = 0;
+  EXPECT_EQ(bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)),
+            0);
+  EXPECT_EQ(listen(fd, SOMAXCONN), 0);
+  return fd;
+}
+
+// Returns a socket connected to the loopback TCP socket `listen_fd`.
+int ConnectTcp(int listen_fd) {
+  struct sockaddr_in addr{};
+  socklen_t len = sizeof(addr);
+  getsockname(listen_fd, reinterpret_cast<struct sockaddr *>(&addr), &len);
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  EXPECT_EQ(connect(fd, reinterpret_cast<struct sockaddr *>(&addr), len), 0);
+  return fd;
+}
+
+// Sends kTransferBytes of a repeating pattern from `writer` to `reader` and
+// returns what `reader` received.
+std::vector<char> Transfer(int writer, int reader) {
+  std::thread write_thread([writer]() {
+    std::vector<char> data(kTransferWriteSize);
+    size_t sent = 0;
+    while (sent < kTransferBytes) {
+      size_t size = std::min(data.size(), kTransferBytes - sent);
+      for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<char>((sent + i) % 251);
+      }
+      ssize_t count = write(writer, data.data(), size);
+      if (count <= 0) break;
+      sent += count;
+    }
+  });
+  std::vector<char> received(kTransferBytes);
+  size_t size = 0;
+  while (size < kTransferBytes) {
+    ssize_t count = read(reader, received.data() + size, kTransferBytes - size);
+    if (count <= 0) break;
+    size += count;
+  }
+  write_thread.join();
+  received.resize(size);
+  return received;
+}
+
+TEST(LocalSocket, ConnectsToListener) {
+  int port = GetUniquePort();
+  int listener = ListenLocalSocket(port);
+  ASSERT_GE(listener, 0);
+
+  int client = ConnectLocalSocket(port);
+  ASSERT_GE(client, 0);
+  int server = accept(listener, nullptr, nullptr);
+  ASSERT_GE(server, 0);
+  ASSERT_EQ(write(client, "ping", 4), 4);
+  char data[4];
+  ASSERT_EQ(read(server, data, sizeof(data)), 4);
+
+  EXPECT_EQ(std::string(data, sizeof(data)), "ping");
+  EXPECT_TRUE(IsSameUserPeer(server));
+  EXPECT_TRUE(IsSameUserPeer(client));
+  close(server);
+  close(client);
+  close(listener);
+}
+
+TEST(LocalSocket, ConnectFailsWithoutListener) {
+  EXPECT_LT(ConnectLocalSocket(GetUniquePort()), 0);
+}
+
+TEST(LocalSocket, ListenFailsIfNameIsTaken) {
+  int port = GetUniquePort();
+  int listener = ListenLocalSocket(port);
+  ASSERT_GE(listener, 0);
+
+  EXPECT_LT(ListenLocalSocket(port), 0);
+
+  close(listener);
+}
+
+TEST(LocalSocket, NameIsReleasedWithListener) {
+  int port = GetUniquePort();
+  close(ListenLocalSocket(port));
+
+  int listener = ListenLocalSocket(port);
+  EXPECT_GE(listener, 0);
+
+  close(listener);
+}
+
+TEST(LocalSocket, IsSameUserPeerFailsForTcp) {
+  int listener = ListenTcp();
+  int client = ConnectTcp(listener);
+
+  EXPECT_FALSE(IsSameUserPeer(client));
+
+  close(client);
+  close(listener);
+}
+
+TEST(LocalSocket, IsLocalAddress) {
+  EXPECT_TRUE(IsLocalAddress("127.0.0.1"));
+  EXPECT_TRUE(IsLocalAddress("127.1.2.3"));
+  // Reserved for documentation, never assigned to a host.
+  EXPECT_FALSE(IsLocalAddress("192.0.2.1"));
+  EXPECT_FALSE(IsLocalAddress("not an address"));
+  EXPECT_FALSE(IsLocalAddress(""));
+}
+
+TEST(LocalSocket, ServerSocketAcceptsLocalConnections) {
+  AcceptMultiplexer multiplexer;
+  int port = GetUniquePort();
+  MultiplexedServerSocket server_socket(ListenTcp(), multiplexer);
+  ASSERT_TRUE(server_socket.AddListener(ListenLocalSocket(port),
+                                        &IsSameUserPeer));
+
+  int client = ConnectLocalSocket(port);
+  ASSERT_GE(client, 0);
+  int server = server_socket.Accept();
+
+  EXPECT_GE(server, 0);
+  close(server);
+  close(client);
+  server_socket.Close();
+  multiplexer.ShutDown();
+}
+
+TEST(LocalSocket, ServerSocketDropsFilteredConnections) {
+  AcceptMultiplexer multiplexer;
+  int port = GetUniquePort();
+  int tcp_listener = ListenTcp();
+  MultiplexedServerSocket server_socket(tcp_listener, multiplexer);
+  ASSERT_TRUE(server_socket.AddListener(ListenLocalSocket(port),
+                                        [](int) { return false; }));
+
+  int local_client = ConnectLocalSocket(port);
+  ASSERT_GE(local_client, 0);
+  int tcp_client = ConnectTcp(tcp_listener);
+  int server = server_socket.Accept();
+
+  // Only the TCP connection comes through.
+  struct sockaddr_storage addr;
+  socklen_t len = sizeof(addr);
+  ASSERT_EQ(getsockname(server, reinterpret_cast<struct sockaddr *>(&addr),
+                        &len),
+            0);
+  EXPECT_EQ(addr.ss_family, AF_INET);
+  close(server);
+  close(tcp_client);
+  close(local_client);
+  server_socket.Close();
+  multiplexer.ShutDown();
+}
+
+TEST(LocalSocket, AddListenerFailsAfterClose) {
+  AcceptMultiplexer multiplexer;
+  MultiplexedServerSocket server_socket(ListenTcp(), multiplexer);
+  server_socket.Close();
+
+  EXPECT_FALSE(server_socket.AddListener(ListenLocalSocket(GetUniquePort()),
+                                         &IsSameUserPeer));
+
+  EXPECT_EQ(multiplexer.GetListenerCount(), 0);
+  multiplexer.ShutDown();
+}
+
+TEST(LocalSocket, CarriesLargeTransfers) {
+  int port = GetUniquePort();
+  int listener = ListenLocalSocket(port);
+  ASSERT_GE(listener, 0);
+  int client = ConnectLocalSocket(port);
+  ASSERT_GE(client, 0);
+  int server = accept(listener, nullptr, nullptr);
+  ASSERT_GE(server, 0);
+
+  std::vector<char> received = Transfer(client, server);
+
+  ASSERT_EQ(received.size(), kTransferBytes);
+  for (size_t i = 0; i < received.size(); ++i) {
+    ASSERT_EQ(received[i], static_cast<char>(i % 251)) << "at offset " << i;
+  }
+  close(server);
+  close(client);
+  close(listener);
+}
+
+}  // namespace
+}  // namespace linux
+}  // namespace nearby
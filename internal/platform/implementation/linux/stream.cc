@@ -27,11 +27,19 @@ namespace nearby {
 namespace linux {
 
 ExceptionOr<ByteArray> InputStream::Read(std::int64_t size) {
+  return Receive(size, MSG_WAITALL);
+}
+
+ExceptionOr<ByteArray> InputStream::ReadAvailable(std::int64_t size) {
+  return Receive(size, 0);
+}
+
+ExceptionOr<ByteArray> InputStream::Receive(std::int64_t size, int flags) {
   if (!fd_.isValid()) return {Exception::kIo};
 
   std::string buffer;
   buffer.resize(size);
-  ssize_t ret = recv(fd_.get(), buffer.data(), buffer.size(), MSG_WAITALL);
+  ssize_t ret = recv(fd_.get(), buffer.data(), buffer.size(), flags);
   if (ret == 0) {
     return ExceptionOr(ByteArray());
   }
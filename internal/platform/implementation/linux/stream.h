@@ -33,10 +33,13 @@ class InputStream : public nearby::InputStream {
   explicit InputStream(sdbus::UnixFd fd) : fd_(std::move(fd)){};
 
   ExceptionOr<ByteArray> Read(std::int64_t size) override;
+  ExceptionOr<ByteArray> ReadAvailable(std::int64_t size) override;
 
   Exception Close() override;
 
  private:
+  ExceptionOr<ByteArray> Receive(std::int64_t size, int flags);
+
   sdbus::UnixFd fd_;
 };
 
@@ -38,11 +38,11 @@ std::string NetworkManagerWifiDirectServerSocket::GetIPAddress() const {
 int NetworkManagerWifiDirectServerSocket::GetPort() const {
   struct sockaddr_in sin;
   socklen_t len = sizeof(sin);
-  auto ret =
-      getsockname(fd_.get(), reinterpret_cast<struct sockaddr *>(&sin), &len);
+  auto ret = getsockname(socket_.GetFd(),
+                         reinterpret_cast<struct sockaddr *>(&sin), &len);
   if (ret < 0) {
     NEARBY_LOGS(ERROR) << __func__ << ": Error getting information for socket "
-                       << fd_.get() << ": " << std::strerror(errno);
+                       << socket_.GetFd() << ": " << std::strerror(errno);
     return 0;
   }
 
@@ -51,15 +51,11 @@ int NetworkManagerWifiDirectServerSocket::GetPort() const {
 
 std::unique_ptr<api::WifiDirectSocket>
 NetworkManagerWifiDirectServerSocket::Accept() {
-  struct sockaddr_in addr;
-  socklen_t len = sizeof(addr);
-
-  auto conn =
-      accept(fd_.get(), reinterpret_cast<struct sockaddr *>(&addr), &len);
+  auto conn = socket_.Accept();
   if (conn < 0) {
     NEARBY_LOGS(ERROR) << __func__
                        << ": Error accepting incoming connections on socket "
-                       << fd_.get() << ": " << std::strerror(errno);
+                       << socket_.GetFd();
     return nullptr;
   }
 
@@ -67,15 +63,7 @@ NetworkManagerWifiDirectServerSocket::Accept() {
 }
 
 Exception NetworkManagerWifiDirectServerSocket::Close() {
-  int fd = fd_.release();
-  auto ret = close(fd);
-  if (ret < 0) {
-    NEARBY_LOGS(ERROR) << __func__ << ": Error closing socket " << fd << ": "
-                       << std::strerror(errno);
-    return {Exception::kFailed};
-  }
-
-  return {Exception::kSuccess};
+  return socket_.Close();
 }
 }  // namespace linux
 }  // namespace nearby
@@ -16,6 +16,7 @@
 #define PLATFORM_IMPL_LINUX_WIFI_DIRECT_SERVER_SOCKET_H_
 
 #include <sdbus-c++/IConnection.h>
+#include "internal/platform/implementation/linux/accept_multiplexer.h"
 #include "internal/platform/implementation/linux/wifi_medium.h"
 #include "internal/platform/implementation/wifi_direct.h"
 namespace nearby {
@@ -27,7 +28,7 @@ class NetworkManagerWifiDirectServerSocket
       int socket, sdbus::IConnection &system_bus,
       sdbus::ObjectPath active_connection_path,
       std::shared_ptr<NetworkManager> network_manager)
-      : fd_(socket),
+      : socket_(socket),
         system_bus_(system_bus),
         active_connection_path_(std::move(active_connection_path)),
         network_manager_(std::move(network_manager)) {}
@@ -38,7 +39,7 @@ class NetworkManagerWifiDirectServerSocket
   Exception Close() override;
 
  private:
-  sdbus::UnixFd fd_;
+  MultiplexedServerSocket socket_;
   sdbus::IConnection &system_bus_;
   sdbus::ObjectPath active_connection_path_;
   std::shared_ptr<NetworkManager> network_manager_;
@@ -23,8 +23,11 @@ namespace nearby {
 namespace linux {
 class WifiDirectSocket : public api::WifiDirectSocket {
  public:
+  // Takes ownership of `socket`.
   explicit WifiDirectSocket(int socket)
-      : fd_(sdbus::UnixFd(socket)), output_stream_(fd_), input_stream_(fd_) {}
+      : fd_(sdbus::UnixFd(socket, sdbus::adopt_fd)),
+        output_stream_(fd_),
+        input_stream_(fd_) {}
 
   InputStream &GetInputStream() override { return input_stream_; };
   OutputStream &GetOutputStream() override { return output_stream_; };
@@ -38,11 +38,11 @@ std::string NetworkManagerWifiHotspotServerSocket::GetIPAddress() const {
 int NetworkManagerWifiHotspotServerSocket::GetPort() const {
   struct sockaddr_in sin{};
   socklen_t len = sizeof(sin);
-  auto ret =
-      getsockname(fd_.get(), reinterpret_cast<struct sockaddr *>(&sin), &len);
+  auto ret = getsockname(socket_.GetFd(),
+                         reinterpret_cast<struct sockaddr *>(&sin), &len);
   if (ret < 0) {
     NEARBY_LOGS(ERROR) << __func__ << ": Error getting information for socket "
-                       << fd_.get() << ": " << std::strerror(errno);
+                       << socket_.GetFd() << ": " << std::strerror(errno);
     return 0;
   }
 
@@ -51,15 +51,11 @@ int NetworkManagerWifiHotspotServerSocket::GetPort() const {
 
 std::unique_ptr<api::WifiHotspotSocket>
 NetworkManagerWifiHotspotServerSocket::Accept() {
-  struct sockaddr_in addr{};
-  socklen_t len = sizeof(addr);
-
-  auto conn =
-      accept(fd_.get(), reinterpret_cast<struct sockaddr *>(&addr), &len);
+  auto conn = socket_.Accept();
   if (conn < 0) {
     NEARBY_LOGS(ERROR) << __func__
                        << ": Error accepting incoming connections on socket "
-                       << fd_.get() << ": " << std::strerror(errno);
+                       << socket_.GetFd();
     return nullptr;
   }
 
@@ -67,14 +63,7 @@ NetworkManagerWifiHotspotServerSocket::Accept() {
 }
 
 Exception NetworkManagerWifiHotspotServerSocket::Close() {
-  auto ret = close(fd_.release());
-  if (ret < 0) {
-    NEARBY_LOGS(ERROR) << __func__ << ": Error closing socket: "
-                       << std::strerror(errno);
-    return {Exception::kFailed};
-  }
-
-  return {Exception::kSuccess};
+  return socket_.Close();
 }
 }  // namespace linux
 }  // namespace nearby
@@ -17,6 +17,7 @@
 
 #include <sdbus-c++/IConnection.h>
 
+#include "internal/platform/implementation/linux/accept_multiplexer.h"
 #include "internal/platform/implementation/linux/wifi_medium.h"
 #include "internal/platform/implementation/wifi_hotspot.h"
 
@@ -29,7 +30,7 @@ class NetworkManagerWifiHotspotServerSocket
       int socket, sdbus::IConnection &system_bus,
       sdbus::ObjectPath active_connection_path,
       std::shared_ptr<NetworkManager> network_manager)
-      : fd_(socket),
+      : socket_(socket),
         system_bus_(system_bus),
         active_connection_path_(std::move(active_connection_path)),
         network_manager_(std::move(network_manager)) {}
@@ -40,7 +41,7 @@ class NetworkManagerWifiHotspotServerSocket
   Exception Close() override;
 
  private:
-  sdbus::UnixFd fd_;
+  MultiplexedServerSocket socket_;
   sdbus::IConnection &system_bus_;
   sdbus::ObjectPath active_connection_path_;
   std::shared_ptr<NetworkManager> network_manager_;
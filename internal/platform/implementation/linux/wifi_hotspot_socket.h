@@ -22,8 +22,9 @@ namespace nearby {
 namespace linux {
 class WifiHotspotSocket : public api::WifiHotspotSocket {
  public:
+  // Takes ownership of `connection_fd`.
   explicit WifiHotspotSocket(int connection_fd)
-      : fd_(sdbus::UnixFd(connection_fd)),
+      : fd_(sdbus::UnixFd(connection_fd, sdbus::adopt_fd)),
         output_stream_(fd_),
         input_stream_(fd_) {}
 
@@ -15,6 +15,7 @@
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
+#include <unistd.h>
 #include <cerrno>
 #include <cstdint>
 #include <cstring>
@@ -28,6 +29,7 @@
 #include "absl/strings/substitute.h"
 #include "internal/platform/implementation/linux/avahi.h"
 #include "internal/platform/implementation/linux/dbus.h"
+#include "internal/platform/implementation/linux/local_socket.h"
 #include "internal/platform/implementation/linux/wifi_lan.h"
 #include "internal/platform/implementation/linux/wifi_lan_server_socket.h"
 #include "internal/platform/implementation/linux/wifi_lan_socket.h"
@@ -204,6 +206,16 @@ bool WifiLanMedium::StopDiscovery(const std::string &service_type) {
 std::unique_ptr<api::WifiLanSocket> WifiLanMedium::ConnectToService(
     const std::string &ip_address, int port,
     CancellationFlag *cancellation_flag) {
+  if (IsLocalAddress(ip_address)) {
+    int local_sock = ConnectLocalSocket(port);
+    if (local_sock >= 0) {
+      NEARBY_LOGS(VERBOSE) << __func__ << ": Connected to " << ip_address << ":"
+                           << port << " through a local socket";
+      sdbus::UnixFd fd(local_sock, sdbus::adopt_fd);
+      return std::make_unique<WifiLanSocket>(std::move(fd));
+    }
+  }
+
   int sock = socket(AF_INET, SOCK_STREAM, 0);
   if (sock < 0) {
     NEARBY_LOGS(ERROR) << __func__
@@ -223,10 +235,11 @@ std::unique_ptr<api::WifiLanSocket> WifiLanMedium::ConnectToService(
   if (ret < 0) {
     NEARBY_LOGS(ERROR) << __func__ << ": Error connecting to socket: "
                        << std::strerror(errno);
+    close(sock);
     return nullptr;
   }
 
-  sdbus::UnixFd fd(sock);
+  sdbus::UnixFd fd(sock, sdbus::adopt_fd);
   return std::make_unique<WifiLanSocket>(std::move(fd));
 }
 
@@ -261,8 +274,10 @@ std::unique_ptr<api::WifiLanServerSocket> WifiLanMedium::ListenForService(
 
   NEARBY_LOGS(VERBOSE) << __func__ << "Listening for services on port " << port;
 
-  return std::make_unique<WifiLanServerSocket>(sock, network_manager_,
-                                               system_bus_);
+  auto server_socket = std::make_unique<WifiLanServerSocket>(
+      sock, network_manager_, system_bus_);
+  server_socket->AcceptLocalConnections();
+  return server_socket;
 }
 
 absl::optional<std::pair<std::int32_t, std::int32_t>> GetDynamicPortRange() {
@@ -25,6 +25,7 @@
 
 #include "internal/platform/exception.h"
 #include "internal/platform/implementation/linux/dbus.h"
+#include "internal/platform/implementation/linux/local_socket.h"
 #include "internal/platform/implementation/linux/wifi_lan_server_socket.h"
 #include "internal/platform/implementation/linux/wifi_lan_socket.h"
 #include "internal/platform/implementation/linux/wifi_medium.h"
@@ -77,11 +78,11 @@ std::string WifiLanServerSocket::GetIPAddress() const {
 int WifiLanServerSocket::GetPort() const {
   struct sockaddr_in sin;
   socklen_t len = sizeof(sin);
-  auto ret =
-      getsockname(fd_.get(), reinterpret_cast<struct sockaddr *>(&sin), &len);
+  auto ret = getsockname(socket_.GetFd(),
+                         reinterpret_cast<struct sockaddr *>(&sin), &len);
   if (ret < 0) {
     NEARBY_LOGS(ERROR) << __func__ << ": Error getting information for socket "
-                       << fd_.get() << ": " << std::strerror(errno);
+                       << socket_.GetFd() << ": " << std::strerror(errno);
     return 0;
   }
 
@@ -89,31 +90,31 @@ int WifiLanServerSocket::GetPort() const {
 }
 
 std::unique_ptr<api::WifiLanSocket> WifiLanServerSocket::Accept() {
-  struct sockaddr_in addr;
-  socklen_t len = sizeof(addr);
-
-  auto conn =
-      accept(fd_.get(), reinterpret_cast<struct sockaddr *>(&addr), &len);
+  auto conn = socket_.Accept();
   if (conn < 0) {
     NEARBY_LOGS(ERROR) << __func__
                        << ": Error accepting incoming connections on socket "
-                       << fd_.get() << ": " << std::strerror(errno);
+                       << socket_.GetFd();
     return nullptr;
   }
 
-  return std::make_unique<WifiLanSocket>(sdbus::UnixFd(conn));
+  return std::make_unique<WifiLanSocket>(
+      sdbus::UnixFd(conn, sdbus::adopt_fd));
 }
 
-Exception WifiLanServerSocket::Close() {
-  int fd = fd_.release();
-  auto ret = close(fd);
-  if (ret < 0) {
-    NEARBY_LOGS(ERROR) << __func__ << ": Error closing socket " << fd << ": "
-                       << std::strerror(errno);
-    return {Exception::kFailed};
+void WifiLanServerSocket::AcceptLocalConnections() {
+  int port = GetPort();
+  int local_socket = ListenLocalSocket(port);
+  if (local_socket < 0) return;
+  if (!socket_.AddListener(local_socket, &IsSameUserPeer)) {
+    NEARBY_LOGS(WARNING) << __func__
+                         << ": Not accepting local connections for port "
+                         << port;
   }
+}
 
-  return {Exception::kSuccess};
+Exception WifiLanServerSocket::Close() {
+  return socket_.Close();
 }
 }  // namespace linux
 }  // namespace nearby
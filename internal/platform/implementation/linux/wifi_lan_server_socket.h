@@ -21,6 +21,7 @@
 #include <sdbus-c++/Types.h>
 
 #include "internal/platform/exception.h"
+#include "internal/platform/implementation/linux/accept_multiplexer.h"
 #include "internal/platform/implementation/linux/wifi_medium.h"
 #include "internal/platform/implementation/wifi_lan.h"
 
@@ -31,7 +32,7 @@ class WifiLanServerSocket : public api::WifiLanServerSocket {
   explicit WifiLanServerSocket(int socket,
                                std::shared_ptr<NetworkManager> network_manager,
                                sdbus::IConnection &system_bus)
-      : fd_(sdbus::UnixFd(socket)),
+      : socket_(socket),
         network_manager_(std::move(network_manager)),
         system_bus_(system_bus) {}
 
@@ -41,8 +42,12 @@ class WifiLanServerSocket : public api::WifiLanServerSocket {
   std::unique_ptr<api::WifiLanSocket> Accept() override;
   Exception Close() override;
 
+  // Also accepts connections from processes of the same user on this host
+  // through a local socket, see local_socket.h.
+  void AcceptLocalConnections();
+
  private:
-  sdbus::UnixFd fd_;
+  MultiplexedServerSocket socket_;
   std::shared_ptr<NetworkManager> network_manager_;
   sdbus::IConnection &system_bus_;
 };
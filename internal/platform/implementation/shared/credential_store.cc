@@ -0,0 +1,431 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/platform/implementation/shared/credential_store.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "internal/proto/credential.pb.h"
+
+namespace nearby {
+namespace shared {
+
+// "NPCS", read as a little endian integer.
+constexpr uint32_t kMagic = 0x5343504e;
+constexpr uint32_t kVersion = 1;
+
+struct PublicCredentialStore::Header {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t index_count;
+  uint32_t record_count;
+  uint32_t data_size;
+  uint32_t reserved;
+};
+
+struct PublicCredentialStore::IndexEntry {
+  uint32_t manager_app_id_offset;
+  uint32_t manager_app_id_size;
+  uint32_t account_name_offset;
+  uint32_t account_name_size;
+  uint32_t credential_type;
+  uint32_t identity_type;
+  uint32_t first_record;
+  uint32_t record_count;
+};
+
+struct PublicCredentialStore::Record {
+  uint32_t key_seed_offset;
+  uint32_t key_seed_size;
+  uint32_t metadata_encryption_key_tag_v0_offset;
+  uint32_t metadata_encryption_key_tag_v0_size;
+  uint32_t credential_offset;
+  uint32_t credential_size;
+  uint32_t identity_type;
+  uint32_t reserved;
+};
+
+namespace {
+
+using IndexKey = std::tuple<absl::string_view, absl::string_view, uint32_t,
+                            uint32_t>;
+
+template <typename T>
+void Append(const T& value, std::string& out) {
+  out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+bool IsInRange(uint32_t offset, uint32_t size, uint32_t limit) {
+  return offset <= limit && size <= limit - offset;
+}
+
+}  // namespace
+
+PublicCredentialView::SharedCredential PublicCredentialView::ToCredential()
+    const {
+  // Stores are only written from valid protos, and a store that fails to
+  // parse here is corrupted beyond what Open() checks for.
+  SharedCredential credential;
+  credential.ParseFromArray(credential_.data(), credential_.size());
+  return credential;
+}
+
+void PublicCredentialStore::Builder::Add(const PublicCredentialStore& store) {
+  const IndexEntry* index = store.index();
+  for (uint32_t i = 0; i < store.header().index_count; ++i) {
+    const IndexEntry& entry = index[i];
+    std::vector<PendingRecord>& records = records_[Key(
+        std::string(store.GetString(entry.manager_app_id_offset,
+                                    entry.manager_app_id_size)),
+        std::string(store.GetString(entry.account_name_offset,
+                                    entry.account_name_size)),
+        static_cast<PublicCredentialType>(entry.credential_type))];
+    for (uint32_t j = 0; j < entry.record_count; ++j) {
+      PublicCredentialView view =
+          store.GetView(store.records()[entry.first_record + j]);
+      records.push_back({
+          .identity_type = view.identity_type(),
+          .key_seed = std::string(view.key_seed()),
+          .metadata_encryption_key_tag_v0 =
+              std::string(view.metadata_encryption_key_tag_v0()),
+          .credential = std::string(view.credential()),
+      });
+    }
+  }
+}
+
+void PublicCredentialStore::Builder::Set(
+    absl::string_view manager_app_id, absl::string_view account_name,
+    PublicCredentialType credential_type,
+    absl::Span<const SharedCredential> credentials) {
+  Key key(std::string(manager_app_id), std::string(account_name),
+          credential_type);
+  if (credentials.empty()) {
+    records_.erase(key);
+    return;
+  }
+  std::vector<PendingRecord>& records = records_[key];
+  records.clear();
+  records.reserve(credentials.size());
+  for (const SharedCredential& credential : credentials) {
+    records.push_back({
+        .identity_type = credential.identity_type(),
+        .key_seed = credential.key_seed(),
+        .metadata_encryption_key_tag_v0 =
+            credential.metadata_encryption_key_tag_v0(),
+        .credential = credential.SerializeAsString(),
+    });
+  }
+}
+
+std::string PublicCredentialStore::Builder::Build() const {
+  std::vector<IndexEntry> index;
+  std::vector<Record> records;
+  std::string data;
+  auto add_string = [&data](absl::string_view value) {
+    uint32_t offset = data.size();
+    data.append(value.data(), value.size());
+    return offset;
+  };
+
+  for (const auto& [key, pending_records] : records_) {
+    const auto& [manager_app_id, account_name, credential_type] = key;
+    uint32_t manager_app_id_offset = add_string(manager_app_id);
+    uint32_t account_name_offset = add_string(account_name);
+    // Records of an identity type form one run, in the order they were added.
+    std::vector<const PendingRecord*> sorted;
+    sorted.reserve(pending_records.size());
+    for (const PendingRecord& record : pending_records) {
+      sorted.push_back(&record);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const PendingRecord* a, const PendingRecord* b) {
+                       return a->identity_type < b->identity_type;
+                     });
+    bool is_new_key = true;
+    for (const PendingRecord* record : sorted) {
+      if (is_new_key ||
+          index.back().identity_type !=
+              static_cast<uint32_t>(record->identity_type)) {
+        is_new_key = false;
+        index.push_back({
+            .manager_app_id_offset = manager_app_id_offset,
+            .manager_app_id_size = static_cast<uint32_t>(manager_app_id.size()),
+            .account_name_offset = account_name_offset,
+            .account_name_size = static_cast<uint32_t>(account_name.size()),
+            .credential_type = static_cast<uint32_t>(credential_type),
+            .identity_type = static_cast<uint32_t>(record->identity_type),
+            .first_record = static_cast<uint32_t>(records.size()),
+            .record_count = 0,
+        });
+      }
+      index.back().record_count++;
+      records.push_back({
+          .key_seed_offset = add_string(record->key_seed),
+          .key_seed_size = static_cast<uint32_t>(record->key_seed.size()),
+          .metadata_encryption_key_tag_v0_offset =
+              add_string(record->metadata_encryption_key_tag_v0),
+          .metadata_encryption_key_tag_v0_size = static_cast<uint32_t>(
+              record->metadata_encryption_key_tag_v0.size()),
+          .credential_offset = add_string(record->credential),
+          .credential_size = static_cast<uint32_t>(record->credential.size()),
+          .identity_type = static_cast<uint32_t>(record->identity_type),
+          .reserved = 0,
+      });
+    }
+  }
+
+  Header header = {
+      .magic = kMagic,
+      .version = kVersion,
+      .index_count = static_cast<uint32_t>(index.size()),
+      .record_count = static_cast<uint32_t>(records.size()),
+      .data_size = static_cast<uint32_t>(data.size()),
+      .reserved = 0,
+  };
+  std::string bytes;
+  bytes.reserve(sizeof(Header) + index.size() * sizeof(IndexEntry) +
+                records.size() * sizeof(Record) + data.size());
+  Append(header, bytes);
+  for (const IndexEntry& entry : index) Append(entry, bytes);
+  for (const Record& record : records) Append(record, bytes);
+  bytes.append(data);
+  return bytes;
+}
+
+PublicCredentialStore::PublicCredentialStore()
+    : owned_bytes_(Builder().Build()), bytes_(owned_bytes_) {}
+
+absl::StatusOr<PublicCredentialStore> PublicCredentialStore::Create(
+    std::string bytes) {
+  PublicCredentialStore store;
+  store.owned_bytes_ = std::move(bytes);
+  store.bytes_ = store.owned_bytes_;
+  return OpenInternal(std::move(store));
+}
+
+absl::StatusOr<PublicCredentialStore> PublicCredentialStore::Open(
+    absl::string_view bytes) {
+  return OpenInternal(PublicCredentialStore(bytes));
+}
+
+absl::StatusOr<PublicCredentialStore> PublicCredentialStore::OpenInternal(
+    PublicCredentialStore store) {
+  absl::string_view bytes = store.bytes_;
+  if (reinterpret_cast<uintptr_t>(bytes.data()) % alignof(Header) != 0) {
+    return absl::InvalidArgumentError("Credential store is not aligned");
+  }
+  if (bytes.size() < sizeof(Header)) {
+    return absl::InvalidArgumentError("Credential store is truncated");
+  }
+  const Header& header = store.header();
+  if (header.magic != kMagic) {
+    return absl::InvalidArgumentError("Not a credential store");
+  }
+  if (header.version != kVersion) {
+    return absl::UnimplementedError("Unsupported credential store version");
+  }
+  if (bytes.size() != sizeof(Header) +
+                          uint64_t{header.index_count} * sizeof(IndexEntry) +
+                          uint64_t{header.record_count} * sizeof(Record) +
+                          header.data_size) {
+    return absl::InvalidArgumentError("Credential store has the wrong size");
+  }
+
+  // Checks the offsets once so that lookups don't have to.
+  const IndexEntry* index = store.index();
+  const Record* records = store.records();
+  uint32_t next_record = 0;
+  for (uint32_t i = 0; i < header.index_count; ++i) {
+    const IndexEntry& entry = index[i];
+    if (!IsInRange(entry.manager_app_id_offset, entry.manager_app_id_size,
+                   header.data_size) ||
+        !IsInRange(entry.account_name_offset, entry.account_name_size,
+                   header.data_size) ||
+        entry.first_record != next_record || entry.record_count == 0 ||
+        !IsInRange(entry.first_record, entry.record_count,
+                   header.record_count)) {
+      return absl::InvalidArgumentError("Credential store index is corrupted");
+    }
+    next_record += entry.record_count;
+    if (i > 0) {
+      const IndexEntry& previous = index[i - 1];
+      if (IndexKey(store.GetString(previous.manager_app_id_offset,
+                                   previous.manager_app_id_size),
+                   store.GetString(previous.account_name_offset,
+                                   previous.account_name_size),
+                   previous.credential_type, previous.identity_type) >=
+          IndexKey(store.GetString(entry.manager_app_id_offset,
+                                   entry.manager_app_id_size),
+                   store.GetString(entry.account_name_offset,
+                                   entry.account_name_size),
+                   entry.credential_type, entry.identity_type)) {
+        return absl::InvalidArgumentError("Credential store index is unsorted");
+      }
+    }
+    for (uint32_t j = entry.first_record; j < next_record; ++j) {
+      const Record& record = records[j];
+      if (record.identity_type != entry.identity_type ||
+          !IsInRange(record.key_seed_offset, record.key_seed_size,
+                     header.data_size) ||
+          !IsInRange(record.metadata_encryption_key_tag_v0_offset,
+                     record.metadata_encryption_key_tag_v0_size,
+                     header.data_size) ||
+          !IsInRange(record.credential_offset, record.credential_size,
+                     header.data_size)) {
+        return absl::InvalidArgumentError(
+            "Credential store record is corrupted");
+      }
+    }
+  }
+  if (next_record != header.record_count) {
+    return absl::InvalidArgumentError("Credential store index is corrupted");
+  }
+  return store;
+}
+
+PublicCredentialStore::PublicCredentialStore(
+    const PublicCredentialStore& other)
+    : owned_bytes_(other.owned_bytes_) {
+  Rebind(other);
+}
+
+PublicCredentialStore& PublicCredentialStore::operator=(
+    const PublicCredentialStore& other) {
+  if (this != &other) {
+    owned_bytes_ = other.owned_bytes_;
+    Rebind(other);
+  }
+  return *this;
+}
+
+PublicCredentialStore::PublicCredentialStore(
+    PublicCredentialStore&& other) noexcept
+    : bytes_(other.bytes_) {
+  // Moving a string may move its bytes when they fit in the string itself,
+  // so the view is rebuilt rather than trusted.
+  bool owned = other.bytes_.data() == other.owned_bytes_.data();
+  owned_bytes_ = std::move(other.owned_bytes_);
+  if (owned) bytes_ = owned_bytes_;
+}
+
+PublicCredentialStore& PublicCredentialStore::operator=(
+    PublicCredentialStore&& other) noexcept {
+  if (this != &other) {
+    bool owned = other.bytes_.data() == other.owned_bytes_.data();
+    bytes_ = other.bytes_;
+    owned_bytes_ = std::move(other.owned_bytes_);
+    if (owned) bytes_ = owned_bytes_;
+  }
+  return *this;
+}
+
+void PublicCredentialStore::Rebind(const PublicCredentialStore& other) {
+  if (other.bytes_.data() == other.owned_bytes_.data()) {
+    bytes_ = owned_bytes_;
+  } else {
+    bytes_ = other.bytes_;
+  }
+}
+
+std::vector<PublicCredentialView> PublicCredentialStore::Find(
+    absl::string_view manager_app_id, absl::string_view account_name,
+    PublicCredentialType credential_type, IdentityType identity_type) const {
+  const IndexEntry* begin = index();
+  const IndexEntry* end = begin + header().index_count;
+  auto get_key = [this](const IndexEntry& entry) {
+    return IndexKey(
+        GetString(entry.manager_app_id_offset, entry.manager_app_id_size),
+        GetString(entry.account_name_offset, entry.account_name_size),
+        entry.credential_type, entry.identity_type);
+  };
+  // IDENTITY_TYPE_UNSPECIFIED is 0, so it also finds the first entry of the
+  // key when it asks for any identity type.
+  IndexKey key(manager_app_id, account_name,
+               static_cast<uint32_t>(credential_type),
+               static_cast<uint32_t>(identity_type));
+  const IndexEntry* it = std::lower_bound(
+      begin, end, key, [&get_key](const IndexEntry& entry, const IndexKey& key) {
+        return get_key(entry) < key;
+      });
+
+  std::vector<PublicCredentialView> views;
+  for (; it != end; ++it) {
+    IndexKey entry_key = get_key(*it);
+    if (std::get<0>(entry_key) != manager_app_id ||
+        std::get<1>(entry_key) != account_name ||
+        std::get<2>(entry_key) != std::get<2>(key)) {
+      break;
+    }
+    if (identity_type != IdentityType::IDENTITY_TYPE_UNSPECIFIED &&
+        std::get<3>(entry_key) != std::get<3>(key)) {
+      break;
+    }
+    views.reserve(views.size() + it->record_count);
+    for (uint32_t i = 0; i < it->record_count; ++i) {
+      views.push_back(GetView(records()[it->first_record + i]));
+    }
+  }
+  return views;
+}
+
+uint32_t PublicCredentialStore::size() const { return header().record_count; }
+
+const PublicCredentialStore::Header& PublicCredentialStore::header() const {
+  return *reinterpret_cast<const Header*>(bytes_.data());
+}
+
+const PublicCredentialStore::IndexEntry* PublicCredentialStore::index() const {
+  return reinterpret_cast<const IndexEntry*>(bytes_.data() + sizeof(Header));
+}
+
+const PublicCredentialStore::Record* PublicCredentialStore::records() const {
+  return reinterpret_cast<const Record*>(index() + header().index_count);
+}
+
+absl::string_view PublicCredentialStore::data() const {
+  return bytes_.substr(bytes_.size() - header().data_size);
+}
+
+absl::string_view PublicCredentialStore::GetString(uint32_t offset,
+                                                   uint32_t size) const {
+  return data().substr(offset, size);
+}
+
+PublicCredentialView PublicCredentialStore::GetView(
+    const Record& record) const {
+  PublicCredentialView view;
+  view.key_seed_ = GetString(record.key_seed_offset, record.key_seed_size);
+  view.metadata_encryption_key_tag_v0_ =
+      GetString(record.metadata_encryption_key_tag_v0_offset,
+                record.metadata_encryption_key_tag_v0_size);
+  view.credential_ =
+      GetString(record.credential_offset, record.credential_size);
+  view.identity_type_ = static_cast<IdentityType>(record.identity_type);
+  return view;
+}
+
+}  // namespace shared
+}  // namespace nearby
@@ -0,0 +1,160 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PLATFORM_IMPL_SHARED_CREDENTIAL_STORE_H_
+#define PLATFORM_IMPL_SHARED_CREDENTIAL_STORE_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "internal/platform/implementation/credential_callbacks.h"
+#include "internal/proto/credential.pb.h"
+
+namespace nearby {
+namespace shared {
+
+// Public credentials of a store, read in place. A view is valid as long as
+// the bytes of its store are.
+class PublicCredentialView {
+ public:
+  using IdentityType = ::nearby::internal::IdentityType;
+  using SharedCredential = ::nearby::internal::SharedCredential;
+
+  absl::string_view key_seed() const { return key_seed_; }
+  absl::string_view metadata_encryption_key_tag_v0() const {
+    return metadata_encryption_key_tag_v0_;
+  }
+  IdentityType identity_type() const { return identity_type_; }
+  // The serialized `SharedCredential`.
+  absl::string_view credential() const { return credential_; }
+
+  // Parses the full credential. Only needed by callers that use more than the
+  // fields above.
+  SharedCredential ToCredential() const;
+
+ private:
+  friend class PublicCredentialStore;
+
+  absl::string_view key_seed_;
+  absl::string_view metadata_encryption_key_tag_v0_;
+  absl::string_view credential_;
+  IdentityType identity_type_;
+};
+
+// A compact, read-only collection of public credentials, laid out so that it
+// can be used straight from a memory mapped file. Opening a store checks its
+// layout but parses no protos, and lookups by manager app, account,
+// credential type and identity type are binary searches over its index.
+//
+// The layout, in host byte order and with 4 byte alignment:
+//
+//   Header   magic, version, index and record counts, size of the data
+//   Index    one entry per (manager app, account, credential type,
+//            identity type), sorted, each pointing at a run of records
+//   Records  fixed size, offsets of the key seed, the tag and the serialized
+//            credential in the data
+//   Data     the bytes of the strings above
+//
+// Stores stay on the device that wrote them; a store of another byte order
+// fails the magic check like any other foreign file.
+class PublicCredentialStore {
+ public:
+  using IdentityType = ::nearby::internal::IdentityType;
+  using SharedCredential = ::nearby::internal::SharedCredential;
+  using PublicCredentialType = ::nearby::presence::PublicCredentialType;
+
+  // Collects credentials and writes them out as a store.
+  class Builder {
+   public:
+    // Copies every credential of `store`, without parsing them.
+    void Add(const PublicCredentialStore& store);
+    // Replaces the credentials of the given manager app, account and type.
+    // This is also how credentials kept as protos migrate to a store.
+    void Set(absl::string_view manager_app_id, absl::string_view account_name,
+             PublicCredentialType credential_type,
+             absl::Span<const SharedCredential> credentials);
+    // Returns the bytes of the store.
+    std::string Build() const;
+
+   private:
+    struct PendingRecord {
+      IdentityType identity_type;
+      std::string key_seed;
+      std::string metadata_encryption_key_tag_v0;
+      std::string credential;
+    };
+    using Key = std::tuple<std::string, std::string, PublicCredentialType>;
+
+    std::map<Key, std::vector<PendingRecord>> records_;
+  };
+
+  // An empty store.
+  PublicCredentialStore();
+
+  // Opens a store that owns its bytes.
+  static absl::StatusOr<PublicCredentialStore> Create(std::string bytes);
+  // Opens a store over bytes owned by the caller, e.g. a mapped file, which
+  // must outlive it and all its views. `bytes` must be 4 byte aligned.
+  static absl::StatusOr<PublicCredentialStore> Open(absl::string_view bytes);
+
+  PublicCredentialStore(const PublicCredentialStore& other);
+  PublicCredentialStore& operator=(const PublicCredentialStore& other);
+  PublicCredentialStore(PublicCredentialStore&& other) noexcept;
+  PublicCredentialStore& operator=(PublicCredentialStore&& other) noexcept;
+
+  // Returns the credentials of the given manager app, account and type,
+  // grouped by identity type. `IDENTITY_TYPE_UNSPECIFIED` matches any.
+  std::vector<PublicCredentialView> Find(absl::string_view manager_app_id,
+                                         absl::string_view account_name,
+                                         PublicCredentialType credential_type,
+                                         IdentityType identity_type) const;
+
+  // Returns the total number of credentials.
+  uint32_t size() const;
+  bool empty() const { return size() == 0; }
+  absl::string_view bytes() const { return bytes_; }
+
+ private:
+  struct Header;
+  struct IndexEntry;
+  struct Record;
+
+  explicit PublicCredentialStore(absl::string_view bytes) : bytes_(bytes) {}
+
+  static absl::StatusOr<PublicCredentialStore> OpenInternal(
+      PublicCredentialStore store);
+
+  const Header& header() const;
+  const IndexEntry* index() const;
+  const Record* records() const;
+  absl::string_view data() const;
+  absl::string_view GetString(uint32_t offset, uint32_t size) const;
+  PublicCredentialView GetView(const Record& record) const;
+  // Rebinds `bytes_` to `owned_bytes_` after the latter moved or got copied.
+  void Rebind(const PublicCredentialStore& other);
+
+  std::string owned_bytes_;
+  absl::string_view bytes_;
+};
+
+}  // namespace shared
+}  // namespace nearby
+
+#endif  // PLATFORM_IMPL_SHARED_CREDENTIAL_STORE_H_
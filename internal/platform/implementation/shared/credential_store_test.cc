@@ -0,0 +1,290 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/platform/implementation/shared/credential_store.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "protobuf-matchers/protocol-buffer-matchers.h"
+#include "gtest/gtest.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "internal/platform/implementation/credential_callbacks.h"
+#include "internal/proto/credential.pb.h"
+
+namespace nearby {
+namespace shared {
+namespace {
+
+using ::nearby::internal::IdentityType;
+using ::nearby::internal::SharedCredential;
+using ::nearby::presence::PublicCredentialType;
+using ::protobuf_matchers::EqualsProto;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::UnorderedElementsAreArray;
+
+constexpr absl::string_view kManagerAppId = "manager app id";
+constexpr absl::string_view kAccountName = "test_account";
+constexpr int kManyCredentials = 10000;
+
+SharedCredential CreateCredential(absl::string_view secret_id,
+                                  IdentityType identity_type) {
+  SharedCredential credential;
+  credential.set_secret_id(secret_id);
+  credential.set_key_seed(absl::StrCat("key seed of ", secret_id));
+  credential.set_metadata_encryption_key_tag_v0(
+      absl::StrCat("tag of ", secret_id));
+  credential.set_encrypted_metadata_bytes_v0(std::string(64, 'm'));
+  credential.set_start_time_millis(1000);
+  credential.set_end_time_millis(2000);
+  credential.set_identity_type(identity_type);
+  return credential;
+}
+
+std::vector<std::string> GetSecretIds(
+    const std::vector<PublicCredentialView>& views) {
+  std::vector<std::string> secret_ids;
+  for (const PublicCredentialView& view : views) {
+    secret_ids.push_back(view.ToCredential().secret_id());
+  }
+  return secret_ids;
+}
+
+PublicCredentialStore BuildStore(
+    const std::vector<SharedCredential>& credentials) {
+  PublicCredentialStore::Builder builder;
+  builder.Set(kManagerAppId, kAccountName,
+              PublicCredentialType::kRemotePublicCredential, credentials);
+  absl::StatusOr<PublicCredentialStore> store =
+      PublicCredentialStore::Create(builder.Build());
+  EXPECT_TRUE(store.ok()) << store.status();
+  return *std::move(store);
+}
+
+TEST(PublicCredentialStoreTest, EmptyStore) {
+  PublicCredentialStore store;
+
+  EXPECT_TRUE(store.empty());
+  EXPECT_THAT(store.Find(kManagerAppId, kAccountName,
+                         PublicCredentialType::kRemotePublicCredential,
+                         IdentityType::IDENTITY_TYPE_UNSPECIFIED),
+              IsEmpty());
+  EXPECT_TRUE(PublicCredentialStore::Create(std::string(store.bytes())).ok());
+}
+
+TEST(PublicCredentialStoreTest, MigratesCredentials) {
+  SharedCredential credential =
+      CreateCredential("a", IdentityType::IDENTITY_TYPE_PRIVATE);
+  PublicCredentialStore store = BuildStore({credential});
+
+  std::vector<PublicCredentialView> views = store.Find(
+      kManagerAppId, kAccountName,
+      PublicCredentialType::kRemotePublicCredential,
+      IdentityType::IDENTITY_TYPE_PRIVATE);
+
+  ASSERT_EQ(views.size(), 1);
+  EXPECT_EQ(views[0].key_seed(), credential.key_seed());
+  EXPECT_EQ(views[0].metadata_encryption_key_tag_v0(),
+            credential.metadata_encryption_key_tag_v0());
+  EXPECT_EQ(views[0].identity_type(), IdentityType::IDENTITY_TYPE_PRIVATE);
+  EXPECT_THAT(views[0].ToCredential(), EqualsProto(credential));
+}
+
+TEST(PublicCredentialStoreTest, FindsByIdentityType) {
+  PublicCredentialStore store =
+      BuildStore({CreateCredential("a", IdentityType::IDENTITY_TYPE_TRUSTED),
+                  CreateCredential("b", IdentityType::IDENTITY_TYPE_PRIVATE),
+                  CreateCredential("c", IdentityType::IDENTITY_TYPE_TRUSTED)});
+
+  EXPECT_THAT(GetSecretIds(store.Find(
+                  kManagerAppId, kAccountName,
+                  PublicCredentialType::kRemotePublicCredential,
+                  IdentityType::IDENTITY_TYPE_TRUSTED)),
+              ElementsAre("a", "c"));
+  EXPECT_THAT(GetSecretIds(store.Find(
+                  kManagerAppId, kAccountName,
+                  PublicCredentialType::kRemotePublicCredential,
+                  IdentityType::IDENTITY_TYPE_UNSPECIFIED)),
+              ElementsAre("b", "a", "c"));
+  EXPECT_THAT(store.Find(kManagerAppId, kAccountName,
+                         PublicCredentialType::kRemotePublicCredential,
+                         IdentityType::IDENTITY_TYPE_PUBLIC),
+              IsEmpty());
+}
+
+TEST(PublicCredentialStoreTest, FindsByManagerAppAndAccount) {
+  PublicCredentialStore::Builder builder;
+  builder.Set("app 1", kAccountName,
+              PublicCredentialType::kRemotePublicCredential,
+              {CreateCredential("a", IdentityType::IDENTITY_TYPE_PRIVATE)});
+  builder.Set("app 2", kAccountName,
+              PublicCredentialType::kRemotePublicCredential,
+              {CreateCredential("b", IdentityType::IDENTITY_TYPE_PRIVATE)});
+  builder.Set("app 2", kAccountName,
+              PublicCredentialType::kLocalPublicCredential,
+              {CreateCredential("c", IdentityType::IDENTITY_TYPE_PRIVATE)});
+  builder.Set("app 2", "other account",
+              PublicCredentialType::kRemotePublicCredential,
+              {CreateCredential("d", IdentityType::IDENTITY_TYPE_PRIVATE)});
+  absl::StatusOr<PublicCredentialStore> store =
+      PublicCredentialStore::Create(builder.Build());
+  ASSERT_TRUE(store.ok());
+
+  EXPECT_EQ(store->size(), 4);
+  EXPECT_THAT(GetSecretIds(store->Find(
+                  "app 2", kAccountName,
+                  PublicCredentialType::kRemotePublicCredential,
+                  IdentityType::IDENTITY_TYPE_UNSPECIFIED)),
+              ElementsAre("b"));
+  EXPECT_THAT(GetSecretIds(store->Find(
+                  "app 2", kAccountName,
+                  PublicCredentialType::kLocalPublicCredential,
+                  IdentityType::IDENTITY_TYPE_PRIVATE)),
+              ElementsAre("c"));
+  EXPECT_THAT(store->Find("app 3", kAccountName,
+                          PublicCredentialType::kRemotePublicCredential,
+                          IdentityType::IDENTITY_TYPE_UNSPECIFIED),
+              IsEmpty());
+}
+
+TEST(PublicCredentialStoreTest, RebuildsFromStore) {
+  PublicCredentialStore::Builder builder;
+  builder.Set("app 1", kAccountName,
+              PublicCredentialType::kRemotePublicCredential,
+              {CreateCredential("a", IdentityType::IDENTITY_TYPE_PRIVATE)});
+  builder.Set("app 2", kAccountName,
+              PublicCredentialType::kRemotePublicCredential,
+              {CreateCredential("b", IdentityType::IDENTITY_TYPE_PRIVATE)});
+  absl::StatusOr<PublicCredentialStore> store =
+      PublicCredentialStore::Create(builder.Build());
+  ASSERT_TRUE(store.ok());
+
+  PublicCredentialStore::Builder rebuilder;
+  rebuilder.Add(*store);
+  rebuilder.Set("app 1", kAccountName,
+                PublicCredentialType::kRemotePublicCredential,
+                {CreateCredential("c", IdentityType::IDENTITY_TYPE_TRUSTED)});
+  absl::StatusOr<PublicCredentialStore> rebuilt =
+      PublicCredentialStore::Create(rebuilder.Build());
+  ASSERT_TRUE(rebuilt.ok());
+
+  EXPECT_THAT(GetSecretIds(rebuilt->Find(
+                  "app 1", kAccountName,
+                  PublicCredentialType::kRemotePublicCredential,
+                  IdentityType::IDENTITY_TYPE_UNSPECIFIED)),
+              ElementsAre("c"));
+  EXPECT_THAT(GetSecretIds(rebuilt->Find(
+                  "app 2", kAccountName,
+                  PublicCredentialType::kRemotePublicCredential,
+                  IdentityType::IDENTITY_TYPE_UNSPECIFIED)),
+              ElementsAre("b"));
+}
+
+TEST(PublicCredentialStoreTest, OpensBytesInPlace) {
+  PublicCredentialStore owned = BuildStore(
+      {CreateCredential("a", IdentityType::IDENTITY_TYPE_PRIVATE)});
+
+  absl::StatusOr<PublicCredentialStore> store =
+      PublicCredentialStore::Open(owned.bytes());
+  ASSERT_TRUE(store.ok());
+  std::vector<PublicCredentialView> views =
+      store->Find(kManagerAppId, kAccountName,
+                  PublicCredentialType::kRemotePublicCredential,
+                  IdentityType::IDENTITY_TYPE_PRIVATE);
+
+  ASSERT_EQ(views.size(), 1);
+  // Views point into the bytes the store was opened on.
+  EXPECT_GE(views[0].key_seed().data(), owned.bytes().data());
+  EXPECT_LT(views[0].key_seed().data(),
+            owned.bytes().data() + owned.bytes().size());
+}
+
+TEST(PublicCredentialStoreTest, ViewsSurviveMove) {
+  PublicCredentialStore store =
+      BuildStore({CreateCredential("a", IdentityType::IDENTITY_TYPE_PRIVATE)});
+  PublicCredentialStore copy = store;
+  PublicCredentialStore moved = std::move(store);
+
+  EXPECT_THAT(GetSecretIds(copy.Find(
+                  kManagerAppId, kAccountName,
+                  PublicCredentialType::kRemotePublicCredential,
+                  IdentityType::IDENTITY_TYPE_UNSPECIFIED)),
+              ElementsAre("a"));
+  EXPECT_THAT(GetSecretIds(moved.Find(
+                  kManagerAppId, kAccountName,
+                  PublicCredentialType::kRemotePublicCredential,
+                  IdentityType::IDENTITY_TYPE_UNSPECIFIED)),
+              ElementsAre("a"));
+}
+
+TEST(PublicCredentialStoreTest, RejectsCorruptedBytes) {
+  std::string bytes = std::string(
+      BuildStore({CreateCredential("a", IdentityType::IDENTITY_TYPE_PRIVATE)})
+          .bytes());
+
+  // Credentials saved as a serialized proto are not a store.
+  EXPECT_FALSE(PublicCredentialStore::Create(
+                   CreateCredential("a", IdentityType::IDENTITY_TYPE_PRIVATE)
+                       .SerializeAsString())
+                   .ok());
+  EXPECT_FALSE(PublicCredentialStore::Create("").ok());
+  EXPECT_FALSE(
+      PublicCredentialStore::Create(bytes.substr(0, bytes.size() - 1)).ok());
+  std::string bad_version = bytes;
+  bad_version[4] = 2;
+  EXPECT_FALSE(PublicCredentialStore::Create(bad_version).ok());
+  // The first record count of the index.
+  std::string bad_index = bytes;
+  bad_index[24 + 28] = 2;
+  EXPECT_FALSE(PublicCredentialStore::Create(bad_index).ok());
+  // The key seed size of the first record.
+  std::string bad_record = bytes;
+  bad_record[24 + 32 + 5] = 1;
+  EXPECT_FALSE(PublicCredentialStore::Create(bad_record).ok());
+}
+
+TEST(PublicCredentialStoreTest, FindsAmongManyCredentials) {
+  std::vector<SharedCredential> credentials;
+  std::vector<std::string> private_secret_ids;
+  for (int i = 0; i < kManyCredentials; ++i) {
+    IdentityType identity_type = i % 2 == 0
+                                     ? IdentityType::IDENTITY_TYPE_PRIVATE
+                                     : IdentityType::IDENTITY_TYPE_TRUSTED;
+    credentials.push_back(
+        CreateCredential(absl::StrCat("secret ", i), identity_type));
+    if (identity_type == IdentityType::IDENTITY_TYPE_PRIVATE) {
+      private_secret_ids.push_back(absl::StrCat("secret ", i));
+    }
+  }
+  std::string bytes = std::string(BuildStore(credentials).bytes());
+
+  absl::StatusOr<PublicCredentialStore> store =
+      PublicCredentialStore::Open(bytes);
+  ASSERT_TRUE(store.ok());
+
+  EXPECT_THAT(GetSecretIds(store->Find(
+                  kManagerAppId, kAccountName,
+                  PublicCredentialType::kRemotePublicCredential,
+                  IdentityType::IDENTITY_TYPE_PRIVATE)),
+              UnorderedElementsAreArray(private_secret_ids));
+}
+
+}  // namespace
+}  // namespace shared
+}  // namespace nearby
@@ -17,9 +17,11 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <utility>
 
 #include "internal/platform/byte_array.h"
+#include "internal/platform/byte_buffer_pool.h"
 #include "internal/platform/exception.h"
 
 namespace nearby {
@@ -27,6 +29,10 @@ namespace {
 constexpr size_t kSkipBufferSize = 64 * 1024;
 }  // namespace
 
+ExceptionOr<ByteArray> InputStream::ReadAvailable(std::int64_t size) {
+  return Read(size);
+}
+
 ExceptionOr<size_t> InputStream::Skip(size_t offset) {
   size_t bytes_left = offset;
   while (bytes_left > 0) {
@@ -45,7 +51,8 @@ ExceptionOr<size_t> InputStream::Skip(size_t offset) {
 }
 
 ExceptionOr<ByteArray> InputStream::ReadExactly(std::size_t size) {
-  ByteArray buffer;
+  ByteBufferPool& pool = ByteBufferPool::GetInstance();
+  PooledByteBuffer buffer;
   std::size_t current_pos = 0;
 
   while (current_pos < size) {
@@ -53,7 +60,7 @@ ExceptionOr<ByteArray> InputStream::ReadExactly(std::size_t size) {
     if (!read_bytes.ok()) {
       return read_bytes;
     }
-    const ByteArray& result = read_bytes.result();
+    ByteArray& result = read_bytes.result();
 
     if (result.Empty()) {
       return ExceptionOr<ByteArray>(Exception::kIo);
@@ -65,13 +72,16 @@ ExceptionOr<ByteArray> InputStream::ReadExactly(std::size_t size) {
         return read_bytes;
       } else {
         // Reserve space for in the buffer.
-        buffer.SetData(size);
+        buffer = pool.Acquire(size);
       }
     }
-    buffer.CopyAt(current_pos, result);
+    std::memcpy(buffer.data() + current_pos, result.data(),
+                std::min(result.size(), size - current_pos));
     current_pos += result.size();
+    // The partial read is only needed until it's copied.
+    pool.Release(std::move(result));
   }
 
-  return ExceptionOr<ByteArray>(std::move(buffer));
+  return ExceptionOr<ByteArray>(std::move(buffer).ToByteArray());
 }
 }  // namespace nearby
@@ -33,6 +33,11 @@ class InputStream {
   // Returns an empty byte array on end of file, or Exception::kIo on error.
   virtual ExceptionOr<ByteArray> Read(std::int64_t size) = 0;
 
+  // Reads at most `size` bytes, returning as soon as any bytes are available
+  // rather than waiting to fill `size`. Streams whose Read() waits for the
+  // full amount override this; by default it is Read().
+  virtual ExceptionOr<ByteArray> ReadAvailable(std::int64_t size);
+
   // Skips `offset` bytes from the stream.
   // Returns the number of bytes skipped, which can be less than offset on EOF,
   // or Exception::kIo on error.
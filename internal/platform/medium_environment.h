@@ -61,6 +61,9 @@ struct EnvironmentConfig {
   // The simulated clock is automatically picked up by SystemClock, Timer and
   // ScheduledExecutor implementations.
   bool use_simulated_clock = false;
+
+  // Control whether BLE v2 mediums support extended advertisements.
+  bool ble_extended_advertisements_enabled = false;
 };
 
 // MediumEnvironment is a simulated environment which allows multiple instances
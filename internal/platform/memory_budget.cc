@@ -0,0 +1,119 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/platform/memory_budget.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace nearby {
+
+MemoryBudget::Charge::Charge(Charge&& other)
+    : budget_(other.budget_),
+      subsystem_(other.subsystem_),
+      size_(std::exchange(other.size_, 0)) {}
+
+MemoryBudget::Charge& MemoryBudget::Charge::operator=(Charge&& other) {
+  if (this != &other) {
+    Release(size_);
+    budget_ = other.budget_;
+    subsystem_ = other.subsystem_;
+    size_ = std::exchange(other.size_, 0);
+  }
+  return *this;
+}
+
+void MemoryBudget::Charge::Absorb(Charge&& other) {
+  if (other.size_ == 0) return;
+  if (size_ == 0) {
+    *this = std::move(other);
+    return;
+  }
+  size_ += std::exchange(other.size_, 0);
+}
+
+void MemoryBudget::Charge::Release(std::int64_t size) {
+  size = std::min(size, size_);
+  if (size <= 0) return;
+  size_ -= size;
+  budget_->Release(subsystem_, size);
+}
+
+MemoryBudget& MemoryBudget::GetInstance() {
+  static MemoryBudget* budget = new MemoryBudget();
+  return *budget;
+}
+
+void MemoryBudget::SetLimit(std::int64_t limit) {
+  absl::MutexLock lock(&mutex_);
+  stats_.limit = std::max<std::int64_t>(limit, 0);
+}
+
+std::optional<MemoryBudget::Charge> MemoryBudget::Reserve(
+    Subsystem subsystem, std::int64_t size, absl::Duration timeout) {
+  size = std::max<std::int64_t>(size, 0);
+  absl::MutexLock lock(&mutex_);
+  if (!AwaitFits(size, timeout)) return std::nullopt;
+  AddLocked(subsystem, size);
+  return Charge(this, subsystem, size);
+}
+
+MemoryBudget::Charge MemoryBudget::ChargeUnconditionally(Subsystem subsystem,
+                                                         std::int64_t size) {
+  size = std::max<std::int64_t>(size, 0);
+  absl::MutexLock lock(&mutex_);
+  AddLocked(subsystem, size);
+  return Charge(this, subsystem, size);
+}
+
+MemoryBudget::Stats MemoryBudget::GetStats() const {
+  absl::MutexLock lock(&mutex_);
+  return stats_;
+}
+
+bool MemoryBudget::Fits(std::int64_t size) const {
+  return stats_.limit == 0 || stats_.in_use == 0 ||
+         stats_.in_use + size <= stats_.limit;
+}
+
+bool MemoryBudget::AwaitFits(std::int64_t size, absl::Duration timeout) {
+  if (Fits(size)) return true;
+  ++stats_.waits;
+  auto fits = [this, size]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return Fits(size);
+  };
+  return mutex_.AwaitWithTimeout(absl::Condition(&fits), timeout);
+}
+
+void MemoryBudget::AddLocked(Subsystem subsystem, std::int64_t size) {
+  SubsystemStats& subsystem_stats =
+      stats_.subsystems[static_cast<int>(subsystem)];
+  subsystem_stats.in_use += size;
+  subsystem_stats.peak = std::max(subsystem_stats.peak, subsystem_stats.in_use);
+  stats_.in_use += size;
+  stats_.peak = std::max(stats_.peak, stats_.in_use);
+}
+
+void MemoryBudget::Release(Subsystem subsystem, std::int64_t size) {
+  absl::MutexLock lock(&mutex_);
+  stats_.subsystems[static_cast<int>(subsystem)].in_use -= size;
+  stats_.in_use -= size;
+}
+
+}  // namespace nearby
@@ -0,0 +1,127 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PLATFORM_BASE_MEMORY_BUDGET_H_
+#define PLATFORM_BASE_MEMORY_BUDGET_H_
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace nearby {
+
+// A process-wide cap on the memory held by in-flight payload data.
+//
+// Subsystems that buffer large amounts of data charge it against the budget.
+// Those that can wait for memory reserve it first, and are paused while the
+// budget is spent; data that is already in memory is charged as is, and only
+// counted. Without a limit, charges are counted but never wait.
+class MemoryBudget {
+ public:
+  enum class Subsystem {
+    // Data written to a pipe and not read yet.
+    kPipes = 0,
+    // BYTES payloads being sent or received.
+    kPayloads = 1,
+    // Outgoing payload chunks, from being read until they're written out.
+    kOutgoingChunks = 2,
+  };
+  static constexpr int kNumSubsystems = 3;
+
+  struct SubsystemStats {
+    std::int64_t in_use = 0;
+    std::int64_t peak = 0;
+  };
+
+  struct Stats {
+    // 0 if there is no limit.
+    std::int64_t limit = 0;
+    std::int64_t in_use = 0;
+    std::int64_t peak = 0;
+    // Times a reservation had to wait for memory.
+    std::int64_t waits = 0;
+    std::array<SubsystemStats, kNumSubsystems> subsystems;
+  };
+
+  // Memory charged to a subsystem. Move-only; goes back to the budget when
+  // destroyed.
+  class Charge {
+   public:
+    Charge() = default;
+    Charge(const Charge&) = delete;
+    Charge& operator=(const Charge&) = delete;
+    Charge(Charge&& other);
+    Charge& operator=(Charge&& other);
+    ~Charge() { Release(size_); }
+
+    std::int64_t size() const { return size_; }
+
+    // Adds `other` to this charge. Both must be charged to the same budget and
+    // subsystem, or `other` must be empty.
+    void Absorb(Charge&& other);
+
+    // Returns up to `size` bytes of this charge to the budget.
+    void Release(std::int64_t size);
+
+   private:
+    friend class MemoryBudget;
+    Charge(MemoryBudget* budget, Subsystem subsystem, std::int64_t size)
+        : budget_(budget), subsystem_(subsystem), size_(size) {}
+
+    MemoryBudget* budget_ = nullptr;
+    Subsystem subsystem_ = Subsystem::kPipes;
+    std::int64_t size_ = 0;
+  };
+
+  static MemoryBudget& GetInstance();
+
+  MemoryBudget() = default;
+  MemoryBudget(const MemoryBudget&) = delete;
+  MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+  // Sets the most memory reservations may take up, or 0 for no limit.
+  void SetLimit(std::int64_t limit);
+
+  // Waits up to `timeout` for `size` bytes to fit under the limit, and charges
+  // them to `subsystem`. Returns std::nullopt if they didn't fit in time. A
+  // request larger than the whole limit is granted once nothing else is
+  // charged.
+  std::optional<Charge> Reserve(Subsystem subsystem, std::int64_t size,
+                                absl::Duration timeout);
+
+  // Charges `size` bytes that are already in memory to `subsystem`, whether or
+  // not they fit under the limit.
+  Charge ChargeUnconditionally(Subsystem subsystem, std::int64_t size);
+
+  Stats GetStats() const;
+
+ private:
+  bool Fits(std::int64_t size) const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  bool AwaitFits(std::int64_t size, absl::Duration timeout)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void AddLocked(Subsystem subsystem, std::int64_t size)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void Release(Subsystem subsystem, std::int64_t size);
+
+  mutable absl::Mutex mutex_;
+  Stats stats_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace nearby
+
+#endif  // PLATFORM_BASE_MEMORY_BUDGET_H_
@@ -0,0 +1,191 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/platform/memory_budget.h"
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace nearby {
+namespace {
+
+using Subsystem = MemoryBudget::Subsystem;
+
+constexpr absl::Duration kNoWait = absl::ZeroDuration();
+
+std::int64_t GetInUse(const MemoryBudget& budget, Subsystem subsystem) {
+  return budget.GetStats().subsystems[static_cast<int>(subsystem)].in_use;
+}
+
+TEST(MemoryBudgetTest, ChargesAreCountedPerSubsystem) {
+  MemoryBudget budget;
+
+  MemoryBudget::Charge pipes =
+      budget.ChargeUnconditionally(Subsystem::kPipes, 100);
+  MemoryBudget::Charge payloads =
+      budget.ChargeUnconditionally(Subsystem::kPayloads, 30);
+
+  MemoryBudget::Stats stats = budget.GetStats();
+  EXPECT_EQ(stats.in_use, 130);
+  EXPECT_EQ(GetInUse(budget, Subsystem::kPipes), 100);
+  EXPECT_EQ(GetInUse(budget, Subsystem::kPayloads), 30);
+  EXPECT_EQ(GetInUse(budget, Subsystem::kOutgoingChunks), 0);
+}
+
+TEST(MemoryBudgetTest, ChargeIsReturnedWhenDestroyed) {
+  MemoryBudget budget;
+
+  {
+    MemoryBudget::Charge charge =
+        budget.ChargeUnconditionally(Subsystem::kPipes, 100);
+    MemoryBudget::Charge moved = std::move(charge);
+    EXPECT_EQ(budget.GetStats().in_use, 100);
+  }
+
+  MemoryBudget::Stats stats = budget.GetStats();
+  EXPECT_EQ(stats.in_use, 0);
+  EXPECT_EQ(stats.peak, 100);
+}
+
+TEST(MemoryBudgetTest, ChargeCanBeReleasedInParts) {
+  MemoryBudget budget;
+  MemoryBudget::Charge charge =
+      budget.ChargeUnconditionally(Subsystem::kPipes, 100);
+  charge.Absorb(budget.ChargeUnconditionally(Subsystem::kPipes, 50));
+
+  charge.Release(120);
+
+  EXPECT_EQ(charge.size(), 30);
+  EXPECT_EQ(budget.GetStats().in_use, 30);
+}
+
+TEST(MemoryBudgetTest, ReserveNeverWaitsWithoutLimit) {
+  MemoryBudget budget;
+
+  std::optional<MemoryBudget::Charge> charge =
+      budget.Reserve(Subsystem::kPipes, 1 << 30, kNoWait);
+
+  ASSERT_TRUE(charge.has_value());
+  EXPECT_EQ(charge->size(), 1 << 30);
+  EXPECT_EQ(budget.GetStats().waits, 0);
+}
+
+TEST(MemoryBudgetTest, ReserveFailsWhenLimitIsReached) {
+  MemoryBudget budget;
+  budget.SetLimit(100);
+  MemoryBudget::Charge charge =
+      budget.ChargeUnconditionally(Subsystem::kPayloads, 80);
+
+  EXPECT_FALSE(budget.Reserve(Subsystem::kPipes, 30, kNoWait).has_value());
+  EXPECT_TRUE(budget.Reserve(Subsystem::kPipes, 20, kNoWait).has_value());
+  EXPECT_EQ(budget.GetStats().waits, 1);
+}
+
+TEST(MemoryBudgetTest, ReserveLargerThanLimitIsGrantedAlone) {
+  MemoryBudget budget;
+  budget.SetLimit(100);
+
+  std::optional<MemoryBudget::Charge> charge =
+      budget.Reserve(Subsystem::kPipes, 500, kNoWait);
+
+  ASSERT_TRUE(charge.has_value());
+  EXPECT_FALSE(budget.Reserve(Subsystem::kPipes, 1, kNoWait).has_value());
+}
+
+TEST(MemoryBudgetTest, ReserveWaitsForRelease) {
+  MemoryBudget budget;
+  budget.SetLimit(100);
+  MemoryBudget::Charge charge =
+      budget.ChargeUnconditionally(Subsystem::kPayloads, 100);
+
+  std::thread releaser([&charge]() {
+    absl::SleepFor(absl::Milliseconds(100));
+    charge.Release(50);
+  });
+  std::optional<MemoryBudget::Charge> reserved =
+      budget.Reserve(Subsystem::kPipes, 50, absl::Seconds(10));
+  releaser.join();
+
+  EXPECT_TRUE(reserved.has_value());
+  EXPECT_EQ(budget.GetStats().in_use, 100);
+}
+
+TEST(MemoryBudgetTest, StressReservationsStayWithinLimit) {
+  constexpr std::int64_t kLimit = 256 * 1024;
+  constexpr int kProducers = 6;
+  constexpr int kConsumers = 2;
+  constexpr int kReservationsPerProducer = 2000;
+  MemoryBudget budget;
+  budget.SetLimit(kLimit);
+
+  // Producers reserve memory and hand it to consumers, which free it. Like a
+  // pipe, nothing waits for memory while holding some.
+  absl::Mutex mutex;
+  std::deque<MemoryBudget::Charge> charges;
+  int producers_left = kProducers;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kProducers; ++i) {
+    threads.emplace_back([&, i]() {
+      std::uint32_t seed = i + 1;
+      for (int j = 0; j < kReservationsPerProducer; ++j) {
+        seed = seed * 1103515245 + 12345;
+        std::int64_t size = 1 + (seed >> 8) % (64 * 1024);
+        std::optional<MemoryBudget::Charge> charge =
+            budget.Reserve(Subsystem::kOutgoingChunks, size, absl::Seconds(10));
+        EXPECT_TRUE(charge.has_value());
+        if (!charge.has_value()) break;
+        absl::MutexLock lock(&mutex);
+        charges.push_back(std::move(*charge));
+      }
+      absl::MutexLock lock(&mutex);
+      --producers_left;
+    });
+  }
+  for (int i = 0; i < kConsumers; ++i) {
+    threads.emplace_back([&]() {
+      while (true) {
+        MemoryBudget::Charge charge;
+        {
+          absl::MutexLock lock(&mutex);
+          auto ready = [&]() {
+            return !charges.empty() || producers_left == 0;
+          };
+          mutex.Await(absl::Condition(&ready));
+          if (charges.empty()) return;
+          charge = std::move(charges.front());
+          charges.pop_front();
+        }
+        absl::SleepFor(absl::Microseconds(20));
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  MemoryBudget::Stats stats = budget.GetStats();
+  EXPECT_LE(stats.peak, kLimit);
+  EXPECT_EQ(stats.in_use, 0);
+  EXPECT_GT(stats.waits, 0);
+}
+
+}  // namespace
+}  // namespace nearby
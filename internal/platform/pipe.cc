@@ -14,13 +14,16 @@
 
 #include "internal/platform/pipe.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <deque>
 #include <memory>
+#include <optional>
 #include <utility>
 
 #include "absl/base/thread_annotations.h"
+#include "absl/time/time.h"
 #include "internal/platform/base_mutex_lock.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/exception.h"
@@ -28,6 +31,7 @@
 #include "internal/platform/implementation/mutex.h"
 #include "internal/platform/implementation/platform.h"
 #include "internal/platform/input_stream.h"
+#include "internal/platform/memory_budget.h"
 #include "internal/platform/output_stream.h"
 
 namespace nearby {
@@ -35,6 +39,10 @@ namespace nearby {
 namespace {
 using Platform = api::ImplementationPlatform;
 
+// How long a write waits for memory before checking whether the pipe was
+// closed meanwhile.
+constexpr absl::Duration kMemoryWaitInterval = absl::Milliseconds(100);
+
 class Pipe {
  public:
   Pipe() {
@@ -97,6 +105,8 @@ class Pipe {
   bool read_all_chunks_ ABSL_GUARDED_BY(mutex_) = false;
 
   std::deque<ByteArray> ABSL_GUARDED_BY(mutex_) buffer_;
+  // The memory taken up by buffer_.
+  MemoryBudget::Charge buffer_charge_ ABSL_GUARDED_BY(mutex_);
   // Order of declaration matters:
   // - mutex must be defined before condvar;
   std::unique_ptr<api::Mutex> mutex_;
@@ -131,6 +141,7 @@ ExceptionOr<ByteArray> Pipe::Read(size_t size) {
 
   ByteArray first_chunk{buffer_.front()};
   buffer_.pop_front();
+  buffer_charge_.Release(std::min(first_chunk.size(), size));
 
   // If first_chunk is small enough to not overshoot the requested 'size', just
   // return that.
@@ -149,15 +160,39 @@ ExceptionOr<ByteArray> Pipe::Read(size_t size) {
 }
 
 Exception Pipe::Write(const ByteArray& data) {
-  BaseMutexLock lock(mutex_.get());
+  // Waits for memory without holding the lock, so that reads can free some
+  // meanwhile. This is what pauses a writer that gets ahead of its reader
+  // while the memory budget is spent.
+  MemoryBudget::Charge charge;
+  while (true) {
+    {
+      BaseMutexLock lock(mutex_.get());
+      if (input_stream_closed_ || output_stream_closed_) {
+        return {Exception::kIo};
+      }
+    }
+    std::optional<MemoryBudget::Charge> reserved =
+        MemoryBudget::GetInstance().Reserve(MemoryBudget::Subsystem::kPipes,
+                                            data.size(), kMemoryWaitInterval);
+    if (reserved.has_value()) {
+      charge = std::move(*reserved);
+      break;
+    }
+  }
 
-  return WriteLocked(data);
+  BaseMutexLock lock(mutex_.get());
+  Exception exception = WriteLocked(data);
+  if (exception.Ok()) buffer_charge_.Absorb(std::move(charge));
+  return exception;
 }
 
 void Pipe::MarkInputStreamClosed() {
   BaseMutexLock lock(mutex_.get());
   if (input_stream_closed_) return;
   input_stream_closed_ = true;
+  // Nothing can read the buffered data anymore.
+  buffer_.clear();
+  buffer_charge_ = {};
   // Trigger cond_ to unblock a potentially-blocked call to read(), and to let
   // it know to return Exception::IO.
   cond_->Notify();
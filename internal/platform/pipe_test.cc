@@ -16,6 +16,7 @@
 
 #include <pthread.h>
 
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
 #include <cstring>
@@ -29,6 +30,7 @@
 #include "internal/platform/byte_array.h"
 #include "internal/platform/exception.h"
 #include "internal/platform/input_stream.h"
+#include "internal/platform/memory_budget.h"
 #include "internal/platform/output_stream.h"
 #include "internal/platform/prng.h"
 #include "internal/platform/runnable.h"
@@ -337,4 +339,96 @@ TEST(PipeTest, ConcurrentWriteAndRead) {
   reader_thread.Join();
 }
 
+// Sets the process-wide memory budget for the duration of a test.
+class ScopedMemoryLimit {
+ public:
+  explicit ScopedMemoryLimit(std::int64_t limit) {
+    MemoryBudget::GetInstance().SetLimit(limit);
+  }
+  ~ScopedMemoryLimit() { MemoryBudget::GetInstance().SetLimit(0); }
+};
+
+std::int64_t GetPipesMemoryInUse() {
+  return MemoryBudget::GetInstance()
+      .GetStats()
+      .subsystems[static_cast<int>(MemoryBudget::Subsystem::kPipes)]
+      .in_use;
+}
+
+TEST(PipeTest, WriteWaitsForMemoryBudget) {
+  ScopedMemoryLimit limit(4);
+  auto [input_stream, output_stream] = CreatePipe();
+  EXPECT_TRUE(output_stream->Write(ByteArray("ABCD")).Ok());
+  EXPECT_EQ(GetPipesMemoryInUse(), 4);
+
+  std::atomic_bool written = false;
+  Thread writer_thread;
+  writer_thread.Start([&output_stream = output_stream, &written]() {
+    EXPECT_TRUE(output_stream->Write(ByteArray("EF")).Ok());
+    written = true;
+  });
+  absl::SleepFor(absl::Milliseconds(300));
+  EXPECT_FALSE(written);
+
+  ExceptionOr<ByteArray> read_data = input_stream->Read(2);
+  EXPECT_EQ(std::string(read_data.result()), "AB");
+  writer_thread.Join();
+  EXPECT_TRUE(written);
+  EXPECT_EQ(GetPipesMemoryInUse(), 4);
+
+  input_stream->Close();
+  EXPECT_EQ(GetPipesMemoryInUse(), 0);
+}
+
+TEST(PipeTest, WriteWaitingForMemoryFailsWhenInputStreamClosed) {
+  ScopedMemoryLimit limit(4);
+  auto [input_stream, output_stream] = CreatePipe();
+  EXPECT_TRUE(output_stream->Write(ByteArray("ABCD")).Ok());
+
+  Thread writer_thread;
+  writer_thread.Start([&output_stream = output_stream]() {
+    EXPECT_TRUE(output_stream->Write(ByteArray("EF")).Raised(Exception::kIo));
+  });
+  absl::SleepFor(absl::Milliseconds(300));
+  input_stream->Close();
+  writer_thread.Join();
+
+  EXPECT_EQ(GetPipesMemoryInUse(), 0);
+}
+
+TEST(PipeTest, StressWritesStayWithinMemoryBudget) {
+  constexpr std::int64_t kLimit = 128 * 1024;
+  constexpr size_t kWriteSize = 16 * 1024;
+  constexpr size_t kReadSize = 4 * 1024;
+  constexpr int kWrites = 512;
+  ScopedMemoryLimit limit(kLimit);
+  auto [input_stream, output_stream] = CreatePipe();
+
+  Thread writer_thread;
+  writer_thread.Start([&output_stream = output_stream]() {
+    for (int i = 0; i < kWrites; ++i) {
+      EXPECT_TRUE(
+          output_stream->Write(ByteArray(std::string(kWriteSize, 'a' + i % 26)))
+              .Ok());
+    }
+    EXPECT_TRUE(output_stream->Close().Ok());
+  });
+
+  std::int64_t bytes_read = 0;
+  std::int64_t max_in_use = 0;
+  while (true) {
+    max_in_use = std::max(max_in_use, GetPipesMemoryInUse());
+    ExceptionOr<ByteArray> read_data = input_stream->Read(kReadSize);
+    ASSERT_TRUE(read_data.ok());
+    if (read_data.result().Empty()) break;
+    EXPECT_EQ(read_data.result().data()[0], 'a' + bytes_read / kWriteSize % 26);
+    bytes_read += read_data.result().size();
+  }
+  writer_thread.Join();
+
+  EXPECT_EQ(bytes_read, kWrites * kWriteSize);
+  EXPECT_LE(max_in_use, kLimit);
+  EXPECT_EQ(GetPipesMemoryInUse(), 0);
+}
+
 }  // namespace nearby
@@ -30,6 +30,7 @@
 #include "presence/data_element.h"
 #include "presence/implementation/action_factory.h"
 #include "presence/implementation/base_broadcast_request.h"
+#include "presence/implementation/data_element_codec.h"
 #include "presence/implementation/ldt.h"
 
 namespace nearby {
@@ -37,63 +38,10 @@ namespace presence {
 
 namespace {
 
-constexpr uint8_t kDataTypeMask =
-    (1 << DataElement::kDataElementLengthShift) - 1;
-
 constexpr int kAdvertisementVersion = 0;
 
 constexpr int kEncryptedIdentityAdditionalLength =
     kSaltSize + kBaseMetadataSize;
-constexpr int kEddystoneAdditionalLength = 20;
-
-uint8_t GetDataElementType(uint8_t header) { return header & kDataTypeMask; }
-
-size_t GetDataElementLength(uint8_t header) {
-  return header >> DataElement::kDataElementLengthShift;
-}
-
-// Verifies if the DE header describes a valid DE in v0 advertisement.
-bool IsDataElementAllowed(uint8_t header) {
-  uint8_t data_type = GetDataElementType(header);
-  size_t length = GetDataElementLength(header);
-  switch (data_type) {
-    case DataElement::kSaltFieldType:
-      return length == 2;
-    case DataElement::kPublicIdentityFieldType:
-      return length == 0;
-    case DataElement::kPrivateIdentityFieldType:
-    case DataElement::kProvisionedIdentityFieldType:
-    case DataElement::kTrustedIdentityFieldType:
-      return length >= 2 && length <= 6;
-    case DataElement::kTxPowerFieldType:
-      return length == 1;
-    case DataElement::kActionFieldType:
-      return length >= 1 && length <= 3;
-    case DataElement::kModelIdFieldType:
-      return length == 3;
-    case DataElement::kEddystoneIdFieldType:
-      return length == 0;
-    case DataElement::kAccountKeyDataFieldType:
-      return length <= 12;
-    case DataElement::kConnectionStatusFieldType:
-      return length <= 3;
-    case DataElement::kBatteryFieldType:
-      return length <= 3;
-    default:
-      return false;
-  }
-}
-
-bool IsEncryptedIdentity(int data_type) {
-  return data_type == DataElement::kPrivateIdentityFieldType ||
-         data_type == DataElement::kTrustedIdentityFieldType ||
-         data_type == DataElement::kProvisionedIdentityFieldType;
-}
-
-bool IsIdentity(int data_type) {
-  return data_type == DataElement::kPublicIdentityFieldType ||
-         IsEncryptedIdentity(data_type);
-}
 
 internal::IdentityType GetIdentityType(int data_type) {
   switch (data_type) {
@@ -109,52 +57,6 @@ internal::IdentityType GetIdentityType(int data_type) {
   return internal::IDENTITY_TYPE_UNSPECIFIED;
 }
 
-// Returns the real length of a DE in v0 advertisement, which may be larger than
-// the value in the header.
-size_t GetDataElementTrueLength(uint8_t header) {
-  uint8_t data_type = GetDataElementType(header);
-  size_t length = GetDataElementLength(header);
-  if (IsEncryptedIdentity(data_type)) {
-    // The length of an encrypted DE is 16 bytes of overhead (salt + metadata
-    // key) + the actual payload, which is too long to fit in the 4-bit DE
-    // length field.
-    length += kEncryptedIdentityAdditionalLength;
-  } else if (data_type == DataElement::kEddystoneIdFieldType) {
-    // Length in the header is set to EID length minus 20, because EID is longer
-    // than 15 (the maximum length that can be stored in 4 bits.
-    length += kEddystoneAdditionalLength;
-  }
-  return length;
-}
-
-absl::StatusOr<DataElement> ParseDataElement(const absl::string_view input,
-                                             size_t& index) {
-  if (index >= input.size()) {
-    return absl::OutOfRangeError(absl::StrFormat(
-        "Data element (%s) is %d bytes long. Expected more than %d",
-        absl::BytesToHexString(input), input.size(), index));
-  }
-  uint8_t header = input[index];
-  if (!IsDataElementAllowed(header)) {
-    return absl::InvalidArgumentError(
-        absl::StrFormat("Unsupported Data Element 0x%x", header));
-  }
-  uint8_t data_type = GetDataElementType(header);
-  size_t length = GetDataElementTrueLength(header);
-  ++index;
-  size_t start = index;
-  index += length;
-  if (index > input.size()) {
-    return absl::OutOfRangeError(absl::StrFormat(
-        "Data element (%s) is %d bytes long. Expected at least %d",
-        absl::BytesToHexString(input), input.size(), index));
-  }
-  NEARBY_LOGS(VERBOSE) << "Type: " << static_cast<int>(data_type)
-                       << " length: " << static_cast<int>(length) << " DE: "
-                       << absl::BytesToHexString(input.substr(start, length));
-  return DataElement(data_type, input.substr(start, length));
-}
-
 bool Contains(const std::vector<DataElement>& data_elements,
               const DataElement& data_element) {
   return std::find(data_elements.begin(), data_elements.end(), data_element) !=
@@ -199,7 +101,7 @@ void AdvertisementDecoder::DecodeBaseAction(
   Action action = {.action = 0};
   for (int i = 0; i < serialized_action.size(); ++i) {
     int offset = (sizeof(uint32_t) - 1 - i) * 8;
-    action.action |= serialized_action[i] << offset;
+    action.action |= static_cast<uint8_t>(serialized_action[i]) << offset;
   }
 
   ActionFactory::DecodeAction(action, decoded_advertisement_.data_elements);
@@ -231,35 +133,35 @@ absl::StatusOr<std::string> AdvertisementDecoder::DecryptLdt(
 }
 
 absl::Status AdvertisementDecoder::DecryptDataElements(
-    const DataElement& elem) {
-  if (elem.GetValue().size() <= kEncryptedIdentityAdditionalLength) {
+    const DataElementView& elem, DataElementFormat format) {
+  if (elem.value.size() <= kEncryptedIdentityAdditionalLength) {
     return absl::OutOfRangeError(absl::StrFormat(
         "Encrypted identity data element is too short - %d bytes",
-        elem.GetValue().size()));
+        elem.value.size()));
   }
-  absl::string_view salt = elem.GetValue().substr(0, kSaltSize);
+  absl::string_view salt = elem.value.substr(0, kSaltSize);
   decoded_advertisement_.data_elements.emplace_back(DataElement::kSaltFieldType,
                                                     salt);
-  absl::string_view encrypted = elem.GetValue().substr(kSaltSize);
+  absl::string_view encrypted = elem.value.substr(kSaltSize);
   absl::StatusOr<std::string> decrypted = Decrypt(salt, encrypted);
   if (!decrypted.ok()) {
     NEARBY_LOGS(WARNING) << "Failed to decrypt advertisement, status: "
                          << decrypted.status();
     return decrypted.status();
   }
-  size_t index = 0;
-  while (index < decrypted->size()) {
-    absl::StatusOr<DataElement> internal_elem =
-        ParseDataElement(*decrypted, index);
+  DataElementReader reader(*decrypted, /*offset=*/0, format);
+  while (reader.HasNext()) {
+    absl::StatusOr<DataElementView> internal_elem = reader.Next();
     if (!internal_elem.ok()) {
       NEARBY_LOGS(WARNING) << "Failed to read data element, status: "
                            << internal_elem.status();
       return internal_elem.status();
     }
-    if (internal_elem->GetType() == DataElement::kActionFieldType) {
-      DecodeBaseAction(internal_elem->GetValue());
+    if (internal_elem->type == DataElement::kActionFieldType) {
+      DecodeBaseAction(internal_elem->value);
     } else {
-      decoded_advertisement_.data_elements.push_back(*std::move(internal_elem));
+      decoded_advertisement_.data_elements.push_back(
+          internal_elem->ToDataElement());
     }
   }
   return absl::OkStatus();
@@ -320,28 +222,10 @@ void AdvertisementDecoder::AddBannedDataTypes() {
   }
 }
 
-absl::StatusOr<Advertisement> AdvertisementDecoder::DecodeAdvertisement(
-    absl::string_view advertisement) {
-  // Let's keep the result advertisement in a member variable to avoid passing
-  // it around all the time.
-  decoded_advertisement_ = Advertisement{};
-  std::vector<DataElement> result;
-  NEARBY_LOGS(INFO) << "Advertisement: "
-                    << absl::BytesToHexString(advertisement);
-  if (advertisement.empty()) {
-    return absl::OutOfRangeError("Empty advertisement");
-  }
-  uint8_t version = advertisement[0];
-  NEARBY_LOGS(VERBOSE) << "Version: " << version;
-  if (version != kAdvertisementVersion) {
-    return absl::UnimplementedError(absl::StrFormat(
-        "Advertisement version (%d) is not supported", version));
-  }
-  decoded_advertisement_.version = version;
-  size_t index = 1;
-  absl::StatusOr<std::string> decrypted;
-  while (index < advertisement.size()) {
-    absl::StatusOr<DataElement> elem = ParseDataElement(advertisement, index);
+absl::Status AdvertisementDecoder::DecodeDataElements(
+    DataElementReader& reader, DataElementFormat format) {
+  while (reader.HasNext()) {
+    absl::StatusOr<DataElementView> elem = reader.Next();
     if (!elem.ok()) {
       NEARBY_LOGS(WARNING) << "Failed to read data element, status: "
                            << elem.status();
@@ -350,27 +234,99 @@ absl::StatusOr<Advertisement> AdvertisementDecoder::DecodeAdvertisement(
     // This checks allows us to bail before decryption when, for example, the
     // client is scanning for advertisements with private identity but the
     // advertisement uses trusted identity.
-    if (banned_data_types_.contains(elem->GetType())) {
-      return absl::FailedPreconditionError(
-          absl::StrFormat("Ignoring advertisement with data element type: %d",
-                          elem->GetType()));
+    if (banned_data_types_.contains(elem->type)) {
+      return absl::FailedPreconditionError(absl::StrFormat(
+          "Ignoring advertisement with data element type: %d", elem->type));
     }
-    if (IsIdentity(elem->GetType())) {
-      decoded_advertisement_.identity_type = GetIdentityType(elem->GetType());
+    // An extended advertisement may have both public and encrypted sections.
+    // The encrypted identity takes precedence.
+    if (IsEncryptedIdentityDataElementType(elem->type) ||
+        (IsIdentityDataElementType(elem->type) &&
+         decoded_advertisement_.identity_type ==
+             internal::IDENTITY_TYPE_UNSPECIFIED)) {
+      decoded_advertisement_.identity_type = GetIdentityType(elem->type);
     }
-    if (IsEncryptedIdentity(elem->GetType())) {
-      absl::Status status = DecryptDataElements(*elem);
+    if (IsEncryptedIdentityDataElementType(elem->type)) {
+      absl::Status status = DecryptDataElements(*elem, format);
       if (!status.ok()) {
         return status;
       }
     } else {
-      if (elem->GetType() == DataElement::kActionFieldType) {
-        DecodeBaseAction(elem->GetValue());
+      if (elem->type == DataElement::kActionFieldType) {
+        DecodeBaseAction(elem->value);
       } else {
-        decoded_advertisement_.data_elements.push_back(*std::move(elem));
+        decoded_advertisement_.data_elements.push_back(elem->ToDataElement());
       }
     }
   }
+  return absl::OkStatus();
+}
+
+absl::Status AdvertisementDecoder::DecodeExtendedSections(
+    absl::string_view sections) {
+  size_t index = 0;
+  while (index < sections.size()) {
+    size_t length = static_cast<uint8_t>(sections[index++]);
+    if (length == 0 || index + length > sections.size()) {
+      return absl::OutOfRangeError(absl::StrFormat(
+          "Section length %d doesn't match the %d remaining bytes", length,
+          sections.size() - index));
+    }
+    absl::string_view section = sections.substr(index, length);
+    index += length;
+    // Every section starts with its identity.
+    absl::StatusOr<DataElementView> identity =
+        DataElementReader(section, /*offset=*/0, DataElementFormat::kExtended)
+            .Next();
+    if (!identity.ok()) {
+      return identity.status();
+    }
+    if (!IsIdentityDataElementType(identity->type)) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Section starts with non-identity data element type: %d",
+          identity->type));
+    }
+    DataElementReader reader(section, /*offset=*/0,
+                             DataElementFormat::kExtended);
+    absl::Status status =
+        DecodeDataElements(reader, DataElementFormat::kExtended);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<Advertisement> AdvertisementDecoder::DecodeAdvertisement(
+    absl::string_view advertisement) {
+  // Let's keep the result advertisement in a member variable to avoid passing
+  // it around all the time.
+  decoded_advertisement_ = Advertisement{};
+  std::vector<DataElement> result;
+  NEARBY_LOGS(INFO) << "Advertisement: "
+                    << absl::BytesToHexString(advertisement);
+  if (advertisement.empty()) {
+    return absl::OutOfRangeError("Empty advertisement");
+  }
+  uint8_t version = advertisement[0];
+  NEARBY_LOGS(VERBOSE) << "Version: " << version;
+  if (version != kAdvertisementVersion &&
+      version != kExtendedAdvertisementHeader) {
+    return absl::UnimplementedError(absl::StrFormat(
+        "Advertisement version (%d) is not supported", version));
+  }
+  absl::Status status;
+  if (version == kAdvertisementVersion) {
+    decoded_advertisement_.version = version;
+    DataElementReader reader(advertisement, /*offset=*/1);
+    status = DecodeDataElements(reader, DataElementFormat::kBase);
+  } else {
+    decoded_advertisement_.version = kExtendedAdvertisementVersion;
+    status = DecodeExtendedSections(advertisement.substr(1));
+  }
+  if (!status.ok()) {
+    return status;
+  }
   return std::move(decoded_advertisement_);
 }
 
@@ -25,6 +25,7 @@
 #include "internal/platform/implementation/credential_callbacks.h"
 #include "internal/proto/credential.pb.h"
 #include "presence/data_element.h"
+#include "presence/implementation/data_element_codec.h"
 #include "presence/scan_request.h"
 
 namespace nearby {
@@ -71,9 +72,16 @@ class AdvertisementDecoder {
   bool MatchesScanFilter(const std::vector<DataElement>& data_elements);
 
  private:
+  // Decodes data elements from `reader` and appends them to
+  // `decoded_advertisement_`.
+  absl::Status DecodeDataElements(DataElementReader& reader,
+                                  DataElementFormat format);
+  // Decodes the length-prefixed sections of an extended advertisement.
+  absl::Status DecodeExtendedSections(absl::string_view sections);
   // Decrypts data elements stored inside encrypted `elem` and appends them to
   // `decoded_advertisement_`.
-  absl::Status DecryptDataElements(const DataElement& elem);
+  absl::Status DecryptDataElements(const DataElementView& elem,
+                                   DataElementFormat format);
   absl::StatusOr<std::string> Decrypt(absl::string_view salt,
                                       absl::string_view encrypted);
   void DecodeBaseAction(absl::string_view serialized_action);
@@ -329,6 +329,58 @@ TEST(AdvertisementDecoder, UnsupportedAdvertisementVersion) {
               StatusIs(absl::StatusCode::kUnimplemented));
 }
 
+TEST(AdvertisementDecoder, DecodeExtendedPublicAdvertisement) {
+  AdvertisementDecoder decoder(GetScanRequest());
+
+  const absl::StatusOr<Advertisement> result =
+      decoder.DecodeAdvertisement(absl::HexStringToBytes(
+          // Presence extended header
+          "e0"
+          // Section: public identity, tx power, action and model id
+          "0a031505260080370a0b0c"
+          // Section: public identity, tx power and 10 bytes of account key
+          // data, with a 2 byte DE header
+          "0f0315058a0930313233343536373839"));
+
+  ASSERT_OK(result);
+  EXPECT_EQ(result->identity_type, IdentityType::IDENTITY_TYPE_PUBLIC);
+  EXPECT_EQ(result->version, 7);
+  EXPECT_THAT(
+      result->data_elements,
+      ElementsAre(DataElement(DataElement::kPublicIdentityFieldType, ""),
+                  DataElement(DataElement::kTxPowerFieldType,
+                              absl::HexStringToBytes("05")),
+                  DataElement(ActionBit::kActiveUnlockAction),
+                  DataElement(DataElement::kModelIdFieldType,
+                              absl::HexStringToBytes("0a0b0c")),
+                  DataElement(DataElement::kPublicIdentityFieldType, ""),
+                  DataElement(DataElement::kTxPowerFieldType,
+                              absl::HexStringToBytes("05")),
+                  DataElement(DataElement::kAccountKeyDataFieldType,
+                              "0123456789")));
+}
+
+TEST(AdvertisementDecoder, ExtendedSectionLongerThanAdvertisementFails) {
+  AdvertisementDecoder decoder(GetScanRequest());
+
+  EXPECT_THAT(decoder.DecodeAdvertisement(absl::HexStringToBytes("e005031505")),
+              StatusIs(absl::StatusCode::kOutOfRange));
+}
+
+TEST(AdvertisementDecoder, ExtendedSectionWithoutIdentityFails) {
+  AdvertisementDecoder decoder(GetScanRequest());
+
+  EXPECT_THAT(decoder.DecodeAdvertisement(absl::HexStringToBytes("e002150503")),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(AdvertisementDecoder, NpV1AdvertisementIsNotSupported) {
+  AdvertisementDecoder decoder(GetScanRequest());
+
+  EXPECT_THAT(decoder.DecodeAdvertisement(absl::HexStringToBytes("2005031505")),
+              StatusIs(absl::StatusCode::kUnimplemented));
+}
+
 TEST(AdvertisementDecoder, MatchesScanFilterNoFilterPasses) {
   std::vector<DataElement> adv = {
       DataElement(DataElement::kPrivateIdentityFieldType, "payload")};
@@ -14,18 +14,23 @@
 
 #include "presence/implementation/advertisement_factory.h"
 
+#include <array>
+#include <cstdint>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/status/status.h"
+#include "absl/strings/escaping.h"
 #include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/variant.h"
 #include "internal/platform/logging.h"
 #include "internal/platform/uuid.h"
 #include "internal/proto/credential.pb.h"
 #include "presence/data_element.h"
 #include "presence/implementation/base_broadcast_request.h"
+#include "presence/implementation/data_element_codec.h"
 #include "presence/implementation/ldt.h"
 #include "presence/implementation/mediums/advertisement_data.h"
 
@@ -35,34 +40,6 @@ namespace presence {
 namespace {
 using ::nearby::internal::IdentityType;
 constexpr uint8_t kBaseVersion = 0;
-constexpr size_t kMaxBaseNpAdvSize = 26;
-
-absl::StatusOr<uint8_t> CreateDataElementHeader(size_t length,
-                                                unsigned data_type) {
-  if (length > DataElement::kMaxDataElementLength) {
-    return absl::InvalidArgumentError(
-        absl::StrFormat("Unsupported Data Element length: %d", length));
-  }
-  if (data_type > DataElement::kMaxDataElementType) {
-    return absl::InvalidArgumentError(
-        absl::StrFormat("Unsupported Data Element type: %d", data_type));
-  }
-  return (length << DataElement::kDataElementLengthShift) | data_type;
-}
-
-absl::Status AppendDataElement(unsigned data_type,
-                               absl::string_view data_element,
-                               std::string& output) {
-  auto header = CreateDataElementHeader(data_element.size(), data_type);
-  if (!header.ok()) {
-    NEARBY_LOG(WARNING, "Can't add Data element type: %d, length: %d",
-               data_type, data_element.size());
-    return header.status();
-  }
-  output.push_back(*header);
-  output.insert(output.end(), data_element.begin(), data_element.end());
-  return absl::OkStatus();
-}
 
 uint8_t GetIdentityFieldType(IdentityType type) {
   switch (type) {
@@ -79,18 +56,21 @@ uint8_t GetIdentityFieldType(IdentityType type) {
   }
 }
 
-std::string SerializeAction(const Action& action) {
-  std::string output;
+// Serializes `action` into `output` in Big Endian order, skipping trailing
+// zero bytes. Returns the serialized bytes, which point into `output`.
+absl::string_view SerializeAction(const Action& action,
+                                  std::array<char, sizeof(uint32_t)>& output) {
+  size_t size = 0;
   uint32_t input = action.action;
   for (int i = 3; i >= 0; --i) {
     if (input == 0) {
-      return output;
+      break;
     }
     int shift = 8 * i;
-    output.push_back(static_cast<char>((input >> shift) & 0xFF));
+    output[size++] = static_cast<char>((input >> shift) & 0xFF);
     input &= (1 << shift) - 1;
   }
-  return output;
+  return absl::string_view(output.data(), size);
 }
 
 bool RequiresCredentials(IdentityType identity_type) {
@@ -108,6 +88,10 @@ absl::StatusOr<AdvertisementData> AdvertisementFactory::CreateAdvertisement(
           request.variant)) {
     return CreateBaseNpAdvertisement(request, std::move(credential));
   }
+  if (absl::holds_alternative<BaseBroadcastRequest::ExtendedPresence>(
+          request.variant)) {
+    return CreateExtendedNpAdvertisement(request, credential);
+  }
   return advert;
 }
 
@@ -117,12 +101,14 @@ AdvertisementFactory::CreateBaseNpAdvertisement(
     absl::optional<LocalCredential> credential) const {
   const auto& presence =
       absl::get<BaseBroadcastRequest::BasePresence>(request.variant);
-  std::string payload;
-  payload.reserve(kMaxBaseNpAdvSize);
-  payload.push_back(kBaseVersion);
-  absl::Status result;
-  std::string tx_power = {static_cast<char>(request.tx_power)};
-  std::string action = SerializeAction(presence.action);
+  DataElementWriter payload;
+  absl::Status result = payload.AppendByte(kBaseVersion);
+  if (!result.ok()) {
+    return result;
+  }
+  char tx_power[] = {static_cast<char>(request.tx_power)};
+  std::array<char, sizeof(uint32_t)> action_buffer;
+  absl::string_view action = SerializeAction(presence.action, action_buffer);
   uint8_t identity_type =
       GetIdentityFieldType(presence.credential_selector.identity_type);
   bool needs_encryption =
@@ -135,21 +121,22 @@ AdvertisementFactory::CreateBaseNpAdvertisement(
     if (!credential) {
       return absl::FailedPreconditionError("Missing credentials");
     }
-    std::string unencrypted;
-    result = AppendDataElement(DataElement::kTxPowerFieldType, tx_power,
-                               unencrypted);
+    DataElementWriter unencrypted;
+    result = unencrypted.AppendDataElement(
+        DataElement::kTxPowerFieldType,
+        absl::string_view(tx_power, sizeof(tx_power)));
     if (!result.ok()) {
       return result;
     }
-    result =
-        AppendDataElement(DataElement::kActionFieldType, action, unencrypted);
+    result = unencrypted.AppendDataElement(DataElement::kActionFieldType,
+                                           action);
     if (!result.ok()) {
       return result;
     }
     NEARBY_LOGS(VERBOSE) << "Unencrypted advertisement payload "
-                         << absl::BytesToHexString(unencrypted);
+                         << absl::BytesToHexString(unencrypted.data());
     absl::StatusOr<std::string> encrypted =
-        EncryptDataElements(*credential, request.salt, unencrypted);
+        EncryptDataElements(*credential, request.salt, unencrypted.data());
     if (!encrypted.ok()) {
       return encrypted.status();
     }
@@ -166,35 +153,145 @@ AdvertisementFactory::CreateBaseNpAdvertisement(
     if (!identity_header.ok()) {
       return identity_header.status();
     }
-    payload.push_back(*identity_header);
+    result = payload.AppendByte(*identity_header);
+    if (!result.ok()) {
+      return result;
+    }
     // In the encrypted format, salt is not a DE (thus no header)
-    payload.append(request.salt);
-    payload.append(*encrypted);
+    result = payload.AppendBytes(request.salt);
+    if (!result.ok()) {
+      return result;
+    }
+    result = payload.AppendBytes(*encrypted);
+    if (!result.ok()) {
+      return result;
+    }
   } else {
-    result = AppendDataElement(identity_type, "", payload);
+    result = payload.AppendDataElement(identity_type, "");
     if (!result.ok()) {
       return result;
     }
     if (!request.salt.empty()) {
       result =
-          AppendDataElement(DataElement::kSaltFieldType, request.salt, payload);
+          payload.AppendDataElement(DataElement::kSaltFieldType, request.salt);
       if (!result.ok()) {
         return result;
       }
     }
-    result =
-        AppendDataElement(DataElement::kTxPowerFieldType, tx_power, payload);
+    result = payload.AppendDataElement(
+        DataElement::kTxPowerFieldType,
+        absl::string_view(tx_power, sizeof(tx_power)));
     if (!result.ok()) {
       return result;
     }
-    result = AppendDataElement(DataElement::kActionFieldType, action, payload);
+    result = payload.AppendDataElement(DataElement::kActionFieldType, action);
     if (!result.ok()) {
       return result;
     }
   }
   return AdvertisementData{.is_extended_advertisement = false,
-                           .content = payload};
+                           .content = std::string(payload.data())};
 }
+absl::StatusOr<AdvertisementData>
+AdvertisementFactory::CreateExtendedNpAdvertisement(
+    const BaseBroadcastRequest& request,
+    const absl::optional<LocalCredential>& credential) const {
+  const auto& presence =
+      absl::get<BaseBroadcastRequest::ExtendedPresence>(request.variant);
+  if (presence.sections.empty()) {
+    return absl::InvalidArgumentError("Missing advertisement sections");
+  }
+  DataElementWriter payload(DataElementFormat::kExtended);
+  absl::Status result = payload.AppendByte(kExtendedAdvertisementHeader);
+  if (!result.ok()) {
+    return result;
+  }
+  for (const auto& section : presence.sections) {
+    DataElementWriter section_payload(DataElementFormat::kExtended);
+    result = AppendExtendedSection(request, section, credential,
+                                   section_payload);
+    if (!result.ok()) {
+      return result;
+    }
+    // Each section is prefixed with its length.
+    result = payload.AppendByte(section_payload.size());
+    if (!result.ok()) {
+      return result;
+    }
+    result = payload.AppendBytes(section_payload.data());
+    if (!result.ok()) {
+      return result;
+    }
+  }
+  return AdvertisementData{.is_extended_advertisement = true,
+                           .content = std::string(payload.data())};
+}
+
+absl::Status AdvertisementFactory::AppendExtendedSection(
+    const BaseBroadcastRequest& request,
+    const BaseBroadcastRequest::ExtendedPresence::Section& section,
+    const absl::optional<LocalCredential>& credential,
+    DataElementWriter& output) const {
+  char tx_power[] = {static_cast<char>(request.tx_power)};
+  std::array<char, sizeof(uint32_t)> action_buffer;
+  absl::string_view action = SerializeAction(section.action, action_buffer);
+  DataElementWriter data_elements(DataElementFormat::kExtended);
+  absl::Status result = data_elements.AppendDataElement(
+      DataElement::kTxPowerFieldType,
+      absl::string_view(tx_power, sizeof(tx_power)));
+  if (!result.ok()) {
+    return result;
+  }
+  if (!action.empty()) {
+    result =
+        data_elements.AppendDataElement(DataElement::kActionFieldType, action);
+    if (!result.ok()) {
+      return result;
+    }
+  }
+  for (const DataElement& data_element : section.data_elements) {
+    result = data_elements.AppendDataElement(data_element.GetType(),
+                                             data_element.GetValue());
+    if (!result.ok()) {
+      return result;
+    }
+  }
+  uint8_t identity_type =
+      GetIdentityFieldType(section.credential_selector.identity_type);
+  if (identity_type == DataElement::kPublicIdentityFieldType) {
+    // Public sections carry no salt, since nothing in them is encrypted.
+    result = output.AppendDataElement(identity_type, "");
+    if (!result.ok()) {
+      return result;
+    }
+    return output.AppendBytes(data_elements.data());
+  }
+  if (request.salt.size() != kSaltSize) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Unsupported salt size %d", request.salt.size()));
+  }
+  if (!credential) {
+    return absl::FailedPreconditionError("Missing credentials");
+  }
+  absl::StatusOr<std::string> encrypted =
+      EncryptDataElements(*credential, request.salt, data_elements.data());
+  if (!encrypted.ok()) {
+    return encrypted.status();
+  }
+  // Unlike in base NP, the identity DE length covers the salt and the
+  // encrypted metadata key and DEs.
+  DataElementWriter identity(DataElementFormat::kExtended);
+  result = identity.AppendBytes(request.salt);
+  if (!result.ok()) {
+    return result;
+  }
+  result = identity.AppendBytes(*encrypted);
+  if (!result.ok()) {
+    return result;
+  }
+  return output.AppendDataElement(identity_type, identity.data());
+}
+
 absl::StatusOr<std::string> AdvertisementFactory::EncryptDataElements(
     const LocalCredential& credential, absl::string_view salt,
     absl::string_view data_elements) const {
@@ -225,6 +322,16 @@ absl::StatusOr<CredentialSelector> AdvertisementFactory::GetCredentialSelector(
       return presence.credential_selector;
     }
   }
+  if (absl::holds_alternative<BaseBroadcastRequest::ExtendedPresence>(
+          request.variant)) {
+    for (const auto& section :
+         absl::get<BaseBroadcastRequest::ExtendedPresence>(request.variant)
+             .sections) {
+      if (RequiresCredentials(section.credential_selector.identity_type)) {
+        return section.credential_selector;
+      }
+    }
+  }
   return absl::NotFoundError("credentials not required");
 }
 }  // namespace presence
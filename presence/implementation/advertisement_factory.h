@@ -18,9 +18,12 @@
 #include <string>
 #include <vector>
 
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/types/optional.h"
 #include "internal/proto/credential.pb.h"
 #include "presence/implementation/base_broadcast_request.h"
+#include "presence/implementation/data_element_codec.h"
 #include "presence/implementation/mediums/advertisement_data.h"
 
 namespace nearby {
@@ -50,6 +53,16 @@ class AdvertisementFactory {
   absl::StatusOr<AdvertisementData> CreateBaseNpAdvertisement(
       const BaseBroadcastRequest& request,
       absl::optional<LocalCredential> credential) const;
+  absl::StatusOr<AdvertisementData> CreateExtendedNpAdvertisement(
+      const BaseBroadcastRequest& request,
+      const absl::optional<LocalCredential>& credential) const;
+  // Appends an extended advertisement section, without the length prefix, to
+  // `output`.
+  absl::Status AppendExtendedSection(
+      const BaseBroadcastRequest& request,
+      const BaseBroadcastRequest::ExtendedPresence::Section& section,
+      const absl::optional<LocalCredential>& credential,
+      DataElementWriter& output) const;
   absl::StatusOr<std::string> EncryptDataElements(
       const LocalCredential& credential, absl::string_view salt,
       absl::string_view data_elements) const;
@@ -152,6 +152,66 @@ TEST(AdvertisementFactory, CreateAdvertisementFromPublicIdentity) {
   EXPECT_EQ(absl::BytesToHexString(result->content), "00032041421505260080");
 }
 
+TEST(AdvertisementFactory, CreateExtendedAdvertisementFromPublicSections) {
+  std::vector<DataElement> data_elements;
+  data_elements.emplace_back(ActionBit::kActiveUnlockAction);
+  BaseBroadcastRequest::ExtendedPresence presence = {
+      .sections = {
+          {.credential_selector = {.identity_type =
+                                       IdentityType::IDENTITY_TYPE_PUBLIC},
+           .action = ActionFactory::CreateAction(data_elements),
+           .data_elements = {DataElement(DataElement::kModelIdFieldType,
+                                         absl::HexStringToBytes("0a0b0c"))}},
+          {.credential_selector = {.identity_type =
+                                       IdentityType::IDENTITY_TYPE_PUBLIC},
+           .action = {.action = 0},
+           .data_elements = {DataElement(DataElement::kAccountKeyDataFieldType,
+                                         "0123456789")}}}};
+  BaseBroadcastRequest request = {
+      .variant = presence, .salt = "AB", .tx_power = 5};
+
+  absl::StatusOr<AdvertisementData> result =
+      AdvertisementFactory().CreateAdvertisement(request);
+
+  ASSERT_OK(result);
+  EXPECT_TRUE(result->is_extended_advertisement);
+  EXPECT_EQ(absl::BytesToHexString(result->content),
+            "e0"
+            "0a031505260080370a0b0c"
+            "0f0315058a0930313233343536373839");
+}
+
+TEST(AdvertisementFactory, CreateExtendedAdvertisementFailsWhenTooLong) {
+  BaseBroadcastRequest::ExtendedPresence presence;
+  for (int i = 0; i < 3; ++i) {
+    presence.sections.push_back(
+        {.credential_selector = {.identity_type =
+                                     IdentityType::IDENTITY_TYPE_PUBLIC},
+         .action = {.action = 0},
+         .data_elements = {DataElement(DataElement::kAccountKeyDataFieldType,
+                                       std::string(100, 'x'))}});
+  }
+  BaseBroadcastRequest request = {
+      .variant = presence, .salt = "AB", .tx_power = 5};
+
+  EXPECT_THAT(AdvertisementFactory().CreateAdvertisement(request),
+              StatusIs(absl::StatusCode::kOutOfRange));
+}
+
+TEST(AdvertisementFactory, CreateExtendedAdvertisementRequiresCredentials) {
+  BaseBroadcastRequest::ExtendedPresence presence = {
+      .sections = {{.credential_selector = {.identity_type =
+                                                IdentityType::
+                                                    IDENTITY_TYPE_PRIVATE},
+                    .action = {.action = 0}}}};
+  BaseBroadcastRequest request = {
+      .variant = presence, .salt = "AB", .tx_power = 5};
+
+  EXPECT_OK(AdvertisementFactory::GetCredentialSelector(request));
+  EXPECT_THAT(AdvertisementFactory().CreateAdvertisement(request),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
 TEST(AdvertisementFactory, CreateAdvertisementFailsWhenSaltIsTooShort) {
   std::string salt = "AB";
   constexpr IdentityType kIdentity = internal::IDENTITY_TYPE_PRIVATE;
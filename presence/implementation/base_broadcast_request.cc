@@ -15,6 +15,7 @@
 #include "presence/implementation/base_broadcast_request.h"
 
 #include <string>
+#include <utility>
 #include <variant>
 
 #include "absl/status/status.h"
@@ -22,11 +23,96 @@
 #include "internal/platform/implementation/crypto.h"
 #include "internal/platform/logging.h"
 #include "presence/broadcast_request.h"
+#include "presence/data_element.h"
 #include "presence/implementation/action_factory.h"
+#include "presence/implementation/data_element_codec.h"
 
 namespace nearby {
 namespace presence {
 
+namespace {
+
+std::string CreateRandomSalt() {
+  std::string bytes(kSaltSize, 0);
+  crypto::RandBytes(const_cast<std::string::value_type*>(bytes.data()),
+                    bytes.size());
+  return bytes;
+}
+
+bool RequiresCredentials(nearby::internal::IdentityType identity_type) {
+  return identity_type == nearby::internal::IDENTITY_TYPE_PRIVATE ||
+         identity_type == nearby::internal::IDENTITY_TYPE_TRUSTED ||
+         identity_type == nearby::internal::IDENTITY_TYPE_PROVISIONED;
+}
+
+// Returns true if the Data Element is folded into the `Action` in base NP
+// advertisement.
+bool IsActionDataElement(const DataElement& data_element) {
+  return data_element.GetType() == DataElement::kActionFieldType ||
+         data_element.GetType() == DataElement::kContextTimestampFieldType;
+}
+
+// Returns true if the Data Element is generated by the SDK, so it can't be
+// provided by the client.
+bool IsGeneratedDataElement(const DataElement& data_element) {
+  return data_element.GetType() == DataElement::kSaltFieldType ||
+         data_element.GetType() == DataElement::kTxPowerFieldType ||
+         IsIdentityDataElementType(data_element.GetType());
+}
+
+// Returns true if `request` carries more than fits in a base NP advertisement.
+bool RequiresExtendedAdvertisement(const PresenceBroadcast& request) {
+  if (request.sections.size() > 1) {
+    return true;
+  }
+  for (const DataElement& data_element :
+       request.sections.front().extended_properties) {
+    if (!IsActionDataElement(data_element) &&
+        !IsGeneratedDataElement(data_element)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+absl::StatusOr<BaseBroadcastRequest> CreateExtendedRequest(
+    const BroadcastRequest& request, const PresenceBroadcast& presence) {
+  BaseBroadcastRequest::ExtendedPresence extended;
+  bool has_encrypted_section = false;
+  for (const PresenceBroadcast::BroadcastSection& section : presence.sections) {
+    if (RequiresCredentials(section.identity)) {
+      if (has_encrypted_section) {
+        return absl::InvalidArgumentError(
+            "Only one broadcast section can use an encrypted identity");
+      }
+      has_encrypted_section = true;
+    }
+    BaseBroadcastRequest::ExtendedPresence::Section extended_section = {
+        .credential_selector = {.manager_app_id = section.manager_app_id,
+                                .account_name = section.account_name,
+                                .identity_type = section.identity},
+        .action = ActionFactory::CreateAction(section.extended_properties)};
+    for (const DataElement& data_element : section.extended_properties) {
+      if (IsActionDataElement(data_element)) {
+        continue;
+      }
+      if (IsGeneratedDataElement(data_element)) {
+        NEARBY_LOG(WARNING, "Ignoring Data Element type %d generated by SDK",
+                   data_element.GetType());
+        continue;
+      }
+      extended_section.data_elements.push_back(data_element);
+    }
+    extended.sections.push_back(std::move(extended_section));
+  }
+  return BaseBroadcastRequest{.variant = std::move(extended),
+                              .salt = CreateRandomSalt(),
+                              .tx_power = static_cast<int8_t>(request.tx_power),
+                              .power_mode = request.power_mode};
+}
+
+}  // namespace
+
 BasePresenceRequestBuilder& BasePresenceRequestBuilder::SetSalt(
     absl::string_view salt) {
   if (salt.size() != kSaltSize) {
@@ -73,26 +159,26 @@ BasePresenceRequestBuilder::operator BaseBroadcastRequest() const {
                               .identity_type = identity_},
       .action = action_};
 
-  std::string bytes(kSaltSize, 0);
-  crypto::RandBytes(const_cast<std::string::value_type*>(bytes.data()),
-                    bytes.size());
-
   BaseBroadcastRequest broadcast_request{
       .variant = presence,
-      .salt = salt_.size() == kSaltSize ? salt_ : bytes,
+      .salt = salt_.size() == kSaltSize ? salt_ : CreateRandomSalt(),
       .tx_power = tx_power_,
       .power_mode = power_mode_};
   return broadcast_request;
 }
 
 absl::StatusOr<BaseBroadcastRequest> BaseBroadcastRequest::Create(
-    const BroadcastRequest& request) {
+    const BroadcastRequest& request, bool extended_advertisement_available) {
   if (absl::holds_alternative<PresenceBroadcast>(request.variant)) {
     const auto& presence_request =
         absl::get<PresenceBroadcast>(request.variant);
     if (presence_request.sections.empty()) {
       return absl::InvalidArgumentError("Missing broadcast sections");
     }
+    if (extended_advertisement_available &&
+        RequiresExtendedAdvertisement(presence_request)) {
+      return CreateExtendedRequest(request, presence_request);
+    }
     if (presence_request.sections.size() > 1) {
       NEARBY_LOG(WARNING,
                  "Only first section is used in BLE 4.2 advertisement");
@@ -18,12 +18,14 @@
 #include <stdint.h>
 
 #include <string>
+#include <vector>
 
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/variant.h"
 #include "internal/platform/implementation/credential_callbacks.h"
 #include "presence/broadcast_request.h"
+#include "presence/data_element.h"
 #include "presence/power_mode.h"
 
 namespace nearby {
@@ -42,9 +44,13 @@ struct Action {
 /** Defines a Nearby Presence broadcast request */
 struct BaseBroadcastRequest {
   // Creates `BaseBroadcastRequest` from the public API request in
-  // `BroadcastRequest`.
+  // `BroadcastRequest`. If `extended_advertisement_available` is true and the
+  // request doesn't fit in a base NP advertisement, creates an
+  // `ExtendedPresence` request. Otherwise, only the first section of the
+  // request is used.
   static absl::StatusOr<BaseBroadcastRequest> Create(
-      const BroadcastRequest& request);
+      const BroadcastRequest& request,
+      bool extended_advertisement_available = false);
 
   struct BasePresence {
     CredentialSelector credential_selector;
@@ -63,7 +69,19 @@ struct BaseBroadcastRequest {
   struct BaseEddystone {
     std::string ephemeral_id;
   };
-  absl::variant<BasePresence, BaseFastPair, BaseEddystone> variant;
+  // NP advertisement with multiple sections, broadcast over BLE 5. At most one
+  // section may use an encrypted identity, and it uses `salt`.
+  struct ExtendedPresence {
+    struct Section {
+      CredentialSelector credential_selector;
+      Action action;
+      // Data Elements that are not folded into `action`.
+      std::vector<DataElement> data_elements;
+    };
+    std::vector<Section> sections;
+  };
+  absl::variant<BasePresence, BaseFastPair, BaseEddystone, ExtendedPresence>
+      variant;
   std::string salt;
   int8_t tx_power;
   unsigned int interval_ms;
@@ -29,6 +29,7 @@ namespace presence {
 namespace {
 
 using ::nearby::internal::IdentityType;
+using ::testing::ElementsAre;
 using ::testing::status::StatusIs;
 
 TEST(BroadcastRequestTest, CreateBasePresenceRequest) {
@@ -80,6 +81,84 @@ TEST(BroadcastRequestTest, CreateFromPresenceRequest) {
               manager_app_id);
 }
 
+TEST(BroadcastRequestTest, CreateExtendedFromMultiSectionPresenceRequest) {
+  constexpr int8_t kTxPower = 30;
+  PresenceBroadcast presence_request = {
+      .sections = {
+          {.identity = internal::IDENTITY_TYPE_PRIVATE,
+           .extended_properties = {DataElement(ActionBit::kActiveUnlockAction),
+                                   DataElement(DataElement::kModelIdFieldType,
+                                               "abc")},
+           .account_name = "Test account"},
+          {.identity = internal::IDENTITY_TYPE_PUBLIC,
+           .extended_properties = {
+               DataElement(DataElement::kTxPowerFieldType, uint8_t{1}),
+               DataElement(DataElement::kBatteryFieldType, "b")}}}};
+  BroadcastRequest input = {.tx_power = kTxPower, .variant = presence_request};
+
+  absl::StatusOr<BaseBroadcastRequest> request = BaseBroadcastRequest::Create(
+      input, /*extended_advertisement_available=*/true);
+
+  ASSERT_OK(request);
+  EXPECT_EQ(request->tx_power, kTxPower);
+  EXPECT_EQ(request->salt.size(), 2);
+  const auto& sections =
+      absl::get<BaseBroadcastRequest::ExtendedPresence>(request->variant)
+          .sections;
+  ASSERT_EQ(sections.size(), 2);
+  EXPECT_EQ(sections[0].credential_selector.identity_type,
+            IdentityType::IDENTITY_TYPE_PRIVATE);
+  EXPECT_EQ(sections[0].credential_selector.account_name, "Test account");
+  EXPECT_EQ(sections[0].action.action, 1 << 23);
+  EXPECT_THAT(sections[0].data_elements,
+              ElementsAre(DataElement(DataElement::kModelIdFieldType, "abc")));
+  EXPECT_EQ(sections[1].credential_selector.identity_type,
+            IdentityType::IDENTITY_TYPE_PUBLIC);
+  // The SDK generates the TX power Data Element.
+  EXPECT_THAT(sections[1].data_elements,
+              ElementsAre(DataElement(DataElement::kBatteryFieldType, "b")));
+}
+
+TEST(BroadcastRequestTest, CreateBaseWhenExtendedAdvertisementUnavailable) {
+  PresenceBroadcast presence_request = {
+      .sections = {{.identity = internal::IDENTITY_TYPE_PUBLIC},
+                   {.identity = internal::IDENTITY_TYPE_PUBLIC}}};
+  BroadcastRequest input = {.variant = presence_request};
+
+  absl::StatusOr<BaseBroadcastRequest> request = BaseBroadcastRequest::Create(
+      input, /*extended_advertisement_available=*/false);
+
+  ASSERT_OK(request);
+  EXPECT_TRUE(absl::holds_alternative<BaseBroadcastRequest::BasePresence>(
+      request->variant));
+}
+
+TEST(BroadcastRequestTest, CreateBaseWhenRequestFitsInBaseAdvertisement) {
+  PresenceBroadcast presence_request = {
+      .sections = {{.identity = internal::IDENTITY_TYPE_PUBLIC,
+                    .extended_properties = {
+                        DataElement(ActionBit::kActiveUnlockAction)}}}};
+  BroadcastRequest input = {.variant = presence_request};
+
+  absl::StatusOr<BaseBroadcastRequest> request = BaseBroadcastRequest::Create(
+      input, /*extended_advertisement_available=*/true);
+
+  ASSERT_OK(request);
+  EXPECT_TRUE(absl::holds_alternative<BaseBroadcastRequest::BasePresence>(
+      request->variant));
+}
+
+TEST(BroadcastRequestTest, CreateExtendedWithTwoEncryptedSectionsFails) {
+  PresenceBroadcast presence_request = {
+      .sections = {{.identity = internal::IDENTITY_TYPE_PRIVATE},
+                   {.identity = internal::IDENTITY_TYPE_TRUSTED}}};
+  BroadcastRequest input = {.variant = presence_request};
+
+  EXPECT_THAT(BaseBroadcastRequest::Create(
+                  input, /*extended_advertisement_available=*/true),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 TEST(BroadcastRequestTest, CreateFromEmptyPresenceRequestFails) {
   BroadcastRequest empty = {
       .variant = PresenceBroadcast(),
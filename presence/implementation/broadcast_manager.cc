@@ -76,8 +76,8 @@ std::string SelectSalt(LocalCredential& credential,
 
 absl::StatusOr<BroadcastSessionId> BroadcastManager::StartBroadcast(
     BroadcastRequest broadcast_request, BroadcastCallback callback) {
-  absl::StatusOr<BaseBroadcastRequest> request =
-      BaseBroadcastRequest::Create(broadcast_request);
+  absl::StatusOr<BaseBroadcastRequest> request = BaseBroadcastRequest::Create(
+      broadcast_request, mediums_->GetBle().IsExtendedAdvertisementsAvailable());
   if (!request.ok()) {
     NEARBY_LOGS(WARNING) << "Invalid broadcast request, reason: "
                          << request.status();
@@ -14,6 +14,7 @@
 
 #include "presence/implementation/connection_authenticator.h"
 
+#include <memory>
 #include <optional>
 #include <string>
 #include <vector>
@@ -26,6 +27,7 @@
 #include "internal/crypto/ed25519.h"
 #include "internal/crypto_cros/hkdf.h"
 #include "internal/crypto_cros/secure_util.h"
+#include "internal/platform/mutex_lock.h"
 #include "internal/proto/credential.pb.h"
 #include "internal/proto/local_credential.pb.h"
 
@@ -44,6 +46,22 @@ constexpr char kBroadcasterHkdfInfo[] =
     "Nearby Presence Broadcaster Credential Hash";
 constexpr char kDiscovererHkdfInfo[] =
     "Nearby Presence Discoverer Credential Hash";
+constexpr char kBroadcasterHintHkdfInfo[] =
+    "Nearby Presence Broadcaster Signer Hint";
+constexpr char kDiscovererHintHkdfInfo[] =
+    "Nearby Presence Discoverer Signer Hint";
+// Short enough to say little about the credential. Two credentials sharing a
+// hint only cost an extra signature verification.
+constexpr int kSignerCredentialHintSize = 8;
+// The verifier cache starts over once it holds this many verifiers.
+constexpr int kMaxCachedVerifiers = 1024;
+
+std::string SignerCredentialHint(absl::string_view ukey2_secret,
+                                 absl::string_view key_seed,
+                                 absl::string_view hint_info) {
+  return crypto::HkdfSha256(absl::StrCat(ukey2_secret, key_seed), kHkdfSalt,
+                            hint_info, kSignerCredentialHintSize);
+}
 }  // namespace
 
 absl::StatusOr<ConnectionAuthenticator::InitiatorData>
@@ -69,6 +87,9 @@ ConnectionAuthenticator::BuildSignedMessageAsInitiator(
     return ConnectionAuthenticator::TwoWayInitiatorData{
         .shared_credential_hash = shared_credential_hash,
         .private_key_signature = *pkey_signature,
+        .signer_credential_hint =
+            SignerCredentialHint(ukey2_secret, local_credential->key_seed(),
+                                 kDiscovererHintHkdfInfo),
     };
   }
   // one-way authentication, trusted identity.
@@ -91,8 +112,12 @@ ConnectionAuthenticator::BuildSignedMessageAsResponder(
   if (!pkey_signature.has_value()) {
     return absl::InternalError("Signing using private key failed.");
   }
-  return ConnectionAuthenticator::ResponderData{.private_key_signature =
-                                                    *pkey_signature};
+  return ConnectionAuthenticator::ResponderData{
+      .private_key_signature = *pkey_signature,
+      .signer_credential_hint =
+          SignerCredentialHint(ukey2_secret, local_credential.key_seed(),
+                               kBroadcasterHintHkdfInfo),
+  };
 }
 
 absl::Status ConnectionAuthenticator::VerifyMessageAsInitiator(
@@ -101,19 +126,12 @@ absl::Status ConnectionAuthenticator::VerifyMessageAsInitiator(
   if (authentication_data.private_key_signature.empty()) {
     return absl::InvalidArgumentError("Empty private key signature.");
   }
-  for (const auto& shared_credential : shared_credentials) {
-    auto verifier = crypto::Ed25519Verifier::Create(
-        shared_credential.connection_signature_verification_key());
-    if (!verifier.ok()) {
-      continue;
-    }
-    // Verify ED25519 signature, returning true if verification succeeded.
-    if (verifier
-            ->Verify(absl::StrCat(kBroadcasterMessageHeader, ukey2_secret),
-                     authentication_data.private_key_signature)
-            .ok()) {
-      return absl::OkStatus();
-    }
+  if (VerifySignature(absl::StrCat(kBroadcasterMessageHeader, ukey2_secret),
+                      authentication_data.private_key_signature, ukey2_secret,
+                      kBroadcasterHintHkdfInfo,
+                      authentication_data.signer_credential_hint,
+                      shared_credentials)) {
+    return absl::OkStatus();
   }
   return absl::InternalError("Unable to verify responder's private key sig.");
 }
@@ -170,20 +188,11 @@ ConnectionAuthenticator::VerifyMessageAsResponder(
       }
     }
     // Now, match our shared credential.
-    std::optional<internal::SharedCredential> matched_shared_credential;
-    for (const auto& shared_credential : shared_credentials) {
-      auto verifier = crypto::Ed25519Verifier::Create(
-          shared_credential.connection_signature_verification_key());
-      if (!verifier.ok() ||
-          verifier
-              ->Verify(absl::StrCat(kDiscovererMessageHeader, ukey2_secret),
-                       auth_data.private_key_signature)
-              .ok()) {
-        matched_shared_credential = shared_credential;
-        break;
-      }
-    }
-    if (!matched_shared_credential.has_value()) {
+    if (!VerifySignature(absl::StrCat(kDiscovererMessageHeader, ukey2_secret),
+                         auth_data.private_key_signature, ukey2_secret,
+                         kDiscovererHintHkdfInfo,
+                         auth_data.signer_credential_hint,
+                         shared_credentials)) {
       return absl::InternalError("Unable to verify shared credential.");
     }
   }
@@ -193,5 +202,47 @@ ConnectionAuthenticator::VerifyMessageAsResponder(
   return absl::InternalError("Unable to verify local credential.");
 }
 
+bool ConnectionAuthenticator::VerifySignature(
+    absl::string_view message, absl::string_view signature,
+    absl::string_view ukey2_secret, absl::string_view hint_info,
+    absl::string_view signer_credential_hint,
+    const std::vector<internal::SharedCredential>& shared_credentials) const {
+  for (const auto& shared_credential : shared_credentials) {
+    // Deriving the hint is much cheaper than verifying the signature.
+    if (!signer_credential_hint.empty() &&
+        SignerCredentialHint(ukey2_secret, shared_credential.key_seed(),
+                             hint_info) != signer_credential_hint) {
+      continue;
+    }
+    std::shared_ptr<crypto::Ed25519Verifier> verifier =
+        GetVerifier(shared_credential.connection_signature_verification_key());
+    // Verify ED25519 signature, returning true if verification succeeded.
+    if (verifier != nullptr && verifier->Verify(message, signature).ok()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::shared_ptr<crypto::Ed25519Verifier> ConnectionAuthenticator::GetVerifier(
+    const std::string& public_key) const {
+  MutexLock lock(&mutex_);
+  auto it = verifiers_.find(public_key);
+  if (it != verifiers_.end()) {
+    return it->second;
+  }
+  auto verifier = crypto::Ed25519Verifier::Create(public_key);
+  if (!verifier.ok()) {
+    return nullptr;
+  }
+  if (verifiers_.size() >= kMaxCachedVerifiers) {
+    verifiers_.clear();
+  }
+  auto cached_verifier =
+      std::make_shared<crypto::Ed25519Verifier>(*std::move(verifier));
+  verifiers_.emplace(public_key, cached_verifier);
+  return cached_verifier;
+}
+
 }  // namespace presence
 }  // namespace nearby
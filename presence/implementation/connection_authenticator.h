@@ -15,13 +15,18 @@
 #ifndef THIRD_PARTY_NEARBY_PRESENCE_IMPLEMENTATION_CONNECTION_AUTHENTICATOR_H_
 #define THIRD_PARTY_NEARBY_PRESENCE_IMPLEMENTATION_CONNECTION_AUTHENTICATOR_H_
 
+#include <memory>
 #include <optional>
 #include <string>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "internal/crypto/ed25519.h"
+#include "internal/platform/mutex.h"
 #include "internal/proto/credential.pb.h"
 #include "internal/proto/local_credential.pb.h"
 
@@ -37,10 +42,16 @@ class ConnectionAuthenticator {
   struct TwoWayInitiatorData {
     std::string shared_credential_hash;
     std::string private_key_signature;
+    // Derived from the key seed of the credential that made
+    // `private_key_signature`, so the responder only verifies against the
+    // shared credential with that key seed. Empty if the peer didn't send one.
+    std::string signer_credential_hint;
   };
 
   struct ResponderData {
     std::string private_key_signature;
+    // Same as `TwoWayInitiatorData::signer_credential_hint`.
+    std::string signer_credential_hint;
   };
 
   using InitiatorData = absl::variant<OneWayInitiatorData, TwoWayInitiatorData>;
@@ -91,6 +102,27 @@ class ConnectionAuthenticator {
       absl::string_view ukey2_secret, InitiatorData initiator_data,
       const std::vector<internal::LocalCredential>& local_credentials,
       const std::vector<internal::SharedCredential>& shared_credentials) const;
+
+ private:
+  // Returns whether `signature` over `message` was made with the key of one of
+  // `shared_credentials`. With a `signer_credential_hint`, only the
+  // credentials whose key seed matches the hint are tried. Without one, every
+  // credential is tried against the same message.
+  bool VerifySignature(
+      absl::string_view message, absl::string_view signature,
+      absl::string_view ukey2_secret, absl::string_view hint_info,
+      absl::string_view signer_credential_hint,
+      const std::vector<internal::SharedCredential>& shared_credentials) const;
+
+  // Returns the verifier for `public_key`, parsing it on first use.
+  std::shared_ptr<crypto::Ed25519Verifier> GetVerifier(
+      const std::string& public_key) const ABSL_LOCKS_EXCLUDED(mutex_);
+
+  mutable Mutex mutex_;
+  // Verifiers of the shared credentials seen so far, by public key.
+  mutable absl::flat_hash_map<std::string,
+                              std::shared_ptr<crypto::Ed25519Verifier>>
+      verifiers_ ABSL_GUARDED_BY(mutex_);
 };
 
 }  // namespace presence
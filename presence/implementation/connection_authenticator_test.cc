@@ -34,6 +34,7 @@ using ::testing::status::StatusIs;
 constexpr char kUkey2Secret[] = {0x34, 0x56, 0x78, 0x90};
 constexpr char kKeySeed1[] = {1, 2, 3, 4, 5, 6, 7, 8};
 constexpr char kKeySeed2[] = {8, 7, 6, 5, 4, 3, 2, 1};
+constexpr int kManyCredentials = 100;
 
 internal::LocalCredential BuildLocalCredential(
     const crypto::Ed25519KeyPair& key_pair, absl::string_view key_seed) {
@@ -267,6 +268,97 @@ TEST_F(PresenceAuthenticatorTest,
                   auth_data, kUkey2Secret, {responder_shared_credential_}),
               StatusIs(absl::StatusCode::kInvalidArgument));
 }
+
+TEST_F(PresenceAuthenticatorTest,
+       TestResponderSignInitiatorVerifyWithoutHint) {
+  ConnectionAuthenticator responder_authenticator;
+  ConnectionAuthenticator initiator_authenticator;
+  ASSERT_OK_AND_ASSIGN(ConnectionAuthenticator::ResponderData auth_data,
+                       responder_authenticator.BuildSignedMessageAsResponder(
+                           kUkey2Secret, responder_local_credential_));
+  auth_data.signer_credential_hint.clear();
+  EXPECT_OK(initiator_authenticator.VerifyMessageAsInitiator(
+      auth_data, kUkey2Secret,
+      {responder_shared_credential_wrong_key_, responder_shared_credential_}));
+}
+
+TEST_F(PresenceAuthenticatorTest,
+       TestResponderSignInitiatorVerifyWrongHintFails) {
+  ConnectionAuthenticator responder_authenticator;
+  ConnectionAuthenticator initiator_authenticator;
+  ASSERT_OK_AND_ASSIGN(ConnectionAuthenticator::ResponderData auth_data,
+                       responder_authenticator.BuildSignedMessageAsResponder(
+                           kUkey2Secret, responder_local_credential_));
+  // Same key, but the key seed of another credential.
+  internal::SharedCredential wrong_key_seed_credential =
+      responder_shared_credential_;
+  wrong_key_seed_credential.set_key_seed(
+      initiator_shared_credential_.key_seed());
+  EXPECT_THAT(initiator_authenticator.VerifyMessageAsInitiator(
+                  auth_data, kUkey2Secret, {wrong_key_seed_credential}),
+              StatusIs(absl::StatusCode::kInternal));
+}
+
+TEST_F(PresenceAuthenticatorTest,
+       TestTwoWayInitiatorSignResponderVerifyInvalidKeyFails) {
+  ConnectionAuthenticator responder_authenticator;
+  ConnectionAuthenticator initiator_authenticator;
+  ASSERT_OK_AND_ASSIGN(ConnectionAuthenticator::InitiatorData auth_data,
+                       initiator_authenticator.BuildSignedMessageAsInitiator(
+                           kUkey2Secret, initiator_local_credential_,
+                           responder_shared_credential_));
+  internal::SharedCredential invalid_key_credential =
+      initiator_shared_credential_;
+  invalid_key_credential.clear_connection_signature_verification_key();
+  EXPECT_THAT(responder_authenticator.VerifyMessageAsResponder(
+                  kUkey2Secret, auth_data, {responder_local_credential_},
+                  {invalid_key_credential}),
+              StatusIs(absl::StatusCode::kInternal));
+}
+
+TEST_F(PresenceAuthenticatorTest, TestRepeatedVerificationsSucceed) {
+  ConnectionAuthenticator responder_authenticator;
+  ConnectionAuthenticator initiator_authenticator;
+  ASSERT_OK_AND_ASSIGN(ConnectionAuthenticator::ResponderData auth_data,
+                       responder_authenticator.BuildSignedMessageAsResponder(
+                           kUkey2Secret, responder_local_credential_));
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_OK(initiator_authenticator.VerifyMessageAsInitiator(
+        auth_data, kUkey2Secret, {responder_shared_credential_}));
+    EXPECT_THAT(initiator_authenticator.VerifyMessageAsInitiator(
+                    auth_data, kUkey2Secret,
+                    {responder_shared_credential_wrong_key_}),
+                StatusIs(absl::StatusCode::kInternal));
+  }
+}
+
+TEST_F(PresenceAuthenticatorTest,
+       TestVerifyAmongManyCredentialsWithAndWithoutHint) {
+  ConnectionAuthenticator responder_authenticator;
+  ConnectionAuthenticator initiator_authenticator;
+  ASSERT_OK_AND_ASSIGN(ConnectionAuthenticator::ResponderData auth_data,
+                       responder_authenticator.BuildSignedMessageAsResponder(
+                           kUkey2Secret, responder_local_credential_));
+  ConnectionAuthenticator::ResponderData auth_data_without_hint = auth_data;
+  auth_data_without_hint.signer_credential_hint.clear();
+  std::vector<internal::SharedCredential> shared_credentials;
+  for (int i = 1; i < kManyCredentials; ++i) {
+    ASSERT_OK_AND_ASSIGN(auto key_pair,
+                         crypto::Ed25519Signer::CreateNewKeyPair());
+    shared_credentials.push_back(
+        BuildSharedCredential(key_pair, absl::StrCat("contact", i)));
+  }
+
+  EXPECT_THAT(initiator_authenticator.VerifyMessageAsInitiator(
+                  auth_data, kUkey2Secret, shared_credentials),
+              StatusIs(absl::StatusCode::kInternal));
+  shared_credentials.push_back(responder_shared_credential_);
+  EXPECT_OK(initiator_authenticator.VerifyMessageAsInitiator(
+      auth_data, kUkey2Secret, shared_credentials));
+  EXPECT_OK(initiator_authenticator.VerifyMessageAsInitiator(
+      auth_data_without_hint, kUkey2Secret, shared_credentials));
+}
+
 }  // namespace
 }  // namespace presence
 }  // namespace nearby
@@ -0,0 +1,189 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "presence/implementation/data_element_codec.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "internal/platform/logging.h"
+#include "presence/data_element.h"
+
+namespace nearby {
+namespace presence {
+
+namespace {
+
+// Flags the extended (v1) DE header with a separate type byte.
+constexpr uint8_t kExtendedHeaderFlag = 0x80;
+constexpr uint8_t kExtendedHeaderLengthMask = 0x7F;
+// Max length and type that fit in a single byte extended header.
+constexpr size_t kMaxShortHeaderLength = 7;
+constexpr unsigned kMaxShortHeaderType = DataElement::kMaxDataElementType;
+constexpr unsigned kMaxExtendedHeaderType = 0x7F;
+
+}  // namespace
+
+absl::StatusOr<uint8_t> CreateDataElementHeader(size_t length,
+                                                unsigned data_type) {
+  if (length > DataElement::kMaxDataElementLength) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Unsupported Data Element length: %d", length));
+  }
+  if (data_type > DataElement::kMaxDataElementType) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Unsupported Data Element type: %d", data_type));
+  }
+  return (length << DataElement::kDataElementLengthShift) | data_type;
+}
+
+absl::Status DataElementReader::ReadHeader(uint8_t& type, size_t& length) {
+  uint8_t header = input_[index_];
+  if (!IsDataElementHeaderAllowed(header)) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Unsupported Data Element 0x%x", header));
+  }
+  type = GetDataElementHeaderType(header);
+  length = GetDataElementTrueLength(header);
+  ++index_;
+  return absl::OkStatus();
+}
+
+absl::Status DataElementReader::ReadExtendedHeader(uint8_t& type,
+                                                   size_t& length) {
+  uint8_t header = input_[index_];
+  if ((header & kExtendedHeaderFlag) == 0) {
+    type = GetDataElementHeaderType(header);
+    length = GetDataElementHeaderLength(header);
+    ++index_;
+    return absl::OkStatus();
+  }
+  if (index_ + 1 >= input_.size()) {
+    return absl::OutOfRangeError(absl::StrFormat(
+        "Data element header 0x%x is missing the type byte", header));
+  }
+  uint8_t type_byte = input_[index_ + 1];
+  if (type_byte > kMaxExtendedHeaderType) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Unsupported Data Element type 0x%x", type_byte));
+  }
+  type = type_byte;
+  length = header & kExtendedHeaderLengthMask;
+  index_ += 2;
+  return absl::OkStatus();
+}
+
+absl::StatusOr<DataElementView> DataElementReader::Next() {
+  if (index_ >= input_.size()) {
+    return absl::OutOfRangeError(absl::StrFormat(
+        "Data element (%s) is %d bytes long. Expected more than %d",
+        absl::BytesToHexString(input_), input_.size(), index_));
+  }
+  uint8_t type;
+  size_t length;
+  absl::Status status = format_ == DataElementFormat::kBase
+                            ? ReadHeader(type, length)
+                            : ReadExtendedHeader(type, length);
+  if (!status.ok()) {
+    // Leave the reader at the end so that a caller ignoring the error can't
+    // loop forever.
+    index_ = input_.size();
+    return status;
+  }
+  size_t start = index_;
+  if (start + length > input_.size()) {
+    index_ = input_.size();
+    return absl::OutOfRangeError(absl::StrFormat(
+        "Data element (%s) is %d bytes long. Expected at least %d",
+        absl::BytesToHexString(input_), input_.size(), start + length));
+  }
+  index_ = start + length;
+  DataElementView view = {.type = type, .value = input_.substr(start, length)};
+  NEARBY_LOGS(VERBOSE) << "Type: " << static_cast<int>(view.type)
+                       << " length: " << length
+                       << " DE: " << absl::BytesToHexString(view.value);
+  return view;
+}
+
+absl::Status DataElementWriter::AppendBytes(absl::string_view bytes) {
+  if (bytes.size() > max_size_ - size_) {
+    return absl::OutOfRangeError(absl::StrFormat(
+        "Advertisement is too long. Can't add %d bytes to %d, max size is %d",
+        bytes.size(), size_, max_size_));
+  }
+  if (!bytes.empty()) {
+    std::memcpy(buffer_.data() + size_, bytes.data(), bytes.size());
+    size_ += bytes.size();
+  }
+  return absl::OkStatus();
+}
+
+absl::Status DataElementWriter::AppendDataElement(unsigned data_type,
+                                                  absl::string_view value) {
+  if (format_ == DataElementFormat::kExtended) {
+    return AppendExtendedDataElement(data_type, value);
+  }
+  absl::StatusOr<uint8_t> header =
+      CreateDataElementHeader(value.size(), data_type);
+  if (!header.ok()) {
+    NEARBY_LOG(WARNING, "Can't add Data element type: %d, length: %d",
+               data_type, value.size());
+    return header.status();
+  }
+  if (1 + value.size() > max_size_ - size_) {
+    return absl::OutOfRangeError(absl::StrFormat(
+        "Advertisement is too long. Can't add Data element type: %d, length: "
+        "%d to %d bytes",
+        data_type, value.size(), size_));
+  }
+  buffer_[size_++] = static_cast<char>(*header);
+  return AppendBytes(value);
+}
+
+absl::Status DataElementWriter::AppendExtendedDataElement(
+    unsigned data_type, absl::string_view value) {
+  if (data_type > kMaxExtendedHeaderType ||
+      value.size() > kExtendedHeaderLengthMask) {
+    NEARBY_LOG(WARNING, "Can't add Data element type: %d, length: %d",
+               data_type, value.size());
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Unsupported Data Element type: %d, length: %d",
+                        data_type, value.size()));
+  }
+  bool short_header = value.size() <= kMaxShortHeaderLength &&
+                      data_type <= kMaxShortHeaderType;
+  size_t header_size = short_header ? 1 : 2;
+  if (header_size + value.size() > max_size_ - size_) {
+    return absl::OutOfRangeError(absl::StrFormat(
+        "Advertisement is too long. Can't add Data element type: %d, length: "
+        "%d to %d bytes",
+        data_type, value.size(), size_));
+  }
+  if (short_header) {
+    buffer_[size_++] = static_cast<char>(
+        (value.size() << DataElement::kDataElementLengthShift) | data_type);
+  } else {
+    buffer_[size_++] = static_cast<char>(kExtendedHeaderFlag | value.size());
+    buffer_[size_++] = static_cast<char>(data_type);
+  }
+  return AppendBytes(value);
+}
+
+}  // namespace presence
+}  // namespace nearby
@@ -0,0 +1,226 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_NEARBY_PRESENCE_IMPLEMENTATION_DATA_ELEMENT_CODEC_H_
+#define THIRD_PARTY_NEARBY_PRESENCE_IMPLEMENTATION_DATA_ELEMENT_CODEC_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "presence/data_element.h"
+#include "presence/implementation/base_broadcast_request.h"
+
+namespace nearby {
+namespace presence {
+
+// Maximum size of a base NP (v0) advertisement, including the version byte.
+constexpr size_t kMaxBaseNpAdvertisementSize = 26;
+// Maximum size of a Presence extended advertisement, including the header
+// byte. That's 254 bytes of BLE 5 advertising data minus the service data
+// header.
+constexpr size_t kMaxExtendedNpAdvertisementSize = 250;
+
+// Header byte of a Presence extended advertisement. The extended format uses
+// the NP v1 Data Element header but not the v1 section encoding or crypto
+// (sections are not signed and encrypted sections use LDT), so it must not be
+// mistaken for NP v1. It claims version 7 in the top 3 bits, which NP
+// reserves, so NP v1 scanners reject it instead of misparsing it.
+constexpr uint8_t kExtendedAdvertisementHeader = 0xE0;
+// Version reported for decoded Presence extended advertisements.
+constexpr uint8_t kExtendedAdvertisementVersion = 7;
+
+// The Data Element header format.
+enum class DataElementFormat {
+  // Base NP (v0), sent in BLE 4.2 advertisements. The header is
+  // (length << 4 | type) and some types carry bytes not counted in the length.
+  kBase,
+  // Presence extended, sent in BLE 5 extended advertisements and modeled on
+  // the NP v1 Data Element header. A header with the high bit clear is
+  // (length << 4 | type), for lengths up to 7. Otherwise the header is
+  // (0x80 | length) followed by a type byte. The length always covers the
+  // whole value.
+  kExtended,
+};
+
+// Describes how a Data Element type is encoded in a v0 advertisement.
+struct DataElementEncoding {
+  // False if the type is not allowed in a v0 advertisement.
+  bool allowed;
+  // Range of values allowed in the length field of the DE header.
+  uint8_t min_header_length;
+  uint8_t max_header_length;
+  // Number of bytes following the header that are not counted in the length
+  // field. Encrypted identities carry salt and metadata key, Eddystone IDs are
+  // longer than what fits in 4 bits.
+  uint8_t additional_length;
+  bool is_identity;
+  bool is_encrypted_identity;
+};
+
+// Encoding rules indexed by Data Element type.
+inline constexpr std::array<DataElementEncoding,
+                            DataElement::kMaxDataElementType + 1>
+    kDataElementEncodings = {{
+        // kSaltFieldType
+        {true, 2, 2, 0, false, false},
+        // kPrivateIdentityFieldType
+        {true, 2, 6, kSaltSize + kBaseMetadataSize, true, true},
+        // kTrustedIdentityFieldType
+        {true, 2, 6, kSaltSize + kBaseMetadataSize, true, true},
+        // kPublicIdentityFieldType
+        {true, 0, 0, 0, true, false},
+        // kProvisionedIdentityFieldType
+        {true, 2, 6, kSaltSize + kBaseMetadataSize, true, true},
+        // kTxPowerFieldType
+        {true, 1, 1, 0, false, false},
+        // kActionFieldType
+        {true, 1, 3, 0, false, false},
+        // kModelIdFieldType
+        {true, 3, 3, 0, false, false},
+        // kEddystoneIdFieldType
+        {true, 0, 0, 20, false, false},
+        // kAccountKeyDataFieldType
+        {true, 0, 12, 0, false, false},
+        // kConnectionStatusFieldType
+        {true, 0, 3, 0, false, false},
+        // kBatteryFieldType
+        {true, 0, 3, 0, false, false},
+        // kAdvertisementSignature, kContextTimestampFieldType and reserved
+        // types are not supported in v0 advertisements.
+        {false, 0, 0, 0, false, false},
+        {false, 0, 0, 0, false, false},
+        {false, 0, 0, 0, false, false},
+        {false, 0, 0, 0, false, false},
+    }};
+
+constexpr uint8_t GetDataElementHeaderType(uint8_t header) {
+  return header & ((1 << DataElement::kDataElementLengthShift) - 1);
+}
+
+constexpr uint8_t GetDataElementHeaderLength(uint8_t header) {
+  return header >> DataElement::kDataElementLengthShift;
+}
+
+// Returns true if the DE header describes a valid DE in v0 advertisement.
+constexpr bool IsDataElementHeaderAllowed(uint8_t header) {
+  const DataElementEncoding& encoding =
+      kDataElementEncodings[GetDataElementHeaderType(header)];
+  uint8_t length = GetDataElementHeaderLength(header);
+  return encoding.allowed && length >= encoding.min_header_length &&
+         length <= encoding.max_header_length;
+}
+
+// Returns the real length of a DE in v0 advertisement, which may be larger than
+// the value in the header.
+constexpr size_t GetDataElementTrueLength(uint8_t header) {
+  return GetDataElementHeaderLength(header) +
+         kDataElementEncodings[GetDataElementHeaderType(header)]
+             .additional_length;
+}
+
+constexpr bool IsIdentityDataElementType(uint8_t type) {
+  return type <= DataElement::kMaxDataElementType &&
+         kDataElementEncodings[type].is_identity;
+}
+
+constexpr bool IsEncryptedIdentityDataElementType(uint8_t type) {
+  return type <= DataElement::kMaxDataElementType &&
+         kDataElementEncodings[type].is_encrypted_identity;
+}
+
+// Returns a DE header or an error if `length` or `data_type` don't fit in it.
+absl::StatusOr<uint8_t> CreateDataElementHeader(size_t length,
+                                                unsigned data_type);
+
+// A non-owning view of a Data Element. `value` points into the buffer the
+// element was decoded from, which must outlive the view.
+struct DataElementView {
+  uint8_t type;
+  absl::string_view value;
+
+  // Copies the view into an owning `DataElement`.
+  DataElement ToDataElement() const { return DataElement(type, value); }
+};
+
+// Decodes Data Elements from an advertisement without copying them.
+class DataElementReader {
+ public:
+  // Reads DEs from `input`, starting at `offset`.
+  explicit DataElementReader(
+      absl::string_view input, size_t offset = 0,
+      DataElementFormat format = DataElementFormat::kBase)
+      : input_(input), index_(offset), format_(format) {}
+
+  bool HasNext() const { return index_ < input_.size(); }
+
+  // Returns the next DE or an error if the input is malformed. A view returned
+  // after an error is never valid; stop reading after the first error.
+  absl::StatusOr<DataElementView> Next();
+
+ private:
+  // Reads the header at `index_`. Sets `type` and the length of the value,
+  // and advances `index_` past the header.
+  absl::Status ReadHeader(uint8_t& type, size_t& length);
+  absl::Status ReadExtendedHeader(uint8_t& type, size_t& length);
+
+  absl::string_view input_;
+  size_t index_;
+  DataElementFormat format_;
+};
+
+// Encodes an advertisement into a fixed-size buffer, without allocating. The
+// buffer holds up to `kMaxBaseNpAdvertisementSize` bytes in the base format
+// and `kMaxExtendedNpAdvertisementSize` bytes in the extended format.
+class DataElementWriter {
+ public:
+  explicit DataElementWriter(
+      DataElementFormat format = DataElementFormat::kBase)
+      : format_(format),
+        max_size_(format == DataElementFormat::kBase
+                      ? kMaxBaseNpAdvertisementSize
+                      : kMaxExtendedNpAdvertisementSize) {}
+
+  // Appends raw bytes, for example the version byte or an encrypted section.
+  absl::Status AppendBytes(absl::string_view bytes);
+  absl::Status AppendByte(uint8_t byte) {
+    char c = static_cast<char>(byte);
+    return AppendBytes(absl::string_view(&c, 1));
+  }
+
+  // Appends a DE header followed by `value`.
+  absl::Status AppendDataElement(unsigned data_type, absl::string_view value);
+
+  absl::string_view data() const {
+    return absl::string_view(buffer_.data(), size_);
+  }
+  size_t size() const { return size_; }
+
+ private:
+  absl::Status AppendExtendedDataElement(unsigned data_type,
+                                         absl::string_view value);
+
+  DataElementFormat format_;
+  size_t max_size_;
+  std::array<char, kMaxExtendedNpAdvertisementSize> buffer_;
+  size_t size_ = 0;
+};
+
+}  // namespace presence
+}  // namespace nearby
+
+#endif  // THIRD_PARTY_NEARBY_PRESENCE_IMPLEMENTATION_DATA_ELEMENT_CODEC_H_
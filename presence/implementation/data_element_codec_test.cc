@@ -0,0 +1,343 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "presence/implementation/data_element_codec.h"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "protobuf-matchers/protocol-buffer-matchers.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/string_view.h"
+#include "presence/data_element.h"
+
+namespace nearby {
+namespace presence {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::status::StatusIs;
+
+// The string-based codec that `DataElementReader` and `DataElementWriter`
+// replaced. Kept here as a reference for the comparison tests.
+bool LegacyIsDataElementAllowed(uint8_t header) {
+  uint8_t data_type = header & 0x0F;
+  size_t length = header >> 4;
+  switch (data_type) {
+    case DataElement::kSaltFieldType:
+      return length == 2;
+    case DataElement::kPublicIdentityFieldType:
+      return length == 0;
+    case DataElement::kPrivateIdentityFieldType:
+    case DataElement::kProvisionedIdentityFieldType:
+    case DataElement::kTrustedIdentityFieldType:
+      return length >= 2 && length <= 6;
+    case DataElement::kTxPowerFieldType:
+      return length == 1;
+    case DataElement::kActionFieldType:
+      return length >= 1 && length <= 3;
+    case DataElement::kModelIdFieldType:
+      return length == 3;
+    case DataElement::kEddystoneIdFieldType:
+      return length == 0;
+    case DataElement::kAccountKeyDataFieldType:
+      return length <= 12;
+    case DataElement::kConnectionStatusFieldType:
+      return length <= 3;
+    case DataElement::kBatteryFieldType:
+      return length <= 3;
+    default:
+      return false;
+  }
+}
+
+size_t LegacyGetDataElementTrueLength(uint8_t header) {
+  uint8_t data_type = header & 0x0F;
+  size_t length = header >> 4;
+  if (data_type == DataElement::kPrivateIdentityFieldType ||
+      data_type == DataElement::kTrustedIdentityFieldType ||
+      data_type == DataElement::kProvisionedIdentityFieldType) {
+    length += 16;
+  } else if (data_type == DataElement::kEddystoneIdFieldType) {
+    length += 20;
+  }
+  return length;
+}
+
+absl::StatusOr<std::vector<DataElement>> LegacyDecode(
+    absl::string_view input) {
+  std::vector<DataElement> result;
+  size_t index = 0;
+  while (index < input.size()) {
+    uint8_t header = input[index];
+    if (!LegacyIsDataElementAllowed(header)) {
+      return absl::InvalidArgumentError("Unsupported Data Element");
+    }
+    size_t length = LegacyGetDataElementTrueLength(header);
+    ++index;
+    size_t start = index;
+    index += length;
+    if (index > input.size()) {
+      return absl::OutOfRangeError("Data element too short");
+    }
+    result.push_back(DataElement(header & 0x0F, input.substr(start, length)));
+  }
+  return result;
+}
+
+std::string LegacyEncode(const std::vector<DataElement>& data_elements) {
+  std::string output;
+  for (const auto& elem : data_elements) {
+    output.push_back(static_cast<char>(
+        (elem.GetValue().size() << DataElement::kDataElementLengthShift) |
+        elem.GetType()));
+    output.append(elem.GetValue().data(), elem.GetValue().size());
+  }
+  return output;
+}
+
+absl::StatusOr<std::vector<DataElement>> Decode(
+    absl::string_view input,
+    DataElementFormat format = DataElementFormat::kBase) {
+  std::vector<DataElement> result;
+  DataElementReader reader(input, /*offset=*/0, format);
+  while (reader.HasNext()) {
+    absl::StatusOr<DataElementView> view = reader.Next();
+    if (!view.ok()) {
+      return view.status();
+    }
+    result.push_back(view->ToDataElement());
+  }
+  return result;
+}
+
+TEST(DataElementCodecTest, EncodingTableMatchesLegacyRules) {
+  for (int header = 0; header <= 0xFF; ++header) {
+    SCOPED_TRACE(header);
+    EXPECT_EQ(IsDataElementHeaderAllowed(header),
+              LegacyIsDataElementAllowed(header));
+    if (IsDataElementHeaderAllowed(header)) {
+      EXPECT_EQ(GetDataElementTrueLength(header),
+                LegacyGetDataElementTrueLength(header));
+    }
+  }
+}
+
+TEST(DataElementCodecTest, ReadDataElements) {
+  std::string input = absl::HexStringToBytes("0020abcd1505");
+
+  DataElementReader reader(input, /*offset=*/1);
+
+  ASSERT_TRUE(reader.HasNext());
+  absl::StatusOr<DataElementView> salt = reader.Next();
+  ASSERT_TRUE(salt.ok());
+  EXPECT_EQ(salt->type, DataElement::kSaltFieldType);
+  EXPECT_EQ(absl::BytesToHexString(salt->value), "abcd");
+  // The view points into the input buffer.
+  EXPECT_EQ(salt->value.data(), input.data() + 2);
+  ASSERT_TRUE(reader.HasNext());
+  absl::StatusOr<DataElementView> tx_power = reader.Next();
+  ASSERT_TRUE(tx_power.ok());
+  EXPECT_EQ(tx_power->ToDataElement(),
+            DataElement(DataElement::kTxPowerFieldType, uint8_t{5}));
+  EXPECT_FALSE(reader.HasNext());
+}
+
+TEST(DataElementCodecTest, ReadEncryptedIdentityIncludesSaltAndMetadata) {
+  // Private identity with 2 bytes of DEs is 2 + 16 bytes long.
+  std::string input = "\x21" + std::string(18, 'x');
+
+  DataElementReader reader(input);
+  absl::StatusOr<DataElementView> identity = reader.Next();
+
+  ASSERT_TRUE(identity.ok());
+  EXPECT_EQ(identity->type, DataElement::kPrivateIdentityFieldType);
+  EXPECT_EQ(identity->value.size(), 18);
+  EXPECT_FALSE(reader.HasNext());
+}
+
+TEST(DataElementCodecTest, ReadUnsupportedDataElementFails) {
+  std::string input = absl::HexStringToBytes("0c");
+
+  DataElementReader reader(input);
+
+  EXPECT_THAT(reader.Next(), StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_FALSE(reader.HasNext());
+}
+
+TEST(DataElementCodecTest, ReadTruncatedDataElementFails) {
+  std::string input = absl::HexStringToBytes("20ab");
+
+  DataElementReader reader(input);
+
+  EXPECT_THAT(reader.Next(), StatusIs(absl::StatusCode::kOutOfRange));
+  EXPECT_FALSE(reader.HasNext());
+}
+
+TEST(DataElementCodecTest, WriteDataElements) {
+  DataElementWriter writer;
+
+  EXPECT_OK(writer.AppendByte(0));
+  EXPECT_OK(writer.AppendDataElement(DataElement::kPublicIdentityFieldType,
+                                     ""));
+  EXPECT_OK(writer.AppendDataElement(DataElement::kSaltFieldType, "\xab\xcd"));
+
+  EXPECT_EQ(absl::BytesToHexString(writer.data()), "000320abcd");
+}
+
+TEST(DataElementCodecTest, WriteInvalidDataElementFails) {
+  DataElementWriter writer;
+
+  EXPECT_THAT(writer.AppendDataElement(16, ""),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(writer.AppendDataElement(DataElement::kAccountKeyDataFieldType,
+                                       std::string(16, 'x')),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_EQ(writer.size(), 0);
+}
+
+TEST(DataElementCodecTest, WriteBeyondMaxAdvertisementSizeFails) {
+  DataElementWriter writer;
+  EXPECT_OK(writer.AppendBytes(std::string(kMaxBaseNpAdvertisementSize - 1,
+                                           'x')));
+
+  EXPECT_THAT(writer.AppendDataElement(DataElement::kTxPowerFieldType, "\x05"),
+              StatusIs(absl::StatusCode::kOutOfRange));
+  EXPECT_THAT(writer.AppendBytes("xyz"),
+              StatusIs(absl::StatusCode::kOutOfRange));
+  EXPECT_OK(writer.AppendByte(1));
+  EXPECT_OK(writer.AppendBytes(""));
+  EXPECT_EQ(writer.size(), kMaxBaseNpAdvertisementSize);
+}
+
+TEST(DataElementCodecTest, RoundTrip) {
+  std::vector<DataElement> data_elements = {
+      DataElement(DataElement::kPublicIdentityFieldType, ""),
+      DataElement(DataElement::kSaltFieldType, "\x01\x02"),
+      DataElement(DataElement::kTxPowerFieldType, uint8_t{0xF0}),
+      DataElement(DataElement::kActionFieldType, std::string("\x00\x40", 2)),
+      DataElement(DataElement::kModelIdFieldType, "\x0a\x0b\x0c")};
+  DataElementWriter writer;
+  for (const auto& elem : data_elements) {
+    ASSERT_OK(writer.AppendDataElement(elem.GetType(), elem.GetValue()));
+  }
+
+  EXPECT_EQ(writer.data(), LegacyEncode(data_elements));
+  absl::StatusOr<std::vector<DataElement>> decoded = Decode(writer.data());
+  ASSERT_OK(decoded);
+  EXPECT_EQ(*decoded, data_elements);
+}
+
+TEST(DataElementCodecTest, WriteExtendedDataElements) {
+  DataElementWriter writer(DataElementFormat::kExtended);
+
+  EXPECT_OK(writer.AppendDataElement(DataElement::kTxPowerFieldType, "\x05"));
+  EXPECT_OK(writer.AppendDataElement(DataElement::kAccountKeyDataFieldType,
+                                     "01234567"));
+  EXPECT_OK(writer.AppendDataElement(0x20, "a"));
+
+  EXPECT_EQ(absl::BytesToHexString(writer.data()),
+            "1505"
+            "88093031323334353637"
+            "812061");
+}
+
+TEST(DataElementCodecTest, WriteInvalidExtendedDataElementFails) {
+  DataElementWriter writer(DataElementFormat::kExtended);
+
+  EXPECT_THAT(writer.AppendDataElement(0x80, ""),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(writer.AppendDataElement(DataElement::kAccountKeyDataFieldType,
+                                       std::string(128, 'x')),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_EQ(writer.size(), 0);
+}
+
+TEST(DataElementCodecTest, ReadExtendedDataElementWithoutTypeFails) {
+  DataElementReader reader(absl::HexStringToBytes("1505" "88"), /*offset=*/0,
+                           DataElementFormat::kExtended);
+
+  EXPECT_OK(reader.Next());
+  EXPECT_THAT(reader.Next(), StatusIs(absl::StatusCode::kOutOfRange));
+  EXPECT_FALSE(reader.HasNext());
+}
+
+TEST(DataElementCodecTest, ExtendedRoundTrip) {
+  std::mt19937 random(/*seed=*/42);
+  std::uniform_int_distribution<int> type(0, 0x7F);
+  std::uniform_int_distribution<int> length(0, 40);
+  for (int i = 0; i < 1000; ++i) {
+    std::vector<DataElement> data_elements;
+    DataElementWriter writer(DataElementFormat::kExtended);
+    while (true) {
+      DataElement elem(type(random), std::string(length(random), 'x'));
+      if (!writer.AppendDataElement(elem.GetType(), elem.GetValue()).ok()) {
+        break;
+      }
+      data_elements.push_back(elem);
+    }
+
+    absl::StatusOr<std::vector<DataElement>> decoded =
+        Decode(writer.data(), DataElementFormat::kExtended);
+
+    ASSERT_OK(decoded);
+    EXPECT_EQ(*decoded, data_elements);
+  }
+}
+
+// Decodes random inputs with both codecs and expects the same outcome.
+TEST(DataElementCodecTest, FuzzMatchesLegacyDecoder) {
+  std::mt19937 random(/*seed=*/42);
+  std::uniform_int_distribution<int> byte(0, 0xFF);
+  std::uniform_int_distribution<int> size(0, kMaxBaseNpAdvertisementSize);
+  for (int i = 0; i < 20000; ++i) {
+    std::string input(size(random), 0);
+    for (char& c : input) {
+      c = static_cast<char>(byte(random));
+    }
+    // Bias half of the inputs towards valid headers so that decoding gets
+    // past the first DE.
+    if (i % 2 == 0) {
+      for (size_t j = 0; j < input.size();) {
+        uint8_t header = input[j];
+        while (!LegacyIsDataElementAllowed(header)) {
+          header = byte(random);
+        }
+        input[j] = static_cast<char>(header);
+        j += 1 + LegacyGetDataElementTrueLength(header);
+      }
+    }
+    SCOPED_TRACE(absl::BytesToHexString(input));
+
+    absl::StatusOr<std::vector<DataElement>> expected = LegacyDecode(input);
+    absl::StatusOr<std::vector<DataElement>> actual = Decode(input);
+
+    ASSERT_EQ(actual.ok(), expected.ok());
+    if (expected.ok()) {
+      EXPECT_EQ(*actual, *expected);
+    } else {
+      EXPECT_EQ(actual.status().code(), expected.status().code());
+    }
+  }
+}
+
+}  // namespace
+}  // namespace presence
+}  // namespace nearby
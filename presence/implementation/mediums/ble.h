@@ -19,6 +19,7 @@
 #include <string>
 #include <utility>
 
+#include "internal/platform/ble_scan_multiplexer.h"
 #include "internal/platform/ble_v2.h"
 #include "internal/platform/bluetooth_adapter.h"
 #include "internal/platform/uuid.h"
@@ -57,6 +58,11 @@ class Ble {
 
   bool IsAvailable() const { return medium_.IsValid(); }
 
+  // Returns true if the medium can broadcast BLE 5 extended advertisements.
+  bool IsExtendedAdvertisementsAvailable() {
+    return IsAvailable() && medium_.IsExtendedAdvertisementsAvailable();
+  }
+
   // Starts broadcasting NP advertisement in `payload`. The caller should use
   // the returned `AdvertisingSession` to stop the broadcast.
   std::unique_ptr<AdvertisingSession> StartAdvertising(
@@ -75,11 +81,12 @@ class Ble {
   }
 
   // Starts scanning for NP advertisements. The caller should use the returned
-  // `ScanningSession` to stop scanning.
+  // `ScanningSession` to stop scanning. Concurrent NP scan requests in the
+  // process share a single platform scan.
   std::unique_ptr<ScanningSession> StartScanning(ScanRequest scan_request,
                                                  ScanningCallback callback) {
-    return medium_.StartScanning(
-        kPresenceServiceUuid,
+    return BleScanMultiplexer::GetInstance().StartScanning(
+        medium_, kPresenceServiceUuid,
         ConvertPowerModeToPowerLevel(scan_request.power_mode),
         std::move(callback));
   }
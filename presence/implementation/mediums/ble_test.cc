@@ -168,6 +168,56 @@ TEST_P(BleTest, AdvertiseAndScan) {
   env_.Stop();
 }
 
+TEST_P(BleTest, AdvertiseAndScanExtendedAdvertisement) {
+  env_.Start({.ble_extended_advertisements_enabled = true});
+  nearby::BluetoothAdapter client_adapter;
+  Ble client(client_adapter);
+  nearby::BluetoothAdapter server_adapter;
+  Ble server(server_adapter);
+  // Longer than a BLE 4.2 advertisement can carry.
+  AdvertisementData advert_data = {.is_extended_advertisement = true,
+                                   .content = std::string(100, 'x')};
+  nearby::CountDownLatch scan_latch(1);
+  std::vector<BleAdvertisementData> advertisements;
+  std::unique_ptr<ScanningSession> scanning_session = client.StartScanning(
+      ScanRequest{.power_mode = PowerMode::kBalanced},
+      ScanningCallback{.advertisement_found_cb =
+                           [&](BlePeripheral& peripheral,
+                               BleAdvertisementData advertisement_data) {
+                             advertisements.push_back(advertisement_data);
+                             scan_latch.CountDown();
+                           }});
+  ASSERT_TRUE(server.IsExtendedAdvertisementsAvailable());
+  std::unique_ptr<AdvertisingSession> advertising_session =
+      server.StartAdvertising(advert_data, PowerMode::kBalanced,
+                              AdvertisingCallback{});
+
+  ASSERT_NE(advertising_session, nullptr);
+  EXPECT_TRUE(scan_latch.Await(kWaitDuration).result());
+  EXPECT_OK(scanning_session->stop_scanning());
+  EXPECT_OK(advertising_session->stop_advertising());
+  ASSERT_FALSE(advertisements.empty());
+  EXPECT_TRUE(advertisements[0].is_extended_advertisement);
+  EXPECT_EQ(advertisements[0]
+                .service_data.find(kPresenceServiceUuid)
+                ->second.AsStringView(),
+            advert_data.content);
+  env_.Stop();
+}
+
+TEST_P(BleTest, ExtendedAdvertisementUnavailable) {
+  env_.Start();
+  nearby::BluetoothAdapter adapter;
+  Ble ble(adapter);
+
+  EXPECT_FALSE(ble.IsExtendedAdvertisementsAvailable());
+  EXPECT_EQ(ble.StartAdvertising({.is_extended_advertisement = true,
+                                  .content = "my advertisement"},
+                                 PowerMode::kBalanced, AdvertisingCallback{}),
+            nullptr);
+  env_.Stop();
+}
+
 }  // namespace
 }  // namespace presence
 }  // namespace nearby